@@ -32,6 +32,11 @@ static void closeconn(socket_client_t* cl);
 
 static bool s_logging = false;
 
+/* Connection opened by rg_connect() that every command 
+ * uses until rg_disconnect() is called */
+static socket_client_t s_conn;
+static bool s_connected = false;
+
 int32_t 
 clientconnect(socket_client_t* cl) {
   int code = connect(cl->sock, 
@@ -42,14 +47,28 @@ clientconnect(socket_client_t* cl) {
 
 int32_t 
 senddata(socket_client_t* cl, const void* data, size_t size) {
-  int code = write(cl->sock, data, size);
-  return code == -1 ? 1 : 0;
+  // Larger commands may be written in several parts
+  const uint8_t* ptr = data;
+  while(size) {
+    ssize_t code = write(cl->sock, ptr, size);
+    if(code == -1) return 1;
+    ptr += code;
+    size -= code;
+  }
+  return 0;
 }
 
 int32_t
 recvdata(socket_client_t* cl, void* data, size_t size) {
-  int code = read(cl->sock, data, size);
-  return code == -1 ? 1 : 0;
+  // Larger replies may arrive in several parts
+  uint8_t* ptr = data;
+  while(size) {
+    ssize_t code = read(cl->sock, ptr, size);
+    if(code <= 0) return 1;
+    ptr += code;
+    size -= code;
+  }
+  return 0;
 }
 
 int32_t 
@@ -122,6 +141,10 @@ clientclose(socket_client_t* cl) {
 
 void
 establishconn(socket_client_t* cl) {
+  if(s_connected) {
+    *cl = s_conn;
+    return;
+  }
   if(clientinit(cl) != 0) {
     fprintf(stderr, "ragnar api: failed to open client connection.\n");
     return;
@@ -139,6 +162,10 @@ establishconn(socket_client_t* cl) {
 
 void
 closeconn(socket_client_t* cl) {
+  // The persistent connection stays open for the next command
+  if(s_connected && cl->sock == s_conn.sock) {
+    return;
+  }
   if(clientclose(cl) != 0) {
     fprintf(stderr, "ragnar api: failed to close client connection.\n");
     return;
@@ -152,6 +179,37 @@ void rg_set_trace_logging(bool logging) {
   s_logging = logging;
 }
 
+int32_t 
+rg_connect(void) {
+  if(s_connected) {
+    return 0;
+  }
+  if(clientinit(&s_conn) != 0) {
+    fprintf(stderr, "ragnar api: failed to open client connection.\n");
+    return 1;
+  }
+  if(clientconnect(&s_conn) != 0) {
+    fprintf(stderr, "ragnar api: client failed to connect to ragnar API.\n");
+    clientclose(&s_conn);
+    return 1;
+  }
+  s_connected = true;
+
+  if(s_logging) {
+    printf("ragnar api: opened persistent connection.\n");
+  }
+  return 0;
+}
+
+void 
+rg_disconnect(void) {
+  if(!s_connected) {
+    return;
+  }
+  s_connected = false;
+  closeconn(&s_conn);
+}
+
 int32_t 
 rg_cmd_terminate(uint32_t exitcode) {
   socket_client_t cl;
@@ -475,3 +533,122 @@ rg_cmd_switch_desktop(uint32_t desktop_id) {
   return 0;
 
 }
+
+int32_t 
+rg_cmd_get_memory_stats(RgMemoryStats* stats) {
+  socket_client_t cl;
+  establishconn(&cl);
+
+  if(sendcmd(&cl, RgCommandGetMemoryStats, NULL, 0) != 0) {
+    fprintf(stderr, "ragnar api: RgCommandGetMemoryStats: failed to send command.\n");
+    closeconn(&cl);
+    return 1;
+  }
+
+  if(recvdata(&cl, stats, sizeof(*stats)) != 0) {
+    fprintf(stderr, "ragnar api: RgCommandGetMemoryStats: failed to receive memory stats.\n");
+    closeconn(&cl);
+    return 1;
+  }
+
+  if(s_logging) {
+    printf("ragnar api: RgCommandGetMemoryStats: successfully sent command.\n");
+  }
+  closeconn(&cl);
+  return 0;
+}
+
+int32_t 
+rg_cmd_restart(void) {
+  socket_client_t cl;
+  establishconn(&cl);
+
+  if(sendcmd(&cl, RgCommandRestart, NULL, 0) != 0) {
+    fprintf(stderr, "ragnar api: RgCommandRestart: failed to send command.\n");
+    closeconn(&cl);
+    return 1;
+  }
+
+  if(s_logging) {
+    printf("ragnar api: RgCommandRestart: successfully sent command.\n");
+  }
+  closeconn(&cl);
+  return 0;
+}
+
+int32_t 
+rg_cmd_update_windows(const RgWindowUpdate* updates, uint32_t numupdates, 
+                      RgWindowUpdateStatus* statuses) {
+  if(!numupdates || numupdates > RG_MAX_WINDOW_UPDATES) {
+    fprintf(stderr, "ragnar api: RgCommandUpdateWindows: invalid number of updates (%u).\n", numupdates);
+    return 1;
+  }
+  socket_client_t cl;
+  establishconn(&cl);
+
+  if(sendcmd(&cl, RgCommandUpdateWindows, (uint8_t*)updates, 
+             numupdates * sizeof(RgWindowUpdate)) != 0) {
+    fprintf(stderr, "ragnar api: RgCommandUpdateWindows: failed to send command.\n");
+    closeconn(&cl);
+    return 1;
+  }
+
+  for(uint32_t i = 0; i < numupdates; i++) {
+    int32_t status;
+    if(recvdata(&cl, &status, sizeof(status)) != 0) {
+      fprintf(stderr, "ragnar api: RgCommandUpdateWindows: failed to receive update status.\n");
+      closeconn(&cl);
+      return 1;
+    }
+    statuses[i] = (RgWindowUpdateStatus)status;
+  }
+
+  if(s_logging) {
+    printf("ragnar api: RgCommandUpdateWindows: successfully sent command.\n");
+  }
+  closeconn(&cl);
+  return 0;
+}
+
+int32_t 
+rg_cmd_get_resources(RgResourceStats* stats, RgWindowResources** wins, 
+                     uint32_t* numwins) {
+  socket_client_t cl;
+  establishconn(&cl);
+
+  if(sendcmd(&cl, RgCommandGetResources, NULL, 0) != 0) {
+    fprintf(stderr, "ragnar api: RgCommandGetResources: failed to send command.\n");
+    closeconn(&cl);
+    return 1;
+  }
+
+  uint32_t num;
+  if(recvdata(&cl, stats, sizeof(*stats)) != 0 || 
+    recvdata(&cl, &num, sizeof(num)) != 0) {
+    fprintf(stderr, "ragnar api: RgCommandGetResources: failed to receive resource stats.\n");
+    closeconn(&cl);
+    return 1;
+  }
+
+  RgWindowResources* buf = malloc((num ? num : 1) * sizeof(*buf));
+  if(!buf) {
+    fprintf(stderr, "ragnar api: RgCommandGetResources: failed to allocate memory for windows.\n");
+    closeconn(&cl);
+    return 1;
+  }
+  if(num && recvdata(&cl, buf, num * sizeof(*buf)) != 0) {
+    fprintf(stderr, "ragnar api: RgCommandGetResources: failed to receive window resources.\n");
+    free(buf);
+    closeconn(&cl);
+    return 1;
+  }
+
+  if(s_logging) {
+    printf("ragnar api: RgCommandGetResources: successfully sent command.\n");
+  }
+  closeconn(&cl);
+
+  *wins = buf;
+  *numwins = num;
+  return 0;
+}
@@ -20,8 +20,15 @@ typedef enum {
   RgCommandGetWindowArea,
   RgCommandReloadConfig,
   RgCommandSwitchDesktop,
+  RgCommandGetMemoryStats,
+  RgCommandRestart,
+  RgCommandUpdateWindows,
+  RgCommandGetResources,
 } RgCommandType;
 
+/* Maximum number of updates in a single rg_cmd_update_windows() call */
+#define RG_MAX_WINDOW_UPDATES 1024
+
 typedef struct {
   float x, y;
 } Rgv2;
@@ -30,8 +37,80 @@ typedef struct {
   Rgv2 pos, size;
 } RgArea;
 
+typedef struct {
+  /* Clients that are currently allocated and the most that ever were */
+  uint32_t liveclients, peakclients;
+  /* Slabs the clients are allocated from */
+  uint32_t clientslabs;
+  /* Strings (e.g. window names) that are currently allocated and the most that ever were */
+  uint32_t livestrings, peakstrings;
+  /* Bytes held by the string pool */
+  uint64_t stringbytes;
+} RgMemoryStats;
+
+typedef enum {
+  RgWindowUpdateArea      = 1 << 0,
+  RgWindowUpdateDesktop   = 1 << 1,
+  RgWindowUpdateMonitor   = 1 << 2,
+  RgWindowUpdateFloating  = 1 << 3,
+} RgWindowUpdateField;
+
+typedef struct {
+  RgWindow win;
+  /* The fields of the update that are applied (RgWindowUpdateField) */
+  uint32_t fields;
+  /* Area in root window coordinates (makes the window float 
+   * unless the floating state is given as well) */
+  RgArea area;
+  uint32_t desktop;
+  int32_t monitor;
+  uint32_t floating;
+} RgWindowUpdate;
+
+typedef enum {
+  RgWindowUpdateOk = 0,
+  /* The update is valid but another update of the call is not */
+  RgWindowUpdateNotApplied,
+  RgWindowUpdateInvalidWindow,
+  RgWindowUpdateInvalidDesktop,
+  RgWindowUpdateInvalidMonitor,
+  RgWindowUpdateInvalidArea,
+} RgWindowUpdateStatus;
+
+/* Kinds of X resources the window manager creates */
+typedef enum {
+  RgResourceWindow,
+  RgResourceCursor,
+  RgResourceColormap,
+  RgResourceAlarm,
+  RgResourceGrab,
+  RgResourceKindCount,
+} RgResourceKind;
+
+typedef struct {
+  /* X resources the window manager created and freed (indexed by RgResourceKind) */
+  uint64_t created[RgResourceKindCount], freed[RgResourceKindCount];
+  /* Resources that were still held for windows when they were released */
+  uint64_t leaked[RgResourceKindCount];
+  /* Bytes of the window manager's own heap allocations by what they hold */
+  uint64_t heapclients, heapstrings, heapmonitors, heapwinmaps, heaprules, heapother;
+} RgResourceStats;
+
+typedef struct {
+  RgWindow win;
+  /* X resources held for the window (indexed by RgResourceKind) */
+  uint32_t resources[RgResourceKindCount];
+} RgWindowResources;
+
 void rg_set_trace_logging(bool logging);
 
+/* Opens a connection that all following commands are sent over 
+ * until rg_disconnect() is called. Without it, every command 
+ * opens a connection of its own. */
+int32_t rg_connect(void);
+
+void rg_disconnect(void);
+
 int32_t rg_cmd_terminate(uint32_t exitcode);
 
 int32_t rg_cmd_get_windows(RgWindow** wins, uint32_t* numwins);
@@ -56,3 +135,16 @@ int32_t rg_cmd_reload_config(void);
 
 int32_t rg_cmd_switch_desktop(uint32_t desktop_id);
 
+int32_t rg_cmd_get_memory_stats(RgMemoryStats* stats);
+
+int32_t rg_cmd_restart(void);
+
+/* Applies all updates at once or, if any of them is invalid, none of 
+ * them. Gets the status of every update in statuses. */
+int32_t rg_cmd_update_windows(const RgWindowUpdate* updates, uint32_t numupdates, 
+                              RgWindowUpdateStatus* statuses);
+
+/* Gets the X resources and heap memory of the window manager and the 
+ * resources held for every managed window (wins is allocated). */
+int32_t rg_cmd_get_resources(RgResourceStats* stats, RgWindowResources** wins, 
+                             uint32_t* numwins);
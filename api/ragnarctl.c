@@ -0,0 +1,497 @@
+#include "include/ragnar/api.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <errno.h>
+
+/* Maximum number of arguments of a single command (including its name) */
+#define MAXARGS 8
+/* Maximum length of a command line read from stdin */
+#define MAXLINE 1024
+
+typedef int32_t (*ctl_handler_t)(int32_t argc, char** argv);
+
+typedef struct {
+  const char* name;
+  /* Number of arguments after the command name */
+  int32_t numargs;
+  const char* usage;
+  ctl_handler_t handler;
+} ctl_cmd_t;
+
+static bool parseint(const char* str, int64_t* val);
+static bool parsearea(const char* str, RgArea* area);
+static int32_t ctlterminate(int32_t argc, char** argv);
+static int32_t ctlgetwins(int32_t argc, char** argv);
+static int32_t ctlkillwin(int32_t argc, char** argv);
+static int32_t ctlfocuswin(int32_t argc, char** argv);
+static int32_t ctlnextwin(int32_t argc, char** argv);
+static int32_t ctlfirstwin(int32_t argc, char** argv);
+static int32_t ctlgetfocus(int32_t argc, char** argv);
+static int32_t ctlgetmonfocus(int32_t argc, char** argv);
+static int32_t ctlgetcursor(int32_t argc, char** argv);
+static int32_t ctlgetwinarea(int32_t argc, char** argv);
+static int32_t ctlreloadconfig(int32_t argc, char** argv);
+static int32_t ctlswitchdesktop(int32_t argc, char** argv);
+static int32_t ctlgetmemstats(int32_t argc, char** argv);
+static int32_t ctlrestart(int32_t argc, char** argv);
+static int32_t ctlgetresources(int32_t argc, char** argv);
+static const char* parseupdate(int32_t argc, char** argv, RgWindowUpdate* u);
+static int32_t ctlupdatewin(int32_t argc, char** argv);
+static int32_t flushupdates(void);
+static int32_t runcmd(int32_t argc, char** argv);
+static int32_t runline(char* line);
+static void usage(FILE* f);
+
+static const ctl_cmd_t ctlcmds[] = {
+  { "terminate",          -1, "[exitcode]",  ctlterminate },
+  { "get-windows",        0,  "",            ctlgetwins },
+  { "kill-window",        1,  "<window>",    ctlkillwin },
+  { "focus-window",       1,  "<window>",    ctlfocuswin },
+  { "next-window",        1,  "<window>",    ctlnextwin },
+  { "first-window",       0,  "",            ctlfirstwin },
+  { "get-focus",          0,  "",            ctlgetfocus },
+  { "get-monitor-focus",  0,  "",            ctlgetmonfocus },
+  { "get-cursor",         0,  "",            ctlgetcursor },
+  { "get-window-area",    1,  "<window>",    ctlgetwinarea },
+  { "reload-config",      0,  "",            ctlreloadconfig },
+  { "switch-desktop",     1,  "<desktop>",   ctlswitchdesktop },
+  { "get-memory-stats",   0,  "",            ctlgetmemstats },
+  { "restart",            0,  "",            ctlrestart },
+  { "get-resources",      0,  "",            ctlgetresources },
+  { "update-window",      -1, "<window> [area=x,y,w,h] [desktop=n] [monitor=n] [floating=0|1]", 
+                                             ctlupdatewin },
+};
+
+/* Consecutive update-window commands are sent as one transaction */
+static RgWindowUpdate s_updates[RG_MAX_WINDOW_UPDATES];
+static uint32_t s_numupdates = 0;
+
+static const char* updatestatuses[] = {
+  [RgWindowUpdateOk]            = "ok",
+  [RgWindowUpdateNotApplied]    = "not-applied",
+  [RgWindowUpdateInvalidWindow] = "invalid-window",
+  [RgWindowUpdateInvalidDesktop]= "invalid-desktop",
+  [RgWindowUpdateInvalidMonitor]= "invalid-monitor",
+  [RgWindowUpdateInvalidArea]   = "invalid-area",
+};
+
+bool
+parseint(const char* str, int64_t* val) {
+  char* end;
+  errno = 0;
+  *val = strtoll(str, &end, 0);
+  return errno == 0 && end != str && *end == '\0';
+}
+
+bool
+parsearea(const char* str, RgArea* area) {
+  int32_t x, y, w, h, n;
+  if(sscanf(str, "%d,%d,%d,%d%n", &x, &y, &w, &h, &n) != 4 || str[n] != '\0') {
+    return false;
+  }
+  *area = (RgArea){ .pos = { x, y }, .size = { w, h } };
+  return true;
+}
+
+/* Every command prints a single line: 'ok' followed by its
+ * results separated by spaces, or 'error' followed by the reason. */
+
+int32_t
+ctlterminate(int32_t argc, char** argv) {
+  int64_t code = 0;
+  if(argc > 1 && (argc > 2 || !parseint(argv[1], &code))) {
+    printf("error usage: terminate [exitcode]\n");
+    return -1;
+  }
+  if(rg_cmd_terminate((uint32_t)code) != 0) return 1;
+  printf("ok\n");
+  return 0;
+}
+
+int32_t
+ctlgetwins(int32_t argc, char** argv) {
+  (void)argc; (void)argv;
+  RgWindow* wins = NULL;
+  uint32_t numwins = 0;
+  if(rg_cmd_get_windows(&wins, &numwins) != 0) return 1;
+  printf("ok");
+  for(uint32_t i = 0; i < numwins; i++) {
+    printf(" %i", wins[i]);
+  }
+  printf("\n");
+  free(wins);
+  return 0;
+}
+
+int32_t
+ctlkillwin(int32_t argc, char** argv) {
+  (void)argc;
+  int64_t win;
+  if(!parseint(argv[1], &win)) {
+    printf("error invalid window '%s'\n", argv[1]);
+    return -1;
+  }
+  if(rg_cmd_kill_window((RgWindow)win) != 0) return 1;
+  printf("ok\n");
+  return 0;
+}
+
+int32_t
+ctlfocuswin(int32_t argc, char** argv) {
+  (void)argc;
+  int64_t win;
+  if(!parseint(argv[1], &win)) {
+    printf("error invalid window '%s'\n", argv[1]);
+    return -1;
+  }
+  if(rg_cmd_focus_window((RgWindow)win) != 0) return 1;
+  printf("ok\n");
+  return 0;
+}
+
+int32_t
+ctlnextwin(int32_t argc, char** argv) {
+  (void)argc;
+  int64_t win;
+  if(!parseint(argv[1], &win)) {
+    printf("error invalid window '%s'\n", argv[1]);
+    return -1;
+  }
+  RgWindow next;
+  if(rg_cmd_next_window((RgWindow)win, &next) != 0) return 1;
+  printf("ok %i\n", next);
+  return 0;
+}
+
+int32_t
+ctlfirstwin(int32_t argc, char** argv) {
+  (void)argc; (void)argv;
+  RgWindow first;
+  if(rg_cmd_first_window(&first) != 0) return 1;
+  printf("ok %i\n", first);
+  return 0;
+}
+
+int32_t
+ctlgetfocus(int32_t argc, char** argv) {
+  (void)argc; (void)argv;
+  RgWindow focus;
+  if(rg_cmd_get_focus(&focus) != 0) return 1;
+  printf("ok %i\n", focus);
+  return 0;
+}
+
+int32_t
+ctlgetmonfocus(int32_t argc, char** argv) {
+  (void)argc; (void)argv;
+  int32_t idx;
+  if(rg_cmd_get_monitor_focus(&idx) != 0) return 1;
+  printf("ok %i\n", idx);
+  return 0;
+}
+
+int32_t
+ctlgetcursor(int32_t argc, char** argv) {
+  (void)argc; (void)argv;
+  Rgv2 cursor;
+  if(rg_cmd_get_cursor(&cursor) != 0) return 1;
+  printf("ok %i %i\n", (int32_t)cursor.x, (int32_t)cursor.y);
+  return 0;
+}
+
+int32_t
+ctlgetwinarea(int32_t argc, char** argv) {
+  (void)argc;
+  int64_t win;
+  if(!parseint(argv[1], &win)) {
+    printf("error invalid window '%s'\n", argv[1]);
+    return -1;
+  }
+  RgArea area;
+  if(rg_cmd_get_window_area((RgWindow)win, &area) != 0) return 1;
+  printf("ok %i %i %i %i\n",
+         (int32_t)area.pos.x, (int32_t)area.pos.y,
+         (int32_t)area.size.x, (int32_t)area.size.y);
+  return 0;
+}
+
+int32_t
+ctlreloadconfig(int32_t argc, char** argv) {
+  (void)argc; (void)argv;
+  if(rg_cmd_reload_config() != 0) return 1;
+  printf("ok\n");
+  return 0;
+}
+
+int32_t
+ctlswitchdesktop(int32_t argc, char** argv) {
+  (void)argc;
+  int64_t desktop;
+  if(!parseint(argv[1], &desktop) || desktop < 0) {
+    printf("error invalid desktop '%s'\n", argv[1]);
+    return -1;
+  }
+  if(rg_cmd_switch_desktop((uint32_t)desktop) != 0) return 1;
+  printf("ok\n");
+  return 0;
+}
+
+int32_t
+ctlgetmemstats(int32_t argc, char** argv) {
+  (void)argc; (void)argv;
+  RgMemoryStats stats;
+  if(rg_cmd_get_memory_stats(&stats) != 0) return 1;
+  printf("ok liveclients=%u peakclients=%u clientslabs=%u "
+         "livestrings=%u peakstrings=%u stringbytes=%llu\n",
+         stats.liveclients, stats.peakclients, stats.clientslabs,
+         stats.livestrings, stats.peakstrings,
+         (unsigned long long)stats.stringbytes);
+  return 0;
+}
+
+/* Prints the live resources of every kind, the leaked ones and the 
+ * heap usage, followed by the resources of every window as 
+ * <window>=<windows>,<cursors>,<colormaps>,<alarms>,<grabs> */
+int32_t
+ctlgetresources(int32_t argc, char** argv) {
+  (void)argc; (void)argv;
+  static const char* kinds[RgResourceKindCount] = {
+    "windows", "cursors", "colormaps", "alarms", "grabs"
+  };
+  RgResourceStats stats;
+  RgWindowResources* wins = NULL;
+  uint32_t numwins = 0;
+  if(rg_cmd_get_resources(&stats, &wins, &numwins) != 0) return 1;
+  uint64_t leaked = 0;
+  printf("ok");
+  for(uint32_t i = 0; i < RgResourceKindCount; i++) {
+    printf(" %s=%llu", kinds[i], (unsigned long long)(stats.created[i] - stats.freed[i]));
+    leaked += stats.leaked[i];
+  }
+  printf(" leaked=%llu heapclients=%llu heapstrings=%llu heapmonitors=%llu "
+         "heapwinmaps=%llu heaprules=%llu heapother=%llu",
+         (unsigned long long)leaked,
+         (unsigned long long)stats.heapclients, (unsigned long long)stats.heapstrings,
+         (unsigned long long)stats.heapmonitors, (unsigned long long)stats.heapwinmaps,
+         (unsigned long long)stats.heaprules, (unsigned long long)stats.heapother);
+  for(uint32_t i = 0; i < numwins; i++) {
+    printf(" %i=", wins[i].win);
+    for(uint32_t k = 0; k < RgResourceKindCount; k++) {
+      printf(k ? ",%u" : "%u", wins[i].resources[k]);
+    }
+  }
+  printf("\n");
+  free(wins);
+  return 0;
+}
+
+int32_t
+ctlrestart(int32_t argc, char** argv) {
+  (void)argc; (void)argv;
+  if(rg_cmd_restart() != 0) return 1;
+  printf("ok\n");
+  return 0;
+}
+
+/* Parses the fields of an update-window command into u. Returns 
+ * NULL on success or a message describing the invalid field. */
+const char*
+parseupdate(int32_t argc, char** argv, RgWindowUpdate* u) {
+  static char err[MAXLINE];
+  int64_t val;
+  if(argc < 2 || !parseint(argv[1], &val)) {
+    return "usage: update-window <window> [area=x,y,w,h] [desktop=n] [monitor=n] [floating=0|1]";
+  }
+  *u = (RgWindowUpdate){ .win = (RgWindow)val };
+  for(int32_t i = 2; i < argc; i++) {
+    char* arg = argv[i];
+    char* eq = strchr(arg, '=');
+    if(!eq) {
+      snprintf(err, sizeof(err), "invalid field '%s'", arg);
+      return err;
+    }
+    *eq = '\0';
+    const char* v = eq + 1;
+    bool valid = true;
+    if(strcmp(arg, "area") == 0) {
+      u->fields |= RgWindowUpdateArea;
+      valid = parsearea(v, &u->area);
+    } else if(strcmp(arg, "desktop") == 0) {
+      u->fields |= RgWindowUpdateDesktop;
+      valid = parseint(v, &val) && val >= 0;
+      u->desktop = (uint32_t)val;
+    } else if(strcmp(arg, "monitor") == 0) {
+      u->fields |= RgWindowUpdateMonitor;
+      valid = parseint(v, &val);
+      u->monitor = (int32_t)val;
+    } else if(strcmp(arg, "floating") == 0) {
+      u->fields |= RgWindowUpdateFloating;
+      valid = parseint(v, &val) && (val == 0 || val == 1);
+      u->floating = (uint32_t)val;
+    } else {
+      snprintf(err, sizeof(err), "unknown field '%s'", arg);
+      return err;
+    }
+    if(!valid) {
+      snprintf(err, sizeof(err), "invalid %s '%s'", arg, v);
+      return err;
+    }
+  }
+  return NULL;
+}
+
+/* Queues an update that is sent with the following update-window 
+ * commands once another command runs or the input ends. An invalid 
+ * update discards the queued ones, just like the window manager does. */
+int32_t
+ctlupdatewin(int32_t argc, char** argv) {
+  RgWindowUpdate u;
+  const char* err = parseupdate(argc, argv, &u);
+  if(err) {
+    for(uint32_t i = 0; i < s_numupdates; i++) {
+      printf("error %s\n", updatestatuses[RgWindowUpdateNotApplied]);
+    }
+    s_numupdates = 0;
+    printf("error %s\n", err);
+    return -1;
+  }
+  if(s_numupdates == RG_MAX_WINDOW_UPDATES && flushupdates() != 0) {
+    return -1;
+  }
+  s_updates[s_numupdates++] = u;
+  return 0;
+}
+
+/* Sends the queued updates and prints one line for each of them */
+int32_t
+flushupdates(void) {
+  if(!s_numupdates) return 0;
+  uint32_t n = s_numupdates;
+  s_numupdates = 0;
+
+  RgWindowUpdateStatus statuses[RG_MAX_WINDOW_UPDATES];
+  if(rg_cmd_update_windows(s_updates, n, statuses) != 0) {
+    for(uint32_t i = 0; i < n; i++) {
+      printf("error update-window failed\n");
+    }
+    return 1;
+  }
+  int32_t code = 0;
+  for(uint32_t i = 0; i < n; i++) {
+    if(statuses[i] == RgWindowUpdateOk) {
+      printf("ok\n");
+      continue;
+    }
+    uint32_t idx = (uint32_t)statuses[i];
+    printf("error %s\n", idx < sizeof(updatestatuses) / sizeof(updatestatuses[0]) ?
+           updatestatuses[idx] : "unknown");
+    code = 1;
+  }
+  return code;
+}
+
+/* Runs a single command given by its name and arguments */
+int32_t
+runcmd(int32_t argc, char** argv) {
+  // Queued updates run before any other command
+  int32_t flushed = 0;
+  if(strcmp(argv[0], "update-window") != 0) {
+    flushed = flushupdates();
+  }
+  for(uint32_t i = 0; i < sizeof(ctlcmds) / sizeof(ctlcmds[0]); i++) {
+    const ctl_cmd_t* cmd = &ctlcmds[i];
+    if(strcmp(argv[0], cmd->name) != 0) continue;
+    if(cmd->numargs != -1 && argc - 1 != cmd->numargs) {
+      printf("error usage: %s %s\n", cmd->name, cmd->usage);
+      return 1;
+    }
+    // Invalid arguments are reported by the handler (-1), API failures on stderr
+    int32_t code = cmd->handler(argc, argv);
+    if(code > 0) {
+      printf("error %s failed\n", cmd->name);
+    }
+    return (code != 0) | flushed;
+  }
+  printf("error unknown command '%s'\n", argv[0]);
+  return 1;
+}
+
+/* Splits a line at whitespace and runs it as a command.
+ * Empty lines and lines starting with '#' are skipped. */
+int32_t
+runline(char* line) {
+  char* argv[MAXARGS];
+  int32_t argc = 0;
+  for(char* tok = strtok(line, " \t\r\n"); tok; tok = strtok(NULL, " \t\r\n")) {
+    if(argc == 0 && tok[0] == '#') break;
+    if(argc == MAXARGS) {
+      printf("error too many arguments\n");
+      return 1;
+    }
+    argv[argc++] = tok;
+  }
+  if(!argc) return 0;
+  return runcmd(argc, argv);
+}
+
+void
+usage(FILE* f) {
+  fprintf(f,
+          "usage: ragnarctl [-v] <command> [args] [';' <command> [args]]...\n"
+          "       ragnarctl [-v] -   (read one command per line from stdin)\n"
+          "\n"
+          "All commands run over a single connection. Every command prints\n"
+          "one line: 'ok' followed by its results, or 'error' and the reason.\n"
+          "The exit code is 1 if any command failed. Consecutive update-window\n"
+          "commands are applied as one transaction: either all or none of them.\n"
+          "\n"
+          "commands:\n");
+  for(uint32_t i = 0; i < sizeof(ctlcmds) / sizeof(ctlcmds[0]); i++) {
+    fprintf(f, "  %s %s\n", ctlcmds[i].name, ctlcmds[i].usage);
+  }
+}
+
+int
+main(int argc, char** argv) {
+  int32_t first = 1;
+  if(first < argc && strcmp(argv[first], "-v") == 0) {
+    rg_set_trace_logging(true);
+    first++;
+  }
+  if(first >= argc || strcmp(argv[first], "-h") == 0 || strcmp(argv[first], "--help") == 0) {
+    usage(first >= argc ? stderr : stdout);
+    return first >= argc ? 1 : 0;
+  }
+
+  if(rg_connect() != 0) {
+    return 1;
+  }
+
+  int32_t code = 0;
+  if(strcmp(argv[first], "-") == 0) {
+    char line[MAXLINE];
+    while(fgets(line, sizeof(line), stdin)) {
+      code |= runline(line);
+      // Results are read line by line by scripts that pipe into ragnarctl
+      fflush(stdout);
+    }
+  } else {
+    // Commands on the command line are separated by ';' arguments
+    int32_t start = first;
+    for(int32_t i = first; i <= argc; i++) {
+      if(i < argc && strcmp(argv[i], ";") != 0) continue;
+      if(i > start) {
+        code |= runcmd(i - start, &argv[start]);
+      }
+      start = i + 1;
+    }
+  }
+
+  code |= flushupdates();
+  rg_disconnect();
+  return code;
+}
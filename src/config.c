@@ -1,10 +1,19 @@
 #include "config.h"
 #include "funcs.h"
+#include "rules.h"
+#include "xbackend.h"
 #include <ctype.h>
 #include <libconfig.h>
+#include <stddef.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <xcb/xcb.h>
 #include <X11/XF86keysym.h>
 #include <xcb/xproto.h>
@@ -19,6 +28,58 @@ typedef struct {
   keycallback_t cb;
 } key_cb_mapping_t;
 
+#define CFG_CACHE_MAGIC   0x43434752 /* "RGCC" */
+/* Needs to be increased whenever the meaning of a cached value 
+ * changes in a way that the layout of the cache does not show */
+#define CFG_CACHE_VERSION 5
+/* Offset of a string that is not set */
+#define CFG_CACHE_NOSTR   UINT32_MAX
+
+/* Header of the compiled config cache. It is followed by the keybinds, 
+ * the window rules, the string offsets of the desktop names and the string table. */
+typedef struct {
+  uint32_t magic, version;
+  /* Invalidates caches written by builds with different tables or structures */
+  uint32_t datasize, numkeymappings, numkeycbmappings;
+  /* Hash of the names of the key and callback tables and the layout of 
+   * the settings, as keybinds are stored as indices and settings by their layout */
+  uint64_t buildid;
+  /* Identifies the config file the cache was compiled from */
+  int64_t srcmtime_sec, srcmtime_nsec;
+  uint64_t srcsize, srchash;
+  uint32_t srcpath;
+
+  uint32_t numkeybinds, numrules, numdesktopnames;
+  uint32_t cursorimage;
+  uint32_t strtabsize;
+  /* Numeric settings, pointers are not valid */
+  config_data_t data;
+} cfg_cache_header_t;
+
+/* A resolved keybind within the config cache */
+typedef struct {
+  uint16_t modmask;
+  uint32_t key;
+  /* Index into keycbmappings */
+  uint32_t cb;
+  /* Offset of the command in the string table */
+  uint32_t cmd;
+  int32_t i;
+  /* Offset of the scratchpad window class in the string table */
+  uint32_t wmclass;
+  uint32_t launch;
+} cfg_cache_keybind_t;
+
+/* A window rule within the config cache */
+typedef struct {
+  /* Offsets of the match criteria in the string table */
+  uint32_t wmclass, instance, title, role, type;
+  int32_t desktop, monitor;
+  int8_t floating, fullscreen;
+  bool hasgeometry;
+  area_t geometry;
+} cfg_cache_rule_t;
+
 const key_mapping_t keymappings[] = {
     {"KeyVoidSymbol", KeyVoidSymbol},
     {"KeyBackSpace", KeyBackSpace},
@@ -245,6 +306,8 @@ const key_cb_mapping_t keycbmappings[] = {
     {"setverticalstripes", setverticalstripes},
     {"sethorizontalstripes", sethorizontalstripes},
     {"setfloatingmode", setfloatingmode},
+    {"setmonocle", setmonocle},
+    {"settabbed", settabbed},
     {"updatebarslayout", updatebarslayout},
     {"cycledownlayout", cycledownlayout},
     {"cycleuplayout", cycleuplayout},
@@ -264,12 +327,44 @@ const key_cb_mapping_t keycbmappings[] = {
     {"cyclefocusmonitorup", cyclefocusmonitorup},
     {"togglescratchpad", togglescratchpad},
     {"reloadconfigfile", reloadconfigfile},
+    {"restartwm", restartwm},
+    {"movefocusmonitorleft", movefocusmonitorleft},
+    {"movefocusmonitorright", movefocusmonitorright},
+    {"movefocusmonitorup", movefocusmonitorup},
+    {"movefocusmonitordown", movefocusmonitordown},
+    {"focusmonitorleft", focusmonitorleft},
+    {"focusmonitorright", focusmonitorright},
+    {"focusmonitorup", focusmonitorup},
+    {"focusmonitordown", focusmonitordown},
 };
 
-static config_t cfghndl;
+/* Hash tables mapping the names of keymappings and keycbmappings 
+ * to their index + 1 (0 marks an empty slot), built on first use */
+static uint16_t keylookup[ARRLEN(keymappings) * 2 + 1];
+static uint16_t keycblookup[ARRLEN(keycbmappings) * 2 + 1];
+
+static config_t cfgfile;
+/* Source file state captured right before it was parsed */
+static struct stat cfgsrcstat;
+static uint64_t cfgsrchash;
+/* Handle of the parsed config file, NULL if nothing was parsed 
+ * or the config is read from the cache */
+static config_t* cfghndl = NULL;
+
+/* Memory mapped config cache, NULL if the config file is parsed */
+static const uint8_t* cfgcache = NULL;
+static size_t cfgcachesize = 0;
+
+/* Path of the config file that was read last */
+static char* cfgpath = NULL;
 
 static char* replaceplaceholder(const char* str, const char* placeholder, const char* value);
 
+static uint64_t hashbytes(const void* data, size_t len);
+static uint64_t cachebuildid(void);
+static void buildlookup(uint16_t* table, uint32_t tablesize, const void* entries, uint32_t count, size_t stride);
+static int32_t lookupname(const uint16_t* table, uint32_t tablesize, const void* entries, size_t stride, const char* name);
+
 static uint16_t kbmodsfromstr(state_t* s, const char* modifiers);
 static keycode_t keycodefromstr(const char* keycode);
 static keycallback_t keycbfromstr(const char* cbstr);
@@ -282,8 +377,34 @@ static bool cfgreadstr(state_t* s, const char** val, const char* label);
 static bool cfgevalkbmod(state_t* s, kb_modifier_t* mod, const char* label);
 static bool cfgevalmousebtn(state_t* s, mousebtn_t* btn, const char* label);
 static layout_type_t cfgevallayouttype(state_t* s, const char* label);
-static char** cfgevalstrarr(state_t* s, const char* label);
+static hide_strategy_t cfgevalhidestrategy(state_t* s, const char* label);
+static frame_visual_t cfgevalframevisual(state_t* s, const char* label);
+static resize_mode_t cfgevalresizemode(state_t* s, const char* label);
+static char** cfgevalstrarr(state_t* s, uint32_t* len, const char* label);
 static keybind_t* cfgevalkeybinds(state_t* s, uint32_t* numkeybinds, const char* label);
+static int8_t cfgevaltristate(const config_setting_t* setting, const char* name);
+static window_rule_t* cfgevalrules(state_t* s, uint32_t* numrules, const char* label);
+
+static bool validconfig(state_t* s, const config_data_t* data);
+static void freeconfigdata(config_data_t* data);
+static bool keybindschanged(const config_data_t* a, const config_data_t* b);
+static bool strchanged(const char* a, const char* b);
+static bool desktopnameschanged(const config_data_t* a, const config_data_t* b);
+static void reloaddesktops(state_t* s, const config_data_t* old);
+static void reloadscratchpads(state_t* s, const config_data_t* old);
+static void applyconfig(state_t* s, const config_data_t* old);
+
+static char* logfilepath(void);
+static bool parseconfigfile(state_t* s, const char* path);
+
+static bool hashfile(const char* path, uint64_t* hash, struct stat* st);
+static char* cfgcachepath(void);
+static bool mapconfigcache(state_t* s, const char* path);
+static char* cachestrdup(const char* strtab, uint32_t strtabsize, uint32_t offset);
+static uint32_t cacheaddstr(char** strtab, uint32_t* strtabsize, const char* str);
+static bool writeall(int32_t fd, const void* data, size_t len);
+static bool readconfigcache(state_t* s, config_data_t* data);
+static void writeconfigcache(state_t* s, const config_data_t* data);
 
 char*
 replaceplaceholder(const char* str, const char* placeholder, const char* value) {
@@ -362,29 +483,129 @@ kbmodsfromstr(state_t* s, const char* modifiers) {
   return bitmask;
 }
 
+uint64_t
+hashbytes(const void* data, size_t len) {
+  // 64-bit FNV-1a
+  const uint8_t* bytes = data;
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for(size_t i = 0; i < len; i++) {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+/* Hashes what a config cache depends on besides the sizes of the tables: 
+ * the names in the tables and the layout of the cached structures. It only 
+ * changes with the sources, so every build of the same sources shares it. */
+uint64_t
+cachebuildid(void) {
+  const size_t layout[] = {
+    sizeof(config_data_t), sizeof(cfg_cache_keybind_t), sizeof(cfg_cache_rule_t),
+    offsetof(config_data_t, maxstruts), offsetof(config_data_t, maxdesktops),
+    offsetof(config_data_t, maxscratchpads), offsetof(config_data_t, winborderwidth),
+    offsetof(config_data_t, winbordercolor), offsetof(config_data_t, winbordercolor_selected),
+    offsetof(config_data_t, modkey), offsetof(config_data_t, winmod),
+    offsetof(config_data_t, movebtn), offsetof(config_data_t, resizebtn),
+    offsetof(config_data_t, desktopinit), offsetof(config_data_t, usedecoration),
+    offsetof(config_data_t, layoutmasterarea), offsetof(config_data_t, layoutmasterarea_min),
+    offsetof(config_data_t, layoutmasterarea_max), offsetof(config_data_t, layoutmasterarea_step),
+    offsetof(config_data_t, layoutsize_step), offsetof(config_data_t, layoutsize_min),
+    offsetof(config_data_t, keywinmove_step), offsetof(config_data_t, winlayoutgap),
+    offsetof(config_data_t, winlayoutgap_max), offsetof(config_data_t, winlayoutgap_step),
+    offsetof(config_data_t, tabbarheight), offsetof(config_data_t, initlayout),
+    offsetof(config_data_t, hidestrategy), offsetof(config_data_t, framevisual),
+    offsetof(config_data_t, resizemode), offsetof(config_data_t, motion_notify_debounce_fps),
+    offsetof(config_data_t, glvsync), offsetof(config_data_t, logmessages),
+    offsetof(config_data_t, shouldlogtofile), offsetof(config_data_t, watchconfig),
+  };
+  uint64_t hash = hashbytes(layout, sizeof(layout));
+  for(uint32_t i = 0; i < ARRLEN(keymappings); i++) {
+    hash = (hash ^ hashbytes(keymappings[i].name, strlen(keymappings[i].name))) * 0x100000001b3ULL;
+    hash = (hash ^ keymappings[i].value) * 0x100000001b3ULL;
+  }
+  for(uint32_t i = 0; i < ARRLEN(keycbmappings); i++) {
+    hash = (hash ^ hashbytes(keycbmappings[i].name, strlen(keycbmappings[i].name))) * 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+/**
+ * @brief Fills an open addressing hash table with the indices of a 
+ * given array of entries that start with their name (const char*).
+ *
+ * @param table The table to fill 
+ * @param tablesize The number of slots in the table 
+ * @param entries The entries to insert 
+ * @param count The number of entries 
+ * @param stride The size of a single entry
+ */
+void
+buildlookup(uint16_t* table, uint32_t tablesize, const void* entries, uint32_t count, size_t stride) {
+  for(uint32_t i = 0; i < count; i++) {
+    const char* name = *(const char* const*)((const uint8_t*)entries + i * stride);
+    uint32_t slot = hashbytes(name, strlen(name)) % tablesize;
+    while(table[slot]) {
+      slot = (slot + 1) % tablesize;
+    }
+    table[slot] = i + 1;
+  }
+}
+
+/**
+ * @brief Looks up the index of the entry with a given name in a 
+ * table that was filled by buildlookup().
+ *
+ * @return The index of the entry or -1 if there is no entry with the name
+ */
+int32_t
+lookupname(const uint16_t* table, uint32_t tablesize, const void* entries, size_t stride, const char* name) {
+  uint32_t slot = hashbytes(name, strlen(name)) % tablesize;
+  while(table[slot]) {
+    uint32_t idx = table[slot] - 1;
+    if(strcmp(name, *(const char* const*)((const uint8_t*)entries + idx * stride)) == 0) {
+      return idx;
+    }
+    slot = (slot + 1) % tablesize;
+  }
+  return -1;
+}
+
 keycode_t 
 keycodefromstr(const char* keycode) {
-  for (size_t i = 0; i < sizeof(keymappings) / sizeof(keymappings[0]); ++i) {
-    if (strcmp(keycode, keymappings[i].name) == 0) {
-      return keymappings[i].value;
+  static bool built = false;
+  if(!built) {
+    buildlookup(keylookup, ARRLEN(keylookup), keymappings, ARRLEN(keymappings), sizeof(keymappings[0]));
+    built = true;
+  }
+  int32_t idx = lookupname(keylookup, ARRLEN(keylookup), keymappings, sizeof(keymappings[0]), keycode);
+  return idx != -1 ? keymappings[idx].value : (keycode_t)-1;
+}
+
+const char*
+keysymtostr(xcb_keysym_t keysym) {
+  for(uint32_t i = 0; i < ARRLEN(keymappings); i++) {
+    if(keymappings[i].value == keysym) {
+      return keymappings[i].name;
     }
   }
-  return -1; 
+  return "unknown";
 }
 
 keycallback_t 
 keycbfromstr(const char* cbstr) {
-  for (size_t i = 0; i < sizeof(keycbmappings) / sizeof(keycbmappings[0]); ++i) {
-    if (strcmp(cbstr, keycbmappings[i].name) == 0) {
-      return keycbmappings[i].cb;
-    }
+  static bool built = false;
+  if(!built) {
+    buildlookup(keycblookup, ARRLEN(keycblookup), keycbmappings, ARRLEN(keycbmappings), sizeof(keycbmappings[0]));
+    built = true;
   }
-  return NULL; 
+  int32_t idx = lookupname(keycblookup, ARRLEN(keycblookup), keycbmappings, sizeof(keycbmappings[0]), cbstr);
+  return idx != -1 ? keycbmappings[idx].cb : NULL;
 }
 
 bool
 cfgreadint(state_t* s, int32_t* val ,const char* label) {
-  bool success = (bool)config_lookup_int(&cfghndl, label, val);
+  bool success = (bool)config_lookup_int(cfghndl, label, val);
 
   if(!success) {
     logmsg(s, LogLevelError, "config: %s is not set.", label);
@@ -395,7 +616,7 @@ cfgreadint(state_t* s, int32_t* val ,const char* label) {
 
 bool 
 cfgreadfloat(state_t* s, double* val, const char* label) {
-  bool success = (bool)config_lookup_float(&cfghndl, label, val);
+  bool success = (bool)config_lookup_float(cfghndl, label, val);
 
   if(!success) {
     logmsg(s, LogLevelError, "config: %s is not set.", label);
@@ -406,7 +627,7 @@ cfgreadfloat(state_t* s, double* val, const char* label) {
 
 bool 
 cfgreadbool(state_t* s, bool* val, const char* label) {
-  bool success = (bool)config_lookup_bool(&cfghndl, label, (int32_t*)val);
+  bool success = (bool)config_lookup_bool(cfghndl, label, (int32_t*)val);
 
   if(!success) {
     logmsg(s, LogLevelError, "config: %s is not set.", label);
@@ -417,7 +638,7 @@ cfgreadbool(state_t* s, bool* val, const char* label) {
 
 bool 
 cfgreadstr(state_t* s, const char** val, const char* label) {
-  bool success = (bool)config_lookup_string(&cfghndl, label, val);
+  bool success = (bool)config_lookup_string(cfghndl, label, val);
 
   if(!success) {
     logmsg(s, LogLevelError, "config: %s is not set.", label);
@@ -428,26 +649,26 @@ cfgreadstr(state_t* s, const char** val, const char* label) {
 
 bool
 cfgevalkbmod(state_t* s, kb_modifier_t* mod, const char* label) {
-  bool success = false;
-
-  const char* modstr;
-  success = cfgreadstr(s, &modstr, label);
+  const char* modstr = NULL;
+  if(!cfgreadstr(s, &modstr, label)) {
+    return false;
+  }
 
   if(strcmp(modstr, "Shift") == 0) {
     *mod = Shift;
-    return success;
+    return true;
   }
   if(strcmp(modstr, "Control") == 0) {
     *mod = Control;
-    return success;
+    return true;
   }
   if(strcmp(modstr, "Alt") == 0) {
     *mod = Alt;
-    return success;
+    return true;
   }
   if(strcmp(modstr, "Super") == 0) {
     *mod = Super;
-    return success;
+    return true;
   }
 
   logmsg(s, LogLevelError, "config: invalid keyboard modifier specified.");
@@ -456,31 +677,31 @@ cfgevalkbmod(state_t* s, kb_modifier_t* mod, const char* label) {
 
 bool 
 cfgevalmousebtn(state_t* s, mousebtn_t* btn, const char* label) {
-  bool success = false;
-
-  const char* btnstr;
-  success = cfgreadstr(s, &btnstr, label);
+  const char* btnstr = NULL;
+  if(!cfgreadstr(s, &btnstr, label)) {
+    return false;
+  }
 
   if(strcmp(btnstr, "LeftMouse") == 0) {
     *btn = LeftMouse; 
   } else if(strcmp(btnstr, "MiddleMouse") == 0) {
     *btn = MiddleMouse;
-    return success;
   } else if(strcmp(btnstr, "RightMouse") == 0) {
     *btn = RightMouse;
-    return success;
   } else {
     logmsg(s, LogLevelError, "config: invalid mouse button specified.");
     return false;
   }
-  return false;
+  return true;
 }
 
 layout_type_t
 cfgevallayouttype(state_t* s, const char* label) {
 
-  const char* layoutstr;
-  cfgreadstr(s, &layoutstr, label);
+  const char* layoutstr = NULL;
+  if(!cfgreadstr(s, &layoutstr, label)) {
+    return -1;
+  }
 
   layout_type_t layout;
 
@@ -492,6 +713,10 @@ cfgevallayouttype(state_t* s, const char* label) {
     layout = LayoutHorizontalStripes;
   } else if(strcmp(layoutstr, "LayoutVerticalStripes") == 0) {
     layout = LayoutVerticalStripes;
+  } else if(strcmp(layoutstr, "LayoutMonocle") == 0) {
+    layout = LayoutMonocle;
+  } else if(strcmp(layoutstr, "LayoutTabbed") == 0) {
+    layout = LayoutTabbed;
   } else {
     layout = -1;
     logmsg(s, LogLevelError, "config: invalid layout type specified.");
@@ -501,20 +726,77 @@ cfgevallayouttype(state_t* s, const char* label) {
   return layout;
 }
 
+hide_strategy_t
+cfgevalhidestrategy(state_t* s, const char* label) {
+  const char* strategystr = NULL;
+  // Hiding by unmapping is the default if nothing is specified
+  if(!config_lookup_string(cfghndl, label, &strategystr)) {
+    return HideStrategyUnmap;
+  }
+
+  if(strcmp(strategystr, "unmap") == 0) {
+    return HideStrategyUnmap;
+  } else if(strcmp(strategystr, "park") == 0) {
+    return HideStrategyPark;
+  }
+
+  logmsg(s, LogLevelError, "config: invalid hide strategy specified.");
+  return HideStrategyUnmap;
+}
+
+frame_visual_t
+cfgevalframevisual(state_t* s, const char* label) {
+  const char* visualstr = NULL;
+  /* ARGB frames are the default if nothing is specified, as the 
+   * compositor is usually started after the frame visual is chosen */
+  if(!config_lookup_string(cfghndl, label, &visualstr)) {
+    return FrameVisualARGB;
+  }
+
+  if(strcmp(visualstr, "auto") == 0) {
+    return FrameVisualAuto;
+  } else if(strcmp(visualstr, "argb") == 0) {
+    return FrameVisualARGB;
+  } else if(strcmp(visualstr, "opaque") == 0) {
+    return FrameVisualOpaque;
+  }
+
+  logmsg(s, LogLevelError, "config: invalid frame visual specified.");
+  return FrameVisualARGB;
+}
+
+resize_mode_t
+cfgevalresizemode(state_t* s, const char* label) {
+  const char* modestr = NULL;
+  // Live resizing is the default if nothing is specified
+  if(!config_lookup_string(cfghndl, label, &modestr)) {
+    return ResizeModeLive;
+  }
+
+  if(strcmp(modestr, "live") == 0) {
+    return ResizeModeLive;
+  } else if(strcmp(modestr, "outline") == 0) {
+    return ResizeModeOutline;
+  }
+
+  logmsg(s, LogLevelError, "config: invalid resize mode specified.");
+  return ResizeModeLive;
+}
+
 char**
-cfgevalstrarr(state_t* s, const char* label) {
+cfgevalstrarr(state_t* s, uint32_t* len, const char* label) {
   const config_setting_t* setting;
 
-  setting = config_lookup(&cfghndl, label);
+  setting = config_lookup(cfghndl, label);
   if(!setting) {
     logmsg(s, LogLevelError, "config: %s is not set.", label);
     return NULL;
   }
 
-  uint32_t len = (uint32_t)config_setting_length(setting);
+  *len = (uint32_t)config_setting_length(setting);
 
-  char** arr = malloc(len * sizeof(char*));
-  for (uint32_t i = 0; i < len; i++) {
+  char** arr = calloc(*len, sizeof(char*));
+  for (uint32_t i = 0; i < *len; i++) {
     const char* val = config_setting_get_string_elem(setting, i);
     if (val) {
       arr[i] = malloc(strlen(val) + 1);
@@ -528,14 +810,14 @@ cfgevalstrarr(state_t* s, const char* label) {
 keybind_t* 
 cfgevalkeybinds(state_t* s, uint32_t* numkeybinds, const char* label) {
   const config_setting_t* setting;
-  setting = config_lookup(&cfghndl, "keybinds");
+  setting = config_lookup(cfghndl, "keybinds");
   if(!setting) {
     logmsg(s, LogLevelError, "config: %s is not set.", label);
     return NULL;
   }
   uint32_t len = config_setting_length(setting);
   *numkeybinds = len;
-  keybind_t* keys = malloc(sizeof(keybind_t) * len);
+  keybind_t* keys = calloc(len, sizeof(keybind_t));
 
   for(uint32_t i = 0; i < len; ++i)
   {
@@ -568,25 +850,130 @@ cfgevalkeybinds(state_t* s, uint32_t* numkeybinds, const char* label) {
     uint32_t i_val = 0;
     config_setting_lookup_int(keybind, "i", (int32_t*)&i_val);
 
+    // Scratchpads can be matched by window class and launched ahead of time
+    const char* wmclass = NULL;
+    config_setting_lookup_string(keybind, "class", &wmclass);
+
+    scratchpad_launch_t launch = ScratchpadLaunchOnDemand;
+    const char* launch_str = NULL;
+    if(config_setting_lookup_string(keybind, "launch", &launch_str)) {
+      if(strcmp(launch_str, "startup") == 0) {
+        launch = ScratchpadLaunchStartup;
+      } else if(strcmp(launch_str, "lazy") == 0) {
+        launch = ScratchpadLaunchLazy;
+      } else if(strcmp(launch_str, "ondemand") != 0) {
+        logmsg(s, LogLevelError, "config: invalid scratchpad launch mode '%s'.", launch_str);
+      }
+    }
+
     keys[i] = (keybind_t){
       .cb = cb,
       .key = key,
       .data = (passthrough_data_t){
         .i = i_val,
-        .cmd = cmd
+        .cmd = cmd ? strdup(cmd) : NULL
       },
-      .modmask = mods
+      .modmask = mods,
+      .wmclass = wmclass ? strdup(wmclass) : NULL,
+      .launch = launch
     };
   }
 
   return keys;
 }
 
+int8_t
+cfgevaltristate(const config_setting_t* setting, const char* name) {
+  int32_t val;
+  if(!config_setting_lookup_bool(setting, name, &val)) return -1;
+  return val ? 1 : 0;
+}
 
-void 
-initconfig(state_t* s) {
-  config_init(&cfghndl);
+window_rule_t*
+cfgevalrules(state_t* s, uint32_t* numrules, const char* label) {
+  // Window rules are optional
+  *numrules = 0;
+  const config_setting_t* setting = config_lookup(cfghndl, label);
+  if(!setting) return NULL;
+
+  uint32_t len = config_setting_length(setting);
+  window_rule_t* rules = calloc(len, sizeof(window_rule_t));
+
+  for(uint32_t i = 0; i < len; i++) {
+    config_setting_t* rulesetting = config_setting_get_elem(setting, i);
+
+    const char *wmclass = NULL, *instance = NULL, *title = NULL, *role = NULL, *type = NULL;
+    config_setting_lookup_string(rulesetting, "class", &wmclass);
+    config_setting_lookup_string(rulesetting, "instance", &instance);
+    config_setting_lookup_string(rulesetting, "title", &title);
+    config_setting_lookup_string(rulesetting, "role", &role);
+    config_setting_lookup_string(rulesetting, "type", &type);
+
+    window_rule_t rule = {
+      .wmclass = wmclass ? strdup(wmclass) : NULL,
+      .instance = instance ? strdup(instance) : NULL,
+      .title = title ? strdup(title) : NULL,
+      .role = role ? strdup(role) : NULL,
+      .type = type ? strdup(type) : NULL,
+      .desktop = -1,
+      .monitor = -1,
+      .floating = cfgevaltristate(rulesetting, "floating"),
+      .fullscreen = cfgevaltristate(rulesetting, "fullscreen"),
+    };
+    config_setting_lookup_int(rulesetting, "desktop", &rule.desktop);
+    config_setting_lookup_int(rulesetting, "monitor", &rule.monitor);
+
+    // The geometry is given as [x, y, width, height] relative to the monitor
+    const config_setting_t* geometry = config_setting_get_member(rulesetting, "geometry");
+    if(geometry) {
+      if(config_setting_length(geometry) == 4) {
+        rule.hasgeometry = true;
+        rule.geometry = (area_t){
+          .pos  = (v2_t){ config_setting_get_int_elem(geometry, 0), config_setting_get_int_elem(geometry, 1) },
+          .size = (v2_t){ config_setting_get_int_elem(geometry, 2), config_setting_get_int_elem(geometry, 3) }
+        };
+      } else {
+        logmsg(s, LogLevelError, "config: rule %i: geometry needs to be [x, y, width, height].", i);
+      }
+    }
+
+    rules[(*numrules)++] = rule;
+  }
+
+  return rules;
+}
+
+char*
+logfilepath(void) {
+  const char* home = getenv("HOME");
+  const char* relpath = "/.ragnarwm.log";
+  char* logpath = malloc(strlen(home) + strlen(relpath) + 2);
+  sprintf(logpath, "%s%s", home, relpath);
+  return logpath;
+}
+
+bool
+parseconfigfile(state_t* s, const char* path) {
+  // Capture the state of the file that is parsed for the config cache
+  if(!hashfile(path, &cfgsrchash, &cfgsrcstat)) {
+    return false;
+  }
 
+  config_init(&cfgfile);
+  if(!config_read_file(&cfgfile, path)) {
+    logmsg(s, LogLevelError, "%s:%d - %s\n", config_error_file(&cfgfile),
+           config_error_line(&cfgfile), config_error_text(&cfgfile));
+    printf("ragnar: %s:%d - %s\n", config_error_file(&cfgfile),
+           config_error_line(&cfgfile), config_error_text(&cfgfile));
+    config_destroy(&cfgfile);
+    return false;
+  }
+  cfghndl = &cfgfile;
+  return true;
+}
+
+bool 
+initconfig(state_t* s) {
   const char* home = getenv("HOME");
   if(!home) {
     logmsg(s, LogLevelError, "cannot read config file because HOME is not defined.");
@@ -598,186 +985,870 @@ initconfig(state_t* s) {
   asprintf(&cfg_path, "%s/.config/ragnarwm/ragnar.cfg", home);
 
   printf("ragnar: attempting to read config at %s or %s\n", cfg_path, cfg_path_global);
-  if (
-    !config_read_file(&cfghndl, cfg_path)
-    && !config_read_file(&cfghndl, cfg_path_global)
-  ) {
-    logmsg(s, LogLevelError, "%s:%d - %s\n", config_error_file(&cfghndl),
-            config_error_line(&cfghndl), config_error_text(&cfghndl));
-    printf("ragnar: %s:%d - %s\n", config_error_file(&cfghndl),
-            config_error_line(&cfghndl), config_error_text(&cfghndl));
 
-    destroyconfig();
-    terminate(s, EXIT_FAILURE);
+  /* Use the compiled cache of a config file if it is up to date 
+   * and only parse the file otherwise */
+  const char* paths[] = {cfg_path, cfg_path_global};
+  bool success = false;
+  for(uint32_t i = 0; i < ARRLEN(paths) && !success; i++) {
+    if(access(paths[i], R_OK) != 0) continue;
+    success = mapconfigcache(s, paths[i]) || parseconfigfile(s, paths[i]);
+    if(success) {
+      // Remember which file was read so that it can be watched
+      free(cfgpath);
+      cfgpath = strdup(paths[i]);
+    }
   }
 
+  if(!success) {
+    logmsg(s, LogLevelError, "config: failed to read config at %s or %s.", cfg_path, cfg_path_global);
+  }
+  free(cfg_path);
+  return success;
 }
 
-void 
+bool 
 readconfig(state_t* s, config_data_t* data) {
-  if(!data) return;
+  if(!data) return false;
 
-  bool success = false;
+  if(cfgcache) {
+    if(readconfigcache(s, data)) {
+      destroyconfig();
+      printf("ragnar: successfully read cached config.\n");
+      return true;
+    }
+    // Fall back to parsing the config file if the cache is unusable
+    freeconfigdata(data);
+    *data = (config_data_t){0};
+    destroyconfig();
+    if(!parseconfigfile(s, cfgpath)) {
+      return false;
+    }
+  }
+
+  /* Every setting is read even if an earlier one failed so that 
+   * all errors of the config are logged at once */
+  bool success = true;
 
-  success = cfgreadint(s, (int32_t*)&data->maxstruts, "max_struts");
-  success = cfgreadint(s, (int32_t*)&data->maxdesktops, "num_desktops");
-  success = cfgreadint(s, (int32_t*)&data->maxscratchpads, "max_scratchpads");
+  success &= cfgreadint(s, (int32_t*)&data->maxstruts, "max_struts");
+  success &= cfgreadint(s, (int32_t*)&data->maxdesktops, "num_desktops");
+  success &= cfgreadint(s, (int32_t*)&data->maxscratchpads, "max_scratchpads");
 
-  success = cfgreadint(s, (int32_t*)&data->winborderwidth, "win_border_width");
-  success = cfgreadint(s, (int32_t*)&data->winbordercolor, "win_border_color");
-  success = cfgreadint(s, (int32_t*)&data->winbordercolor_selected, "win_border_color_selected");
+  success &= cfgreadint(s, (int32_t*)&data->winborderwidth, "win_border_width");
+  success &= cfgreadint(s, (int32_t*)&data->winbordercolor, "win_border_color");
+  success &= cfgreadint(s, (int32_t*)&data->winbordercolor_selected, "win_border_color_selected");
 
-  success = cfgevalkbmod(s, &data->modkey, "mod_key"); 
-  success = cfgevalkbmod(s, &data->winmod, "win_mod"); 
+  success &= cfgevalkbmod(s, &data->modkey, "mod_key"); 
+  success &= cfgevalkbmod(s, &data->winmod, "win_mod"); 
 
-  success = cfgevalmousebtn(s, &data->movebtn, "move_button");
-  success = cfgevalmousebtn(s, &data->resizebtn, "resize_button");
+  success &= cfgevalmousebtn(s, &data->movebtn, "move_button");
+  success &= cfgevalmousebtn(s, &data->resizebtn, "resize_button");
 
-  success = cfgreadint(s, (int32_t*)&data->desktopinit, "initial_desktop");
+  success &= cfgreadint(s, (int32_t*)&data->desktopinit, "initial_desktop");
 
-  data->desktopnames = cfgevalstrarr(s, "desktop_names");
-  success = data->desktopnames != NULL;
+  data->desktopnames = cfgevalstrarr(s, &data->numdesktopnames, "desktop_names");
+  success &= data->desktopnames != NULL;
 
-  success = cfgreadbool(s, &data->usedecoration, "use_decoration");
+  success &= cfgreadbool(s, &data->usedecoration, "use_decoration");
 
-  success = cfgreadfloat(s, &data->layoutmasterarea, "layout_master_area");
-  success = cfgreadfloat(s, &data->layoutmasterarea_min, "layout_master_area_min");
-  success = cfgreadfloat(s, &data->layoutmasterarea_max, "layout_master_area_max");
-  success = cfgreadfloat(s, &data->layoutmasterarea_step, "layout_master_area_step");
+  success &= cfgreadfloat(s, &data->layoutmasterarea, "layout_master_area");
+  success &= cfgreadfloat(s, &data->layoutmasterarea_min, "layout_master_area_min");
+  success &= cfgreadfloat(s, &data->layoutmasterarea_max, "layout_master_area_max");
+  success &= cfgreadfloat(s, &data->layoutmasterarea_step, "layout_master_area_step");
 
-  success = cfgreadfloat(s, &data->layoutsize_step, "layout_size_step");
-  success = cfgreadfloat(s, &data->layoutsize_min, "layout_size_min");
+  success &= cfgreadfloat(s, &data->layoutsize_step, "layout_size_step");
+  success &= cfgreadfloat(s, &data->layoutsize_min, "layout_size_min");
 
-  success = cfgreadfloat(s, &data->keywinmove_step, "key_win_move_step");
+  success &= cfgreadfloat(s, &data->keywinmove_step, "key_win_move_step");
 
 
-  success = cfgreadint(s, (int32_t*)&data->winlayoutgap, "win_layout_gap");
-  success = cfgreadint(s, (int32_t*)&data->winlayoutgap_max, "win_layout_gap_max");
-  success = cfgreadint(s, (int32_t*)&data->winlayoutgap_step, "win_layout_gap_step");
+  success &= cfgreadint(s, (int32_t*)&data->winlayoutgap, "win_layout_gap");
+  success &= cfgreadint(s, (int32_t*)&data->winlayoutgap_max, "win_layout_gap_max");
+  success &= cfgreadint(s, (int32_t*)&data->winlayoutgap_step, "win_layout_gap_step");
 
   data->initlayout = cfgevallayouttype(s, "initial_layout");
+  success &= data->initlayout != (layout_type_t)-1;
 
-  success = cfgreadint(s, (int32_t*)&data->motion_notify_debounce_fps, "motion_notify_debounce_fps");
-  success = cfgreadbool(s, &data->glvsync, "gl_vsync");
+  // The tab bar of the tabbed layout is 8px high if nothing is specified
+  data->tabbarheight = 8;
+  config_lookup_int(cfghndl, "tab_bar_height", &data->tabbarheight);
 
-  success = cfgreadstr(s, (const char**)&data->cursorimage, "cursor_image");
+  data->hidestrategy = cfgevalhidestrategy(s, "desktop_hide_mode");
+  data->framevisual = cfgevalframevisual(s, "frame_visual");
+  data->resizemode = cfgevalresizemode(s, "resize_mode");
 
-  const char* home = getenv("HOME");
-  const char* relpath = "/.ragnarwm.log";
-  char* logpath = malloc(strlen(home) + strlen(relpath) + 2);
-  sprintf(logpath, "%s%s", home, relpath);
-  data->logfile = logpath;
+  // Watching the config file is optional and disabled by default
+  int32_t watchconfig = 0;
+  config_lookup_bool(cfghndl, "watch_config_file", &watchconfig);
+  data->watchconfig = watchconfig;
 
-  success = cfgreadbool(s, &data->logmessages, "log_messages");
-  success = cfgreadbool(s, &data->shouldlogtofile, "should_log_to_file");
+  success &= cfgreadint(s, (int32_t*)&data->motion_notify_debounce_fps, "motion_notify_debounce_fps");
+  success &= cfgreadbool(s, &data->glvsync, "gl_vsync");
+
+  const char* cursorimage = NULL;
+  success &= cfgreadstr(s, &cursorimage, "cursor_image");
+  data->cursorimage = cursorimage ? strdup(cursorimage) : NULL;
+
+  data->logfile = logfilepath();
+
+  success &= cfgreadbool(s, &data->logmessages, "log_messages");
+  success &= cfgreadbool(s, &data->shouldlogtofile, "should_log_to_file");
 
 
   data->keybinds = cfgevalkeybinds(s, (uint32_t*)&data->numkeybinds, "keybinds");
+  data->rules = cfgevalrules(s, &data->numrules, "rules");
 
-  success = data->keybinds != NULL;
+  success &= validconfig(s, data);
 
-  if(!success) {
-    terminate(s, EXIT_FAILURE);
-  } else {
+  // Only a config that can be applied is cached
+  if(success) {
     printf("ragnar: successfully read config file.\n");
+    writeconfigcache(s, data);
   }
-}
 
-void 
-reloadconfig(state_t* s, config_data_t* data) {
+  // The config owns all of its values, so the parsed file is not needed anymore
   destroyconfig();
+  return success;
+}
 
-  bool using_decoration = s->config.usedecoration;
+/**
+ * @brief Checks the values of a read config that the window manager 
+ * cannot work without. Both the parsed config file and the config 
+ * cache go through this check, so they accept the same configs.
+ *
+ * @param s The window manager's state
+ * @param data The config data to check 
+ *
+ * @return Whether or not the config can be applied
+ */
+bool
+validconfig(state_t* s, const config_data_t* data) {
+  // Missing settings were already reported when they were read
+  if(!data->keybinds || !data->desktopnames || !data->cursorimage) {
+    return false;
+  }
+  /* The per-desktop arrays of every monitor are sized by the number 
+   * of desktops, so a config without desktops or with desktops that 
+   * have no name cannot be applied */
+  if(data->maxdesktops == 0) {
+    logmsg(s, LogLevelError, "config: num_desktops needs to be at least 1.");
+    return false;
+  }
+  if(data->numdesktopnames < data->maxdesktops) {
+    logmsg(s, LogLevelError, "config: desktop_names needs a name for each of the %i desktops.",
+           data->maxdesktops);
+    return false;
+  }
+  if(data->desktopinit >= data->maxdesktops) {
+    logmsg(s, LogLevelError, "config: initial_desktop needs to be less than num_desktops.");
+    return false;
+  }
+  return true;
+}
 
-  initconfig(s);
-  readconfig(s, data);
+void 
+freeconfigdata(config_data_t* data) {
+  if(data->desktopnames) {
+    for(uint32_t i = 0; i < data->numdesktopnames; i++) {
+      free(data->desktopnames[i]);
+    }
+    free(data->desktopnames);
+  }
+  if(data->keybinds) {
+    for(uint32_t i = 0; i < data->numkeybinds; i++) {
+      free((char*)data->keybinds[i].data.cmd);
+      free((char*)data->keybinds[i].wmclass);
+    }
+    free(data->keybinds);
+  }
+  if(data->rules) {
+    for(uint32_t i = 0; i < data->numrules; i++) {
+      free(data->rules[i].wmclass);
+      free(data->rules[i].instance);
+      free(data->rules[i].title);
+      free(data->rules[i].role);
+      free(data->rules[i].type);
+    }
+    free(data->rules);
+  }
+  free(data->logfile);
+  free(data->cursorimage);
+}
 
-  // Load the default root cursor image
-  loaddefaultcursor(s);
+bool 
+strchanged(const char* a, const char* b) {
+  if(!a || !b) return a != b;
+  return strcmp(a, b) != 0;
+}
 
-  // Grab the window manager's keybinds
-  grabkeybinds(s);
+bool 
+keybindschanged(const config_data_t* a, const config_data_t* b) {
+  if(a->numkeybinds != b->numkeybinds) return true;
+  for(uint32_t i = 0; i < a->numkeybinds; i++) {
+    const keybind_t* ka = &a->keybinds[i];
+    const keybind_t* kb = &b->keybinds[i];
+    if(ka->key != kb->key || ka->modmask != kb->modmask || ka->cb != kb->cb ||
+      ka->data.i != kb->data.i || strchanged(ka->data.cmd, kb->data.cmd) ||
+      ka->launch != kb->launch || strchanged(ka->wmclass, kb->wmclass)) {
+      return true;
+    }
+  }
+  return false;
+}
 
-  if(!using_decoration) {
-    s->config.usedecoration = false;
+bool 
+desktopnameschanged(const config_data_t* a, const config_data_t* b) {
+  uint32_t n = MIN(a->maxdesktops, b->maxdesktops);
+  for(uint32_t i = 0; i < n; i++) {
+    if(strchanged(a->desktopnames[i], b->desktopnames[i])) return true;
   }
+  return false;
+}
 
-  // Reload struts 
-  s->nwinstruts = 0;
-  getwinstruts(s, s->root);
+/**
+ * @brief Brings the virtual desktops of every monitor in line with a 
+ * changed number of desktops or desktop names. The layout state 
+ * of desktops that still exist is kept.
+ *
+ * @param s The window manager's state
+ * @param old The configuration that was active before the reload
+ */
+void
+reloaddesktops(state_t* s, const config_data_t* old) {
+  uint32_t lastmaxdesktops = old->maxdesktops;
+  uint32_t maxdesktops = s->config.maxdesktops;
 
-  // Reload desktops
   for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
-    for(uint32_t i = 0; i < s->config.maxdesktops; i++) {
-      mon->layouts[i].nmaster = 1;
-      mon->layouts[i].gapsize = s->config.winlayoutgap;
-      mon->layouts[i].masterarea = MIN(MAX(s->config.layoutmasterarea, 0.0), 1.0);
-      mon->layouts[i].curlayout = s->config.initlayout;
+    // Make room for the client lists, layouts and names of new desktops
+    if(maxdesktops > lastmaxdesktops) {
+      mon->clients = realloc(mon->clients, sizeof(*mon->clients) * maxdesktops);
+      mon->layouts = realloc(mon->layouts, sizeof(*mon->layouts) * maxdesktops);
+      mon->activedesktops = realloc(mon->activedesktops, sizeof(*mon->activedesktops) * maxdesktops);
+      for(uint32_t i = lastmaxdesktops; i < maxdesktops; i++) {
+        mon->clients[i] = (client_list_t){0};
+        mon->layouts[i] = (layout_props_t){
+          .nmaster = 1,
+          .gapsize = s->config.winlayoutgap,
+          .masterarea = MIN(MAX(s->config.layoutmasterarea, 0.0), 1.0),
+          .curlayout = s->config.initlayout,
+          .dirty = true,
+        };
+      }
+      while(mon->desktopcount < maxdesktops) {
+        createdesktop(s, mon->desktopcount, mon);
+        mon->activedesktops[mon->desktopcount - 1].init = true;
+      }
     }
 
-    uint32_t lastdesktopcount = mon->desktopcount;
-    uint32_t curdesktop = mondesktop(s, mon)->idx;
-
-    mon->desktopcount = 0;
-    free(mon->activedesktops);
-    mon->activedesktops = malloc(sizeof(*mon->activedesktops) * s->config.maxdesktops);
-    for(uint32_t i = 0; i < s->config.maxdesktops; i++) {   
-      createdesktop(s, i, mon);
-      mon->activedesktops[i].init = true; 
+    // Rename desktops whose name changed
+    for(uint32_t i = 0; i < MIN(mon->desktopcount, maxdesktops); i++) {
+      if(!strchanged(mon->activedesktops[i].name, s->config.desktopnames[i])) continue;
+      free(mon->activedesktops[i].name);
+      mon->activedesktops[i].name = strdup(s->config.desktopnames[i]);
     }
 
-    uint32_t desktopcount = 0;
-    for(uint32_t i = 0; i < mon->desktopcount; i++) {
-      if(mon->activedesktops[i].init) {
-        desktopcount++;
+    if(maxdesktops < lastmaxdesktops) {
+      // Switch away from the selected desktop if it is removed
+      if(mondesktop(s, mon)->idx >= maxdesktops) {
+        monitor_t* monfocus = s->monfocus;
+        s->monfocus = mon;
+        switchmonitordesktop(s, maxdesktops - 1);
+        s->monfocus = monfocus;
+      }
+
+      // Move the clients of removed desktops onto the last desktop
+      for(uint32_t i = maxdesktops; i < lastmaxdesktops; i++) {
+        while(mon->clients[i].size) {
+          switchclientdesktop(s, mon->clients[i].items[0], maxdesktops - 1);
+        }
+        vector_free(&mon->clients[i]);
+      }
+      for(uint32_t i = maxdesktops; i < mon->desktopcount; i++) {
+        free(mon->activedesktops[i].name);
       }
+      mon->desktopcount = MIN(mon->desktopcount, maxdesktops);
+      mon->clients = realloc(mon->clients, sizeof(*mon->clients) * maxdesktops);
+      mon->layouts = realloc(mon->layouts, sizeof(*mon->layouts) * maxdesktops);
+    }
+  }
+
+  uint32_t desktopcount = 0;
+  for(uint32_t i = 0; i < s->monfocus->desktopcount; i++) {
+    if(s->monfocus->activedesktops[i].init) {
+      desktopcount++;
+    }
+  }
+  xchangeproperty(s, XCB_PROP_MODE_REPLACE, s->root, s->ewmh_atoms[EWMHnumberOfDesktops],
+                  XCB_ATOM_CARDINAL, 32, 1, &desktopcount);
+  uploaddesktopnames(s, s->monfocus);
+}
+
+/**
+ * @brief Resizes the scratchpad slots to a changed number of 
+ * scratchpads. Running scratchpads in slots that still exist are kept.
+ *
+ * @param s The window manager's state
+ * @param old The configuration that was active before the reload
+ */
+void
+reloadscratchpads(state_t* s, const config_data_t* old) {
+  // Scratchpads in removed slots become regular windows
+  for(uint32_t i = s->config.maxscratchpads; i < old->maxscratchpads; i++) {
+    if(s->scratchpads[i].win == 0) continue;
+    client_t* cl = clientfromwin(s, s->scratchpads[i].win);
+    if(cl) {
+      cl->is_scratchpad = false;
+      cl->scratchpad_index = -1;
     }
-    xcb_change_property(s->con, XCB_PROP_MODE_REPLACE, s->root, s->ewmh_atoms[EWMHnumberOfDesktops],
-                        XCB_ATOM_CARDINAL, 32, 1, &desktopcount);
-    uploaddesktopnames(s, mon);
+  }
+
+  s->scratchpads = realloc(s->scratchpads, sizeof(*s->scratchpads) * s->config.maxscratchpads);
+
+  for(uint32_t i = old->maxscratchpads; i < s->config.maxscratchpads; i++) {
+    s->scratchpads[i] = (scratchpad_t){
+      .hidden = true,
+      .needs_restart = true,
+    };
+  }
+}
+
+/**
+ * @brief Applies the differences between the previous configuration 
+ * and the current configuration (s->config) to the window manager.
+ *
+ * @param s The window manager's state
+ * @param old The configuration that was active before the reload
+ */
+void
+applyconfig(state_t* s, const config_data_t* old) {
+  bool relayout = false;
+
+  // Decoration cannot be enabled at runtime
+  if(!old->usedecoration) {
+    s->config.usedecoration = false;
+  }
+
+  // Existing frames keep their visual, so it cannot be changed at runtime
+  s->config.framevisual = old->framevisual;
 
-    if(lastdesktopcount > mon->desktopcount) {
-      if(curdesktop > mon->desktopcount) {
-        switchdesktop(s, (passthrough_data_t){.i = mon->desktopcount - 1});
+  if(keybindschanged(old, &s->config)) {
+    grabkeybinds(s);
+  }
+
+  if(strchanged(old->cursorimage, s->config.cursorimage)) {
+    loaddefaultcursor(s);
+  }
+
+  if(old->maxstruts != s->config.maxstruts) {
+    s->winstruts = realloc(s->winstruts, sizeof(*s->winstruts) * s->config.maxstruts);
+    s->nwinstruts = 0;
+    getwinstruts(s, s->root);
+    relayout = true;
+  }
+
+  if(old->maxdesktops != s->config.maxdesktops || desktopnameschanged(old, &s->config)) {
+    reloaddesktops(s, old);
+    relayout = true;
+  }
+
+  // Apply changed layout defaults to desktops that still use the old default
+  if(old->winlayoutgap != s->config.winlayoutgap || 
+    old->layoutmasterarea != s->config.layoutmasterarea) {
+    float lastmasterarea = MIN(MAX(old->layoutmasterarea, 0.0), 1.0);
+    uint32_t n = MIN(old->maxdesktops, s->config.maxdesktops);
+    for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
+      for(uint32_t i = 0; i < n; i++) {
+        if(mon->layouts[i].gapsize == old->winlayoutgap) {
+          mon->layouts[i].gapsize = s->config.winlayoutgap;
+        }
+        if(mon->layouts[i].masterarea == lastmasterarea) {
+          mon->layouts[i].masterarea = MIN(MAX(s->config.layoutmasterarea, 0.0), 1.0);
+        }
       }
-      for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
-        for(client_t* cl = mon->clients; cl != NULL; cl = cl->next) {
-          if(cl->mon == mon && cl->desktop >= s->config.maxdesktops) {
-            switchclientdesktop(s, cl, s->config.maxdesktops - 1);
+    }
+    relayout = true;
+  }
+
+  if(old->maxscratchpads != s->config.maxscratchpads) {
+    reloadscratchpads(s, old);
+  }
+
+  // The tab bars are redrawn with the new colors or height
+  if(old->tabbarheight != s->config.tabbarheight || 
+    old->winbordercolor != s->config.winbordercolor ||
+    old->winbordercolor_selected != s->config.winbordercolor_selected) {
+    for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
+      mon->tabbar.dirty = true;
+    }
+    relayout = true;
+  }
+
+  bool borderwidthchanged = old->winborderwidth != s->config.winborderwidth;
+  bool bordercolorchanged = old->winbordercolor != s->config.winbordercolor ||
+    old->winbordercolor_selected != s->config.winbordercolor_selected;
+  if(borderwidthchanged || bordercolorchanged) {
+    for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
+      for(uint32_t i = 0; i < s->config.maxdesktops; i++) {
+        for(uint32_t j = 0; j < mon->clients[i].size; j++) {
+          client_t* cl = mon->clients[i].items[j];
+          if(cl->fullscreen) continue;
+          if(borderwidthchanged) {
+            setborderwidth(s, cl, s->config.winborderwidth);
+          }
+          if(bordercolorchanged) {
+            setbordercolor(s, cl, cl == s->focus ? 
+                           s->config.winbordercolor_selected : s->config.winbordercolor);
           }
         }
       }
     }
+    relayout |= borderwidthchanged;
   }
 
-  s->scratchpads = realloc(s->scratchpads, sizeof(*s->scratchpads) * s->config.maxscratchpads);
+  if(old->watchconfig != s->config.watchconfig) {
+    watchconfig(s, s->config.watchconfig);
+  }
 
-  for(uint32_t i = 0; i < s->config.maxscratchpads; i++) {
-    if(s->scratchpads[i].win != 0) {
-      xcb_unmap_window(s->con, s->scratchpads[i].win);
-      s->scratchpads[i].win = 0;
-      s->scratchpads[i].hidden = true;
-      s->scratchpads[i].needs_restart = true;
+  // The rules only apply to windows that are mapped from now on
+  compilerules(s);
+
+  // Only the visible desktops are layed out now, the others once they are shown
+  if(relayout) {
+    invalidatelayouts(s);
+    for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
+      makelayout(s, mon);
     }
   }
 
-  s->mapping_scratchpad_index = -1;
+  xflush(s);
+}
 
-  for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
-    for(client_t* cl = mon->clients; cl != NULL; cl = cl->next) {
-      setbordercolor(s, cl, s->config.winbordercolor);
-      setborderwidth(s, cl, s->config.winborderwidth);
+void 
+reloadconfig(state_t* s, config_data_t* data) {
+  /* The current config owns all of its values so it stays valid 
+   * while the new one is read and compared against it */
+  config_data_t newdata = {0};
+  if(!initconfig(s) || !readconfig(s, &newdata)) {
+    freeconfigdata(&newdata);
+    destroyconfig();
+    logmsg(s, LogLevelError, "config: failed to reload, keeping the current configuration.");
+    return;
+  }
+
+  config_data_t olddata = *data;
+  *data = newdata;
+
+  applyconfig(s, &olddata);
+
+  freeconfigdata(&olddata);
+
+  logmsg(s, LogLevelTrace, "config: reloaded configuration.");
+}
+
+void
+watchconfig(state_t* s, bool watch) {
+  if(s->cfgwatchfd != -1) {
+    close(s->cfgwatchfd);
+    s->cfgwatchfd = -1;
+  }
+  s->cfgreloaddue = 0;
+  if(!watch || !cfgpath) return;
+
+  s->cfgwatchfd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if(s->cfgwatchfd == -1) {
+    logmsg(s, LogLevelError, "config: failed to initialize inotify.");
+    return;
+  }
+
+  /* Watch the directory of the config file instead of the file itself 
+   * as editors commonly save by replacing the file. */
+  char* dir = strdup(cfgpath);
+  char* slash = strrchr(dir, '/');
+  if(slash) *slash = '\0';
+
+  if(inotify_add_watch(s->cfgwatchfd, slash ? dir : ".", 
+                       IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) == -1) {
+    logmsg(s, LogLevelError, "config: failed to watch %s.", cfgpath);
+    close(s->cfgwatchfd);
+    s->cfgwatchfd = -1;
+  } else {
+    logmsg(s, LogLevelTrace, "config: watching %s for changes.", cfgpath);
+  }
+  free(dir);
+}
+
+void
+handleconfigwatch(state_t* s) {
+  if(s->cfgwatchfd == -1) return;
+
+  const char* filename = strrchr(cfgpath, '/');
+  filename = filename ? filename + 1 : cfgpath;
+
+  char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+  ssize_t len;
+  bool changed = false;
+  while((len = read(s->cfgwatchfd, buf, sizeof(buf))) > 0) {
+    for(char* ptr = buf; ptr < buf + len; ) {
+      const struct inotify_event* ev = (const struct inotify_event*)ptr;
+      if(ev->len && strcmp(ev->name, filename) == 0) {
+        changed = true;
+      }
+      ptr += sizeof(struct inotify_event) + ev->len;
     }
   }
 
-  for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
-    makelayout(s, mon);
+  // Wait for the file to settle before reloading it 
+  if(changed) {
+    s->cfgreloaddue = monotonicms() + CFG_WATCH_DEBOUNCE_MS;
   }
+}
+
+int32_t
+configreloadtimeout(state_t* s) {
+  if(!s->cfgreloaddue) return -1;
+  uint64_t now = monotonicms();
+  return now >= s->cfgreloaddue ? 0 : (int32_t)(s->cfgreloaddue - now);
+}
 
-  xcb_flush(s->con);
+void
+reloadwatchedconfig(state_t* s) {
+  if(!s->cfgreloaddue || monotonicms() < s->cfgreloaddue) return;
+  s->cfgreloaddue = 0;
+  logmsg(s, LogLevelTrace, "config: config file changed, reloading.");
+  reloadconfig(s, &s->config);
 }
 
 void 
 destroyconfig(void) {
-  config_destroy(&cfghndl);
+  if(cfghndl) {
+    config_destroy(cfghndl);
+    cfghndl = NULL;
+  }
+  if(cfgcache) {
+    munmap((void*)cfgcache, cfgcachesize);
+    cfgcache = NULL;
+    cfgcachesize = 0;
+  }
+}
+
+bool
+hashfile(const char* path, uint64_t* hash, struct stat* st) {
+  int32_t fd = open(path, O_RDONLY | O_CLOEXEC);
+  if(fd == -1) return false;
+
+  if(fstat(fd, st) != 0) {
+    close(fd);
+    return false;
+  }
+
+  *hash = hashbytes(NULL, 0);
+  if(st->st_size > 0) {
+    void* map = mmap(NULL, st->st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(map == MAP_FAILED) {
+      close(fd);
+      return false;
+    }
+    *hash = hashbytes(map, st->st_size);
+    munmap(map, st->st_size);
+  }
+  close(fd);
+  return true;
+}
+
+char*
+cfgcachepath(void) {
+  char* path = NULL;
+  const char* cachehome = getenv("XDG_CACHE_HOME");
+  const char* home = getenv("HOME");
+  if(cachehome && *cachehome) {
+    asprintf(&path, "%s/ragnarwm/ragnar.cfg.cache", cachehome);
+  } else if(home) {
+    asprintf(&path, "%s/.cache/ragnarwm/ragnar.cfg.cache", home);
+  }
+  return path;
+}
+
+/**
+ * @brief Maps the config cache into memory if it was compiled 
+ * from the current contents of a given config file.
+ *
+ * @param s The window manager's state
+ * @param path The path of the config file 
+ *
+ * @return Whether or not an up to date cache was mapped
+ */
+bool
+mapconfigcache(state_t* s, const char* path) {
+  struct stat src;
+  if(stat(path, &src) != 0) return false;
+
+  char* cachepath = cfgcachepath();
+  if(!cachepath) return false;
+  int32_t fd = open(cachepath, O_RDONLY | O_CLOEXEC);
+  free(cachepath);
+  if(fd == -1) return false;
+
+  struct stat st;
+  if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(cfg_cache_header_t)) {
+    close(fd);
+    return false;
+  }
+  void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(map == MAP_FAILED) return false;
+
+  const cfg_cache_header_t* hdr = map;
+  uint64_t size = sizeof(*hdr) + 
+    (uint64_t)hdr->numkeybinds * sizeof(cfg_cache_keybind_t) + 
+    (uint64_t)hdr->numrules * sizeof(cfg_cache_rule_t) + 
+    (uint64_t)hdr->numdesktopnames * sizeof(uint32_t) + 
+    hdr->strtabsize;
+  const char* strtab = (const char*)map + st.st_size - hdr->strtabsize;
+
+  bool valid = 
+    hdr->magic == CFG_CACHE_MAGIC && hdr->version == CFG_CACHE_VERSION &&
+    hdr->datasize == sizeof(config_data_t) && 
+    hdr->numkeymappings == ARRLEN(keymappings) && 
+    hdr->numkeycbmappings == ARRLEN(keycbmappings) &&
+    hdr->buildid == cachebuildid() &&
+    hdr->srcmtime_sec == (int64_t)src.st_mtim.tv_sec && 
+    hdr->srcmtime_nsec == (int64_t)src.st_mtim.tv_nsec &&
+    hdr->srcsize == (uint64_t)src.st_size && 
+    size == (uint64_t)st.st_size &&
+    hdr->strtabsize && strtab[hdr->strtabsize - 1] == '\0' &&
+    hdr->srcpath < hdr->strtabsize && strcmp(strtab + hdr->srcpath, path) == 0;
+
+  // Only hash the config file if everything else matches
+  uint64_t hash;
+  if(!valid || !hashfile(path, &hash, &src) || hash != hdr->srchash) {
+    munmap(map, st.st_size);
+    return false;
+  }
+
+  cfgcache = map;
+  cfgcachesize = st.st_size;
+  logmsg(s, LogLevelTrace, "config: using cached config for %s.", path);
+  return true;
+}
+
+char*
+cachestrdup(const char* strtab, uint32_t strtabsize, uint32_t offset) {
+  if(offset == CFG_CACHE_NOSTR || offset >= strtabsize) return NULL;
+  return strdup(strtab + offset);
+}
+
+/**
+ * @brief Reads the config from the mapped config cache.
+ *
+ * @param s The window manager's state
+ * @param data The config data to fill 
+ *
+ * @return Whether or not the config was read successfully
+ */
+bool
+readconfigcache(state_t* s, config_data_t* data) {
+  const cfg_cache_header_t* hdr = (const cfg_cache_header_t*)cfgcache;
+  const cfg_cache_keybind_t* keybinds = (const cfg_cache_keybind_t*)(hdr + 1);
+  const cfg_cache_rule_t* rules = (const cfg_cache_rule_t*)(keybinds + hdr->numkeybinds);
+  const uint32_t* desktopnames = (const uint32_t*)(rules + hdr->numrules);
+  const char* strtab = (const char*)(desktopnames + hdr->numdesktopnames);
+
+  // Numeric settings are read directly, strings are copied out of the cache
+  *data = hdr->data;
+  data->numkeybinds = hdr->numkeybinds;
+  data->numrules = hdr->numrules;
+  data->numdesktopnames = hdr->numdesktopnames;
+
+  data->desktopnames = calloc(hdr->numdesktopnames, sizeof(char*));
+  for(uint32_t i = 0; i < hdr->numdesktopnames; i++) {
+    data->desktopnames[i] = cachestrdup(strtab, hdr->strtabsize, desktopnames[i]);
+  }
+
+  data->keybinds = calloc(hdr->numkeybinds, sizeof(keybind_t));
+  for(uint32_t i = 0; i < hdr->numkeybinds; i++) {
+    const cfg_cache_keybind_t* kb = &keybinds[i];
+    data->keybinds[i] = (keybind_t){
+      .cb = kb->cb < ARRLEN(keycbmappings) ? keycbmappings[kb->cb].cb : NULL,
+      .key = kb->key,
+      .data = (passthrough_data_t){
+        .i = kb->i,
+        .cmd = cachestrdup(strtab, hdr->strtabsize, kb->cmd)
+      },
+      .modmask = kb->modmask,
+      .wmclass = cachestrdup(strtab, hdr->strtabsize, kb->wmclass),
+      .launch = (scratchpad_launch_t)kb->launch
+    };
+  }
+
+  data->rules = calloc(hdr->numrules, sizeof(window_rule_t));
+  for(uint32_t i = 0; i < hdr->numrules; i++) {
+    const cfg_cache_rule_t* rule = &rules[i];
+    data->rules[i] = (window_rule_t){
+      .wmclass = cachestrdup(strtab, hdr->strtabsize, rule->wmclass),
+      .instance = cachestrdup(strtab, hdr->strtabsize, rule->instance),
+      .title = cachestrdup(strtab, hdr->strtabsize, rule->title),
+      .role = cachestrdup(strtab, hdr->strtabsize, rule->role),
+      .type = cachestrdup(strtab, hdr->strtabsize, rule->type),
+      .desktop = rule->desktop,
+      .monitor = rule->monitor,
+      .floating = rule->floating,
+      .fullscreen = rule->fullscreen,
+      .hasgeometry = rule->hasgeometry,
+      .geometry = rule->geometry
+    };
+  }
+
+  data->cursorimage = cachestrdup(strtab, hdr->strtabsize, hdr->cursorimage);
+  data->logfile = logfilepath();
+
+  if(!validconfig(s, data)) {
+    logmsg(s, LogLevelError, "config: the config cache is invalid.");
+    return false;
+  }
+  return true;
+}
+
+uint32_t
+cacheaddstr(char** strtab, uint32_t* strtabsize, const char* str) {
+  if(!str) return CFG_CACHE_NOSTR;
+  uint32_t offset = *strtabsize;
+  uint32_t len = strlen(str) + 1;
+  *strtab = realloc(*strtab, *strtabsize + len);
+  memcpy(*strtab + offset, str, len);
+  *strtabsize += len;
+  return offset;
+}
+
+bool
+writeall(int32_t fd, const void* data, size_t len) {
+  const uint8_t* ptr = data;
+  while(len) {
+    ssize_t written = write(fd, ptr, len);
+    if(written <= 0) return false;
+    ptr += written;
+    len -= written;
+  }
+  return true;
+}
+
+/**
+ * @brief Compiles a successfully read config into the config cache 
+ * so that the config file does not need to be parsed on the next start.
+ *
+ * @param s The window manager's state
+ * @param data The config data that was read from the config file 
+ */
+void
+writeconfigcache(state_t* s, const config_data_t* data) {
+  char* cachepath = cfgcachepath();
+  if(!cachepath || !cfgpath) {
+    free(cachepath);
+    return;
+  }
+
+  char* strtab = NULL;
+  uint32_t strtabsize = 0;
+
+  cfg_cache_header_t hdr;
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.magic = CFG_CACHE_MAGIC;
+  hdr.version = CFG_CACHE_VERSION;
+  hdr.datasize = sizeof(config_data_t);
+  hdr.numkeymappings = ARRLEN(keymappings);
+  hdr.numkeycbmappings = ARRLEN(keycbmappings);
+  hdr.buildid = cachebuildid();
+  hdr.srcmtime_sec = cfgsrcstat.st_mtim.tv_sec;
+  hdr.srcmtime_nsec = cfgsrcstat.st_mtim.tv_nsec;
+  hdr.srcsize = cfgsrcstat.st_size;
+  hdr.srchash = cfgsrchash;
+  hdr.srcpath = cacheaddstr(&strtab, &strtabsize, cfgpath);
+  hdr.numkeybinds = data->numkeybinds;
+  hdr.numrules = data->numrules;
+  hdr.numdesktopnames = data->numdesktopnames;
+  hdr.cursorimage = cacheaddstr(&strtab, &strtabsize, data->cursorimage);
+  hdr.data = *data;
+  hdr.data.desktopnames = NULL;
+  hdr.data.keybinds = NULL;
+  hdr.data.rules = NULL;
+  hdr.data.logfile = NULL;
+  hdr.data.cursorimage = NULL;
+
+  cfg_cache_keybind_t* keybinds = calloc(data->numkeybinds, sizeof(*keybinds));
+  for(uint32_t i = 0; i < data->numkeybinds; i++) {
+    const keybind_t* kb = &data->keybinds[i];
+    keybinds[i].modmask = kb->modmask;
+    keybinds[i].key = kb->key;
+    keybinds[i].i = kb->data.i;
+    keybinds[i].cmd = cacheaddstr(&strtab, &strtabsize, kb->data.cmd);
+    keybinds[i].wmclass = cacheaddstr(&strtab, &strtabsize, kb->wmclass);
+    keybinds[i].launch = kb->launch;
+    keybinds[i].cb = CFG_CACHE_NOSTR;
+    for(uint32_t j = 0; j < ARRLEN(keycbmappings); j++) {
+      if(keycbmappings[j].cb == kb->cb) {
+        keybinds[i].cb = j;
+        break;
+      }
+    }
+  }
+
+  cfg_cache_rule_t* rules = calloc(data->numrules, sizeof(*rules));
+  for(uint32_t i = 0; i < data->numrules; i++) {
+    const window_rule_t* rule = &data->rules[i];
+    rules[i] = (cfg_cache_rule_t){
+      .wmclass = cacheaddstr(&strtab, &strtabsize, rule->wmclass),
+      .instance = cacheaddstr(&strtab, &strtabsize, rule->instance),
+      .title = cacheaddstr(&strtab, &strtabsize, rule->title),
+      .role = cacheaddstr(&strtab, &strtabsize, rule->role),
+      .type = cacheaddstr(&strtab, &strtabsize, rule->type),
+      .desktop = rule->desktop,
+      .monitor = rule->monitor,
+      .floating = rule->floating,
+      .fullscreen = rule->fullscreen,
+      .hasgeometry = rule->hasgeometry,
+      .geometry = rule->geometry
+    };
+  }
+
+  uint32_t* desktopnames = calloc(data->numdesktopnames, sizeof(*desktopnames));
+  for(uint32_t i = 0; i < data->numdesktopnames; i++) {
+    desktopnames[i] = cacheaddstr(&strtab, &strtabsize, data->desktopnames[i]);
+  }
+  hdr.strtabsize = strtabsize;
+
+  /* Create the cache directory and its parents in a copy of the 
+   * path, so the path of the cache itself is never modified */
+  char* dir = strdup(cachepath);
+  for(size_t i = 1; dir && dir[i]; i++) {
+    if(dir[i] != '/') continue;
+    dir[i] = '\0';
+    mkdir(dir, 0755);
+    dir[i] = '/';
+  }
+  free(dir);
+
+  // Write to a temporary file first so that the cache is replaced atomically
+  char* tmppath = NULL;
+  asprintf(&tmppath, "%s.tmp", cachepath);
+  int32_t fd = open(tmppath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  bool success = fd != -1 &&
+    writeall(fd, &hdr, sizeof(hdr)) &&
+    writeall(fd, keybinds, sizeof(*keybinds) * data->numkeybinds) &&
+    writeall(fd, rules, sizeof(*rules) * data->numrules) &&
+    writeall(fd, desktopnames, sizeof(*desktopnames) * data->numdesktopnames) &&
+    writeall(fd, strtab, strtabsize);
+  if(fd != -1) close(fd);
+
+  if(success && rename(tmppath, cachepath) == 0) {
+    logmsg(s, LogLevelTrace, "config: wrote config cache to %s.", cachepath);
+  } else {
+    logmsg(s, LogLevelWarn, "config: failed to write config cache to %s.", cachepath);
+    unlink(tmppath);
+  }
+
+  free(tmppath);
+  free(keybinds);
+  free(rules);
+  free(desktopnames);
+  free(strtab);
+  free(cachepath);
 }
@@ -2,7 +2,17 @@
 
 #include "structs.h"
 
-void initconfig(state_t* s);
-void readconfig(state_t* s, config_data_t* data);
+/* Time the config file needs to stay unchanged before it is reloaded */
+#define CFG_WATCH_DEBOUNCE_MS 150
+
+bool initconfig(state_t* s);
+bool readconfig(state_t* s, config_data_t* data);
 void reloadconfig(state_t* s, config_data_t* data);
 void destroyconfig(void);
+
+const char* keysymtostr(xcb_keysym_t keysym);
+
+void watchconfig(state_t* s, bool watch);
+void handleconfigwatch(state_t* s);
+int32_t configreloadtimeout(state_t* s);
+void reloadwatchedconfig(state_t* s);
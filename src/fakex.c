@@ -0,0 +1,945 @@
+#include "fakex.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* IDs of the modeled windows start here so that they look like XIDs */
+#define FAKEX_ID_BASE 0x200000
+#define FAKEX_INIT_CAP 64
+/* Depth reported for every window */
+#define FAKEX_DEPTH 24
+/* Visual and colormap of the root window */
+#define FAKEX_VISUAL 0x21
+#define FAKEX_COLORMAP 0x20
+/* Interned atoms follow the predefined ones */
+#define FAKEX_ATOM_BASE (XCB_ATOM_WM_TRANSIENT_FOR + 1)
+
+static fake_window_t* findwin(const fake_x_t* fx, xcb_window_t win);
+static uint32_t newid(fake_x_t* fx);
+static void setattributes(fake_window_t* w, uint32_t mask, const void* values);
+static uint32_t addreply(fake_x_t* fx, void* reply);
+static void* takereply(fake_x_t* fx, uint32_t sequence);
+static fake_property_t* findprop(fake_window_t* w, xcb_atom_t atom);
+static void removeprop(fake_window_t* w, xcb_atom_t atom);
+static bool viewable(const fake_x_t* fx, const fake_window_t* w);
+static v2_t abspos(const fake_x_t* fx, const fake_window_t* w);
+static int cmpstack(const void* a, const void* b);
+
+static void fakeconfigurewindow(void* ctx, xcb_window_t win, uint16_t mask, const void* values);
+static void fakechangewindowattributes(void* ctx, xcb_window_t win, uint32_t mask, const void* values);
+static void fakemapwindow(void* ctx, xcb_window_t win);
+static void fakeunmapwindow(void* ctx, xcb_window_t win);
+static void fakedestroywindow(void* ctx, xcb_window_t win);
+static void fakechangeproperty(void* ctx, uint8_t mode, xcb_window_t win, xcb_atom_t prop,
+                               xcb_atom_t type, uint8_t format, uint32_t len, const void* data);
+static void fakedeleteproperty(void* ctx, xcb_window_t win, xcb_atom_t prop);
+static void fakesetinputfocus(void* ctx, uint8_t revertto, xcb_window_t win, xcb_timestamp_t time);
+static void fakesendevent(void* ctx, uint8_t propagate, xcb_window_t dest, uint32_t mask, const char* ev);
+static void fakeflush(void* ctx);
+static void fakecreatewindow(void* ctx, uint8_t depth, xcb_window_t win, xcb_window_t parent,
+                             int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t borderwidth,
+                             uint16_t class, xcb_visualid_t visual, uint32_t mask, const void* values);
+static void fakereparentwindow(void* ctx, xcb_window_t win, xcb_window_t parent, int16_t x, int16_t y);
+static void fakecleararea(void* ctx, uint8_t exposures, xcb_window_t win, 
+                          int16_t x, int16_t y, uint16_t w, uint16_t h);
+static void fakecreatecolormap(void* ctx, uint8_t alloc, xcb_colormap_t cmap, 
+                               xcb_window_t win, xcb_visualid_t visual);
+static void fakefreecolormap(void* ctx, xcb_colormap_t cmap);
+static void fakefreecursor(void* ctx, xcb_cursor_t cursor);
+static void fakegrabbutton(void* ctx, uint8_t ownerevents, xcb_window_t win, uint16_t evmask, 
+                           uint8_t pointermode, uint8_t keyboardmode, xcb_window_t confineto, 
+                           xcb_cursor_t cursor, uint8_t button, uint16_t modifiers);
+static void fakeungrabbutton(void* ctx, uint8_t button, xcb_window_t win, uint16_t modifiers);
+static void fakegrabkey(void* ctx, uint8_t ownerevents, xcb_window_t win, uint16_t modifiers, 
+                        xcb_keycode_t key, uint8_t pointermode, uint8_t keyboardmode);
+static void fakeungrabkey(void* ctx, xcb_keycode_t key, xcb_window_t win, uint16_t modifiers);
+static void fakeallowevents(void* ctx, uint8_t mode, xcb_timestamp_t time);
+static void fakewarppointer(void* ctx, xcb_window_t srcwin, xcb_window_t dstwin, 
+                            int16_t srcx, int16_t srcy, uint16_t srcw, uint16_t srch, 
+                            int16_t dstx, int16_t dsty);
+static void fakegrabserver(void* ctx);
+static void fakesetclosedownmode(void* ctx, uint8_t mode);
+static void fakekillclient(void* ctx, uint32_t resource);
+static void fakealarm(void* ctx, xcb_sync_alarm_t alarm, uint32_t mask, const void* values);
+static void fakedestroyalarm(void* ctx, xcb_sync_alarm_t alarm);
+static uint32_t fakegenerateid(void* ctx);
+static xcb_cursor_t fakeloadcursor(void* ctx, xcb_screen_t* screen, const char* name);
+static bool fakechangewindowattributeschecked(void* ctx, xcb_window_t win, uint32_t mask, const void* values);
+static xcb_get_property_reply_t* fakegetproperty(void* ctx, uint8_t del, xcb_window_t win, xcb_atom_t prop,
+                                                 xcb_atom_t type, uint32_t offset, uint32_t len);
+static xcb_get_geometry_reply_t* fakegetgeometry(void* ctx, xcb_drawable_t drawable);
+static xcb_get_window_attributes_reply_t* fakegetwindowattributes(void* ctx, xcb_window_t win);
+static xcb_query_pointer_reply_t* fakequerypointer(void* ctx, xcb_window_t win);
+static xcb_query_tree_reply_t* fakequerytree(void* ctx, xcb_window_t win);
+static xcb_intern_atom_reply_t* fakeinternatom(void* ctx, uint8_t onlyifexists, uint16_t len, const char* name);
+static xcb_get_selection_owner_reply_t* fakegetselectionowner(void* ctx, xcb_atom_t selection);
+static xcb_sync_query_counter_reply_t* fakequerycounter(void* ctx, xcb_sync_counter_t counter);
+static xcb_randr_get_monitors_reply_t* fakegetmonitors(void* ctx, xcb_window_t win, uint8_t active);
+static xcb_keysym_t fakegetkeysym(void* ctx, xcb_keycode_t keycode);
+static xcb_keycode_t* fakegetkeycodes(void* ctx, xcb_keysym_t keysym);
+static xcb_get_property_cookie_t fakegetpropertyrequest(void* ctx, uint8_t del, xcb_window_t win, xcb_atom_t prop,
+                                                        xcb_atom_t type, uint32_t offset, uint32_t len);
+static xcb_get_property_reply_t* fakegetpropertyreply(void* ctx, xcb_get_property_cookie_t cookie);
+static xcb_query_tree_cookie_t fakequerytreerequest(void* ctx, xcb_window_t win);
+static xcb_query_tree_reply_t* fakequerytreereply(void* ctx, xcb_query_tree_cookie_t cookie);
+
+const x_backend_t fakexbackend = {
+  .configurewindow        = fakeconfigurewindow,
+  .changewindowattributes = fakechangewindowattributes,
+  .mapwindow              = fakemapwindow,
+  .unmapwindow            = fakeunmapwindow,
+  .destroywindow          = fakedestroywindow,
+  .changeproperty         = fakechangeproperty,
+  .deleteproperty         = fakedeleteproperty,
+  .setinputfocus          = fakesetinputfocus,
+  .sendevent              = fakesendevent,
+  .flush                  = fakeflush,
+  .createwindow           = fakecreatewindow,
+  .reparentwindow         = fakereparentwindow,
+  .cleararea              = fakecleararea,
+  .createcolormap         = fakecreatecolormap,
+  .freecolormap           = fakefreecolormap,
+  .freecursor             = fakefreecursor,
+  .grabbutton             = fakegrabbutton,
+  .ungrabbutton           = fakeungrabbutton,
+  .grabkey                = fakegrabkey,
+  .ungrabkey              = fakeungrabkey,
+  .allowevents            = fakeallowevents,
+  .warppointer            = fakewarppointer,
+  .grabserver             = fakegrabserver,
+  .ungrabserver           = fakegrabserver,
+  .setclosedownmode       = fakesetclosedownmode,
+  .killclient             = fakekillclient,
+  .createalarm            = fakealarm,
+  .changealarm            = fakealarm,
+  .destroyalarm           = fakedestroyalarm,
+  .generateid             = fakegenerateid,
+  .loadcursor             = fakeloadcursor,
+  .changewindowattributeschecked = fakechangewindowattributeschecked,
+  .getproperty            = fakegetproperty,
+  .getgeometry            = fakegetgeometry,
+  .getwindowattributes    = fakegetwindowattributes,
+  .querypointer           = fakequerypointer,
+  .querytree              = fakequerytree,
+  .internatom             = fakeinternatom,
+  .getselectionowner      = fakegetselectionowner,
+  .querycounter           = fakequerycounter,
+  .getmonitors            = fakegetmonitors,
+  .getkeysym              = fakegetkeysym,
+  .getkeycodes            = fakegetkeycodes,
+  .getpropertyrequest     = fakegetpropertyrequest,
+  .getpropertyreply       = fakegetpropertyreply,
+  .querytreerequest       = fakequerytreerequest,
+  .querytreereply         = fakequerytreereply,
+};
+
+/* Returns the window with the given ID or NULL if there is none
+ * (where an X server would fail the request with BadWindow) */
+fake_window_t*
+findwin(const fake_x_t* fx, xcb_window_t win) {
+  if(win < FAKEX_ID_BASE || win - FAKEX_ID_BASE >= fx->numwins) return NULL;
+  fake_window_t* w = &fx->wins[win - FAKEX_ID_BASE];
+  return w->id != XCB_NONE ? w : NULL;
+}
+
+/* Takes the slot of a new resource, which is a window once it is created */
+uint32_t
+newid(fake_x_t* fx) {
+  if(fx->numwins == fx->cap) {
+    fake_window_t* wins = realloc(fx->wins, fx->cap * 2 * sizeof(*wins));
+    if(!wins) return XCB_NONE;
+    fx->wins = wins;
+    fx->cap *= 2;
+  }
+  fx->wins[fx->numwins] = (fake_window_t){0};
+  return FAKEX_ID_BASE + fx->numwins++;
+}
+
+void
+setattributes(fake_window_t* w, uint32_t mask, const void* values) {
+  // The values are given in the order of the bits of the mask
+  const uint32_t* val = values;
+  for(uint32_t bit = 1; bit <= XCB_CW_CURSOR; bit <<= 1) {
+    if(!(mask & bit)) continue;
+    if(bit == XCB_CW_BORDER_PIXEL)      w->borderpixel = *val;
+    if(bit == XCB_CW_OVERRIDE_REDIRECT) w->overrideredirect = *val;
+    if(bit == XCB_CW_EVENT_MASK)        w->eventmask = *val;
+    val++;
+  }
+}
+
+/* Keeps the reply of a pipelined request and returns the sequence of its cookie */
+uint32_t
+addreply(fake_x_t* fx, void* reply) {
+  uint32_t i = 0;
+  while(i < fx->numreplies && fx->replies[i].pending) {
+    i++;
+  }
+  if(i == fx->numreplies) {
+    fake_reply_t* replies = realloc(fx->replies, (fx->numreplies + 1) * sizeof(*replies));
+    if(!replies) {
+      free(reply);
+      return 0;
+    }
+    fx->replies = replies;
+    fx->numreplies++;
+  }
+  fx->replies[i] = (fake_reply_t){ .reply = reply, .pending = true };
+  return i + 1;
+}
+
+void*
+takereply(fake_x_t* fx, uint32_t sequence) {
+  if(sequence == 0 || sequence > fx->numreplies || !fx->replies[sequence - 1].pending) return NULL;
+  fx->replies[sequence - 1].pending = false;
+  return fx->replies[sequence - 1].reply;
+}
+
+fake_property_t*
+findprop(fake_window_t* w, xcb_atom_t atom) {
+  for(uint32_t i = 0; i < w->numprops; i++) {
+    if(w->props[i].atom == atom) return &w->props[i];
+  }
+  return NULL;
+}
+
+void
+removeprop(fake_window_t* w, xcb_atom_t atom) {
+  fake_property_t* prop = findprop(w, atom);
+  if(!prop) return;
+  free(prop->data);
+  *prop = w->props[--w->numprops];
+}
+
+/* Whether the window and all of its ancestors are mapped */
+bool
+viewable(const fake_x_t* fx, const fake_window_t* w) {
+  for(; w; w = findwin(fx, w->parent)) {
+    if(!w->mapped) return false;
+  }
+  return true;
+}
+
+/* Position of the window relative to the root window */
+v2_t
+abspos(const fake_x_t* fx, const fake_window_t* w) {
+  v2_t pos = {0};
+  for(; w && w->parent != XCB_NONE; w = findwin(fx, w->parent)) {
+    pos.x += w->x + w->borderwidth;
+    pos.y += w->y + w->borderwidth;
+  }
+  return pos;
+}
+
+int
+cmpstack(const void* a, const void* b) {
+  int64_t sa = (*(fake_window_t* const*)a)->stack;
+  int64_t sb = (*(fake_window_t* const*)b)->stack;
+  return (sa > sb) - (sa < sb);
+}
+
+/**
+ * @brief Creates an in-memory display with only a root window.
+ *
+ * @param rootarea The area of the root window
+ *
+ * @return The display (NULL if it could not be allocated)
+ */
+fake_x_t*
+fakexcreate(area_t rootarea) {
+  fake_x_t* fx = calloc(1, sizeof(*fx));
+  if(!fx) return NULL;
+  fx->cap = FAKEX_INIT_CAP;
+  fx->wins = calloc(fx->cap, sizeof(*fx->wins));
+  if(!fx->wins) {
+    free(fx);
+    return NULL;
+  }
+  fx->wins[0] = (fake_window_t){
+    .id = FAKEX_ID_BASE,
+    .width = rootarea.size.x, .height = rootarea.size.y,
+    .mapped = true,
+  };
+  fx->numwins = 1;
+  fx->focus = FAKEX_ID_BASE;
+  fx->screen = (xcb_screen_t){
+    .root = FAKEX_ID_BASE,
+    .default_colormap = FAKEX_COLORMAP,
+    .white_pixel = 0xffffff,
+    .width_in_pixels = rootarea.size.x, .height_in_pixels = rootarea.size.y,
+    .root_visual = FAKEX_VISUAL,
+    .root_depth = FAKEX_DEPTH,
+  };
+  return fx;
+}
+
+/**
+ * @brief Frees an in-memory display and all of its windows.
+ *
+ * @param fx The display to free
+ */
+void
+fakexdestroy(fake_x_t* fx) {
+  if(!fx) return;
+  for(uint32_t i = 0; i < fx->numwins; i++) {
+    for(uint32_t j = 0; j < fx->wins[i].numprops; j++) {
+      free(fx->wins[i].props[j].data);
+    }
+    free(fx->wins[i].props);
+  }
+  for(uint32_t i = 0; i < fx->numatoms; i++) {
+    free(fx->atoms[i]);
+  }
+  for(uint32_t i = 0; i < fx->numreplies; i++) {
+    if(fx->replies[i].pending) free(fx->replies[i].reply);
+  }
+  free(fx->replies);
+  free(fx->atoms);
+  free(fx->monitors);
+  free(fx->wins);
+  free(fx);
+}
+
+/**
+ * @brief Makes the requests of the window manager go to an
+ * in-memory display and resets the request statistics.
+ *
+ * @param s The window manager's state
+ * @param fx The display to use
+ */
+void
+fakexuse(state_t* s, fake_x_t* fx) {
+  s->x = &fakexbackend;
+  s->xctx = fx;
+  s->root = fakexroot(fx);
+  s->screen = &fx->screen;
+  s->xstats = (x_stats_t){0};
+}
+
+xcb_window_t
+fakexroot(const fake_x_t* fx) {
+  (void)fx;
+  return FAKEX_ID_BASE;
+}
+
+/**
+ * @brief Creates an unmapped window like a client would.
+ *
+ * @param fx The display to create the window on
+ * @param parent The parent of the window
+ * @param area The area of the window relative to its parent
+ * @param overrideredirect Whether the window is not managed by a window manager
+ *
+ * @return The ID of the window (XCB_NONE if it could not be created)
+ */
+xcb_window_t
+fakexcreatewindow(fake_x_t* fx, xcb_window_t parent, area_t area, bool overrideredirect) {
+  if(!findwin(fx, parent)) return XCB_NONE;
+  xcb_window_t id = newid(fx);
+  if(id == XCB_NONE) return XCB_NONE;
+  fx->wins[id - FAKEX_ID_BASE] = (fake_window_t){
+    .id = id,
+    .parent = parent,
+    .x = area.pos.x, .y = area.pos.y,
+    .width = area.size.x, .height = area.size.y,
+    .overrideredirect = overrideredirect,
+    // New windows are stacked above their siblings
+    .stack = ++fx->stackcounter,
+  };
+  return id;
+}
+
+/**
+ * @brief Returns the modeled state of a window.
+ *
+ * @param fx The display of the window
+ * @param win The ID of the window
+ *
+ * @return The window (NULL if it does not exist)
+ */
+const fake_window_t*
+fakexwindow(const fake_x_t* fx, xcb_window_t win) {
+  return findwin(fx, win);
+}
+
+void
+fakexsetpointer(fake_x_t* fx, v2_t pos) {
+  fx->pointer = pos;
+}
+
+/**
+ * @brief Adds a monitor to the monitors reported by RandR.
+ *
+ * @param fx The display to add the monitor to
+ * @param area The area of the monitor on the root window
+ *
+ * @return Whether or not the monitor could be added
+ */
+bool
+fakexaddmonitor(fake_x_t* fx, area_t area) {
+  area_t* monitors = realloc(fx->monitors, (fx->nummonitors + 1) * sizeof(*monitors));
+  if(!monitors) return false;
+  fx->monitors = monitors;
+  fx->monitors[fx->nummonitors++] = area;
+  return true;
+}
+
+void
+fakeconfigurewindow(void* ctx, xcb_window_t win, uint16_t mask, const void* values) {
+  fake_x_t* fx = ctx;
+  fake_window_t* w = findwin(fx, win);
+  if(!w) return;
+  // The values are given in the order of the bits of the mask
+  const uint32_t* val = values;
+  if(mask & XCB_CONFIG_WINDOW_X)            w->x = (int16_t)*val++;
+  if(mask & XCB_CONFIG_WINDOW_Y)            w->y = (int16_t)*val++;
+  if(mask & XCB_CONFIG_WINDOW_WIDTH)        w->width = (uint16_t)*val++;
+  if(mask & XCB_CONFIG_WINDOW_HEIGHT)       w->height = (uint16_t)*val++;
+  if(mask & XCB_CONFIG_WINDOW_BORDER_WIDTH) w->borderwidth = (uint16_t)*val++;
+  if(mask & XCB_CONFIG_WINDOW_SIBLING)      val++;
+  if(mask & XCB_CONFIG_WINDOW_STACK_MODE) {
+    if(*val == XCB_STACK_MODE_ABOVE) {
+      w->stack = ++fx->stackcounter;
+    } else if(*val == XCB_STACK_MODE_BELOW) {
+      w->stack = -(++fx->stackcounter);
+    }
+  }
+}
+
+void
+fakechangewindowattributes(void* ctx, xcb_window_t win, uint32_t mask, const void* values) {
+  fake_window_t* w = findwin(ctx, win);
+  if(w) setattributes(w, mask, values);
+}
+
+void
+fakemapwindow(void* ctx, xcb_window_t win) {
+  fake_window_t* w = findwin(ctx, win);
+  if(w) w->mapped = true;
+}
+
+void
+fakeunmapwindow(void* ctx, xcb_window_t win) {
+  fake_window_t* w = findwin(ctx, win);
+  if(w) w->mapped = false;
+}
+
+void
+fakedestroywindow(void* ctx, xcb_window_t win) {
+  fake_x_t* fx = ctx;
+  fake_window_t* w = findwin(fx, win);
+  // The root window cannot be destroyed
+  if(!w || w->parent == XCB_NONE) return;
+  for(uint32_t i = 0; i < fx->numwins; i++) {
+    if(fx->wins[i].id != XCB_NONE && fx->wins[i].parent == win) {
+      fakedestroywindow(fx, fx->wins[i].id);
+    }
+  }
+  for(uint32_t i = 0; i < w->numprops; i++) {
+    free(w->props[i].data);
+  }
+  free(w->props);
+  if(fx->focus == win) {
+    fx->focus = fakexroot(fx);
+  }
+  *w = (fake_window_t){0};
+}
+
+void
+fakechangeproperty(void* ctx, uint8_t mode, xcb_window_t win, xcb_atom_t prop,
+                   xcb_atom_t type, uint8_t format, uint32_t len, const void* data) {
+  fake_window_t* w = findwin(ctx, win);
+  if(!w || (format != 8 && format != 16 && format != 32)) return;
+  fake_property_t* p = findprop(w, prop);
+  // Appending and prepending need the same type and format (BadMatch otherwise)
+  if(p && mode != XCB_PROP_MODE_REPLACE && (p->type != type || p->format != format)) return;
+  if(!p) {
+    fake_property_t* props = realloc(w->props, (w->numprops + 1) * sizeof(*props));
+    if(!props) return;
+    w->props = props;
+    p = &w->props[w->numprops++];
+    *p = (fake_property_t){ .atom = prop };
+  }
+  uint32_t unit = format / 8;
+  uint32_t oldlen = mode == XCB_PROP_MODE_REPLACE ? 0 : p->len;
+  uint8_t* buf = malloc((size_t)(oldlen + len) * unit + 1);
+  if(!buf) return;
+  // The new data goes before the old one when prepending
+  uint8_t* olddst = mode == XCB_PROP_MODE_PREPEND ? buf + (size_t)len * unit : buf;
+  uint8_t* newdst = mode == XCB_PROP_MODE_PREPEND ? buf : buf + (size_t)oldlen * unit;
+  if(oldlen) memcpy(olddst, p->data, (size_t)oldlen * unit);
+  if(len)    memcpy(newdst, data, (size_t)len * unit);
+  free(p->data);
+  p->data = buf;
+  p->len = oldlen + len;
+  p->type = type;
+  p->format = format;
+}
+
+void
+fakedeleteproperty(void* ctx, xcb_window_t win, xcb_atom_t prop) {
+  fake_window_t* w = findwin(ctx, win);
+  if(w) removeprop(w, prop);
+}
+
+void
+fakesetinputfocus(void* ctx, uint8_t revertto, xcb_window_t win, xcb_timestamp_t time) {
+  (void)revertto;
+  (void)time;
+  fake_x_t* fx = ctx;
+  if(findwin(fx, win)) fx->focus = win;
+}
+
+void
+fakesendevent(void* ctx, uint8_t propagate, xcb_window_t dest, uint32_t mask, const char* ev) {
+  (void)propagate;
+  (void)mask;
+  (void)ev;
+  fake_x_t* fx = ctx;
+  if(findwin(fx, dest)) fx->sentevents++;
+}
+
+void
+fakeflush(void* ctx) {
+  (void)ctx;
+}
+
+void
+fakecreatewindow(void* ctx, uint8_t depth, xcb_window_t win, xcb_window_t parent,
+                 int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t borderwidth,
+                 uint16_t class, xcb_visualid_t visual, uint32_t mask, const void* values) {
+  (void)depth;
+  (void)class;
+  (void)visual;
+  fake_x_t* fx = ctx;
+  // Only IDs that were generated and hold no window yet can be used
+  if(win < FAKEX_ID_BASE || win - FAKEX_ID_BASE >= fx->numwins || 
+    fx->wins[win - FAKEX_ID_BASE].id != XCB_NONE || !findwin(fx, parent)) return;
+  fake_window_t* nw = &fx->wins[win - FAKEX_ID_BASE];
+  *nw = (fake_window_t){
+    .id = win,
+    .parent = parent,
+    .x = x, .y = y,
+    .width = w, .height = h,
+    .borderwidth = borderwidth,
+    .stack = ++fx->stackcounter,
+  };
+  setattributes(nw, mask, values);
+}
+
+void
+fakereparentwindow(void* ctx, xcb_window_t win, xcb_window_t parent, int16_t x, int16_t y) {
+  fake_x_t* fx = ctx;
+  fake_window_t* w = findwin(fx, win);
+  if(!w || !findwin(fx, parent)) return;
+  w->parent = parent;
+  w->x = x;
+  w->y = y;
+  // The window is stacked above its new siblings
+  w->stack = ++fx->stackcounter;
+}
+
+void
+fakecleararea(void* ctx, uint8_t exposures, xcb_window_t win, 
+              int16_t x, int16_t y, uint16_t w, uint16_t h) {
+  (void)ctx;
+  (void)exposures;
+  (void)win;
+  (void)x;
+  (void)y;
+  (void)w;
+  (void)h;
+}
+
+void
+fakecreatecolormap(void* ctx, uint8_t alloc, xcb_colormap_t cmap, 
+                   xcb_window_t win, xcb_visualid_t visual) {
+  (void)ctx;
+  (void)alloc;
+  (void)cmap;
+  (void)win;
+  (void)visual;
+}
+
+void
+fakefreecolormap(void* ctx, xcb_colormap_t cmap) {
+  (void)ctx;
+  (void)cmap;
+}
+
+void
+fakefreecursor(void* ctx, xcb_cursor_t cursor) {
+  (void)ctx;
+  (void)cursor;
+}
+
+void
+fakegrabbutton(void* ctx, uint8_t ownerevents, xcb_window_t win, uint16_t evmask, 
+               uint8_t pointermode, uint8_t keyboardmode, xcb_window_t confineto, 
+               xcb_cursor_t cursor, uint8_t button, uint16_t modifiers) {
+  (void)ownerevents;
+  (void)evmask;
+  (void)pointermode;
+  (void)keyboardmode;
+  (void)confineto;
+  (void)cursor;
+  (void)modifiers;
+  fake_window_t* w = findwin(ctx, win);
+  if(w && button < 32) w->buttongrabs |= 1u << button;
+}
+
+void
+fakeungrabbutton(void* ctx, uint8_t button, xcb_window_t win, uint16_t modifiers) {
+  (void)modifiers;
+  fake_window_t* w = findwin(ctx, win);
+  if(!w) return;
+  if(button == XCB_BUTTON_INDEX_ANY) {
+    w->buttongrabs = 0;
+  } else if(button < 32) {
+    w->buttongrabs &= ~(1u << button);
+  }
+}
+
+void
+fakegrabkey(void* ctx, uint8_t ownerevents, xcb_window_t win, uint16_t modifiers, 
+            xcb_keycode_t key, uint8_t pointermode, uint8_t keyboardmode) {
+  (void)ctx;
+  (void)ownerevents;
+  (void)win;
+  (void)modifiers;
+  (void)key;
+  (void)pointermode;
+  (void)keyboardmode;
+}
+
+void
+fakeungrabkey(void* ctx, xcb_keycode_t key, xcb_window_t win, uint16_t modifiers) {
+  (void)ctx;
+  (void)key;
+  (void)win;
+  (void)modifiers;
+}
+
+void
+fakeallowevents(void* ctx, uint8_t mode, xcb_timestamp_t time) {
+  (void)ctx;
+  (void)mode;
+  (void)time;
+}
+
+void
+fakewarppointer(void* ctx, xcb_window_t srcwin, xcb_window_t dstwin, 
+                int16_t srcx, int16_t srcy, uint16_t srcw, uint16_t srch, 
+                int16_t dstx, int16_t dsty) {
+  (void)srcwin;
+  (void)srcx;
+  (void)srcy;
+  (void)srcw;
+  (void)srch;
+  fake_x_t* fx = ctx;
+  fake_window_t* dst = findwin(fx, dstwin);
+  // Without a destination window the pointer moves relative to its position
+  v2_t origin = dst ? abspos(fx, dst) : fx->pointer;
+  fx->pointer = (v2_t){ origin.x + dstx, origin.y + dsty };
+}
+
+/* There are no other clients, so grabbing the server changes nothing */
+void
+fakegrabserver(void* ctx) {
+  (void)ctx;
+}
+
+void
+fakesetclosedownmode(void* ctx, uint8_t mode) {
+  (void)ctx;
+  (void)mode;
+}
+
+/* Every window is its own client, so killing a client destroys its window */
+void
+fakekillclient(void* ctx, uint32_t resource) {
+  fakedestroywindow(ctx, resource);
+}
+
+/* Alarms are not modeled since counters never change */
+void
+fakealarm(void* ctx, xcb_sync_alarm_t alarm, uint32_t mask, const void* values) {
+  (void)ctx;
+  (void)alarm;
+  (void)mask;
+  (void)values;
+}
+
+void
+fakedestroyalarm(void* ctx, xcb_sync_alarm_t alarm) {
+  (void)ctx;
+  (void)alarm;
+}
+
+uint32_t
+fakegenerateid(void* ctx) {
+  return newid(ctx);
+}
+
+xcb_cursor_t
+fakeloadcursor(void* ctx, xcb_screen_t* screen, const char* name) {
+  (void)screen;
+  (void)name;
+  return newid(ctx);
+}
+
+bool
+fakechangewindowattributeschecked(void* ctx, xcb_window_t win, uint32_t mask, const void* values) {
+  fake_window_t* w = findwin(ctx, win);
+  // A request for a window that does not exist fails with BadWindow
+  if(!w) return false;
+  setattributes(w, mask, values);
+  return true;
+}
+
+xcb_get_property_reply_t*
+fakegetproperty(void* ctx, uint8_t del, xcb_window_t win, xcb_atom_t prop,
+                xcb_atom_t type, uint32_t offset, uint32_t len) {
+  fake_window_t* w = findwin(ctx, win);
+  if(!w) return NULL;
+  fake_property_t* p = findprop(w, prop);
+
+  uint32_t total = p ? p->len * (p->format / 8) : 0;
+  uint64_t start = (uint64_t)offset * 4;
+  bool match = p && (type == XCB_GET_PROPERTY_TYPE_ANY || type == p->type);
+  // An offset beyond the end of the value fails with BadValue
+  if(match && start > total) return NULL;
+  uint32_t size = match ? (uint32_t)MIN((uint64_t)total - start, (uint64_t)len * 4) : 0;
+
+  xcb_get_property_reply_t* reply = calloc(1, sizeof(*reply) + size + 1);
+  if(!reply) return NULL;
+  reply->response_type = XCB_GET_PROPERTY;
+  reply->format = p ? p->format : 0;
+  reply->type = p ? p->type : XCB_NONE;
+  reply->length = (size + 3) / 4;
+  if(match) {
+    reply->value_len = size / (p->format / 8);
+    reply->bytes_after = total - start - size;
+    // The value follows the reply like in xcb
+    memcpy(reply + 1, p->data + start, size);
+    if(del && !reply->bytes_after) {
+      removeprop(w, prop);
+    }
+  } else {
+    reply->bytes_after = total;
+  }
+  return reply;
+}
+
+xcb_get_geometry_reply_t*
+fakegetgeometry(void* ctx, xcb_drawable_t drawable) {
+  fake_window_t* w = findwin(ctx, drawable);
+  if(!w) return NULL;
+  xcb_get_geometry_reply_t* reply = calloc(1, sizeof(*reply));
+  if(!reply) return NULL;
+  reply->response_type = XCB_GET_GEOMETRY;
+  reply->depth = FAKEX_DEPTH;
+  reply->root = fakexroot(ctx);
+  reply->x = w->x;
+  reply->y = w->y;
+  reply->width = w->width;
+  reply->height = w->height;
+  reply->border_width = w->borderwidth;
+  return reply;
+}
+
+xcb_get_window_attributes_reply_t*
+fakegetwindowattributes(void* ctx, xcb_window_t win) {
+  fake_x_t* fx = ctx;
+  fake_window_t* w = findwin(fx, win);
+  if(!w) return NULL;
+  xcb_get_window_attributes_reply_t* reply = calloc(1, sizeof(*reply));
+  if(!reply) return NULL;
+  reply->response_type = XCB_GET_WINDOW_ATTRIBUTES;
+  reply->_class = XCB_WINDOW_CLASS_INPUT_OUTPUT;
+  reply->map_is_installed = true;
+  reply->map_state = !w->mapped ? XCB_MAP_STATE_UNMAPPED :
+    viewable(fx, w) ? XCB_MAP_STATE_VIEWABLE : XCB_MAP_STATE_UNVIEWABLE;
+  reply->override_redirect = w->overrideredirect;
+  reply->all_event_masks = w->eventmask;
+  reply->your_event_mask = w->eventmask;
+  return reply;
+}
+
+xcb_query_pointer_reply_t*
+fakequerypointer(void* ctx, xcb_window_t win) {
+  fake_x_t* fx = ctx;
+  fake_window_t* w = findwin(fx, win);
+  if(!w) return NULL;
+  xcb_query_pointer_reply_t* reply = calloc(1, sizeof(*reply));
+  if(!reply) return NULL;
+  reply->response_type = XCB_QUERY_POINTER;
+  reply->same_screen = true;
+  reply->root = fakexroot(fx);
+  reply->root_x = fx->pointer.x;
+  reply->root_y = fx->pointer.y;
+  v2_t pos = abspos(fx, w);
+  reply->win_x = fx->pointer.x - pos.x;
+  reply->win_y = fx->pointer.y - pos.y;
+
+  // The child is the topmost viewable child of the window that contains the pointer
+  int64_t top = INT64_MIN;
+  for(uint32_t i = 0; i < fx->numwins; i++) {
+    fake_window_t* c = &fx->wins[i];
+    if(c->id == XCB_NONE || c->parent != win || !c->mapped || c->stack < top) continue;
+    if(reply->win_x >= c->x && reply->win_x < c->x + c->width + 2 * c->borderwidth &&
+      reply->win_y >= c->y && reply->win_y < c->y + c->height + 2 * c->borderwidth) {
+      reply->child = c->id;
+      top = c->stack;
+    }
+  }
+  return reply;
+}
+
+xcb_query_tree_reply_t*
+fakequerytree(void* ctx, xcb_window_t win) {
+  fake_x_t* fx = ctx;
+  fake_window_t* w = findwin(fx, win);
+  if(!w) return NULL;
+
+  uint32_t numchildren = 0;
+  for(uint32_t i = 0; i < fx->numwins; i++) {
+    if(fx->wins[i].id != XCB_NONE && fx->wins[i].parent == win) numchildren++;
+  }
+  fake_window_t** children = malloc((numchildren + 1) * sizeof(*children));
+  xcb_query_tree_reply_t* reply = calloc(1, sizeof(*reply) + numchildren * sizeof(xcb_window_t));
+  if(!children || !reply) {
+    free(children);
+    free(reply);
+    return NULL;
+  }
+  numchildren = 0;
+  for(uint32_t i = 0; i < fx->numwins; i++) {
+    if(fx->wins[i].id != XCB_NONE && fx->wins[i].parent == win) children[numchildren++] = &fx->wins[i];
+  }
+  // Children are listed in stacking order, bottom to top
+  qsort(children, numchildren, sizeof(*children), cmpstack);
+
+  reply->response_type = XCB_QUERY_TREE;
+  reply->root = fakexroot(fx);
+  reply->parent = w->parent;
+  reply->children_len = numchildren;
+  reply->length = numchildren;
+  // The children follow the reply like in xcb
+  xcb_window_t* ids = (xcb_window_t*)(reply + 1);
+  for(uint32_t i = 0; i < numchildren; i++) {
+    ids[i] = children[i]->id;
+  }
+  free(children);
+  return reply;
+}
+
+xcb_intern_atom_reply_t*
+fakeinternatom(void* ctx, uint8_t onlyifexists, uint16_t len, const char* name) {
+  fake_x_t* fx = ctx;
+  xcb_atom_t atom = XCB_NONE;
+  for(uint32_t i = 0; i < fx->numatoms && atom == XCB_NONE; i++) {
+    if(strlen(fx->atoms[i]) == len && memcmp(fx->atoms[i], name, len) == 0) {
+      atom = FAKEX_ATOM_BASE + i;
+    }
+  }
+  if(atom == XCB_NONE && !onlyifexists) {
+    char** atoms = realloc(fx->atoms, (fx->numatoms + 1) * sizeof(*atoms));
+    if(!atoms) return NULL;
+    fx->atoms = atoms;
+    fx->atoms[fx->numatoms] = strndup(name, len);
+    if(!fx->atoms[fx->numatoms]) return NULL;
+    atom = FAKEX_ATOM_BASE + fx->numatoms++;
+  }
+  xcb_intern_atom_reply_t* reply = calloc(1, sizeof(*reply));
+  if(!reply) return NULL;
+  reply->response_type = XCB_INTERN_ATOM;
+  reply->atom = atom;
+  return reply;
+}
+
+/* There are no other clients, so no selection has an owner */
+xcb_get_selection_owner_reply_t*
+fakegetselectionowner(void* ctx, xcb_atom_t selection) {
+  (void)ctx;
+  (void)selection;
+  xcb_get_selection_owner_reply_t* reply = calloc(1, sizeof(*reply));
+  if(!reply) return NULL;
+  reply->response_type = XCB_GET_SELECTION_OWNER;
+  reply->owner = XCB_NONE;
+  return reply;
+}
+
+xcb_sync_query_counter_reply_t*
+fakequerycounter(void* ctx, xcb_sync_counter_t counter) {
+  (void)ctx;
+  (void)counter;
+  xcb_sync_query_counter_reply_t* reply = calloc(1, sizeof(*reply));
+  if(!reply) return NULL;
+  reply->response_type = XCB_SYNC_QUERY_COUNTER;
+  return reply;
+}
+
+xcb_randr_get_monitors_reply_t*
+fakegetmonitors(void* ctx, xcb_window_t win, uint8_t active) {
+  (void)active;
+  fake_x_t* fx = ctx;
+  if(!findwin(fx, win)) return NULL;
+  xcb_randr_get_monitors_reply_t* reply = calloc(1, sizeof(*reply) + 
+                                                 fx->nummonitors * sizeof(xcb_randr_monitor_info_t));
+  if(!reply) return NULL;
+  reply->response_type = XCB_RANDR_GET_MONITORS;
+  reply->nMonitors = fx->nummonitors;
+  reply->length = fx->nummonitors * sizeof(xcb_randr_monitor_info_t) / 4;
+  // The monitors follow the reply like in xcb, without any outputs
+  xcb_randr_monitor_info_t* monitors = (xcb_randr_monitor_info_t*)(reply + 1);
+  for(uint32_t i = 0; i < fx->nummonitors; i++) {
+    monitors[i] = (xcb_randr_monitor_info_t){
+      .primary = i == 0,
+      .automatic = true,
+      .x = fx->monitors[i].pos.x, .y = fx->monitors[i].pos.y,
+      .width = fx->monitors[i].size.x, .height = fx->monitors[i].size.y,
+    };
+  }
+  return reply;
+}
+
+/* There is no keyboard mapping */
+xcb_keysym_t
+fakegetkeysym(void* ctx, xcb_keycode_t keycode) {
+  (void)ctx;
+  (void)keycode;
+  return 0;
+}
+
+xcb_keycode_t*
+fakegetkeycodes(void* ctx, xcb_keysym_t keysym) {
+  (void)ctx;
+  (void)keysym;
+  return NULL;
+}
+
+/* Pipelined requests are answered right away and their replies are kept until they are read */
+
+xcb_get_property_cookie_t
+fakegetpropertyrequest(void* ctx, uint8_t del, xcb_window_t win, xcb_atom_t prop,
+                       xcb_atom_t type, uint32_t offset, uint32_t len) {
+  return (xcb_get_property_cookie_t){ 
+    addreply(ctx, fakegetproperty(ctx, del, win, prop, type, offset, len)) 
+  };
+}
+
+xcb_get_property_reply_t*
+fakegetpropertyreply(void* ctx, xcb_get_property_cookie_t cookie) {
+  return takereply(ctx, cookie.sequence);
+}
+
+xcb_query_tree_cookie_t
+fakequerytreerequest(void* ctx, xcb_window_t win) {
+  return (xcb_query_tree_cookie_t){ addreply(ctx, fakequerytree(ctx, win)) };
+}
+
+xcb_query_tree_reply_t*
+fakequerytreereply(void* ctx, xcb_query_tree_cookie_t cookie) {
+  return takereply(ctx, cookie.sequence);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "structs.h"
+
+/* Backend that models windows in memory instead of talking to an X
+ * server, so that handlers can be benchmarked and checked in-process
+ * (e.g. for the number of requests of an operation, see x_stats_t).
+ * Only requests that go through the backend are modeled. */
+
+typedef struct {
+  xcb_atom_t atom, type;
+  uint8_t format;
+  /* Length of the data in units of the format */
+  uint32_t len;
+  uint8_t* data;
+} fake_property_t;
+
+typedef struct {
+  /* XCB_NONE if the window was destroyed */
+  xcb_window_t id, parent;
+  int16_t x, y;
+  uint16_t width, height, borderwidth;
+  bool mapped, overrideredirect;
+  uint32_t eventmask, borderpixel;
+  /* Bit of every button that is grabbed on the window */
+  uint32_t buttongrabs;
+  /* Position in the stacking order of the window's siblings (higher is above) */
+  int64_t stack;
+  fake_property_t* props;
+  uint32_t numprops;
+} fake_window_t;
+
+/* Reply of a pipelined request that was not read yet */
+typedef struct {
+  void* reply;
+  bool pending;
+} fake_reply_t;
+
+typedef struct {
+  /* Windows indexed by their ID minus FAKEX_ID_BASE (the root is the first). 
+   * Every other resource ID also takes a slot that holds no window. */
+  fake_window_t* wins;
+  uint32_t numwins, cap;
+  xcb_screen_t screen;
+  xcb_window_t focus;
+  v2_t pointer;
+  int64_t stackcounter;
+  /* Number of events sent to windows */
+  uint32_t sentevents;
+  /* Names of the interned atoms, indexed by the atom minus FAKEX_ATOM_BASE */
+  char** atoms;
+  uint32_t numatoms;
+  /* Areas of the monitors (the root window is one monitor if there are none) */
+  area_t* monitors;
+  uint32_t nummonitors;
+  /* Replies of pipelined requests, indexed by the sequence of their cookie minus one */
+  fake_reply_t* replies;
+  uint32_t numreplies;
+} fake_x_t;
+
+extern const x_backend_t fakexbackend;
+
+fake_x_t* fakexcreate(area_t rootarea);
+void fakexdestroy(fake_x_t* fx);
+void fakexuse(state_t* s, fake_x_t* fx);
+xcb_window_t fakexroot(const fake_x_t* fx);
+xcb_window_t fakexcreatewindow(fake_x_t* fx, xcb_window_t parent, area_t area, bool overrideredirect);
+const fake_window_t* fakexwindow(const fake_x_t* fx, xcb_window_t win);
+void fakexsetpointer(fake_x_t* fx, v2_t pos);
+bool fakexaddmonitor(fake_x_t* fx, area_t area);
@@ -16,9 +16,36 @@
  * listen to necessary events. 
  * After the configuration of the root window, all the specified
  * keybinds in config.h are grabbed by the window manager.
+ * If a backend is already set (see fakexuse()), no connection 
+ * is opened and the window manager runs on that backend.
  */
 void             setup(state_t* s);
 
+/**
+ * @brief Opens the connection to the X server and makes the 
+ * window manager's requests go through it. Also looks up the 
+ * screen and the X extensions the window manager uses.
+ *
+ * @param s The window manager's state
+ */
+void             connectx(state_t* s);
+
+/**
+ * @brief Sets up the window manager on the root window of the 
+ * backend: redirects the root window, grabs the keybinds, 
+ * registers the monitors and manages the existing windows. 
+ * Everything goes through the backend, so this also sets up 
+ * a window manager in-process (see fakex.h).
+ *
+ * @param s The window manager's state
+ * @param restarted Whether the state of a previous process that 
+ * restarted in place is to be adopted
+ *
+ * @return Whether or not the root window could be redirected (it 
+ * cannot while another window manager is running)
+ */
+bool             setupwm(state_t* s, bool restarted);
+
 /**
  * @brief Event loop of the window manager 
  *
@@ -27,6 +54,24 @@ void             setup(state_t* s);
  */
 void             loop(state_t* s);
 
+/**
+ * @brief Handles a single event that was received from the 
+ * X server by calling the associated event handler.
+ *
+ * @param s The window manager's state
+ * @param ev The event to handle (not freed)
+ */
+void             dispatchevent(state_t* s, xcb_generic_event_t* ev);
+
+/**
+ * @brief Runs the work of the event loop that is due at a 
+ * certain time (config reloads, sync timeouts, title updates 
+ * and lazily launched scratchpads).
+ *
+ * @param s The window manager's state
+ */
+void             handletimers(state_t* s);
+
 /**
  * @brief Terminates the window manager 
  *
@@ -50,6 +95,15 @@ void             toggleedgewindows(state_t* s, client_t* cl, bool toggle);
 
 void             createwindowedges(state_t* s, client_t* cl);
 
+/**
+ * @brief Selects the events of a client window and grabs the 
+ * buttons for interactive moves and resizes on it.
+ *
+ * @param s The window manager's state
+ * @param cl The client 
+ */
+void             selectclientinput(state_t* s, client_t* cl);
+
 /**
  * @brief Creates a client from a given X windwo 
  *
@@ -79,6 +133,35 @@ bool             pointinarea(v2_t p, area_t a);
  */
 v2_t             cursorpos(state_t* s, bool* success);
 
+/**
+ * @brief Returns the cursor position reported by the last X input 
+ * event and only queries the X server if no event reported it yet.
+ *
+ * @param s The window manager's state
+ * @param success Gets assigned whether or not a cursor position 
+ * could be retrieved.
+ *
+ * @return The cursor position as a two dimensional vector 
+ */
+v2_t             cachedcursorpos(state_t* s, bool* success);
+
+/**
+ * @brief Stores the pointer position reported by an X event and 
+ * updates the monitor that contains it.
+ *
+ * @param s The window manager's state
+ * @param cursor The reported pointer position 
+ */
+void             updatecursor(state_t* s, v2_t cursor);
+
+/**
+ * @brief Marks the cached pointer position as stale so that 
+ * the next lookup queries the X server.
+ *
+ * @param s The window manager's state
+ */
+void             invalidatecursor(state_t* s);
+
 /**
  * @brief Returns the area (position and size) of a given window 
  *
@@ -93,7 +176,27 @@ v2_t             cursorpos(state_t* s, bool* success);
 area_t           winarea(state_t* s, xcb_window_t win, bool* success);
 
 /**
- * @brief Creates a X window with a trucolor visual 
+ * @brief Checks whether a compositing manager owns the 
+ * _NET_WM_CM_Sn selection of the default screen.
+ *
+ * @param s The window manager's state
+ *
+ * @return Whether or not a compositing manager is running
+ */
+bool             compositorrunning(state_t* s);
+
+/**
+ * @brief Chooses the visual, depth and colormap that every frame 
+ * window shares. A 32-bit ARGB visual with its own colormap is only 
+ * used when configured or when a compositing manager is running, 
+ * otherwise frames use the visual and colormap of the root window.
+ *
+ * @param s The window manager's state
+ */
+void             setupframevisual(state_t* s);
+
+/**
+ * @brief Creates a X window with the shared frame visual 
  * and colormap.
  *
  * @param s The window manager's state
@@ -135,8 +238,8 @@ void             setborderwidth(state_t* s, client_t* cl, uint32_t width);
 
 
 /**
- * @brief Removes a given client from the linked list 
- * of clients of a given monitor (not deallocating the client)
+ * @brief Removes a given client from the client list of its 
+ * desktop on a given monitor (not deallocating the client)
  *
  * @param mon The monitor to remove the client from 
  * @param cl The client to remove 
@@ -144,14 +247,26 @@ void             setborderwidth(state_t* s, client_t* cl, uint32_t width);
 void              monremoveclient(monitor_t *mon, client_t *cl);
 
 /**
- * @brief Adds a given client to the front of the linked list 
- * of clients of a given monitor 
+ * @brief Adds a given client to the front of the client list 
+ * of its desktop on a given monitor 
  *
  * @param mon The monitor to add the client to 
  * @param cl The client to add 
  */
 void            monaddclient(monitor_t *mon, client_t *cl);
 
+/**
+ * @brief Moves a given client into the client list of a given 
+ * desktop on a given monitor. Does nothing if the client is 
+ * already on that desktop and monitor.
+ *
+ * @param s The window manager's state
+ * @param cl The client to relocate 
+ * @param mon The monitor to relocate the client to 
+ * @param desktop The desktop to relocate the client to 
+ */
+void            relocateclient(state_t* s, client_t* cl, monitor_t* mon, uint32_t desktop);
+
 /**
  * @brief Moves the window of a given client and updates its area.
  *
@@ -179,6 +294,34 @@ void             resizeclient(state_t* s, client_t* cl, v2_t size);
  */
 void             moveresizeclient(state_t* s, client_t* cl, area_t a);
 
+/**
+ * @brief Moves and resizes the window of a given client and updates 
+ * its area without moving the client to another monitor.
+ *
+ * @param s The window manager's state
+ * @param cl The client to move and resize
+ * @param a The new area (position and size) for the client's window
+ */
+void             setclientarea(state_t* s, client_t* cl, area_t a);
+
+/**
+ * @brief Applies a list of updates to the area, desktop, monitor and 
+ * floating state of clients as a single transaction. Every update is 
+ * validated first and nothing is applied if any of them is invalid. 
+ * The affected desktops are layed out once and all requests go out 
+ * with a single flush. Needs to run on the event loop, as it changes 
+ * the client lists and frees their storage when they grow.
+ *
+ * @param s The window manager's state
+ * @param updates The updates to apply (later updates of a client win)
+ * @param numupdates The number of updates
+ * @param statuses Gets assigned the status of every update
+ *
+ * @return Whether the updates were applied
+ */
+bool             updateclients(state_t* s, const client_update_t* updates, uint32_t numupdates, 
+                               client_update_status_t* statuses);
+
 /**
  * @brief Raises the window of a given client to the top of the stack
  *
@@ -220,7 +363,7 @@ bool             clientshouldtile(state_t* s, client_t* cl);
 bool             clientonscreen(state_t* s, client_t* cl, monitor_t* mon);
 
 /**
- * @brief Retrieves the name of a given client (allocates memory) 
+ * @brief Retrieves the name of a given client (allocated from the string pool) 
  *
  * @param s The window manager's state
  * @param cl The client to retrieve a name from  
@@ -229,6 +372,34 @@ bool             clientonscreen(state_t* s, client_t* cl, monitor_t* mon);
  */
 char*            getclientname(state_t* s, client_t* cl);
 
+/**
+ * @brief Marks the name of a given client as changed. Names are 
+ * fetched at most once per frame, so a client that updates its 
+ * title many times per frame only costs a single fetch.
+ *
+ * @param s The window manager's state
+ * @param cl The client whose name changed
+ */
+void             marktitledirty(state_t* s, client_t* cl);
+
+/**
+ * @brief Returns the time in milliseconds until the changed 
+ * client names are due to be fetched.
+ *
+ * @param s The window manager's state
+ *
+ * @return The time until the fetch (-1 if no name changed)
+ */
+int32_t          titleupdatetimeout(state_t* s);
+
+/**
+ * @brief Fetches the names of the clients whose name changed 
+ * if the title update of the current frame is due.
+ *
+ * @param s The window manager's state
+ */
+void             updatetitles(state_t* s);
+
 /**
  * @brief Kills a given client by destroying the associated window and 
  * removing it from the linked list.
@@ -239,7 +410,8 @@ char*            getclientname(state_t* s, client_t* cl);
 void             killclient(state_t* s, client_t* cl);
 
 /**
- * @brief Sets the current focus to a given client
+ * @brief Sets the current focus to a given client. Only the previously 
+ * focused client and the newly focused client are touched.
  *
  * @param s The window manager's state
  * @param cl The client to focus
@@ -255,6 +427,23 @@ void             focusclient(state_t* s, client_t* cl, bool upload_ewmh_desktops
  */
 void             setxfocus(state_t* s, client_t* cl);
 
+/**
+ * @brief Sets the X input focus to the root window and 
+ * unsets the active window hint.
+ *
+ * @param s The window manager's state
+ */
+void             focusroot(state_t* s);
+
+/**
+ * @brief Sets the _NET_ACTIVE_WINDOW hint on the root window if 
+ * it differs from the last value that was set.
+ *
+ * @param s The window manager's state
+ * @param win The active window (XCB_NONE to delete the hint)
+ */
+void             setactivewindow(state_t* s, xcb_window_t win);
+
 /**
  * @brief Creates a frame window for the content of a client window and decoration to live in.
  * The frame window encapsulates the client's window and decoration like titlebar.
@@ -264,14 +453,23 @@ void             setxfocus(state_t* s, client_t* cl);
  */
 void             frameclient(state_t* s, client_t* cl);
 
+/**
+ * @brief Selects the events the window manager needs on a frame window.
+ *
+ * @param s The window manager's state
+ * @param frame The frame window 
+ */
+void             selectframeinput(state_t* s, xcb_window_t frame);
+
 /**
  * @brief Destroys and unmaps the frame window of a given client 
  * which consequently removes the client's window from the display
  *
  * @param s The window manager's state
  * @param cl The client to unframe 
+ * @param windestroyed Whether the client's window was destroyed
  */
-void             unframeclient(state_t* s, client_t* cl);
+void             unframeclient(state_t* s, client_t* cl, bool windestroyed);
 
 /**
  * @brief Removes the focus from client's window by setting the 
@@ -285,6 +483,70 @@ void             unfocusclient(state_t* s, client_t* cl);
 
 void             removescratchpad(state_t* s, uint32_t idx);
 
+/**
+ * @brief Returns the togglescratchpad keybind that defines 
+ * the scratchpad at a given index.
+ *
+ * @param s The window manager's state
+ * @param idx The index of the scratchpad
+ *
+ * @return The keybind of the scratchpad (NULL if there is none)
+ */
+const keybind_t* scratchpadkeybind(state_t* s, uint32_t idx);
+
+/**
+ * @brief Launches the command of a scratchpad. The window of the 
+ * command becomes the scratchpad once it maps.
+ *
+ * @param s The window manager's state
+ * @param idx The index of the scratchpad to launch
+ * @param cmd The command that opens the scratchpad's window
+ * @param hidden Whether the scratchpad stays hidden when its window maps
+ */
+void             launchscratchpad(state_t* s, uint32_t idx, const char* cmd, bool hidden);
+
+/**
+ * @brief Launches every scratchpad with a given launch mode 
+ * hidden that is not running yet.
+ *
+ * @param s The window manager's state
+ * @param launch The launch mode of the scratchpads to launch
+ */
+void             launchscratchpads(state_t* s, scratchpad_launch_t launch);
+
+/**
+ * @brief Returns the time in milliseconds until the lazily 
+ * launched scratchpads are due to be launched.
+ *
+ * @param s The window manager's state
+ *
+ * @return The time until the launch (-1 if nothing is due)
+ */
+int32_t          scratchpadlaunchtimeout(state_t* s);
+
+/**
+ * @brief Finds the launched scratchpad that a newly mapped client 
+ * belongs to by its WM_CLASS or, if the scratchpad does not specify 
+ * a class, by its _NET_WM_PID.
+ *
+ * @param s The window manager's state
+ * @param cl The newly mapped client
+ *
+ * @return The index of the scratchpad (-1 if the client is no scratchpad)
+ */
+int32_t          matchscratchpad(state_t* s, client_t* cl);
+
+/**
+ * @brief Returns the process id that a given window 
+ * specifies with _NET_WM_PID.
+ *
+ * @param s The window manager's state
+ * @param win The window to get the process id of
+ *
+ * @return The process id of the window (-1 if not specified)
+ */
+int32_t          getwinpid(state_t* s, xcb_window_t win);
+
 /**
  * @brief Notifies a given client window about it's configuration 
  * (geometry) by sending a configure notify event to it.
@@ -295,7 +557,8 @@ void             removescratchpad(state_t* s, uint32_t idx);
 void             configclient(state_t* s, client_t* cl);
 
 /*
- * @brief Hides a given client by unframing it's window
+ * @brief Hides a given client by unmapping it's frame or by moving 
+ * it off-screen, depending on the configured hide strategy
  *
  * @param s The window manager's state
  * @param cl The client to hide 
@@ -303,7 +566,7 @@ void             configclient(state_t* s, client_t* cl);
 void             hideclient(state_t* s, client_t* cl);
 
 /*
- * @brief Shows a given client by unframing it's window
+ * @brief Shows a given client that was hidden with hideclient()
  *
  * @param s The window manager's state
  * @param cl The client to show 
@@ -416,6 +679,14 @@ layout_type_t    getcurlayout(state_t* s, monitor_t* mon);
  */
 void             makelayout(state_t* s, monitor_t* mon);
 
+/**
+ * @brief Marks the layouts of all desktops on all monitors as 
+ * dirty so that they are re-established when they are shown next.
+ *
+ * @param s The window manager's state
+ */
+void             invalidatelayouts(state_t* s);
+
 /**
  * @brief Resets the size modifications of 
  * all client windows within the layout.
@@ -425,6 +696,18 @@ void             makelayout(state_t* s, monitor_t* mon);
  */
 void             resetlayoutsizes(state_t* s, monitor_t* mon);
 
+/**
+ * @brief Returns the area of a given monitor that layouts can 
+ * place windows in, which is the monitor's area without the 
+ * struts of the windows on it.
+ *
+ * @param s The window manager's state
+ * @param mon The monitor to get the layout area of 
+ *
+ * @return The area of the monitor without the struts
+ */
+area_t           layoutarea(state_t* s, monitor_t* mon);
+
 /**
  * @brief Establishes a tiled master layout for the windows that are 
  * currently visible.
@@ -453,7 +736,26 @@ void             verticalstripes(state_t* s, monitor_t* mon);
 void             horizontalstripes(state_t* s, monitor_t* mon);
 
 /**
- * @brief Swaps two clients within the linked list of clients 
+ * @brief Establishes a layout in which only one tiled window 
+ * is shown and fills the whole layout area. The other tiled 
+ * windows are hidden and not configured until they are shown.
+ *
+ * @param s The window manager's state
+ * @param mon The monitor to use as the frame of the layout 
+ */
+void             monocle(state_t* s, monitor_t* mon);
+
+/**
+ * @brief Shows the clients of the visible desktop of a monitor 
+ * that were hidden behind the shown client of a monocle layout.
+ *
+ * @param s The window manager's state
+ * @param mon The monitor of the clients 
+ */
+void             unstackclients(state_t* s, monitor_t* mon);
+
+/**
+ * @brief Swaps two clients within the client list of their desktop 
  *
  * @param s The window manager's state 
  * @param c1 The client to swap with c2 
@@ -504,11 +806,40 @@ void             grabkeybinds(state_t* s);
  * */
 void             loaddefaultcursor(state_t* s);
 
+/**
+ * @brief Frees the root cursor and the cached resize cursors. Windows 
+ * that still use one of them keep it until they are destroyed or their 
+ * cursor changes, the resize cursors are loaded again once needed.
+ *
+ * @param s The window manager's state
+ * */
+void             freecursors(state_t* s);
+
 bool             iswindowpopup(state_t* s, xcb_window_t win); 
 
+/**
+ * @brief Returns the kind of a given window. Windows are only 
+ * classified by querying the server the first time they are seen.
+ *
+ * @param s The window manager's state
+ * @param win The window to get the kind of
+ *
+ * @return The kind of the window 
+ */
+window_kind_t    windowkind(state_t* s, xcb_window_t win);
+
+/**
+ * @brief Retrieves the size hints (WM_NORMAL_HINTS) of a client 
+ * and caches them within the client.
+ *
+ * @param s The window manager's state
+ * @param cl The client to update the size hints of
+ * */
+void             updatesizehints(state_t* s, client_t* cl);
+
 /**
  * @brief Takes in a size for a client window and adjusts it 
- * if it does not meet the requirements of the client's hints.
+ * if it does not meet the requirements of the client's cached hints.
  * The adjusted value is returned.
  *
  * @param s The window manager's state
@@ -519,6 +850,33 @@ bool             iswindowpopup(state_t* s, xcb_window_t win);
  * */
 v2_t            applysizehints(state_t* s, client_t* cl, v2_t size);
 
+/**
+ * @brief Shows the resize outline around a given area of a client 
+ * and remembers the area to apply it once the resize is finished.
+ *
+ * @param s The window manager's state
+ * @param cl The client that is resized 
+ * @param a The area the client is resized to 
+ * @param makefloating Whether the client becomes floating 
+ * once the resize is applied
+ * */
+void             updateoutline(state_t* s, client_t* cl, area_t a, bool makefloating);
+
+/**
+ * @brief Hides the resize outline and resizes the client to 
+ * the area of the outline with a single configure.
+ *
+ * @param s The window manager's state
+ * */
+void             applyoutline(state_t* s);
+
+/**
+ * @brief Hides the resize outline without applying it.
+ *
+ * @param s The window manager's state
+ * */
+void             hideoutline(state_t* s);
+
 
 /**
  * @brief Returns the layering order in EWMH that is 
@@ -612,6 +970,15 @@ void             evdestroynotify(state_t* s, xcb_generic_event_t* ev);
  */
 void             eventernotify(state_t* s, xcb_generic_event_t* ev);
 
+/**
+ * @brief Handles a X leave-window event by storing the pointer 
+ * position that is reported by the event.
+ *
+ * @param s The window manager's state
+ * @param ev The generic event 
+ */
+void             evleavenotify(state_t* s, xcb_generic_event_t* ev);
+
 
 /**
  * @brief Handles a X key press event by checking if the pressed 
@@ -681,20 +1048,89 @@ void             evclientmessage(state_t* s, xcb_generic_event_t* ev);
 
 void             evfocusin(state_t* s, xcb_generic_event_t* ev);
 
+/**
+ * @brief Handles a X sync alarm notify event by finishing the 
+ * _NET_WM_SYNC_REQUEST of the client whose counter triggered the alarm.
+ *
+ * @param s The window manager's state
+ * @param ev The generic event 
+ */
+void             evsyncalarmnotify(state_t* s, xcb_generic_event_t* ev);
+
+/**
+ * @brief Sets up _NET_WM_SYNC_REQUEST resize synchronization for a 
+ * client if the client supports it by creating an alarm on the 
+ * client's sync counter.
+ *
+ * @param s The window manager's state
+ * @param cl The client to set up synchronization for 
+ */
+void             setupclientsync(state_t* s, client_t* cl);
+
+/**
+ * @brief Prepares resizing a client that uses _NET_WM_SYNC_REQUEST. 
+ * If the client has not yet acknowledged the previous resize, the 
+ * resize is held back. Otherwise a new sync request is sent.
+ *
+ * @param s The window manager's state
+ * @param cl The client that is resized 
+ *
+ * @return Whether or not the client can be resized now
+ */
+bool             beginsyncresize(state_t* s, client_t* cl);
+
+/**
+ * @brief Finishes the pending sync request of a client and applies 
+ * a resize that was held back in the meantime.
+ *
+ * @param s The window manager's state
+ * @param cl The client whose sync request is finished 
+ */
+void             endsyncresize(state_t* s, client_t* cl);
+
+/**
+ * @brief Returns the time until the next pending sync request 
+ * times out.
+ *
+ * @param s The window manager's state
+ *
+ * @return The timeout in ms (-1 if no sync request is pending)
+ */
+int32_t          synctimeout(state_t* s);
+
+/**
+ * @brief Finishes every sync request that was not acknowledged 
+ * within SYNC_REQUEST_TIMEOUT_MS.
+ *
+ * @param s The window manager's state
+ */
+void             handlesynctimeouts(state_t* s);
+
 
 
 /**
- * @brief Adds a client window to the linked list of clients
+ * @brief Creates a client from a given window and adds it to the 
+ * client list of the current desktop on a given monitor
  *
  * @param s The window manager's state
+ * @param mon The monitor to add the client to
  * @param win The window to create a client from and add it 
  * to the clients
  *
- * @return The newly created client
+ * @return The newly created client (NULL if the window is invalid)
  */
-client_t*        addclient(state_t* s, client_t** clients, xcb_window_t win);
+client_t*        addclient(state_t* s, monitor_t* mon, xcb_window_t win);
 
-void             setcursorforresize(state_t* s, xcb_window_t win, window_edge_t edge);
+/**
+ * @brief Returns the cursor shown over the edge windows of a given 
+ * edge. Every cursor is loaded once and shared by all clients.
+ *
+ * @param s The window manager's state
+ * @param edge The edge to get the cursor of
+ *
+ * @return The cursor of the edge (XCB_NONE if it could not be loaded)
+ */
+xcb_cursor_t     edgecursor(state_t* s, window_edge_t edge);
 
 window_edge_t    getedgefromwindow(client_t* cl, xcb_window_t win);
 
@@ -724,17 +1160,15 @@ client_t* clientfromedgewindow(state_t* s, xcb_window_t win);
 
 
 /**
- * @brief Returns a filtered linked list of all clients 
- * that are currently visible on the given monitor
+ * @brief Returns the list of clients that are on the currently 
+ * selected desktop of a given monitor
  *
  * @param s The window manager's state
  * @param mon The monitor to get visible clients off
- * @param tiled Whether or not to ignore floating clients
  *
- * @return A filtered linked list with all visible clients on 
- * the given monitor
+ * @return The client list of the current desktop on the given monitor
  */
-client_t*        visibleclients(state_t* s, monitor_t* mon, bool tiled);
+client_list_t*   visibleclients(state_t* s, monitor_t* mon);
 
 /**
 **
@@ -742,10 +1176,33 @@ client_t*        visibleclients(state_t* s, monitor_t* mon, bool tiled);
  *
  * @param s The window manager's state 
  * @param a The area of the monitor to create 
+ * @param idx The index of the monitor 
+ * @param name The RandR name of the monitor (XCB_NONE if unnamed)
  *
  * @return The newly created monitor 
  */
-monitor_t*       addmon(state_t* s, area_t a, uint32_t idx); 
+monitor_t*       addmon(state_t* s, area_t a, uint32_t idx, xcb_atom_t name); 
+
+/**
+ * @brief Frees all resources of a given monitor. The monitor 
+ * needs to be unlinked from the list of monitors and must not 
+ * contain any clients.
+ *
+ * @param s The window manager's state 
+ * @param mon The monitor to destroy 
+ */
+void             destroymon(state_t* s, monitor_t* mon);
+
+/**
+ * @brief Moves all clients of a given monitor onto another monitor. 
+ * Clients keep their virtual desktop and their position relative 
+ * to the monitor.
+ *
+ * @param s The window manager's state 
+ * @param from The monitor to move the clients from 
+ * @param to The monitor to move the clients to 
+ */
+void             migrateclients(state_t* s, monitor_t* from, monitor_t* to);
 
 /**
  * @brief Returns the monitor within the list of monitors 
@@ -772,8 +1229,36 @@ monitor_t*       monbyarea(state_t* s, area_t a);
  */
 monitor_t*       clientmon(state_t* s, client_t* cl);
 
+/**
+ * @brief Moves a given client to a given monitor, keeping its 
+ * position and size relative to the monitor and placing it on 
+ * the monitor's selected desktop.
+ *
+ * @param s The window manager's state
+ * @param cl The client to move
+ * @param mon The monitor to move the client to
+ */
+void             sendclienttomon(state_t* s, client_t* cl, monitor_t* mon);
 
-void             updateclienthints(state_t* s, client_t* cl);
+/**
+ * @brief Focuses a given monitor by warping the pointer to its 
+ * center and focusing the topmost client under it.
+ *
+ * @param s The window manager's state
+ * @param mon The monitor to focus
+ */
+void             focusmon(state_t* s, monitor_t* mon);
+
+
+/**
+ * @brief Applies the WM_HINTS of a given client, updating its 
+ * urgency and whether it accepts input focus.
+ *
+ * @param s The window manager's state
+ * @param cl The client the hints belong to
+ * @param hints The WM_HINTS of the client's window
+ */
+void             applyclienthints(state_t* s, client_t* cl, const xcb_icccm_wm_hints_t* hints);
 
 /**
  * @brief Returns the currently selected virtual desktop on 
@@ -797,8 +1282,21 @@ desktop_t*       mondesktop(state_t* s, monitor_t* mon);
 monitor_t*       cursormon(state_t* s);
 
 /**
- * @brief Gets all screens registed by xrandr and adds newly registered 
- * monitors to the linked list of monitors in the window manager.
+ * @brief Returns the monitor with a given index 
+ *
+ * @param s The window manager's state
+ * @param idx The index of the monitor 
+ *
+ * @return The monitor with the given index (NULL if there is none)
+ */
+monitor_t*       monbyidx(state_t* s, int32_t idx);
+
+/**
+ * @brief Queries the monitors registered by xrandr and reconciles 
+ * them with the linked list of monitors in the window manager. 
+ * Known monitors are matched by name and updated in place, new 
+ * monitors are added and the clients of removed monitors are 
+ * moved to the focused monitor.
  *
  * @param s The window manager's state 
  *
@@ -873,6 +1371,18 @@ void             ewmh_updateclients(state_t* s);
  * */
 void             sigchld_handler(int32_t signum);
 
+/**
+ * @brief Launches a given shell command without waiting for it. 
+ * The shell replaces itself with the command so that the returned 
+ * process id is the one the command's windows report.
+ *
+ * @param s The window manager's state
+ * @param cmd The command to launch (a trailing '&' is ignored)
+ *
+ * @return The process id of the launched command (-1 on failure)
+ */
+int32_t          spawncmd(state_t* s, const char* cmd);
+
 /**
  * @brief Checks if a given string is within a given 
  * array of strings
@@ -919,3 +1429,9 @@ void 		         logtofile(log_level_t lvl, state_t* s, const char* fmt, va_list
  * @return The output of the given command */ 
 char* 		       cmdoutput(const char* cmd);
 
+/**
+ * @brief Returns the current time of the monotonic clock 
+ *
+ * @return The time in milliseconds */ 
+uint64_t         monotonicms(void);
+
@@ -3,32 +3,49 @@
 #include <string.h>
 #include <stdint.h>
 #include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/eventfd.h>
 #include <pthread.h>
 #include <arpa/inet.h>
 
 #include "../funcs.h"
 #include "../structs.h"
 #include "../config.h"
+#include "../restart.h"
+#include "../record.h"
+#include "../resources.h"
 #include <ragnar/api.h>
 
 #define SOCKPATH "/tmp/ragnar_socket"
 #define MSGSIZE 256
+/* Largest command data that is accepted (allocated if it exceeds MSGSIZE) */
+#define MAXMSGSIZE (RG_MAX_WINDOW_UPDATES * sizeof(RgWindowUpdate))
+/* Number of IPC connections that can be open at once */
+#define MAXCLIENTS 32
 
 #include "sockets.h"
 
 typedef void (*cmd_handler_t)(state_t* s, const uint8_t* data, int32_t clientfd);
+typedef void (*cmd_varhandler_t)(state_t* s, const uint8_t* data, size_t len, int32_t clientfd);
 
 typedef struct {
   cmd_handler_t handler;
+  /* Handler of commands whose data is a list of any (nonzero) 
+   * number of items of size len */
+  cmd_varhandler_t varhandler;
   uint32_t len;
   RgCommandType type;
+  bool varlen;
 } cmd_data_t;
 
 static client_t* extractclient(state_t* s, const uint8_t* data);
+static client_t* clientafter(state_t* s, monitor_t* mon, uint32_t desktop, uint32_t slot);
 static void sendv2(int32_t clientfd, state_t* s, v2_t* v);
 
 static void cmdterminate(state_t* s, const uint8_t* data, int32_t clientfd);
@@ -43,9 +60,14 @@ static void cmdgetcursor(state_t* s, const uint8_t* data, int32_t clientfd);
 static void cmdgetwinarea(state_t* s, const uint8_t* data, int32_t clientfd);
 static void cmdreloadconfig(state_t* s, const uint8_t* data, int32_t clientfd);
 static void cmdswitchdesktop(state_t* s, const uint8_t* data, int32_t clientfd);
+static void cmdgetmemstats(state_t* s, const uint8_t* data, int32_t clientfd);
+static void cmdrestart(state_t* s, const uint8_t* data, int32_t clientfd);
+static void cmdupdatewins(state_t* s, const uint8_t* data, size_t len, int32_t clientfd);
+static void cmdgetresources(state_t* s, const uint8_t* data, int32_t clientfd);
 
-static void handlecmd(state_t* s, uint8_t cmdid, const uint8_t* data, 
-                      size_t len, int32_t clientfd);
+static bool readall(int32_t fd, void* buf, size_t size);
+static bool servecmd(state_t* s, int32_t clientfd);
+static void runonloop(state_t* s, ipc_command_t* cmd);
 
 static cmd_data_t cmdhandlers[] = {
   { .handler = cmdterminate,    .len = sizeof(uint32_t),      .type = RgCommandTerminate },
@@ -60,6 +82,10 @@ static cmd_data_t cmdhandlers[] = {
   { .handler = cmdgetwinarea,   .len = sizeof(RgWindow),      .type = RgCommandGetWindowArea },
   { .handler = cmdreloadconfig, .len = 0,                     .type = RgCommandReloadConfig},
   { .handler = cmdswitchdesktop, .len = sizeof(uint32_t),     .type = RgCommandSwitchDesktop},
+  { .handler = cmdgetmemstats,  .len = 0,                     .type = RgCommandGetMemoryStats},
+  { .handler = cmdrestart,      .len = 0,                     .type = RgCommandRestart},
+  { .varhandler = cmdupdatewins, .len = sizeof(RgWindowUpdate), .type = RgCommandUpdateWindows, .varlen = true },
+  { .handler = cmdgetresources, .len = 0,                     .type = RgCommandGetResources},
 };
 
 client_t*
@@ -70,13 +96,29 @@ extractclient(state_t* s, const uint8_t* data) {
   client_t* cl = clientfromwin(s, win);
   if(!cl) {
     logmsg(s, LogLevelError, 
-           "ipc: window %i is invalid, not killing.");
+           "ipc: window %i is invalid, not killing.", win);
     return NULL;
   }
 
   return cl;
 }
 
+/* Returns the first client at or after the given slot, continuing 
+ * through the following desktops and monitors. */
+client_t*
+clientafter(state_t* s, monitor_t* mon, uint32_t desktop, uint32_t slot) {
+  for(; mon != NULL; mon = mon->next) {
+    for(; desktop < s->config.maxdesktops; desktop++) {
+      if(slot < mon->clients[desktop].size) {
+        return mon->clients[desktop].items[slot];
+      }
+      slot = 0;
+    }
+    desktop = 0;
+  }
+  return NULL;
+}
+
 void
 sendv2(int32_t clientfd, state_t* s, v2_t* v) {
   Rgv2 v_rg = (Rgv2){
@@ -113,15 +155,17 @@ cmdgetwins(state_t* s, const uint8_t* data, int32_t clientfd) {
 
   uint32_t numwins = 0;
   for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
-    for(client_t* cl = mon->clients; cl != NULL; cl = cl->next) {
-      numwins++;
+    for(uint32_t i = 0; i < s->config.maxdesktops; i++) {
+      numwins += mon->clients[i].size;
     }
   }
   RgWindow wins[numwins];
-  uint32_t i = 0;
+  uint32_t n = 0;
   for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
-    for(client_t* cl = mon->clients; cl != NULL; cl = cl->next) {
-      wins[i++] = cl->win;
+    for(uint32_t i = 0; i < s->config.maxdesktops; i++) {
+      for(uint32_t j = 0; j < mon->clients[i].size; j++) {
+        wins[n++] = mon->clients[i].items[j]->win;
+      }
     }
   }
 
@@ -169,15 +213,17 @@ cmdnextwin(state_t* s, const uint8_t* data, int32_t clientfd) {
   client_t* cl;
   logmsg(s, LogLevelTrace, 
          "ipc: RgCommandNextWindow: received command.");
+
+  // Commands with a reply always send it so that the connection stays usable
+  RgWindow next = RG_INVALID_WINDOW;
   if(!(cl = extractclient(s, data))) {
     logmsg(s, LogLevelError, 
            "ipc: RgCommandNextWindow: No client associated with window.");
-    return;
-  }
-
-  RgWindow next = RG_INVALID_WINDOW;
-  if(cl->next) {
-    next = cl->next->win;
+  } else {
+    client_t* nextcl = clientafter(s, cl->mon, cl->desktop, cl->slot + 1);
+    if(nextcl) {
+      next = nextcl->win;
+    }
   }
 
   if(write(clientfd, &next, sizeof(next)) == -1) {
@@ -193,8 +239,9 @@ cmdfirstwin(state_t* s, const uint8_t* data, int32_t clientfd) {
          "ipc: RgCommandFirstWindow: received command.");
 
   RgWindow first = RG_INVALID_WINDOW;
-  if(s->monitors->clients) {
-    first = s->monitors->clients->win ? (RgWindow)s->monitors->clients->win : RG_INVALID_WINDOW;
+  client_t* firstcl = clientafter(s, s->monitors, 0, 0);
+  if(firstcl) {
+    first = firstcl->win;
   }
 
   if(write(clientfd, &first, sizeof(first)) == -1) {
@@ -246,7 +293,7 @@ cmdgetcursor(state_t* s, const uint8_t* data, int32_t clientfd) {
   if(!success) {
     logmsg(s, LogLevelError, 
            "ipc: RgCommandGetCursor: failed to get cursor position.");
-    return;
+    cursor = (v2_t){0};
   }
 
   sendv2(clientfd, s, &cursor);
@@ -257,14 +304,16 @@ cmdgetwinarea(state_t* s, const uint8_t* data, int32_t clientfd) {
   logmsg(s, LogLevelTrace, 
          "ipc: RgCommandGetWindowArea: received command.");
   client_t* cl;
+  area_t area = {0};
   if(!(cl = extractclient(s, data))) {
     logmsg(s, LogLevelError, 
            "ipc: RgCommandGetWindowArea: No client associated with window.");
-    return;
+  } else {
+    area = cl->area;
   }
 
-  sendv2(clientfd, s, &cl->area.pos);
-  sendv2(clientfd, s, &cl->area.size);
+  sendv2(clientfd, s, &area.pos);
+  sendv2(clientfd, s, &area.size);
 }
 
 void 
@@ -288,13 +337,166 @@ cmdswitchdesktop(state_t* s, const uint8_t* data, int32_t clientfd) {
   switchmonitordesktop(s, desktop);
 } 
 
+void 
+cmdgetmemstats(state_t* s, const uint8_t* data, int32_t clientfd) {
+  (void)data;
+  logmsg(s, LogLevelTrace, 
+         "ipc: RgCommandGetMemoryStats: received command.");
+
+  RgMemoryStats stats = (RgMemoryStats){
+    .liveclients  = s->clientpool.live,
+    .peakclients  = s->clientpool.peak,
+    .clientslabs  = s->clientpool.numslabs,
+    .livestrings  = s->strpool.live,
+    .peakstrings  = s->strpool.peak,
+    .stringbytes  = s->strpool.bytes
+  };
+
+  if(write(clientfd, &stats, sizeof(stats)) == -1) {
+    logmsg(s, LogLevelError, 
+           "ipc: RgCommandGetMemoryStats: failed to send memory stats.");
+  }
+}
+
+void 
+cmdrestart(state_t* s, const uint8_t* data, int32_t clientfd) {
+  (void)data;
+  (void)clientfd;
+  logmsg(s, LogLevelTrace, 
+         "ipc: RgCommandRestart: received command.");
+
+  // The event loop restarts once it receives the request
+  requestrestart(s);
+}
+
+void 
+cmdupdatewins(state_t* s, const uint8_t* data, size_t len, int32_t clientfd) {
+  // The size of the payload is controlled by the IPC client
+  if(len == 0 || len % sizeof(RgWindowUpdate) != 0 || 
+    len / sizeof(RgWindowUpdate) > RG_MAX_WINDOW_UPDATES) {
+    logmsg(s, LogLevelWarn, 
+           "ipc: RgCommandUpdateWindows: rejected command with invalid data length %zu.", len);
+    return;
+  }
+  uint32_t numupdates = len / sizeof(RgWindowUpdate);
+  logmsg(s, LogLevelTrace, 
+         "ipc: RgCommandUpdateWindows: received command with %u updates.", numupdates);
+
+  client_update_t* updates = malloc(numupdates * sizeof(*updates));
+  client_update_status_t* statuses = malloc(numupdates * sizeof(*statuses));
+  int32_t* reply = malloc(numupdates * sizeof(*reply));
+  if(!updates || !statuses || !reply) {
+    logmsg(s, LogLevelError, 
+           "ipc: RgCommandUpdateWindows: failed to allocate updates.");
+    // The client still expects a status for every update
+    for(uint32_t i = 0; i < numupdates; i++) {
+      int32_t status = RgWindowUpdateNotApplied;
+      if(write(clientfd, &status, sizeof(status)) == -1) break;
+    }
+    free(updates); free(statuses); free(reply);
+    return;
+  }
+
+  for(uint32_t i = 0; i < numupdates; i++) {
+    RgWindowUpdate u;
+    memcpy(&u, data + i * sizeof(u), sizeof(u));
+    updates[i] = (client_update_t){
+      .win = (xcb_window_t)u.win,
+      .fields = u.fields,
+      .area = (area_t){
+        .pos = (v2_t){u.area.pos.x, u.area.pos.y},
+        .size = (v2_t){u.area.size.x, u.area.size.y}
+      },
+      .desktop = u.desktop,
+      .monitor = u.monitor,
+      .floating = u.floating != 0
+    };
+  }
+
+  // Commands are handled on the event loop, so the transaction never races an event handler
+  if(!updateclients(s, updates, numupdates, statuses)) {
+    logmsg(s, LogLevelWarn, 
+           "ipc: RgCommandUpdateWindows: rejected transaction with invalid updates.");
+  }
+
+  for(uint32_t i = 0; i < numupdates; i++) {
+    reply[i] = (int32_t)statuses[i];
+  }
+  if(write(clientfd, reply, numupdates * sizeof(*reply)) == -1) {
+    logmsg(s, LogLevelError, 
+           "ipc: RgCommandUpdateWindows: failed to send update statuses.");
+  }
+  free(updates); free(statuses); free(reply);
+}
+
+void 
+cmdgetresources(state_t* s, const uint8_t* data, int32_t clientfd) {
+  (void)data;
+  logmsg(s, LogLevelTrace, 
+         "ipc: RgCommandGetResources: received command.");
+
+  // The resource kinds of the API are in the same order as x_resource_kind_t
+  RgResourceStats stats = {0};
+  for(uint32_t i = 0; i < RgResourceKindCount && i < XResourceCount; i++) {
+    stats.created[i] = s->resources.created[i];
+    stats.freed[i]   = s->resources.freed[i];
+    stats.leaked[i]  = s->resources.leaked[i];
+  }
+  heap_usage_t heap = heapusage(s);
+  stats.heapclients   = heap.clients;
+  stats.heapstrings   = heap.strings;
+  stats.heapmonitors  = heap.monitors;
+  stats.heapwinmaps   = heap.winmaps;
+  stats.heaprules     = heap.rules;
+  stats.heapother     = heap.other;
+
+  uint32_t numwins = 0;
+  for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
+    for(uint32_t i = 0; i < s->config.maxdesktops; i++) {
+      numwins += mon->clients[i].size;
+    }
+  }
+  RgWindowResources* wins = malloc((numwins ? numwins : 1) * sizeof(*wins));
+  if(!wins) {
+    logmsg(s, LogLevelError, 
+           "ipc: RgCommandGetResources: failed to allocate window resources.");
+    numwins = 0;
+  }
+  uint32_t n = 0;
+  for(monitor_t* mon = s->monitors; mon != NULL && wins; mon = mon->next) {
+    for(uint32_t i = 0; i < s->config.maxdesktops; i++) {
+      for(uint32_t j = 0; j < mon->clients[i].size && n < numwins; j++) {
+        client_t* cl = mon->clients[i].items[j];
+        wins[n].win = cl->win;
+        for(uint32_t k = 0; k < RgResourceKindCount; k++) {
+          wins[n].resources[k] = k < XResourceCount ? cl->props->resources[k] : 0;
+        }
+        n++;
+      }
+    }
+  }
+
+  if(write(clientfd, &stats, sizeof(stats)) == -1 || 
+    write(clientfd, &n, sizeof(n)) == -1 || 
+    (n && write(clientfd, wins, n * sizeof(*wins)) == -1)) {
+    logmsg(s, LogLevelError, 
+           "ipc: RgCommandGetResources: failed to send resources.");
+  }
+  free(wins);
+}
+
 void 
 handlecmd(state_t* s, uint8_t cmdid, const uint8_t* data, size_t len, 
           int32_t clientfd) {
   bool exec = false;
   for(uint32_t i = 0; i < sizeof(cmdhandlers) / sizeof(cmd_data_t); i++) {
-    if(cmdid == (uint8_t)cmdhandlers[i].type && len == cmdhandlers[i].len) {
-      cmdhandlers[i].handler(s, data, clientfd);
+    const cmd_data_t* cmd = &cmdhandlers[i];
+    if(cmdid != (uint8_t)cmd->type) continue;
+    if(cmd->varlen && len && len % cmd->len == 0) {
+      cmd->varhandler(s, data, len, clientfd);
+      exec = true;
+    } else if(!cmd->varlen && len == cmd->len) {
+      cmd->handler(s, data, clientfd);
       exec = true;
     }
   } 
@@ -304,17 +506,127 @@ handlecmd(state_t* s, uint8_t cmdid, const uint8_t* data, size_t len,
   }
 }
 
+bool
+readall(int32_t fd, void* buf, size_t size) {
+  uint8_t* ptr = buf;
+  while(size) {
+    ssize_t n = read(fd, ptr, size);
+    if(n == -1 && errno == EINTR) continue;
+    if(n <= 0) return false;
+    ptr += n;
+    size -= n;
+  }
+  return true;
+}
+
+bool
+servecmd(state_t* s, int32_t clientfd) {
+  uint8_t stackbuf[MSGSIZE];
+  uint8_t* buf = stackbuf;
+
+  // Read the command ID (the client closing the connection ends it)
+  uint8_t command_id;
+  if(!readall(clientfd, &command_id, sizeof(command_id))) {
+    return false;
+  }
+
+  uint32_t len;
+  if(!readall(clientfd, &len, sizeof(len))) {
+    logmsg(s, LogLevelTrace, "ipc: Failed to read data length of IPC client with FD: %i", clientfd);
+    return false;
+  }
+
+  len = ntohl(len); 
+
+  if (len > MAXMSGSIZE) {
+    logmsg(s, LogLevelTrace, 
+           "ipc: Data length of IPC client with FD: %i is too large to fit into the data buffer.", clientfd);
+    return false;
+  }
+
+  // Only the rare large commands (e.g. transactions) need a heap buffer
+  if(len > sizeof(stackbuf)) {
+    if(!(buf = malloc(len))) {
+      logmsg(s, LogLevelError, 
+             "ipc: Failed to allocate data buffer for client with FD: %i", clientfd);
+      return false;
+    }
+  }
+
+  if(!readall(clientfd, buf, len)) {
+    logmsg(s, LogLevelTrace, 
+           "ipc: Failed to read data of client with FD: %i", clientfd);
+    if(buf != stackbuf) free(buf);
+    return false;
+  }
+
+  // Handle the command on the event loop
+  ipc_command_t cmd = (ipc_command_t){
+    .id = command_id,
+    .data = buf,
+    .len = len,
+    .clientfd = clientfd
+  };
+  runonloop(s, &cmd);
+  if(buf != stackbuf) free(buf);
+  return true;
+}
+
+/* Hands a command to the event loop and waits until it was handled */
+void
+runonloop(state_t* s, ipc_command_t* cmd) {
+  ipc_queue_t* q = &s->ipc;
+  pthread_mutex_lock(&q->lock);
+  q->pending = cmd;
+  uint64_t one = 1;
+  if(write(q->eventfd, &one, sizeof(one)) != sizeof(one)) {
+    // The counter is already non-zero, so the main loop wakes up anyway
+  }
+  while(q->pending) {
+    pthread_cond_wait(&q->cond, &q->lock);
+  }
+  pthread_mutex_unlock(&q->lock);
+}
+
+/**
+ * @brief Handles the IPC command that waits for the event loop, 
+ * if any. Needs to be called from the event loop once the IPC 
+ * queue's eventfd is readable.
+ *
+ * @param s The window manager's state
+ */
+void
+handleipccommand(state_t* s) {
+  ipc_queue_t* q = &s->ipc;
+  uint64_t count;
+  if(read(q->eventfd, &count, sizeof(count)) != sizeof(count)) {
+    return;
+  }
+  pthread_mutex_lock(&q->lock);
+  ipc_command_t* cmd = q->pending;
+  pthread_mutex_unlock(&q->lock);
+  if(!cmd) return;
+
+  if(s->recorder.file) {
+    recordipc(s, cmd->id, cmd->data, cmd->len);
+  }
+  handlecmd(s, cmd->id, cmd->data, cmd->len, cmd->clientfd);
+
+  pthread_mutex_lock(&q->lock);
+  q->pending = NULL;
+  pthread_cond_signal(&q->cond);
+  pthread_mutex_unlock(&q->lock);
+}
+
 void* 
 ipcserverthread(void* arg) {
   state_t* s = (state_t*)arg;
 
-  int32_t serverfd, clientfd;
+  int32_t serverfd;
   struct sockaddr_un addr;
-  uint8_t buf[MSGSIZE];
-  ssize_t numread;
 
-  // Create a Unix domain socket
-  serverfd = socket(AF_UNIX, SOCK_STREAM, 0);
+  // Create a Unix domain socket (it must not outlive an in-place restart)
+  serverfd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
   if (serverfd < 0) {
     logmsg(s, LogLevelError, "ipc: Failed to create unix domain socket for IPC.");
     terminate(s, EXIT_FAILURE);
@@ -344,54 +656,74 @@ ipcserverthread(void* arg) {
 
   logmsg(s, LogLevelTrace, "ipc: Server is listening for IPC connections.");
 
-  while (true) {
-    // Accept a new client connection
-    clientfd = accept(serverfd, NULL, NULL);
-    if (clientfd < 0) {
-      logmsg(s, LogLevelTrace, "ipc: Failed to accept IPC client connection.");
-      close(serverfd);
-      continue;
-    }
-
-    // Read the command ID 
-    uint8_t command_id;
-    numread = read(clientfd, &command_id, sizeof(command_id));
-    if (numread != sizeof(command_id)) {
-      logmsg(s, LogLevelTrace, "ipc: Failed to read command ID of IPC client with FD: %i", clientfd);
-      close(clientfd);
-      continue;
-    }
+  /* Clients keep their connection open for as many commands as 
+   * they like, so every open connection is polled alongside the 
+   * listening socket. The first slot is the listening socket. */
+  struct pollfd fds[1 + MAXCLIENTS];
+  uint32_t nfds = 1;
+  fds[0] = (struct pollfd){ .fd = serverfd, .events = POLLIN };
 
-    uint32_t len;
-    numread = read(clientfd, &len, sizeof(len));
-    if (numread != sizeof(len)) {
-      logmsg(s, LogLevelTrace, "ipc: Failed to read data length of IPC client with FD: %i", clientfd);
-      close(clientfd);
+  while (true) {
+    if(poll(fds, nfds, -1) == -1) {
+      if(errno != EINTR) {
+        logmsg(s, LogLevelError, "ipc: Failed to poll IPC connections.");
+      }
       continue;
     }
 
-    len = ntohl(len); 
-
-    if (len > sizeof(buf) - ((sizeof(command_id) + sizeof(len)))) {
-      logmsg(s, LogLevelTrace, 
-             "ipc: Data length of IPC client with FD: %i is too large to fit into the data buffer.", clientfd);
-      close(clientfd);
-      continue;
+    // Serve the connections before accepting so that a new one is not polled yet
+    for(uint32_t i = 1; i < nfds; i++) {
+      if(!fds[i].revents) continue;
+      if(!(fds[i].revents & POLLIN) || !servecmd(s, fds[i].fd)) {
+        // Close the client socket
+        close(fds[i].fd);
+        fds[i--] = fds[--nfds];
+      }
     }
 
-    numread = read(clientfd, buf, len);
-    if (numread != (ssize_t)len) {
-      logmsg(s, LogLevelTrace, 
-             "ipc: Failed to read data of client with FD: %i", clientfd);
-      close(clientfd);
-      continue;
+    if(fds[0].revents & POLLIN) {
+      // Accept a new client connection
+      int32_t clientfd = accept(serverfd, NULL, NULL);
+      if (clientfd < 0) {
+        logmsg(s, LogLevelTrace, "ipc: Failed to accept IPC client connection.");
+        continue;
+      }
+      // Programs that ragnar launches do not inherit the connection
+      fcntl(clientfd, F_SETFD, fcntl(clientfd, F_GETFD) | FD_CLOEXEC);
+      if(nfds == ARRLEN(fds)) {
+        logmsg(s, LogLevelWarn, "ipc: Too many IPC connections, refusing FD: %i", clientfd);
+        close(clientfd);
+        continue;
+      }
+      fds[nfds++] = (struct pollfd){ .fd = clientfd, .events = POLLIN };
     }
-
-    // Handle the command
-    handlecmd(s, command_id, buf, len, clientfd);
-
-    // Close the client socket
-    close(clientfd);
   }
 }
 
+/**
+ * @brief Starts the thread that serves IPC clients. Their commands 
+ * are handled by the event loop (see handleipccommand).
+ *
+ * @param s The window manager's state
+ */
+void
+startipcserver(state_t* s) {
+  ipc_queue_t* q = &s->ipc;
+  q->pending = NULL;
+  q->eventfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if(q->eventfd == -1) {
+    logmsg(s, LogLevelError, "ipc: Failed to create the eventfd of the IPC queue.");
+    return;
+  }
+  pthread_mutex_init(&q->lock, NULL);
+  pthread_cond_init(&q->cond, NULL);
+
+  pthread_t thread;
+  if(pthread_create(&thread, NULL, ipcserverthread, s) != 0) {
+    logmsg(s, LogLevelError, "Failed to create IPC thread.");
+    pthread_mutex_destroy(&q->lock);
+    pthread_cond_destroy(&q->cond);
+    close(q->eventfd);
+    q->eventfd = -1;
+  }
+}
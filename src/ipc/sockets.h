@@ -1,3 +1,9 @@
 #pragma once
 
+#include "../structs.h"
+
 void* ipcserverthread(void* arg);
+void startipcserver(state_t* s);
+void handleipccommand(state_t* s);
+void handlecmd(state_t* s, uint8_t cmdid, const uint8_t* data, 
+               size_t len, int32_t clientfd);
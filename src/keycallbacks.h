@@ -1,6 +1,7 @@
 #pragma once
 #include "config.h"
 #include "funcs.h"
+#include "restart.h"
 #include "structs.h"
 
 #include <string.h>
@@ -28,17 +29,11 @@ inline void terminate_successfully(state_t* s, passthrough_data_t data) {
 */
 inline void cyclefocusdown(state_t* s, passthrough_data_t data) { 
   (void)data;
-  if (!s->monfocus->clients || !s->focus)
+  client_list_t* clients = visibleclients(s, s->monfocus);
+  if (!clients->size || !s->focus || !clientonscreen(s, s->focus, s->monfocus))
     return;
 
-  client_t* focus = NULL;
-  for (focus = s->focus->next; 
-      focus &&  focus->desktop != mondesktop(s, focus->mon)->idx;
-      focus = focus->next);
-  if (!focus)
-    for (focus = s->monfocus->clients; 
-        focus && focus->desktop != mondesktop(s, focus->mon)->idx; 
-        focus = focus->next);
+  client_t* focus = clients->items[(s->focus->slot + 1) % clients->size];
 
   if(!focus) return;
   focusclient(s, focus, false);
@@ -53,24 +48,11 @@ inline void cyclefocusdown(state_t* s, passthrough_data_t data) {
 */
 inline void cyclefocusup(state_t* s, passthrough_data_t data) { 
   (void)data;
-  if (!s->monfocus->clients || !s->focus)
+  client_list_t* clients = visibleclients(s, s->monfocus);
+  if (!clients->size || !s->focus || !clientonscreen(s, s->focus, s->monfocus))
     return;
 
-  client_t* focus = NULL;
-  client_t* cl;
-  for (cl = s->monfocus->clients; cl != s->focus; cl = cl->next) {
-    if (cl->desktop == mondesktop(s, cl->mon)->idx) {
-      focus = cl;
-    }
-  }
-  if(!focus) {
-    for (; cl; cl = cl->next) {
-      if (cl->desktop == mondesktop(s, cl->mon)->idx) {
-        focus = cl;
-      }
-    }
-  }
-  if (!focus) return;
+  client_t* focus = clients->items[(s->focus->slot + clients->size - 1) % clients->size];
   focusclient(s, focus, false);
   raiseclient(s, focus);
 }
@@ -280,9 +262,10 @@ inline void addfocustolayout(state_t* s, passthrough_data_t data) {
 inline void settiledmaster(state_t* s, passthrough_data_t data) { 
   (void)data;
 
-  for(client_t* cl = s->monfocus->clients; cl != NULL; cl = cl->next) {
-    if(!cl->is_scratchpad) {
-      cl->floating = false;
+  client_list_t* clients = visibleclients(s, s->monfocus);
+  for(uint32_t i = 0; i < clients->size; i++) {
+    if(!clients->items[i]->is_scratchpad) {
+      clients->items[i]->floating = false;
     }
   }
   uint32_t deskidx = mondesktop(s, s->monfocus)->idx;
@@ -304,9 +287,10 @@ inline void settiledmaster(state_t* s, passthrough_data_t data) {
 inline void setverticalstripes(state_t* s, passthrough_data_t data) { 
   (void)data;
 
-  for(client_t* cl = s->monfocus->clients; cl != NULL; cl = cl->next) {
-    if(clientonscreen(s, cl, s->monfocus) && !cl->is_scratchpad) {
-      cl->floating = false;
+  client_list_t* clients = visibleclients(s, s->monfocus);
+  for(uint32_t i = 0; i < clients->size; i++) {
+    if(!clients->items[i]->is_scratchpad) {
+      clients->items[i]->floating = false;
     }
   }
   uint32_t deskidx = mondesktop(s, s->monfocus)->idx;
@@ -328,9 +312,10 @@ inline void setverticalstripes(state_t* s, passthrough_data_t data) {
 inline void sethorizontalstripes(state_t* s, passthrough_data_t data) { 
   (void)data;
 
-  for(client_t* cl = s->monfocus->clients; cl != NULL; cl = cl->next) {
-    if(clientonscreen(s, cl, s->monfocus) && !cl->is_scratchpad) {
-      cl->floating = false;
+  client_list_t* clients = visibleclients(s, s->monfocus);
+  for(uint32_t i = 0; i < clients->size; i++) {
+    if(!clients->items[i]->is_scratchpad) {
+      clients->items[i]->floating = false;
     }
   }
   uint32_t deskidx = mondesktop(s, s->monfocus)->idx;
@@ -341,6 +326,62 @@ inline void sethorizontalstripes(state_t* s, passthrough_data_t data) {
   makelayout(s, s->monfocus);
 }
 
+/**
+ * @brief Sets the current layout to monocle, which only shows 
+ * the focused on-screen client and adds every on-screen client 
+ * to the layout.
+ *
+ * @param s The window manager's state 
+ * @param data The data to use for the function (unused here)
+ */
+inline void setmonocle(state_t* s, passthrough_data_t data) { 
+  (void)data;
+
+  client_list_t* clients = visibleclients(s, s->monfocus);
+  for(uint32_t i = 0; i < clients->size; i++) {
+    if(!clients->items[i]->is_scratchpad) {
+      clients->items[i]->floating = false;
+    }
+  }
+  uint32_t deskidx = mondesktop(s, s->monfocus)->idx;
+  s->monfocus->layouts[deskidx].curlayout = LayoutMonocle;
+  if(s->focus && clientonscreen(s, s->focus, s->monfocus) && !s->focus->floating) {
+    s->monfocus->layouts[deskidx].active = s->focus;
+  }
+
+  resetlayoutsizes(s, s->monfocus);
+
+  makelayout(s, s->monfocus);
+}
+
+/**
+ * @brief Sets the current layout to tabbed, which only shows 
+ * the focused on-screen client below a bar with a tab for every 
+ * on-screen client and adds every on-screen client to the layout.
+ *
+ * @param s The window manager's state 
+ * @param data The data to use for the function (unused here)
+ */
+inline void settabbed(state_t* s, passthrough_data_t data) { 
+  (void)data;
+
+  client_list_t* clients = visibleclients(s, s->monfocus);
+  for(uint32_t i = 0; i < clients->size; i++) {
+    if(!clients->items[i]->is_scratchpad) {
+      clients->items[i]->floating = false;
+    }
+  }
+  uint32_t deskidx = mondesktop(s, s->monfocus)->idx;
+  s->monfocus->layouts[deskidx].curlayout = LayoutTabbed;
+  if(s->focus && clientonscreen(s, s->focus, s->monfocus) && !s->focus->floating) {
+    s->monfocus->layouts[deskidx].active = s->focus;
+  }
+
+  resetlayoutsizes(s, s->monfocus);
+
+  makelayout(s, s->monfocus);
+}
+
 /**
  * @brief Sets the current layout to floating 
  * and removes every on-screen client to the layout
@@ -352,10 +393,9 @@ inline void sethorizontalstripes(state_t* s, passthrough_data_t data) {
 inline void setfloatingmode(state_t* s, passthrough_data_t data) { 
   (void)data;
 
-  for(client_t* cl = s->monfocus->clients; cl != NULL; cl = cl->next) {
-    if(clientonscreen(s, cl, s->monfocus)) {
-      cl->floating = true;
-    }
+  client_list_t* clients = visibleclients(s, s->monfocus);
+  for(uint32_t i = 0; i < clients->size; i++) {
+    clients->items[i]->floating = true;
   }
   uint32_t deskidx = mondesktop(s, s->monfocus)->idx;
   s->monfocus->layouts[deskidx].curlayout = LayoutFloating;
@@ -374,6 +414,7 @@ inline void updatebarslayout(state_t* s, passthrough_data_t data) {
   // Gather strut information 
   s->nwinstruts = 0;
   getwinstruts(s, s->root);
+  invalidatelayouts(s);
   makelayout(s, s->monfocus);
 }
 
@@ -386,19 +427,13 @@ inline void updatebarslayout(state_t* s, passthrough_data_t data) {
  */
 inline void cycledownlayout(state_t* s, passthrough_data_t data) { 
   (void)data;
-  if (!s->monfocus->clients || !s->focus)
+  client_list_t* clients = visibleclients(s, s->monfocus);
+  if (!clients->size || !s->focus || !clientonscreen(s, s->focus, s->monfocus))
     return;
   
   s->ignore_enter_layout = true;
 
-  client_t* focus = NULL;
-  for (focus = s->focus->next; 
-      focus &&  focus->desktop != mondesktop(s, focus->mon)->idx;
-      focus = focus->next);
-  if (!focus)
-    for (focus = s->monfocus->clients; 
-        focus && focus->desktop != mondesktop(s, focus->mon)->idx; 
-        focus = focus->next);
+  client_t* focus = clients->items[(s->focus->slot + 1) % clients->size];
 
   if(!focus) return;
 
@@ -416,26 +451,13 @@ inline void cycledownlayout(state_t* s, passthrough_data_t data) {
  */
 inline void cycleuplayout(state_t* s, passthrough_data_t data) { 
   (void)data;
-  if (!s->monfocus->clients || !s->focus)
+  client_list_t* clients = visibleclients(s, s->monfocus);
+  if (!clients->size || !s->focus || !clientonscreen(s, s->focus, s->monfocus))
     return;
 
   s->ignore_enter_layout = true;
 
-  client_t* focus = NULL;
-  client_t* cl;
-  for (cl = s->monfocus->clients; cl != s->focus; cl = cl->next) {
-    if (cl->desktop == mondesktop(s, cl->mon)->idx) {
-      focus = cl;
-    }
-  }
-  if(!focus) {
-    for (; cl; cl = cl->next) {
-      if (cl->desktop == mondesktop(s, cl->mon)->idx) {
-        focus = cl;
-      }
-    }
-  }
-  if (!focus) return;
+  client_t* focus = clients->items[(s->focus->slot + clients->size - 1) % clients->size];
 
   swapclients(s, s->focus, focus);
   resetlayoutsizes(s, s->monfocus);
@@ -571,12 +593,15 @@ inline void inclayoutsizefocus(state_t* s, passthrough_data_t data) {
 
   // The last client cannot change size itself as it is only 
   // influenced by the client ontop of it
-  if(!s->focus->next || (s->focus->next && s->focus->next->desktop != s->focus->desktop)
-      || (s->focus->next && s->focus->next->mon != s->focus->mon)) return;
+  client_list_t* clients = &s->focus->mon->clients[s->focus->desktop];
+  if(s->focus->slot + 1 >= clients->size) return;
+  client_t* next = clients->items[s->focus->slot + 1];
 
+  clients = visibleclients(s, s->monfocus);
   uint32_t i = 0;
-  for(client_t* cl = s->monfocus->clients; cl != NULL; cl = cl->next) {
-    if(cl->floating || cl->desktop != mondesktop(s, cl->mon)->idx) continue;
+  for(uint32_t j = 0; j < clients->size; j++) {
+    client_t* cl = clients->items[j];
+    if(cl->floating) continue;
     if(i == nmaster - 1 && cl == s->focus) {
       return;
     }
@@ -585,12 +610,12 @@ inline void inclayoutsizefocus(state_t* s, passthrough_data_t data) {
 
   // If the height of the window influenced by the focus is smaller 
   // than the minimum height a window can be in the layout, return
-  float nextsize = horizontal ? s->focus->next->area.size.y : s->focus->next->area.size.x;
+  float nextsize = horizontal ? next->area.size.y : next->area.size.x;
   if(nextsize - s->config.layoutsize_step < s->config.layoutsize_min) {
     if(horizontal) {
-      s->focus->next->area.size.y = s->config.layoutsize_min;
+      next->area.size.y = s->config.layoutsize_min;
     } else {
-      s->focus->next->area.size.x = s->config.layoutsize_min;
+      next->area.size.x = s->config.layoutsize_min;
     }
     return;
   }
@@ -627,13 +652,14 @@ inline void declayoutsizefocus(state_t* s, passthrough_data_t data) {
 
   // The last client cannot change size itself as it is only 
   // influenced by the client ontop of it
-  if(!s->focus->next || (s->focus->next && s->focus->next->desktop != s->focus->desktop)
-      || (s->focus->next && s->focus->next->mon != s->focus->mon)) return;
-  
+  client_list_t* clients = &s->focus->mon->clients[s->focus->desktop];
+  if(s->focus->slot + 1 >= clients->size) return;
+
+  clients = visibleclients(s, s->monfocus);
   uint32_t i = 0;
-  for(client_t* cl = s->monfocus->clients; cl != NULL; cl = cl->next) {
-    if(cl->floating || cl->desktop != mondesktop(s, cl->mon)->idx
-      || cl->mon != s->monfocus) continue;
+  for(uint32_t j = 0; j < clients->size; j++) {
+    client_t* cl = clients->items[j];
+    if(cl->floating) continue;
     if(i == nmaster - 1 && cl == s->focus) {
       return;
     }
@@ -765,8 +791,9 @@ inline void movefocusright(state_t* s, passthrough_data_t data) {
 
 
 /**
- * @brief Cycles the currently focused client one monitor 
- * down (to the left).
+ * @brief Cycles the currently focused client to the previous 
+ * monitor when all monitors are ordered top to bottom and then 
+ * left to right, wrapping around to the last monitor.
  *
  * @param s The window manager's state
  * @param data The data to use for the function (unused here)
@@ -775,177 +802,141 @@ inline void movefocusright(state_t* s, passthrough_data_t data) {
 inline void cyclefocusmonitordown(state_t* s, passthrough_data_t data) {
   (void)data;
   if(!s->focus) return;
-  s->ignore_enter_layout = true;
-
-  monitor_t* prevmon = NULL;
-  if(s->focus->mon == s->monitors) {
-    for(monitor_t* mon = s->monitors; mon; mon = mon->next) {
-      prevmon = mon;
-    }
-  } else {
-  for(monitor_t* mon = s->monitors; mon && mon->next; mon = mon->next) {
-    if(mon->next == s->focus->mon) {
-      prevmon = mon;
-      break;
-    }
-  }
-  }
-
-  if(!prevmon) return;
-
-  area_t afocusmon = s->focus->mon->area;
-
-  bool fs = s->focus->fullscreen;
-  bool floating = s->focus->floating;
-  if(fs) {
-    setfullscreen(s, s->focus, false);
-  }
-
-  // Unset fullscreen for all clients on the 
-  // previous monitor
-  for(client_t* cl = prevmon->clients; cl != NULL; cl = cl->next) {
-    if(cl->fullscreen) {
-      setfullscreen(s, cl, false);
-      cl->floating = floating;
-    }
-  }
-
-  // Moving
-  {
-    v2_t relpos;
-    relpos.x = s->focus->area.pos.x - afocusmon.pos.x;
-    relpos.y = s->focus->area.pos.y - afocusmon.pos.y;
-
-    float normx = relpos.x / afocusmon.size.x; 
-    float normy = relpos.y / afocusmon.size.y; 
-
-    v2_t dest;
-    dest.x = prevmon->area.pos.x + (normx * prevmon->area.size.x); 
-    dest.y = prevmon->area.pos.y + (normy * prevmon->area.size.y); 
-
-    removefromlayout(s, s->focus);
-    makelayout(s, s->focus->mon);
-    s->focus->floating = floating;
-
-    moveclient(s, s->focus, dest, false);
+  sendclienttomon(s, s->focus, moncycle(s, s->focus->mon, false));
+}
 
-    monremoveclient(s->focus->mon, s->focus);
-    monaddclient(prevmon, s->focus);
-    s->focus->mon = prevmon;
-    updateewmhdesktops(s, s->focus->mon);
-    s->monfocus = s->focus->mon;
-    s->focus->desktop = mondesktop(s, s->focus->mon)->idx;
-  }
+/**
+ * @brief Cycles the currently focused client to the next 
+ * monitor when all monitors are ordered top to bottom and then 
+ * left to right, wrapping around to the first monitor.
+ *
+ * @param s The window manager's state
+ * @param data The data to use for the function (unused here)
+ */ 
 
-  // Resizing
-  {
-    float scalex = prevmon->area.size.x / afocusmon.size.x;
-    float scaley = prevmon->area.size.y / afocusmon.size.y;
+inline void cyclefocusmonitorup(state_t* s, passthrough_data_t data) {
+  (void)data;
+  if(!s->focus) return;
+  sendclienttomon(s, s->focus, moncycle(s, s->focus->mon, true));
+}
 
-    v2_t dest;
-    dest.x = s->focus->area.size.x * scalex;
-    dest.y = s->focus->area.size.y * scaley;
+/**
+ * @brief Moves the currently focused client to the monitor 
+ * left of its monitor.
+ *
+ * @param s The window manager's state
+ * @param data The data to use for the function (unused here)
+ */ 
 
-    resizeclient(s, s->focus, dest);
-  }
+inline void movefocusmonitorleft(state_t* s, passthrough_data_t data) {
+  (void)data;
+  if(!s->focus) return;
+  sendclienttomon(s, s->focus, monindirection(s, s->focus->mon, DirectionLeft));
+}
 
-  makelayout(s, prevmon);
+/**
+ * @brief Moves the currently focused client to the monitor 
+ * right of its monitor.
+ *
+ * @param s The window manager's state
+ * @param data The data to use for the function (unused here)
+ */ 
 
-  if(fs) {
-    setfullscreen(s, s->focus, true);
-  }
+inline void movefocusmonitorright(state_t* s, passthrough_data_t data) {
+  (void)data;
+  if(!s->focus) return;
+  sendclienttomon(s, s->focus, monindirection(s, s->focus->mon, DirectionRight));
 }
 
 /**
- * @brief Cycles the currently focused client one monitor 
- * down (to the left).
+ * @brief Moves the currently focused client to the monitor 
+ * above its monitor.
  *
  * @param s The window manager's state
  * @param data The data to use for the function (unused here)
  */ 
 
-inline void cyclefocusmonitorup(state_t* s, passthrough_data_t data) {
+inline void movefocusmonitorup(state_t* s, passthrough_data_t data) {
   (void)data;
   if(!s->focus) return;
+  sendclienttomon(s, s->focus, monindirection(s, s->focus->mon, DirectionUp));
+}
 
-  s->ignore_enter_layout = true;
+/**
+ * @brief Moves the currently focused client to the monitor 
+ * below its monitor.
+ *
+ * @param s The window manager's state
+ * @param data The data to use for the function (unused here)
+ */ 
 
-  monitor_t* nextmon = s->focus->mon->next;
-  if(!nextmon) {
-    nextmon = s->monitors; 
-  }
-  if(!nextmon) return;
+inline void movefocusmonitordown(state_t* s, passthrough_data_t data) {
+  (void)data;
+  if(!s->focus) return;
+  sendclienttomon(s, s->focus, monindirection(s, s->focus->mon, DirectionDown));
+}
 
-  area_t afocusmon = s->focus->mon->area;
+/**
+ * @brief Focuses the monitor left of the focused monitor.
+ *
+ * @param s The window manager's state
+ * @param data The data to use for the function (unused here)
+ */ 
 
-  bool fs = s->focus->fullscreen;
-  bool floating = s->focus->floating;
+inline void focusmonitorleft(state_t* s, passthrough_data_t data) {
+  (void)data;
+  focusmon(s, monindirection(s, s->monfocus, DirectionLeft));
+}
 
-  if(fs) {
-    setfullscreen(s, s->focus, false);
-  }
- 
-  // Unset fullscreen for all clients on the 
-  // next monitor
-  for(client_t* cl = nextmon->clients; cl != NULL; cl = cl->next) {
-    if(cl->fullscreen) {
-      setfullscreen(s, cl, false);
-      cl->floating = floating;
-    }
-  }
+/**
+ * @brief Focuses the monitor right of the focused monitor.
+ *
+ * @param s The window manager's state
+ * @param data The data to use for the function (unused here)
+ */ 
 
-  // Moving
-  {
-    v2_t relpos;
-    relpos.x = s->focus->area.pos.x - afocusmon.pos.x;
-    relpos.y = s->focus->area.pos.y - afocusmon.pos.y;
-
-    float normx = relpos.x / afocusmon.size.x; 
-    float normy = relpos.y / afocusmon.size.y; 
-
-    v2_t dest;
-    dest.x = nextmon->area.pos.x + (normx * nextmon->area.size.x); 
-    dest.y = nextmon->area.pos.y + (normy * nextmon->area.size.y); 
-
-    removefromlayout(s, s->focus);
-    makelayout(s, s->focus->mon);
-    s->focus->floating = floating;
-    moveclient(s, s->focus, dest, false);
-
-    monremoveclient(s->focus->mon, s->focus);
-    monaddclient(nextmon, s->focus);
-    s->focus->mon = nextmon;
-    updateewmhdesktops(s, s->focus->mon);
-    s->monfocus = s->focus->mon;
-    s->focus->desktop = mondesktop(s, s->focus->mon)->idx;
-  }
-  // Resizing
-  {
-    float scalex = nextmon->area.size.x / afocusmon.size.x;
-    float scaley = nextmon->area.size.y / afocusmon.size.y;
+inline void focusmonitorright(state_t* s, passthrough_data_t data) {
+  (void)data;
+  focusmon(s, monindirection(s, s->monfocus, DirectionRight));
+}
 
-    v2_t dest;
-    dest.x = s->focus->area.size.x * scalex;
-    dest.y = s->focus->area.size.y * scaley;
+/**
+ * @brief Focuses the monitor above the focused monitor.
+ *
+ * @param s The window manager's state
+ * @param data The data to use for the function (unused here)
+ */ 
 
-    resizeclient(s, s->focus, dest);
-  }
+inline void focusmonitorup(state_t* s, passthrough_data_t data) {
+  (void)data;
+  focusmon(s, monindirection(s, s->monfocus, DirectionUp));
+}
 
-  makelayout(s, nextmon);
+/**
+ * @brief Focuses the monitor below the focused monitor.
+ *
+ * @param s The window manager's state
+ * @param data The data to use for the function (unused here)
+ */ 
 
-  if(fs) {
-    setfullscreen(s, s->focus, true);
-  }
+inline void focusmonitordown(state_t* s, passthrough_data_t data) {
+  (void)data;
+  focusmon(s, monindirection(s, s->monfocus, DirectionDown));
 }
 
 inline void togglescratchpad(state_t* s, passthrough_data_t data) {
   if(s->scratchpads[data.i].needs_restart) {
-    s->mapping_scratchpad_index = data.i;
-    runcmd(s, data);
+    launchscratchpad(s, data.i, data.cmd, false);
+    return;
+  }
+  // The window of a launched scratchpad has not mapped yet
+  if(s->scratchpads[data.i].pending) {
+    s->scratchpads[data.i].hidden = !s->scratchpads[data.i].hidden;
     return;
   }
 
   client_t* cl = clientfromwin(s, s->scratchpads[data.i].win);
+  if(!cl) return;
 
   if(s->scratchpads[data.i].hidden) {
     showclient(s, cl);
@@ -961,3 +952,8 @@ inline void reloadconfigfile(state_t* s, passthrough_data_t data) {
   (void)data;
   reloadconfig(s, &s->config);
 }
+
+inline void restartwm(state_t* s, passthrough_data_t data) {
+  (void)data;
+  execrestart(s);
+}
@@ -0,0 +1,220 @@
+#include "pool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Offset of the first block within a string pool chunk 
+ * (keeps blocks aligned for the free list pointers) */
+#define STRPOOL_CHUNK_HEADER 16
+/* Size class header of strings that are allocated with malloc */
+#define STRPOOL_LARGE STRPOOL_NUMCLASSES
+
+static client_slab_t* addclientslab(client_pool_t* pool);
+static uint32_t strclass(size_t size);
+
+client_slab_t*
+addclientslab(client_pool_t* pool) {
+  client_slab_t* slab = malloc(sizeof(*slab));
+  if(!slab) return NULL;
+
+  // Chain all slots of the slab into its free list
+  slab->freelist = NULL;
+  for(int32_t i = CLIENT_SLAB_SIZE - 1; i >= 0; i--) {
+    slab->slots[i].slab = slab;
+    slab->slots[i].nextfree = slab->freelist;
+    slab->freelist = &slab->slots[i];
+  }
+  slab->used = 0;
+
+  slab->prev = NULL;
+  slab->next = pool->slabs;
+  if(pool->slabs) {
+    pool->slabs->prev = slab;
+  }
+  pool->slabs = slab;
+  pool->numslabs++;
+  return slab;
+}
+
+/* Returns a zeroed client whose props point to the properties 
+ * that are stored next to it. Returns NULL if out of memory. */
+client_t*
+poolallocclient(client_pool_t* pool) {
+  client_slab_t* slab = pool->slabs;
+  while(slab && !slab->freelist) {
+    slab = slab->next;
+  }
+  if(!slab && !(slab = addclientslab(pool))) {
+    return NULL;
+  }
+
+  client_slot_t* slot = slab->freelist;
+  slab->freelist = slot->nextfree;
+  slab->used++;
+
+  memset(&slot->cl, 0, sizeof(slot->cl));
+  memset(&slot->props, 0, sizeof(slot->props));
+  slot->cl.props = &slot->props;
+
+  pool->live++;
+  if(pool->live > pool->peak) {
+    pool->peak = pool->live;
+  }
+  return &slot->cl;
+}
+
+/* Returns a client to its slab. Slabs that become empty are given 
+ * back to the system as long as another slab remains. */
+void
+poolfreeclient(client_pool_t* pool, client_t* cl) {
+  if(!cl) return;
+  client_slot_t* slot = (client_slot_t*)cl;
+  client_slab_t* slab = slot->slab;
+
+  slot->nextfree = slab->freelist;
+  slab->freelist = slot;
+  slab->used--;
+  pool->live--;
+
+  if(slab->used || pool->numslabs == 1) return;
+
+  if(slab->prev) {
+    slab->prev->next = slab->next;
+  } else {
+    pool->slabs = slab->next;
+  }
+  if(slab->next) {
+    slab->next->prev = slab->prev;
+  }
+  pool->numslabs--;
+  free(slab);
+}
+
+void
+destroyclientpool(client_pool_t* pool) {
+  client_slab_t* slab = pool->slabs;
+  while(slab) {
+    client_slab_t* next = slab->next;
+    free(slab);
+    slab = next;
+  }
+  pool->slabs = NULL;
+  pool->numslabs = 0;
+  pool->live = 0;
+}
+
+/* Returns the smallest size class (16 << class bytes) that 
+ * fits the given size or STRPOOL_LARGE if none does. */
+uint32_t
+strclass(size_t size) {
+  uint32_t cls = 0;
+  while(cls < STRPOOL_NUMCLASSES && size > (16u << cls)) {
+    cls++;
+  }
+  return cls;
+}
+
+/* Copies the first len bytes of a string into the pool. Each block 
+ * stores its size class in the byte before the string. */
+char*
+pooldupstr(string_pool_t* pool, const char* str, size_t len) {
+  size_t size = len + 2;
+  uint32_t cls = strclass(size);
+  uint8_t* block;
+
+  if(cls == STRPOOL_LARGE) {
+    // Large strings remember their size in front of the class byte
+    uint8_t* base = malloc(sizeof(size_t) + size);
+    if(!base) return NULL;
+    memcpy(base, &size, sizeof(size));
+    block = base + sizeof(size_t);
+    pool->bytes += sizeof(size_t) + size;
+  } else if(pool->freelists[cls]) {
+    block = pool->freelists[cls];
+    pool->freelists[cls] = *(void**)block;
+  } else {
+    size_t blocksize = 16u << cls;
+    // Start a new chunk if the current one is used up
+    if(!pool->chunkpos || (size_t)(pool->chunkend - pool->chunkpos) < blocksize) {
+      strpool_chunk_t* chunk = malloc(STRPOOL_CHUNK_SIZE);
+      if(!chunk) return NULL;
+      chunk->next = pool->chunks;
+      pool->chunks = chunk;
+      pool->chunkpos = (uint8_t*)chunk + STRPOOL_CHUNK_HEADER;
+      pool->chunkend = (uint8_t*)chunk + STRPOOL_CHUNK_SIZE;
+      pool->bytes += STRPOOL_CHUNK_SIZE;
+    }
+    block = pool->chunkpos;
+    pool->chunkpos += blocksize;
+  }
+
+  block[0] = (uint8_t)cls;
+  char* ret = (char*)block + 1;
+  memcpy(ret, str, len);
+  ret[len] = '\0';
+
+  pool->live++;
+  if(pool->live > pool->peak) {
+    pool->peak = pool->live;
+  }
+  return ret;
+}
+
+void
+poolfreestr(string_pool_t* pool, char* str) {
+  if(!str) return;
+  uint8_t* block = (uint8_t*)str - 1;
+  uint32_t cls = block[0];
+  pool->live--;
+
+  if(cls == STRPOOL_LARGE) {
+    uint8_t* base = block - sizeof(size_t);
+    size_t size;
+    memcpy(&size, base, sizeof(size));
+    pool->bytes -= sizeof(size_t) + size;
+    free(base);
+    return;
+  }
+  *(void**)block = pool->freelists[cls];
+  pool->freelists[cls] = block;
+}
+
+/* Replaces the contents of a pool string with the first len bytes of 
+ * another string. The block of the string is reused if it is large 
+ * enough, so the returned string is the given one in most cases. */
+char*
+poolsetstr(string_pool_t* pool, char* str, const char* src, size_t len) {
+  if(str) {
+    uint8_t* block = (uint8_t*)str - 1;
+    uint32_t cls = block[0];
+    size_t capacity;
+    if(cls == STRPOOL_LARGE) {
+      memcpy(&capacity, block - sizeof(size_t), sizeof(capacity));
+    } else {
+      capacity = 16u << cls;
+    }
+    if(len + 2 <= capacity) {
+      memcpy(str, src, len);
+      str[len] = '\0';
+      return str;
+    }
+    poolfreestr(pool, str);
+  }
+  return pooldupstr(pool, src, len);
+}
+
+/* Frees all chunks of the pool. Strings that are too large 
+ * for a size class need to be freed before. */
+void
+destroystrpool(string_pool_t* pool) {
+  strpool_chunk_t* chunk = pool->chunks;
+  while(chunk) {
+    strpool_chunk_t* next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+  memset(pool->freelists, 0, sizeof(pool->freelists));
+  pool->chunks = NULL;
+  pool->chunkpos = pool->chunkend = NULL;
+  pool->bytes = 0;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "structs.h"
+
+client_t* poolallocclient(client_pool_t* pool);
+void poolfreeclient(client_pool_t* pool, client_t* cl);
+void destroyclientpool(client_pool_t* pool);
+
+char* pooldupstr(string_pool_t* pool, const char* str, size_t len);
+void poolfreestr(string_pool_t* pool, char* str);
+char* poolsetstr(string_pool_t* pool, char* str, const char* src, size_t len);
+void destroystrpool(string_pool_t* pool);
@@ -0,0 +1,372 @@
+#include "propfetch.h"
+#include "funcs.h"
+#include "pool.h"
+#include "xbackend.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <xcb/xcb_icccm.h>
+
+/* Connection that properties are fetched on, which is either the 
+ * fetcher's own connection or the backend of the state */
+typedef struct {
+  const x_backend_t* x;
+  void* ctx;
+  /* Where the requests are counted (NULL on the fetcher's own connection) */
+  x_stats_t* stats;
+} prop_con_t;
+
+static void* propfetchthread(void* arg);
+static xcb_get_property_cookie_t requestprop(const prop_con_t* con, xcb_window_t win, 
+                                             xcb_atom_t prop, xcb_atom_t type, uint32_t len);
+static xcb_get_property_reply_t* replyprop(const prop_con_t* con, xcb_get_property_cookie_t cookie);
+static void requestname(const prop_fetcher_t* pf, const prop_con_t* con, xcb_window_t win, 
+                        xcb_get_property_cookie_t cookies[2]);
+static char* replyname(const prop_con_t* con, xcb_get_property_cookie_t cookies[2], uint32_t* len);
+static void fetchprops(const prop_fetcher_t* pf, const prop_con_t* con, 
+                       prop_request_t* requests, prop_result_t** results);
+static void applypropresult(state_t* s, client_t* cl, const prop_result_t* res);
+
+xcb_get_property_cookie_t
+requestprop(const prop_con_t* con, xcb_window_t win, xcb_atom_t prop, xcb_atom_t type, uint32_t len) {
+  if(con->stats) con->stats->requests++;
+  return con->x->getpropertyrequest(con->ctx, 0, win, prop, type, 0, len);
+}
+
+xcb_get_property_reply_t*
+replyprop(const prop_con_t* con, xcb_get_property_cookie_t cookie) {
+  if(con->stats) con->stats->roundtrips++;
+  return con->x->getpropertyreply(con->ctx, cookie);
+}
+
+/* Requests the UTF-8 _NET_WM_NAME and the WM_NAME of a window */
+void
+requestname(const prop_fetcher_t* pf, const prop_con_t* con, xcb_window_t win, 
+            xcb_get_property_cookie_t cookies[2]) {
+  cookies[0] = requestprop(con, win, pf->netwmname, pf->utf8string, UINT32_MAX);
+  // WM_NAME is a text property of any encoding
+  cookies[1] = requestprop(con, win, XCB_ATOM_WM_NAME, XCB_GET_PROPERTY_TYPE_ANY, UINT32_MAX);
+}
+
+/* Returns the name of a window (malloc'd), preferring _NET_WM_NAME over WM_NAME */
+char*
+replyname(const prop_con_t* con, xcb_get_property_cookie_t cookies[2], uint32_t* len) {
+  char* name = NULL;
+  // The WM_NAME reply is always read so that it does not linger in the connection
+  xcb_get_property_reply_t* replies[2] = { replyprop(con, cookies[0]), replyprop(con, cookies[1]) };
+  for(uint32_t i = 0; i < 2 && !name; i++) {
+    xcb_get_property_reply_t* reply = replies[i];
+    if(reply && reply->type != XCB_NONE && reply->format == 8 && xcb_get_property_value_length(reply) > 0) {
+      *len = xcb_get_property_value_length(reply);
+      name = malloc(*len + 1);
+      memcpy(name, xcb_get_property_value(reply), *len);
+      name[*len] = '\0';
+    }
+  }
+  free(replies[0]);
+  free(replies[1]);
+  return name;
+}
+
+/* Fetches the properties of a batch of requests, sending every 
+ * request before waiting for the first reply */
+void
+fetchprops(const prop_fetcher_t* pf, const prop_con_t* con, 
+           prop_request_t* requests, prop_result_t** results) {
+  uint32_t n = 0;
+  for(prop_request_t* req = requests; req != NULL; req = req->next) {
+    n++;
+  }
+  xcb_get_property_cookie_t (*namecookies)[2] = malloc(sizeof(*namecookies) * n);
+  xcb_get_property_cookie_t* hintscookies = malloc(sizeof(*hintscookies) * n);
+
+  uint32_t i = 0;
+  for(prop_request_t* req = requests; req != NULL; req = req->next, i++) {
+    if(req->what & PropFetchName) {
+      requestname(pf, con, req->win, namecookies[i]);
+    }
+    if(req->what & PropFetchHints) {
+      hintscookies[i] = requestprop(con, req->win, XCB_ATOM_WM_HINTS, XCB_ATOM_WM_HINTS, 
+                                    XCB_ICCCM_NUM_WM_HINTS_ELEMENTS);
+    }
+  }
+
+  i = 0;
+  prop_result_t* last = NULL;
+  for(prop_request_t* req = requests; req != NULL; req = req->next, i++) {
+    prop_result_t* res = calloc(1, sizeof(*res));
+    res->win = req->win;
+    res->what = req->what;
+    if(req->what & PropFetchName) {
+      res->name = replyname(con, namecookies[i], &res->namelen);
+    }
+    if(req->what & PropFetchHints) {
+      xcb_get_property_reply_t* reply = replyprop(con, hintscookies[i]);
+      res->hashints = reply && xcb_icccm_get_wm_hints_from_reply(&res->hints, reply);
+      free(reply);
+    }
+    if(last) {
+      last->next = res;
+    } else {
+      *results = res;
+    }
+    last = res;
+  }
+  free(namecookies);
+  free(hintscookies);
+}
+
+void*
+propfetchthread(void* arg) {
+  prop_fetcher_t* pf = arg;
+
+  pthread_mutex_lock(&pf->lock);
+  while(pf->running) {
+    if(!pf->requests) {
+      pthread_cond_wait(&pf->cond, &pf->lock);
+      continue;
+    }
+    // Take every queued request at once so that they are fetched in one round trip
+    prop_request_t* requests = pf->requests;
+    pf->requests = pf->lastrequest = NULL;
+    pthread_mutex_unlock(&pf->lock);
+
+    prop_result_t* results = NULL;
+    prop_con_t con = { .x = &xcbbackend, .ctx = pf->con };
+    fetchprops(pf, &con, requests, &results);
+    while(requests) {
+      prop_request_t* next = requests->next;
+      free(requests);
+      requests = next;
+    }
+
+    pthread_mutex_lock(&pf->lock);
+    if(results) {
+      prop_result_t* last = results;
+      while(last->next) {
+        last = last->next;
+      }
+      if(pf->lastresult) {
+        pf->lastresult->next = results;
+      } else {
+        pf->results = results;
+      }
+      pf->lastresult = last;
+      uint64_t one = 1;
+      if(write(pf->eventfd, &one, sizeof(one)) != sizeof(one)) {
+        // The counter is already non-zero, so the main loop wakes up anyway
+      }
+    }
+  }
+  pthread_mutex_unlock(&pf->lock);
+  return NULL;
+}
+
+/**
+ * @brief Opens the X connection of the property fetcher and starts 
+ * its thread. If this fails, properties are fetched synchronously.
+ *
+ * @param s The window manager's state
+ *
+ * @return Whether or not the property fetcher was started
+ */
+bool
+startpropfetcher(state_t* s) {
+  prop_fetcher_t* pf = &s->propfetcher;
+  memset(pf, 0, sizeof(*pf));
+  pf->eventfd = -1;
+  pf->netwmname = s->ewmh_atoms[EWMHname];
+  pf->utf8string = s->wm_atoms[WMutf8String];
+  // Without an X connection (see fakex.h) properties are fetched through the backend
+  if(!s->con) return false;
+
+  pf->con = xcb_connect(NULL, NULL);
+  if(!pf->con || xcb_connection_has_error(pf->con)) {
+    logmsg(s, LogLevelWarn, "failed to open the property fetcher's X connection.");
+    if(pf->con) xcb_disconnect(pf->con);
+    pf->con = NULL;
+    return false;
+  }
+  pf->eventfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if(pf->eventfd == -1) {
+    logmsg(s, LogLevelWarn, "failed to create the property fetcher's eventfd.");
+    xcb_disconnect(pf->con);
+    pf->con = NULL;
+    return false;
+  }
+
+  pthread_mutex_init(&pf->lock, NULL);
+  pthread_cond_init(&pf->cond, NULL);
+  pf->running = true;
+  if(pthread_create(&pf->thread, NULL, propfetchthread, pf) != 0) {
+    logmsg(s, LogLevelWarn, "failed to create the property fetcher thread.");
+    pthread_mutex_destroy(&pf->lock);
+    pthread_cond_destroy(&pf->cond);
+    close(pf->eventfd);
+    pf->eventfd = -1;
+    xcb_disconnect(pf->con);
+    pf->con = NULL;
+    pf->running = false;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Stops the thread of the property fetcher and 
+ * drops every request and result that is still queued.
+ *
+ * @param s The window manager's state
+ */
+void
+stoppropfetcher(state_t* s) {
+  prop_fetcher_t* pf = &s->propfetcher;
+  if(!pf->con) return;
+
+  pthread_mutex_lock(&pf->lock);
+  pf->running = false;
+  pthread_cond_signal(&pf->cond);
+  pthread_mutex_unlock(&pf->lock);
+  pthread_join(pf->thread, NULL);
+
+  while(pf->requests) {
+    prop_request_t* next = pf->requests->next;
+    free(pf->requests);
+    pf->requests = next;
+  }
+  while(pf->results) {
+    prop_result_t* next = pf->results->next;
+    free(pf->results->name);
+    free(pf->results);
+    pf->results = next;
+  }
+  pthread_mutex_destroy(&pf->lock);
+  pthread_cond_destroy(&pf->cond);
+  close(pf->eventfd);
+  xcb_disconnect(pf->con);
+  pf->con = NULL;
+  pf->eventfd = -1;
+}
+
+/**
+ * @brief Applies fetched properties to a client.
+ *
+ * @param s The window manager's state
+ * @param cl The client the properties belong to
+ * @param res The fetched properties
+ */
+void
+applypropresult(state_t* s, client_t* cl, const prop_result_t* res) {
+  if(res->what & PropFetchName) {
+    if(!res->name) {
+      poolfreestr(&s->strpool, cl->props->name);
+      cl->props->name = NULL;
+    } else if(!cl->props->name || strcmp(cl->props->name, res->name) != 0) {
+      // The name is copied into the client's current buffer if it fits
+      cl->props->name = poolsetstr(&s->strpool, cl->props->name, res->name, res->namelen);
+    }
+  }
+  if((res->what & PropFetchHints) && res->hashints) {
+    applyclienthints(s, cl, &res->hints);
+  }
+}
+
+/**
+ * @brief Requests properties of a given client. They are fetched by 
+ * the property fetcher's thread and applied once the main loop 
+ * handles the results, or fetched right away if there is no thread.
+ *
+ * @param s The window manager's state
+ * @param cl The client to fetch the properties of
+ * @param what The properties to fetch (prop_fetch_t)
+ */
+void
+fetchclientprops(state_t* s, client_t* cl, uint32_t what) {
+  prop_fetcher_t* pf = &s->propfetcher;
+  if(!pf->con) {
+    prop_request_t req = { .win = cl->win, .what = what };
+    prop_result_t* res = NULL;
+    prop_con_t con = { .x = s->x, .ctx = s->xctx, .stats = &s->xstats };
+    fetchprops(pf, &con, &req, &res);
+    applypropresult(s, cl, res);
+    free(res->name);
+    free(res);
+    return;
+  }
+
+  prop_request_t* req = malloc(sizeof(*req));
+  *req = (prop_request_t){ .win = cl->win, .what = what };
+
+  pthread_mutex_lock(&pf->lock);
+  // Merge with a request for the same window that was not fetched yet
+  for(prop_request_t* it = pf->requests; it != NULL; it = it->next) {
+    if(it->win == cl->win) {
+      it->what |= what;
+      pthread_mutex_unlock(&pf->lock);
+      free(req);
+      return;
+    }
+  }
+  if(pf->lastrequest) {
+    pf->lastrequest->next = req;
+  } else {
+    pf->requests = req;
+  }
+  pf->lastrequest = req;
+  pthread_cond_signal(&pf->cond);
+  pthread_mutex_unlock(&pf->lock);
+}
+
+/**
+ * @brief Applies the properties that the property fetcher's 
+ * thread has fetched since the last call. Results for windows 
+ * that are no longer managed are dropped.
+ *
+ * @param s The window manager's state
+ */
+void
+handlepropresults(state_t* s) {
+  prop_fetcher_t* pf = &s->propfetcher;
+  if(!pf->con) return;
+
+  uint64_t count;
+  if(read(pf->eventfd, &count, sizeof(count)) != sizeof(count)) {
+    return;
+  }
+
+  pthread_mutex_lock(&pf->lock);
+  prop_result_t* results = pf->results;
+  pf->results = pf->lastresult = NULL;
+  pthread_mutex_unlock(&pf->lock);
+
+  while(results) {
+    prop_result_t* next = results->next;
+    client_t* cl = clientfromwin(s, results->win);
+    if(cl) {
+      applypropresult(s, cl, results);
+    }
+    free(results->name);
+    free(results);
+    results = next;
+  }
+}
+
+/**
+ * @brief Reads the name of a window right away, preferring the 
+ * UTF-8 _NET_WM_NAME over WM_NAME.
+ *
+ * @param s The window manager's state
+ * @param win The window to read the name of
+ * @param len Gets assigned the length of the name
+ *
+ * @return The name of the window (malloc'd, NULL if it has none)
+ */
+char*
+fetchwinname(state_t* s, xcb_window_t win, uint32_t* len) {
+  xcb_get_property_cookie_t cookies[2];
+  prop_con_t con = { .x = s->x, .ctx = s->xctx, .stats = &s->xstats };
+  requestname(&s->propfetcher, &con, win, cookies);
+  return replyname(&con, cookies, len);
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "structs.h"
+
+bool startpropfetcher(state_t* s);
+void stoppropfetcher(state_t* s);
+void fetchclientprops(state_t* s, client_t* cl, uint32_t what);
+void handlepropresults(state_t* s);
+char* fetchwinname(state_t* s, xcb_window_t win, uint32_t* len);
@@ -10,6 +10,8 @@
 #include <stdarg.h>
 #include <pthread.h>
 #include <sys/wait.h>
+#include <poll.h>
+#include <errno.h>
 
 #include <xcb/xcb.h>
 #include <xcb/xproto.h>
@@ -23,21 +25,23 @@
 #include <xcb/xcb_cursor.h>
 #include <xcb/randr.h>
 #include <xcb/composite.h>
+#include <xcb/sync.h>
 
-#include <X11/cursorfont.h>
 #include <X11/keysym.h>
 #include <X11/keysymdef.h>
 #include <X11/XF86keysym.h>
-#include <X11/Xatom.h>
-#include <X11/Xlib.h>
-#include <X11/Xproto.h>
-#include <X11/Xutil.h>
-#include <X11/Xlib-xcb.h>
-
-#include <GL/gl.h>
-#include <GL/glx.h>
 
 #include "config.h"
+#include "pool.h"
+#include "winmap.h"
+#include "rules.h"
+#include "propfetch.h"
+#include "restart.h"
+#include "record.h"
+#include "xbackend.h"
+#include "resources.h"
+#include "topology.h"
+#include "tabbar.h"
 #include "ipc/sockets.h"
 #include "structs.h"
 
@@ -50,6 +54,7 @@ static event_handler_t evhandlers[_XCB_EV_LAST] = {
   [XCB_MAP_NOTIFY]          = evmapnotify,
   [XCB_DESTROY_NOTIFY]      = evdestroynotify,
   [XCB_ENTER_NOTIFY]        = eventernotify,
+  [XCB_LEAVE_NOTIFY]        = evleavenotify,
   [XCB_KEY_PRESS]           = evkeypress,
   [XCB_BUTTON_PRESS]        = evbuttonpress,
   [XCB_BUTTON_RELEASE]        = evbuttonrelease,
@@ -61,35 +66,22 @@ static event_handler_t evhandlers[_XCB_EV_LAST] = {
   [XCB_FOCUS_IN]            = evfocusin,
 };
 
-/* --- Static functions to handle another running X window manager */
-static int (*xerrorhandler)(Display*, XErrorEvent*);
-
-static int
-otherwmhandler(Display* dsp, XErrorEvent* ev) {
-  (void)dsp;
-  (void)ev;
-  fprintf(stderr, "ragnar: another X window manager is already running.\n");
-  exit(EXIT_FAILURE);
-  return -1;
-}
-
-/* --- This function is taken from DWM --- */ 
-static int
-xerror(Display *dpy, XErrorEvent *ee)
+/* --- The list of ignored errors is taken from DWM --- */ 
+static void
+xerror(state_t* s, xcb_generic_error_t* err)
 {
-  if (ee->error_code == BadWindow
-    || (ee->request_code == X_SetInputFocus && ee->error_code == BadMatch)
-    || (ee->request_code == X_PolyText8 && ee->error_code == BadDrawable)
-    || (ee->request_code == X_PolyFillRectangle && ee->error_code == BadDrawable)
-    || (ee->request_code == X_PolySegment && ee->error_code == BadDrawable)
-    || (ee->request_code == X_ConfigureWindow && ee->error_code == BadMatch)
-    || (ee->request_code == X_GrabButton && ee->error_code == BadAccess)
-    || (ee->request_code == X_GrabKey && ee->error_code == BadAccess)
-    || (ee->request_code == X_CopyArea && ee->error_code == BadDrawable))
-    return 0;
-  fprintf(stderr, "ragnar: fatal error: request code=%d, error code=%d\n",
-          ee->request_code, ee->error_code);
-  return xerrorhandler(dpy, ee); 
+  if (err->error_code == XCB_WINDOW
+    || (err->major_code == XCB_SET_INPUT_FOCUS && err->error_code == XCB_MATCH)
+    || (err->major_code == XCB_POLY_TEXT_8 && err->error_code == XCB_DRAWABLE)
+    || (err->major_code == XCB_POLY_FILL_RECTANGLE && err->error_code == XCB_DRAWABLE)
+    || (err->major_code == XCB_POLY_SEGMENT && err->error_code == XCB_DRAWABLE)
+    || (err->major_code == XCB_CONFIGURE_WINDOW && err->error_code == XCB_MATCH)
+    || (err->major_code == XCB_GRAB_BUTTON && err->error_code == XCB_ACCESS)
+    || (err->major_code == XCB_GRAB_KEY && err->error_code == XCB_ACCESS)
+    || (err->major_code == XCB_COPY_AREA && err->error_code == XCB_DRAWABLE))
+    return;
+  logmsg(s, LogLevelError, "X error: request code=%d, error code=%d, resource=%u",
+         err->major_code, err->error_code, err->resource_id);
 }
 
 /**
@@ -102,6 +94,8 @@ xerror(Display *dpy, XErrorEvent *ee)
  * listen to necessary events. 
  * After the configuration of the root window, all the specified
  * keybinds in the config are grabbed by the window manager.
+ * If a backend is already set (see fakexuse()), no connection 
+ * is opened and the window manager runs on that backend.
  */
 void
 setup(state_t* s) {
@@ -115,58 +109,110 @@ setup(state_t* s) {
   signal(SIGTERM, sigchld_handler);
   signal(SIGQUIT, sigchld_handler);
 
-  vector_init(&s->popups); 
-
-  initconfig(s);
-  readconfig(s, &s->config);
+  if(!initconfig(s) || !readconfig(s, &s->config)) {
+    terminate(s, EXIT_FAILURE);
+  }
+  watchconfig(s, s->config.watchconfig);
 
   fclose(fopen(s->config.logfile, "w"));
 
   s->lastexposetime = 0;
   s->lastmotiontime = 0;
 
-  // Create IPC thread
-  pthread_t ipc_thread;
-  if(pthread_create(&ipc_thread, NULL, ipcserverthread, s) != 0) {
-    logmsg(s, LogLevelError, "Failed to create IPC thread.");
+  // Serve IPC clients (a replay must not take the socket of a running session)
+  s->ipc.eventfd = -1;
+  if(!s->replaying) {
+    startipcserver(s);
   }
 
-  // Opening Xorg display
-  s->dsp = XOpenDisplay(NULL);
-  if(!s->dsp) {
-    logmsg(s, LogLevelError, "Failed to open X Display.");
-    terminate(s, EXIT_FAILURE);
+  if(!s->x) {
+    connectx(s);
+  }
+
+  // An in-place restart leaves the state of the previous process on the root window
+  bool restarted = hasrestartstate(s);
+  if(!setupwm(s, restarted)) {
+    fprintf(stderr, "ragnar: another X window manager is already running.\n");
+    terminate(s, 1);
   }
-  logmsg(s, LogLevelTrace, "successfully opened X display.");
 
+  /* Run the startup script (it already ran before an in-place restart 
+   * and the programs of a replay are part of the recording) */
+  if(!restarted && !s->replaying) {
+    runcmd(NULL, (passthrough_data_t){.cmd = "ragnarstart"});
+  }
 
-  /* Checking for other window manager and terminating if one is found. */
-  {
-    xerrorhandler = XSetErrorHandler(otherwmhandler);
-    XSelectInput(s->dsp, DefaultRootWindow(s->dsp), SubstructureRedirectMask);
-    XSync(s->dsp, False);
-    XSetErrorHandler(xerror);
-    XSync(s->dsp, False);
+  // Launch the scratchpads that are ready before they are first toggled
+  if(!s->replaying) {
+    launchscratchpads(s, ScratchpadLaunchStartup);
+    s->scratchpadlaunchdue = monotonicms() + SCRATCHPAD_LAZY_DELAY_MS;
   }
-  // Run the startup script
-  runcmd(NULL, (passthrough_data_t){.cmd = "ragnarstart"});
 
+  xflush(s);
+}
+
+/**
+ * @brief Opens the connection to the X server and makes the 
+ * window manager's requests go through it. Also looks up the 
+ * screen and the X extensions the window manager uses.
+ *
+ * @param s The window manager's state
+ */
+void
+connectx(state_t* s) {
   // Setting up xcb connection 
-  s->con = XGetXCBConnection(s->dsp);
+  s->con = xcb_connect(NULL, &s->screennum);
   // Checking for errors
-  if (xcb_connection_has_error(s->con) || !s->con) {
+  if (!s->con || xcb_connection_has_error(s->con)) {
     logmsg(s,  LogLevelError, "cannot connect to XCB.");
     terminate(s, EXIT_FAILURE);
   }
+  s->x = &xcbbackend;
+  s->xctx = s->con;
   logmsg(s,  LogLevelTrace, "successfully opened XCB connection.");
 
-  // Lock the display to prevent concurrency issues
-  XSetEventQueueOwner(s->dsp, XCBOwnsEventQueue);
-
-  xcb_screen_t* screen = xcb_setup_roots_iterator(xcb_get_setup(s->con)).data;
+  xcb_screen_t* screen = xcb_aux_get_screen(s->con, s->screennum);
   s->root = screen->root;
   s->screen = screen;
 
+  // The sync extension is needed for _NET_WM_SYNC_REQUEST
+  const xcb_query_extension_reply_t* syncext = xcb_get_extension_data(s->con, &xcb_sync_id);
+  if(syncext && syncext->present) {
+    xcb_sync_initialize_reply_t* reply = xcb_sync_initialize_reply(
+      s->con, xcb_sync_initialize(s->con, 3, 1), NULL);
+    s->hassync = reply != NULL;
+    s->syncevbase = syncext->first_event;
+    free(reply);
+  }
+
+  // Listen for monitors being plugged, unplugged or reconfigured
+  const xcb_query_extension_reply_t* randrext = xcb_get_extension_data(s->con, &xcb_randr_id);
+  if(randrext && randrext->present) {
+    s->hasrandr = true;
+    s->randrevbase = randrext->first_event;
+    xcb_randr_select_input(s->con, s->root,
+                           XCB_RANDR_NOTIFY_MASK_SCREEN_CHANGE |
+                           XCB_RANDR_NOTIFY_MASK_CRTC_CHANGE |
+                           XCB_RANDR_NOTIFY_MASK_OUTPUT_CHANGE);
+  }
+}
+
+/**
+ * @brief Sets up the window manager on the root window of the 
+ * backend: redirects the root window, grabs the keybinds, 
+ * registers the monitors and manages the existing windows. 
+ * Everything goes through the backend, so this also sets up 
+ * a window manager in-process (see fakex.h).
+ *
+ * @param s The window manager's state
+ * @param restarted Whether the state of a previous process that 
+ * restarted in place is to be adopted
+ *
+ * @return Whether or not the root window could be redirected (it 
+ * cannot while another window manager is running)
+ */
+bool
+setupwm(state_t* s, bool restarted) {
   uint32_t evmask =
     XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT |
     XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY |
@@ -177,16 +223,18 @@ setup(state_t* s) {
     XCB_EVENT_MASK_BUTTON_RELEASE |
     XCB_EVENT_MASK_KEY_PRESS;
 
-  xcb_void_cookie_t cookie = xcb_change_window_attributes_checked(
-    s->con, s->root, XCB_CW_EVENT_MASK, &evmask);
-
-  xcb_generic_error_t* err = xcb_request_check(s->con, cookie);
-  if (err) {
-    fprintf(stderr, "ragnar: xcb_change_window_attributes failed (likely another WM is running)\n");
-    free(err);
-    terminate(s, 1);
+  bool redirected = xchangewindowattributeschecked(s, s->root, XCB_CW_EVENT_MASK, &evmask);
+  // The previous process may not have given up the root window yet
+  for(uint32_t i = 0; !redirected && restarted && i < RESTART_REDIRECT_RETRIES; i++) {
+    usleep(RESTART_REDIRECT_INTERVAL_MS * 1000);
+    redirected = xchangewindowattributeschecked(s, s->root, XCB_CW_EVENT_MASK, &evmask);
   }
+  if(!redirected) return false;
 
+  /* Choose the visual and colormap of frame windows once, after the 
+   * root window is ours so that no colormap is left behind when 
+   * another window manager is running */
+  setupframevisual(s);
 
   // Load the default root cursor image
   loaddefaultcursor(s);
@@ -195,42 +243,42 @@ setup(state_t* s) {
   grabkeybinds(s);
 
   // Handle monitor setup 
-  uint32_t registered_monitors = updatemons(s);
+  updatemons(s);
 
   // Setup atoms for EWMH and NetWM standards
   setupatoms(s);
 
+  // Client names and hints are read on a second connection by a worker thread
+  startpropfetcher(s);
+
+  // Window types of the rules are resolved to atoms once
+  compilerules(s);
+
   // Gather strut information for layouts 
   s->nwinstruts = 0;
   s->winstruts = malloc(sizeof(strut_t) * s->config.maxstruts);
 
 
-  // Initialize virtual desktops
-  s->curdesktop = malloc(sizeof(*s->curdesktop) * registered_monitors);
-  if(s->curdesktop) {
-    for(uint32_t i = 0; i < registered_monitors; i++) {
-      s->curdesktop[i].idx = s->config.desktopinit;
-    }
-  }
-
   s->scratchpads = malloc(sizeof(*s->scratchpads) * s->config.maxscratchpads);
   for(uint32_t i = 0; i < s->config.maxscratchpads; i++) {
-    s->scratchpads[i].needs_restart = true;
-    s->scratchpads[i].hidden = true;
-    s->scratchpads[i].win = 0;
+    s->scratchpads[i] = (scratchpad_t){
+      .hidden = true,
+      .needs_restart = true,
+    };
   }
 
-  s->mapping_scratchpad_index = -1;
-
-  xcb_set_input_focus(s->con, XCB_INPUT_FOCUS_POINTER_ROOT, s->root, XCB_CURRENT_TIME);
-  XSync(s->dsp, False);
-  xcb_flush(s->con);
+  xsetinputfocus(s, XCB_INPUT_FOCUS_POINTER_ROOT, s->root, XCB_CURRENT_TIME);
+  xflush(s);
+  // Adopt the clients of the previous process as they are before managing new windows
+  if(restarted) {
+    restorestate(s);
+  }
   managewins(s);
-  xcb_flush(s->con);
+  xflush(s);
   s->nwinstruts = 0;
   getwinstruts(s, s->root);
-
-  xcb_flush(s->con);
+  invalidatelayouts(s);
+  return true;
 }
 
 /**
@@ -244,16 +292,132 @@ loop(state_t* s) {
   xcb_generic_event_t *ev;
 
   while (1) {
-    // Poll for events without blocking
-    while ((ev = xcb_wait_for_event(s->con))) {
-      uint8_t evcode = ev->response_type & ~0x80;
-      /* If the event we receive is listened for by our 
-       * event listeners, call the callback for the event. */
-      if (evcode < ARRLEN(evhandlers) && evhandlers[evcode]) {
-        evhandlers[evcode](s, ev);
+    // Handle every event that is already queued without blocking
+    while ((ev = xcb_poll_for_event(s->con))) {
+      if(s->recorder.file) {
+        recordevent(s, ev);
+      }
+      dispatchevent(s, ev);
+      free(ev);
+    }
+    if(s->recorder.file) {
+      recordbatch(s);
+    }
+    if(s->monsdirty) {
+      s->monsdirty = false;
+      updatemons(s);
+      /* The monitor query and the relayout make round trips, so 
+       * drain the events that arrived during them before sleeping */
+      continue;
+    }
+    if(xcb_connection_has_error(s->con)) {
+      logmsg(s, LogLevelError, "lost the connection to the X server.");
+      terminate(s, EXIT_FAILURE);
+    }
+    xflush(s);
+
+    /* Round trips made since the drain read any events that arrived 
+     * in the meantime into xcb's queue, which poll() cannot see */
+    if((ev = xcb_poll_for_queued_event(s->con))) {
+      if(s->recorder.file) {
+        recordevent(s, ev);
       }
+      dispatchevent(s, ev);
       free(ev);
+      continue;
+    }
+
+    /* Sleep until the X server sends an event, the watched 
+     * config file changes, fetched client properties arrive, 
+     * an IPC command is pending, a pending config reload is due, 
+     * a sync request times out, scratchpads are due to launch or 
+     * changed titles are due. */
+    struct pollfd fds[4] = {
+      { .fd = xcb_get_file_descriptor(s->con), .events = POLLIN },
+      { .fd = s->cfgwatchfd, .events = POLLIN },
+      // Negative descriptors are ignored by poll()
+      { .fd = s->propfetcher.con ? s->propfetcher.eventfd : -1, .events = POLLIN },
+      { .fd = s->ipc.eventfd, .events = POLLIN },
+    };
+    int32_t timeout = configreloadtimeout(s);
+    int32_t synctimeoutms = synctimeout(s);
+    if(synctimeoutms != -1 && (timeout == -1 || synctimeoutms < timeout)) {
+      timeout = synctimeoutms;
+    }
+    int32_t launchtimeoutms = scratchpadlaunchtimeout(s);
+    if(launchtimeoutms != -1 && (timeout == -1 || launchtimeoutms < timeout)) {
+      timeout = launchtimeoutms;
+    }
+    int32_t titletimeoutms = titleupdatetimeout(s);
+    if(titletimeoutms != -1 && (timeout == -1 || titletimeoutms < timeout)) {
+      timeout = titletimeoutms;
+    }
+    if(poll(fds, ARRLEN(fds), timeout) == -1 && errno != EINTR) {
+      logmsg(s, LogLevelError, "failed to poll for events.");
+      terminate(s, EXIT_FAILURE);
+    }
+    if(s->cfgwatchfd != -1 && (fds[1].revents & POLLIN)) {
+      handleconfigwatch(s);
+    }
+    if(fds[2].revents & POLLIN) {
+      handlepropresults(s);
+    }
+    // IPC commands run here so that they never race the event handlers
+    if(fds[3].revents & POLLIN) {
+      handleipccommand(s);
     }
+    handletimers(s);
+  }
+}
+
+/**
+ * @brief Handles a single event that was received from the 
+ * X server by calling the associated event handler.
+ *
+ * @param s The window manager's state
+ * @param ev The event to handle (not freed)
+ */
+void
+dispatchevent(state_t* s, xcb_generic_event_t* ev) {
+  uint8_t evcode = ev->response_type & ~0x80;
+  // Errors of requests that are not checked arrive as events
+  if (evcode == 0) {
+    xerror(s, (xcb_generic_error_t*)ev);
+    return;
+  }
+  if (s->hassync && evcode == s->syncevbase + XCB_SYNC_ALARM_NOTIFY) {
+    evsyncalarmnotify(s, ev);
+    return;
+  }
+  // Coalesce bursts of RandR events into a single monitor update
+  if (s->hasrandr && 
+    (evcode == s->randrevbase + XCB_RANDR_SCREEN_CHANGE_NOTIFY ||
+    evcode == s->randrevbase + XCB_RANDR_NOTIFY)) {
+    s->monsdirty = true;
+    return;
+  }
+  /* If the event we receive is listened for by our 
+   * event listeners, call the callback for the event. */
+  if (evcode < ARRLEN(evhandlers) && evhandlers[evcode]) {
+    evhandlers[evcode](s, ev);
+  }
+}
+
+/**
+ * @brief Runs the work of the event loop that is due at a 
+ * certain time (config reloads, sync timeouts, title updates 
+ * and lazily launched scratchpads).
+ *
+ * @param s The window manager's state
+ */
+void
+handletimers(state_t* s) {
+  reloadwatchedconfig(s);
+  handlesynctimeouts(s);
+  updatetitles(s);
+  if(s->scratchpadlaunchdue && monotonicms() >= s->scratchpadlaunchdue) {
+    s->scratchpadlaunchdue = 0;
+    launchscratchpads(s, ScratchpadLaunchLazy);
   }
 }
 
@@ -268,12 +432,19 @@ void
 terminate(state_t* s, int32_t exitcode) {
   // Release every client
   for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
-    client_t* cl = mon->clients;
-    client_t* next;
-    while(cl != NULL) {
-      next = cl->next;
-      releaseclient(s, cl->win);
-      cl = next; 
+    for(uint32_t i = 0; i < s->config.maxdesktops; i++) {
+      client_list_t* clients = &mon->clients[i];
+      // Releasing removes the client from the list, so always take the last one
+      while(clients->size) {
+        client_t* cl = clients->items[clients->size - 1];
+        /* Frames adopted after an in-place restart belong to the old 
+         * connection and would not be destroyed along with this one */
+        xdestroywindow(s, cl->frame);
+        // The client window goes with its frame and takes the edge windows and grabs along
+        trackresource(s, cl, XResourceWindow, -(int32_t)cl->props->resources[XResourceWindow]);
+        trackresource(s, cl, XResourceGrab, -(int32_t)cl->props->resources[XResourceGrab]);
+        releaseclient(s, cl->win);
+      }
     }
   }
   // Release every monitor
@@ -282,19 +453,44 @@ terminate(state_t* s, int32_t exitcode) {
     monitor_t* next;
     while (mon != NULL) {
       next = mon->next;
-      free(mon);
+      destroymon(s, mon);
       mon = next;
     }
+    s->monitors = NULL;
+  }
+  destroytopology(&s->montopo);
+  // Every client and name should be released by now
+  if(s->clientpool.live || s->strpool.live) {
+    logmsg(s, LogLevelWarn, "leaked %i clients and %i strings.", 
+           s->clientpool.live, s->strpool.live);
+  }
+  destroyclientpool(&s->clientpool);
+  destroystrpool(&s->strpool);
+  destroywinmap(&s->popups);
+  destroywinmap(&s->winkinds);
+  destroyrules(&s->rules);
+  stoppropfetcher(s);
+  vector_free(&s->dirtytitles);
+  stoprecording(s);
+
+  if (s->x != NULL) {
+    if(s->ownsframecolormap) {
+      xfreecolormap(s, s->framecolormap);
+      trackresource(s, NULL, XResourceColormap, -1);
+    }
+    freecursors(s);
+  }
+  if (s->con != NULL) {
+    // Give up the X connection
+    xcb_disconnect(s->con);
   }
-
-  if (s->dsp != NULL)
-      XCloseDisplay(s->dsp);
-  // Give up the X connection
-  xcb_disconnect(s->con);
 
   logmsg(s,  LogLevelTrace, "terminated with exit code %i.", exitcode);
 
   destroyconfig();
+  if(s->cfgwatchfd != -1) {
+    close(s->cfgwatchfd);
+  }
 
   // Free the window manager's state
   free(s);
@@ -308,8 +504,7 @@ getstate(state_t* s, xcb_window_t w)
     long result = -1;
     xcb_get_property_reply_t *prop_reply;
 
-    prop_reply = xcb_get_property_reply(
-        s->con, xcb_get_property(s->con, 0, w, s->wm_atoms[WMstate], XCB_ATOM_ANY, 0, 2), NULL);
+    prop_reply = xgetproperty(s, 0, w, s->wm_atoms[WMstate], XCB_ATOM_ANY, 0, 2);
     if (!prop_reply || xcb_get_property_value_length(prop_reply) == 0) {
         free(prop_reply);
         return -1;
@@ -323,8 +518,7 @@ getstate(state_t* s, xcb_window_t w)
 
 bool wait_for_mapped(state_t* s, xcb_window_t win) {
     for (int i = 0; i < 10; i++) {  // Try up to 10 times
-        xcb_get_window_attributes_cookie_t attr_cookie = xcb_get_window_attributes(s->con, win);
-        xcb_get_window_attributes_reply_t *attr_reply = xcb_get_window_attributes_reply(s->con, attr_cookie, NULL);
+        xcb_get_window_attributes_reply_t *attr_reply = xgetwindowattributes(s, win);
 
         if (attr_reply) {
             if (attr_reply->map_state == XCB_MAP_STATE_VIEWABLE) {
@@ -340,13 +534,11 @@ bool wait_for_mapped(state_t* s, xcb_window_t win) {
 
 
 void managewins(state_t* s) {
-  xcb_query_tree_cookie_t tree_cookie;
   xcb_query_tree_reply_t *tree_reply;
   xcb_window_t *wins;
   uint32_t num;
 
-  tree_cookie = xcb_query_tree(s->con, s->root);
-  tree_reply = xcb_query_tree_reply(s->con, tree_cookie, NULL);
+  tree_reply = xquerytree(s, s->root);
   if (!tree_reply || tree_reply->children_len == 0) {
     free(tree_reply);
     return;
@@ -355,25 +547,27 @@ void managewins(state_t* s) {
   wins = xcb_query_tree_children(tree_reply);
 
   for (uint32_t i = 0; i < num; i++) {
-    xcb_get_window_attributes_cookie_t attr_cookie;
     xcb_get_window_attributes_reply_t *attr_reply;
     xcb_window_t transient_for;
-    xcb_get_property_cookie_t trans_cookie;
     xcb_get_property_reply_t *trans_reply;
 
-    attr_cookie = xcb_get_window_attributes(s->con, wins[i]);
-    attr_reply = xcb_get_window_attributes_reply(s->con, attr_cookie, NULL);
+    // Frames adopted after an in-place restart keep their stacking order
+    uint8_t kind;
+    if(winmapget(&s->winkinds, wins[i], &kind) && kind == WindowKindOwn) {
+      continue;
+    }
+
+    attr_reply = xgetwindowattributes(s, wins[i]);
     if (!attr_reply || attr_reply->override_redirect) {
       uint32_t config[] = { XCB_STACK_MODE_ABOVE };
-      xcb_configure_window(s->con, wins[i], XCB_CONFIG_WINDOW_STACK_MODE, config);
+      xconfigurewindow(s, wins[i], XCB_CONFIG_WINDOW_STACK_MODE, config);
       if(attr_reply)
         free(attr_reply);
       continue;
     }
 
-    trans_cookie = xcb_get_property(s->con, 0, wins[i], XCB_ATOM_WM_TRANSIENT_FOR,
-                                    XCB_ATOM_WINDOW, 0, sizeof(xcb_window_t));
-    trans_reply = xcb_get_property_reply(s->con, trans_cookie, NULL);
+    trans_reply = xgetproperty(s, 0, wins[i], XCB_ATOM_WM_TRANSIENT_FOR,
+                               XCB_ATOM_WINDOW, 0, sizeof(xcb_window_t));
     transient_for = trans_reply && xcb_get_property_value_length(trans_reply) ?
       *(xcb_window_t *) xcb_get_property_value(trans_reply) : XCB_NONE;
 
@@ -385,12 +579,13 @@ void managewins(state_t* s) {
 
     if (wait_for_mapped(s, wins[i]) || getstate(s, wins[i]) == 3) {
       client_t* cl = makeclient(s, wins[i]);
-      xcb_flush(s->con);
+      xflush(s);
 
       s->nwinstruts = 0;
       getwinstruts(s, s->root);
+      invalidatelayouts(s);
 
-      if(!cl->floating) {
+      if(cl && !cl->floating) {
         addtolayout(s, cl);
       }
     }
@@ -399,21 +594,17 @@ void managewins(state_t* s) {
   }
 
   for (uint32_t i = 0; i < num; i++) {
-    xcb_get_window_attributes_cookie_t attr_cookie;
     xcb_get_window_attributes_reply_t *attr_reply;
     xcb_window_t transient_for;
-    xcb_get_property_cookie_t trans_cookie;
     xcb_get_property_reply_t *trans_reply;
 
-    attr_cookie = xcb_get_window_attributes(s->con, wins[i]);
-    attr_reply = xcb_get_window_attributes_reply(s->con, attr_cookie, NULL);
+    attr_reply = xgetwindowattributes(s, wins[i]);
     if (!attr_reply) {
       continue;
     }
 
-    trans_cookie = xcb_get_property(s->con, 0, wins[i], XCB_ATOM_WM_TRANSIENT_FOR,
-                                    XCB_ATOM_WINDOW, 0, sizeof(xcb_window_t));
-    trans_reply = xcb_get_property_reply(s->con, trans_cookie, NULL);
+    trans_reply = xgetproperty(s, 0, wins[i], XCB_ATOM_WM_TRANSIENT_FOR,
+                               XCB_ATOM_WINDOW, 0, sizeof(xcb_window_t));
     transient_for = trans_reply && xcb_get_property_value_length(trans_reply) ?
       *(xcb_window_t *) xcb_get_property_value(trans_reply) : XCB_NONE;
 
@@ -431,7 +622,8 @@ void managewins(state_t* s) {
 }
 
 void updateedgewindows(state_t* s, client_t* cl) {
-  if (!cl->edges) return;
+  // The edge windows are created after the client is placed
+  if (cl->props->edges[EdgeLeft].win == XCB_NONE) return;
 
   int w = cl->area.size.x;
   int h = cl->area.size.y;
@@ -451,12 +643,12 @@ void updateedgewindows(state_t* s, client_t* cl) {
   };
 
   for (int i = 1; i <= 8; i++) {
-    xcb_configure_window(
-      s->con, cl->edges[i].win,
+    xconfigurewindow(
+      s, cl->props->edges[i].win,
       XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT,
       (uint32_t[]){ regions[i].x, regions[i].y, regions[i].w, regions[i].h }
     );
-    xcb_map_window(s->con, cl->edges[i].win);
+    xmapwindow(s, cl->props->edges[i].win);
   }
 }
 
@@ -465,64 +657,106 @@ toggleedgewindows(state_t* s, client_t* cl, bool toggle) {
   cl->showedgewindows = toggle;
   for (int i = 1; i <= 8; i++) {
     if (toggle)
-      xcb_map_window(s->con, cl->edges[i].win);
+      xmapwindow(s, cl->props->edges[i].win);
     else
-      xcb_unmap_window(s->con, cl->edges[i].win);
+      xunmapwindow(s, cl->props->edges[i].win);
   }
-  xcb_flush(s->con);
+  xflush(s);
 }
 void 
 createwindowedges(state_t* s, client_t* cl) {
   xcb_window_t parent = cl->win;
-  uint32_t mask = XCB_CW_EVENT_MASK;
-  uint32_t val = XCB_EVENT_MASK_ENTER_WINDOW |
+  // The values need to be in the order of the bits in the mask
+  uint32_t mask = XCB_CW_EVENT_MASK | XCB_CW_CURSOR;
+  uint32_t val[2] = { 
+    XCB_EVENT_MASK_ENTER_WINDOW |
     XCB_EVENT_MASK_POINTER_MOTION |
     XCB_EVENT_MASK_BUTTON_PRESS |
-    XCB_EVENT_MASK_BUTTON_RELEASE;
+    XCB_EVENT_MASK_BUTTON_RELEASE
+  };
 
   for (int i = 1; i <= 8; i++) {
-    cl->edges[i].win = xcb_generate_id(s->con);
-    cl->edges[i].edge = (window_edge_t)i;
+    cl->props->edges[i].win = xgenerateid(s);
+    cl->props->edges[i].edge = (window_edge_t)i;
+    // The server shows the resize cursor of the edge without being asked on every motion
+    val[1] = edgecursor(s, (window_edge_t)i);
 
-    xcb_create_window(
-      s->con,
+    xcreatewindow(
+      s,
       XCB_COPY_FROM_PARENT,
-      cl->edges[i].win,
+      cl->props->edges[i].win,
       parent,
       0, 0, 1, 1, // position & size updated later
       0,
       XCB_WINDOW_CLASS_INPUT_ONLY,
       XCB_COPY_FROM_PARENT,
-      mask, &val
+      mask, val
     );
   }
+  trackresource(s, cl, XResourceWindow, 8);
 }
-client_t*
-makeclient(state_t* s, xcb_window_t win) {
+/**
+ * @brief Selects the events of a client window and grabs the 
+ * buttons for interactive moves and resizes on it.
+ *
+ * @param s The window manager's state
+ * @param cl The client 
+ */
+void
+selectclientinput(state_t* s, client_t* cl) {
+  xcb_window_t win = cl->win;
   // Setup listened events for the mapped window
   {
     uint32_t evmask[] = { XCB_EVENT_MASK_ENTER_WINDOW | XCB_EVENT_MASK_FOCUS_CHANGE|  XCB_EVENT_MASK_PROPERTY_CHANGE | XCB_EVENT_MASK_STRUCTURE_NOTIFY |  XCB_EVENT_MASK_KEY_PRESS }; 
-    xcb_change_window_attributes_checked(s->con, win, XCB_CW_EVENT_MASK, evmask);
+    xchangewindowattributes(s, win, XCB_CW_EVENT_MASK, evmask);
   }
 
   // Grabbing mouse events for interactive moves/resizes 
   {
     uint16_t evmask = XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_BUTTON_RELEASE | XCB_EVENT_MASK_BUTTON_MOTION;
-    xcb_grab_button(s->con, 0, win, evmask, XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC, 
-                    s->root, XCB_NONE, 1, s->config.winmod);
-    xcb_grab_button(s->con, 0, win, evmask, XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC, 
-                    s->root, XCB_NONE, 3, s->config.winmod);
+    xgrabbutton(s, 0, win, evmask, XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC, 
+                s->root, XCB_NONE, 1, s->config.winmod);
+    xgrabbutton(s, 0, win, evmask, XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC, 
+                s->root, XCB_NONE, 3, s->config.winmod);
+    trackresource(s, cl, XResourceGrab, 2);
   }
+}
+
+client_t*
+makeclient(state_t* s, xcb_window_t win) {
   monitor_t* clmon = cursormon(s);
-  // Adding the mapped client to our linked list
-  client_t* cl = addclient(s, &clmon->clients, win);
+  // Adding the mapped client to the client list of the current desktop
+  client_t* cl = addclient(s, clmon, win);
+  if(!cl) return NULL;
+
+  selectclientinput(s, cl);
+
+  /* Evaluate the window rules before the client is placed so that 
+   * it is moved to its monitor and desktop before it is mapped */
+  window_rule_t rule = matchrules(s, cl);
+  monitor_t* rulemon = rule.monitor != -1 ? monbyidx(s, rule.monitor) : NULL;
+  bool placed = rulemon || (rule.desktop != -1 && rule.desktop < (int32_t)s->config.maxdesktops);
+  if(placed) {
+    if(!rulemon) rulemon = clmon;
+    uint32_t desktop = rule.desktop != -1 && rule.desktop < (int32_t)s->config.maxdesktops ? 
+      (uint32_t)rule.desktop : mondesktop(s, rulemon)->idx;
+    relocateclient(s, cl, rulemon, desktop);
+    cl->floating = rulemon->layouts[desktop].curlayout == LayoutFloating;
+  }
+
+  /* Scratchpads are matched before the client is mapped so that one 
+   * that was launched ahead of time is created hidden and unfocused */
+  int32_t scratchpad = matchscratchpad(s, cl);
+  if(scratchpad != -1) {
+    cl->scratchpad_index = scratchpad;
+    cl->is_scratchpad = true;
+    s->scratchpads[scratchpad].win = cl->win;
+    s->scratchpads[scratchpad].pending = false;
+  }
 
   // Setting border 
   xcb_atom_t motif_hints = getatom(s, "_MOTIF_WM_HINTS");
-  xcb_get_property_cookie_t prop_cookie = xcb_get_property(
-    s->con, 0, cl->win, motif_hints, motif_hints, 0, 5
-  );
-  xcb_get_property_reply_t* prop_reply = xcb_get_property_reply(s->con, prop_cookie, NULL);
+  xcb_get_property_reply_t* prop_reply = xgetproperty(s, 0, cl->win, motif_hints, motif_hints, 0, 5);
   if (prop_reply && xcb_get_property_value_length(prop_reply) >= (int32_t)sizeof(motif_wm_hints_t)) {
     motif_wm_hints_t* hints = (motif_wm_hints_t*) xcb_get_property_value(prop_reply);
     if (hints->flags & MWM_HINTS_DECORATIONS) {
@@ -544,12 +778,10 @@ makeclient(state_t* s, xcb_window_t win) {
   // Set window type of client (e.g dialog)
   setwintype(s, cl);
 
-  // Update hints like urgency and neverfocus
-  updateclienthints(s, cl);
+  /* Names and hints like urgency and neverfocus are not needed to 
+   * place the client, so they are fetched without blocking */
+  fetchclientprops(s, cl, PropFetchName | PropFetchHints);
 
-  // Set client's monitor
-  cl->mon = clmon; 
-  cl->desktop = mondesktop(s, s->monfocus)->idx;
   logmsg(s, LogLevelTrace,"Added client on desktop %i", cl->desktop);
 
   // Update the EWMH client list
@@ -557,35 +789,64 @@ makeclient(state_t* s, xcb_window_t win) {
 
   {
     bool success;
-    cl->area = winarea(s, cl->frame, &success);
-    if(!success) return NULL;
+    area_t area = winarea(s, cl->frame, &success);
+    if(success) cl->area = area;
   }
 
   cl->area.size = applysizehints(s, cl, cl->area.size);
   if(!cl->floating) {
     cl->floating = cl->fixed;
   }
+  if(rule.floating != -1) {
+    cl->floating = rule.floating;
+  }
+  // Scratchpads always float
+  if(cl->is_scratchpad) {
+    cl->floating = true;
+  }
 
-  if(s->monfocus) {
+  if(rule.hasgeometry) {
+    // Windows with a geometry rule float at that area of their monitor
+    cl->floating = true;
+    resizeclient(s, cl, applysizehints(s, cl, rule.geometry.size));
+    moveclient(s, cl, (v2_t){
+      cl->mon->area.pos.x + rule.geometry.pos.x, 
+      cl->mon->area.pos.y + rule.geometry.pos.y}, false);
+  } else if(s->monfocus) {
+    monitor_t* spawnmon = placed ? cl->mon : s->monfocus;
     resizeclient(s, cl, cl->area.size);
     // Spawn the window in the center of the focused monitor
     moveclient(s, cl, (v2_t){
-      s->monfocus->area.pos.x + (s->monfocus->area.size.x - cl->area.size.x) / 2.0f, 
-      s->monfocus->area.pos.y + (s->monfocus->area.size.y - cl->area.size.y) / 2.0f}, true);
+      spawnmon->area.pos.x + (spawnmon->area.size.x - cl->area.size.x) / 2.0f, 
+      spawnmon->area.pos.y + (spawnmon->area.size.y - cl->area.size.y) / 2.0f}, !placed);
   }
 
   // Map the window
-  xcb_map_window(s->con, win);
+  xmapwindow(s, win);
+
+  /* Clients on a desktop that is not shown and hidden scratchpads 
+   * are mapped hidden, the former are layed out once their desktop is shown */
+  bool visible = cl->desktop == mondesktop(s, cl->mon)->idx && 
+    !(cl->is_scratchpad && s->scratchpads[cl->scratchpad_index].hidden);
+  if(!visible && s->config.hidestrategy != HideStrategyPark) {
+    cl->hidden = true;
+  } else {
+    if(!visible) {
+      hideclient(s, cl);
+    }
+    // Map the window on the screen
+    xmapwindow(s, cl->frame);
+  }
 
-  // Map the window on the screen
-  xcb_map_window(s->con, cl->frame);
+  if(rule.fullscreen != -1 && rule.fullscreen != cl->fullscreen) {
+    setfullscreen(s, cl, rule.fullscreen);
+  }
 
   // Retrieving cursor position
   bool cursor_success;
-  v2_t cursor = cursorpos(s, &cursor_success);
-  if(!cursor_success) return NULL;
+  v2_t cursor = cachedcursorpos(s, &cursor_success);
   // If the cursor is on the mapped window when it spawned, focus it.
-  if(pointinarea(cursor, cl->area)) {
+  if(visible && cursor_success && pointinarea(cursor, cl->area)) {
     focusclient(s, cl, true);
   }
 
@@ -595,6 +856,9 @@ makeclient(state_t* s, xcb_window_t win) {
   // Setup edges for window
   createwindowedges(s, cl);
   updateedgewindows(s, cl);
+  if(s->recorder.file) {
+    recordclient(s, cl);
+  }
   return cl;
 }
 
@@ -610,7 +874,7 @@ bool
 pointinarea(v2_t p, area_t area) {
   return (p.x >= area.pos.x &&
       p.x < (area.pos.x + area.size.x) &&
-      p.x >= area.pos.y &&
+      p.y >= area.pos.y &&
       p.y < (area.pos.y + area.size.y));
 }
 
@@ -626,8 +890,7 @@ pointinarea(v2_t p, area_t area) {
 v2_t 
 cursorpos(state_t* s, bool* success) {
   // Query the pointer position
-  xcb_query_pointer_reply_t *reply = xcb_query_pointer_reply(
-    s->con, xcb_query_pointer(s->con, s->root), NULL);
+  xcb_query_pointer_reply_t *reply = xquerypointer(s, s->root);
   *success = (reply != NULL);
   if(!(*success)) {
     logmsg(s,  LogLevelError, "failed to retrieve cursor position."); 
@@ -636,12 +899,62 @@ cursorpos(state_t* s, bool* success) {
   }
   // Create a v2_t for to store the position 
   v2_t cursor = (v2_t){.x = reply->root_x, .y = reply->root_y};
+  updatecursor(s, cursor);
 
   // Check for errors
   free(reply);
   return cursor;
 }
 
+/**
+ * @brief Returns the cursor position reported by the last X input 
+ * event and only queries the X server if no event reported it yet.
+ *
+ * @param s The window manager's state
+ * @param success Gets assigned whether or not a cursor position 
+ * could be retrieved.
+ *
+ * @return The cursor position as a two dimensional vector 
+ */
+v2_t
+cachedcursorpos(state_t* s, bool* success) {
+  if(s->haslastcursor) {
+    *success = true;
+    return s->lastcursor;
+  }
+  return cursorpos(s, success);
+}
+
+/**
+ * @brief Stores the pointer position reported by an X event and 
+ * updates the monitor that contains it.
+ *
+ * @param s The window manager's state
+ * @param cursor The reported pointer position 
+ */
+void
+updatecursor(state_t* s, v2_t cursor) {
+  s->lastcursor = cursor;
+  s->haslastcursor = true;
+  // Only search the monitors if the pointer left the cached one
+  if(s->lastcursormon && pointinarea(cursor, s->lastcursormon->area)) {
+    return;
+  }
+  s->lastcursormon = monatpoint(s, cursor);
+}
+
+/**
+ * @brief Marks the cached pointer position as stale so that 
+ * the next lookup queries the X server.
+ *
+ * @param s The window manager's state
+ */
+void
+invalidatecursor(state_t* s) {
+  s->haslastcursor = false;
+  s->lastcursormon = NULL;
+}
+
 /**
  * @brief Returns the area (position and size) of a given window 
  *
@@ -655,7 +968,7 @@ cursorpos(state_t* s, bool* success) {
 area_t
 winarea(state_t* s, xcb_window_t win, bool* success) {
   // Retrieve the geometry of the window 
-  xcb_get_geometry_reply_t *reply = xcb_get_geometry_reply(s->con, xcb_get_geometry(s->con, win), NULL);
+  xcb_get_geometry_reply_t *reply = xgetgeometry(s, win);
   *success = (reply != NULL);
   if(!(*success)) {
     logmsg(s,  LogLevelError, "failed to retrieve window geometry of window %i", win); 
@@ -670,7 +983,64 @@ winarea(state_t* s, xcb_window_t win, bool* success) {
 }
 
 /**
- * @brief Creates a X window with a trucolor visual 
+ * @brief Checks whether a compositing manager owns the 
+ * _NET_WM_CM_Sn selection of the default screen.
+ *
+ * @param s The window manager's state
+ *
+ * @return Whether or not a compositing manager is running
+ */
+bool
+compositorrunning(state_t* s) {
+  char name[32];
+  snprintf(name, sizeof(name), "_NET_WM_CM_S%i", s->screennum);
+
+  xcb_atom_t atom = getatom(s, name);
+  xcb_get_selection_owner_reply_t* reply = xgetselectionowner(s, atom);
+  if(!reply) return false;
+
+  bool running = reply->owner != XCB_NONE;
+  free(reply);
+  return running;
+}
+
+/**
+ * @brief Chooses the visual, depth and colormap that every frame 
+ * window shares. A 32-bit ARGB visual with its own colormap is only 
+ * used when configured or when a compositing manager is running, 
+ * otherwise frames use the visual and colormap of the root window.
+ *
+ * @param s The window manager's state
+ */
+void
+setupframevisual(state_t* s) {
+  bool argb = s->config.framevisual == FrameVisualARGB ||
+    (s->config.framevisual == FrameVisualAuto && compositorrunning(s));
+
+  xcb_visualtype_t* visual = argb ? xcb_aux_find_visual_by_attrs(s->screen, XCB_VISUAL_CLASS_TRUE_COLOR, 32) : NULL;
+  if(visual) {
+    s->framevisual = visual->visual_id;
+    s->framedepth = 32;
+    s->framecolormap = xgenerateid(s);
+    xcreatecolormap(s, XCB_COLORMAP_ALLOC_NONE, s->framecolormap, s->root, visual->visual_id);
+    s->ownsframecolormap = true;
+    trackresource(s, NULL, XResourceColormap, 1);
+    logmsg(s, LogLevelTrace, "using 32-bit ARGB visual for frames.");
+    return;
+  }
+  if(argb) {
+    logmsg(s, LogLevelWarn, "no true-color visual found, using the root visual for frames.");
+  }
+
+  s->framevisual = s->screen->root_visual;
+  s->framedepth = s->screen->root_depth;
+  s->framecolormap = s->screen->default_colormap;
+  s->ownsframecolormap = false;
+  logmsg(s, LogLevelTrace, "using the root visual for frames.");
+}
+
+/**
+ * @brief Creates a X window with the shared frame visual 
  * and colormap.
  *
  * @param s The window manager's state
@@ -681,28 +1051,23 @@ winarea(state_t* s, xcb_window_t win, bool* success) {
  */
 xcb_window_t
 truecolorwindow(state_t* s, area_t a, uint32_t bw) {
-  xcb_window_t win;
-  XVisualInfo vinfo;
-  if (!XMatchVisualInfo(s->dsp, DefaultScreen(s->dsp), 32, TrueColor, &vinfo)) {
-    logmsg(s,  LogLevelError, "no true-color visual found.");
-    terminate(s, EXIT_FAILURE);
-  }
+  xcb_window_t win = xgenerateid(s);
 
-  XSetWindowAttributes attr;
-  attr.colormap = XCreateColormap(s->dsp, DefaultRootWindow(s->dsp), vinfo.visual, AllocNone);
-  attr.border_pixel = bw;
-  attr.background_pixel = 0;
-  attr.override_redirect = True; 
-
-  unsigned long mask = CWColormap | CWBorderPixel | CWBackPixel | CWOverrideRedirect;
+  // The values need to be in the order of the bits in the mask
+  uint32_t mask = XCB_CW_BACK_PIXEL | XCB_CW_BORDER_PIXEL | XCB_CW_OVERRIDE_REDIRECT | XCB_CW_COLORMAP;
+  uint32_t values[] = {
+    0,
+    bw,
+    true,
+    s->framecolormap
+  };
 
-  win = XCreateWindow(s->dsp, DefaultRootWindow(s->dsp),
+  xcreatewindow(s, s->framedepth, win, s->root,
       a.pos.x, a.pos.y, a.size.x, a.size.y,
-      s->config.winborderwidth, vinfo.depth, InputOutput, vinfo.visual,
-      mask, &attr);
+      s->config.winborderwidth, XCB_WINDOW_CLASS_INPUT_OUTPUT, s->framevisual,
+      mask, values);
 
-  logmsg(s,  LogLevelTrace, "created window with true-color colormap.",
-         a.pos.x, a.pos.y, a.size.x, a.size.y);
+  logmsg(s,  LogLevelTrace, "created frame window %i.", win);
 
   return win;
 }
@@ -736,7 +1101,7 @@ setbordercolor(state_t* s, client_t* cl, uint32_t color) {
     return;
   }
   // Change the configuration for the border color of the clients window
-  xcb_change_window_attributes_checked(s->con, cl->frame, XCB_CW_BORDER_PIXEL, &color);
+  xchangewindowattributes(s, cl->frame, XCB_CW_BORDER_PIXEL, &color);
 }
 
 /**
@@ -753,33 +1118,56 @@ setborderwidth(state_t* s, client_t* cl, uint32_t width) {
     return;
   }
   // Change the configuration for the border width of the clients window
-  xcb_configure_window(s->con, cl->frame, XCB_CONFIG_WINDOW_BORDER_WIDTH, &(uint32_t){width});
+  xconfigurewindow(s, cl->frame, XCB_CONFIG_WINDOW_BORDER_WIDTH, &(uint32_t){width});
   // Update the border width of the client
   cl->borderwidth = width;
 }
 
+/**
+ * @brief Updates the stored slot of every client in a given 
+ * client list, starting at a given index 
+ *
+ * @param clients The client list to reindex 
+ * @param start The index of the first client to reindex 
+ */
+static void
+reindexclients(client_list_t* clients, uint32_t start) {
+  for(uint32_t i = start; i < clients->size; i++) {
+    clients->items[i]->slot = i;
+  }
+}
+
 void monremoveclient(monitor_t *mon, client_t *cl) {
   if (!mon || !cl || !mon->clients) return;
-  client_t *prev = NULL;
-  client_t *curr = mon->clients;
-  while (curr) {
-    if (curr == cl) {
-      if (prev) {
-        prev->next = curr->next;  
-      } else {
-        mon->clients = curr->next;  
-      }
-      return;
-    }
-    prev = curr;
-    curr = curr->next;
-  }
+  client_list_t* clients = &mon->clients[cl->desktop];
+  if(cl->slot >= clients->size || clients->items[cl->slot] != cl) return;
+  vector_remove_by_idx(clients, cl->slot);
+  reindexclients(clients, cl->slot);
+  mon->layouts[cl->desktop].dirty = true;
+  if(mon->layouts[cl->desktop].active == cl) {
+    mon->layouts[cl->desktop].active = NULL;
+  }
+  // The client is only stacked within the layout of its desktop
+  cl->stacked = false;
 }
 
 void monaddclient(monitor_t *mon, client_t *cl) {
   if (!mon || !cl) return;
-  cl->next = mon->clients;
-  mon->clients = cl;
+  client_list_t* clients = &mon->clients[cl->desktop];
+  vector_insert(clients, 0, cl);
+  reindexclients(clients, 0);
+  cl->mon = mon;
+  mon->layouts[cl->desktop].dirty = true;
+}
+
+void 
+relocateclient(state_t* s, client_t* cl, monitor_t* mon, uint32_t desktop) {
+  (void)s;
+  if(!cl || !mon) return;
+  if(cl->mon == mon && cl->desktop == desktop) return;
+  monremoveclient(cl->mon, cl);
+  cl->desktop = desktop;
+  monaddclient(mon, cl);
 }
 
 /**
@@ -799,7 +1187,10 @@ moveclient(state_t* s, client_t* cl, v2_t pos, bool manage_mons) {
   };
 
   // Move the window by configuring it's x and y position property
-  xcb_configure_window(s->con, cl->frame, XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y, posval);
+  // (parked clients are moved into place once they are shown)
+  if(!cl->parked) {
+    xconfigurewindow(s, cl->frame, XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y, posval);
+  }
 
   cl->area.pos = pos;
 
@@ -807,14 +1198,12 @@ moveclient(state_t* s, client_t* cl, v2_t pos, bool manage_mons) {
 
   // Update focused monitor in case the window was moved onto another monitor
   if(manage_mons){ 
-    cl->mon = clientmon(s, cl);
-    if(cl->mon != s->monfocus) {
-      monremoveclient(s->monfocus, cl);
-      monaddclient(cl->mon, cl);
-      updateewmhdesktops(s, cl->mon);
+    monitor_t* mon = clientmon(s, cl);
+    relocateclient(s, cl, mon, mondesktop(s, mon)->idx);
+    if(mon != s->monfocus) {
+      updateewmhdesktops(s, mon);
     }
-    s->monfocus = cl->mon;
-    cl->desktop = mondesktop(s, cl->mon)->idx;
+    s->monfocus = mon;
   }
   updateedgewindows(s, cl);
 }
@@ -832,12 +1221,19 @@ resizeclient(state_t* s, client_t* cl, v2_t size) {
     return;
   }
 
+  // Hold the resize back until the client has painted the previous one
+  if(!beginsyncresize(s, cl)) {
+    cl->area.size = size;
+    updateedgewindows(s, cl);
+    return;
+  }
+
   uint32_t sizeval[2] = { (uint32_t)size.x, (uint32_t)size.y };
   uint32_t sizeval_content[2] = { (uint32_t)size.x, (uint32_t)size.y};
 
   // Resize the window by configuring its width and height property
-  xcb_configure_window(s->con, cl->win, XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, sizeval_content);
-  xcb_configure_window(s->con, cl->frame, XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, sizeval);
+  xconfigurewindow(s, cl->win, XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, sizeval_content);
+  xconfigurewindow(s, cl->frame, XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, sizeval);
   cl->area.size = size;
   updateedgewindows(s, cl);
 }
@@ -854,6 +1250,30 @@ moveresizeclient(state_t* s, client_t* cl, area_t a) {
   if (!cl) {
     return;
   }
+  setclientarea(s, cl, a);
+
+  // Update focused monitor in case the window was moved onto another monitor
+  monitor_t* mon = clientmon(s, cl);
+  if(mon != cl->mon) {
+    relocateclient(s, cl, mon, mondesktop(s, mon)->idx);
+  }
+  if(mon != s->monfocus) {
+    updateewmhdesktops(s, mon);
+  }
+
+  s->monfocus = mon; 
+}
+
+/**
+ * @brief Moves and resizes the window of a given client and updates 
+ * its area without moving the client to another monitor.
+ *
+ * @param s The window manager's state
+ * @param cl The client to move and resize
+ * @param a The new area (position and size) for the client's window
+ */
+void
+setclientarea(state_t* s, client_t* cl, area_t a) {
   uint32_t values[4] = {
     (uint32_t)a.pos.x, 
     (uint32_t)a.pos.y,
@@ -866,24 +1286,137 @@ moveresizeclient(state_t* s, client_t* cl, area_t a) {
   };
 
   // Move and resize the window by configuring its x, y, width, and height properties
-  xcb_configure_window(s->con, cl->frame, 
-      XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | 
-      XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, values);
-  xcb_configure_window(s->con, cl->win, 
-      XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, values_content);
+  // (parked clients are moved into place once they are shown)
+  bool resize = (a.size.x != cl->area.size.x || a.size.y != cl->area.size.y);
+  if(resize && !beginsyncresize(s, cl)) {
+    // Only move the window until the client has painted the previous size
+    if(!cl->parked) {
+      xconfigurewindow(s, cl->frame, 
+          XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y, values);
+    }
+  } else if(!cl->parked) {
+    xconfigurewindow(s, cl->frame, 
+        XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | 
+        XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, values);
+    xconfigurewindow(s, cl->win, 
+        XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, values_content);
+  } else {
+    xconfigurewindow(s, cl->frame, 
+        XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, &values[2]);
+    xconfigurewindow(s, cl->win, 
+        XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, values_content);
+  }
 
   // Update clients area
   cl->area = a;
-  // Update focused monitor in case the window was moved onto another monitor
-  cl->mon = clientmon(s, cl);
-  if(cl->mon != s->monfocus) {
-    monremoveclient(s->monfocus, cl);
-    monaddclient(cl->mon, cl);
-    updateewmhdesktops(s, cl->mon);
-  }
   updateedgewindows(s, cl);
+}
+
+/**
+ * @brief Applies a list of updates to the area, desktop, monitor and 
+ * floating state of clients as a single transaction. Every update is 
+ * validated first and nothing is applied if any of them is invalid. 
+ * The affected desktops are layed out once and all requests go out 
+ * with a single flush. Needs to run on the event loop, as it changes 
+ * the client lists and frees their storage when they grow.
+ *
+ * @param s The window manager's state
+ * @param updates The updates to apply (later updates of a client win)
+ * @param numupdates The number of updates
+ * @param statuses Gets assigned the status of every update
+ *
+ * @return Whether the updates were applied
+ */
+bool
+updateclients(state_t* s, const client_update_t* updates, uint32_t numupdates, 
+              client_update_status_t* statuses) {
+  bool valid = true;
+  for(uint32_t i = 0; i < numupdates; i++) {
+    const client_update_t* u = &updates[i];
+    statuses[i] = ClientUpdateOk;
+    if(!clientfromwin(s, u->win)) {
+      statuses[i] = ClientUpdateInvalidWindow;
+    } else if((u->fields & ClientUpdateMonitor) && !monbyidx(s, u->monitor)) {
+      statuses[i] = ClientUpdateInvalidMonitor;
+    } else if((u->fields & ClientUpdateDesktop) && u->desktop >= s->config.maxdesktops) {
+      statuses[i] = ClientUpdateInvalidDesktop;
+    } else if((u->fields & ClientUpdateArea) && (u->area.size.x < 1 || u->area.size.y < 1)) {
+      statuses[i] = ClientUpdateInvalidArea;
+    }
+    valid = valid && statuses[i] == ClientUpdateOk;
+  }
+  // The number of updates comes from IPC clients, so it never sizes a stack array
+  client_t** moved = valid ? malloc(numupdates * sizeof(*moved)) : NULL;
+  if(!moved) {
+    for(uint32_t i = 0; i < numupdates; i++) {
+      if(statuses[i] == ClientUpdateOk) {
+        statuses[i] = ClientUpdateNotApplied;
+      }
+    }
+    return false;
+  }
+
+  uint32_t nummoved = 0;
+  for(uint32_t i = 0; i < numupdates; i++) {
+    const client_update_t* u = &updates[i];
+    client_t* cl = clientfromwin(s, u->win);
+
+    if(u->fields & ClientUpdateArea) {
+      // Clients with an explicit area float unless told otherwise
+      cl->floating = true;
+      setclientarea(s, cl, u->area);
+    }
+    if(u->fields & ClientUpdateFloating) {
+      cl->floating = u->floating;
+    }
+
+    /* Without an explicit monitor, the client stays on its monitor or 
+     * moves to the one its new area is on */
+    monitor_t* mon = cl->mon;
+    if(u->fields & ClientUpdateMonitor) {
+      mon = monbyidx(s, u->monitor);
+    } else if(u->fields & ClientUpdateArea) {
+      mon = clientmon(s, cl);
+    }
+    uint32_t desktop = u->fields & ClientUpdateDesktop ? u->desktop : 
+      (mon == cl->mon ? cl->desktop : mondesktop(s, mon)->idx);
+
+    if(mon != cl->mon || desktop != cl->desktop) {
+      if(cl == s->focus && desktop != mondesktop(s, mon)->idx) {
+        unfocusclient(s, cl);
+      }
+      relocateclient(s, cl, mon, desktop);
+      moved[nummoved++] = cl;
+    }
+    cl->mon->layouts[cl->desktop].dirty = true;
+  }
 
-  s->monfocus = cl->mon; 
+  // Clients that left the shown desktop of their monitor are hidden before the layout
+  for(uint32_t i = 0; i < nummoved; i++) {
+    client_t* cl = moved[i];
+    if(cl->desktop != mondesktop(s, cl->mon)->idx && !cl->hidden) {
+      hideclient(s, cl);
+    }
+  }
+
+  for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
+    if(mon->layouts[mondesktop(s, mon)->idx].dirty) {
+      makelayout(s, mon);
+    }
+  }
+
+  // Clients that arrived on a shown desktop appear once they are layed out
+  for(uint32_t i = 0; i < nummoved; i++) {
+    client_t* cl = moved[i];
+    if(cl->desktop == mondesktop(s, cl->mon)->idx && cl->hidden && 
+      !cl->stacked && cl->scratchpad_index == -1) {
+      showclient(s, cl);
+    }
+  }
+  free(moved);
+
+  xflush(s);
+  return true;
 }
 
 /**
@@ -899,32 +1432,34 @@ raiseclient(state_t* s, client_t* cl) {
   }
   uint32_t config[] = { XCB_STACK_MODE_ABOVE };
   // Change the configuration of the window to be above 
-  xcb_configure_window(s->con, cl->frame, XCB_CONFIG_WINDOW_STACK_MODE, config);
-  for(client_t* ci = s->monfocus->clients; ci != NULL; ci = ci->next) {
-    if(ci->desktop != mondesktop(s, s->monfocus)->idx) break;
+  xconfigurewindow(s, cl->frame, XCB_CONFIG_WINDOW_STACK_MODE, config);
+  client_list_t* clients = visibleclients(s, s->monfocus);
+  for(uint32_t i = 0; i < clients->size; i++) {
+    client_t* ci = clients->items[i];
     switch(clientlayering(s, ci)) {
       case LayeringOrderAbove: 
-        xcb_configure_window(s->con, ci->frame, 
-                             XCB_CONFIG_WINDOW_STACK_MODE, config);
+        xconfigurewindow(s, ci->frame, 
+                         XCB_CONFIG_WINDOW_STACK_MODE, config);
         break;
       case LayeringOrderBelow: {
         uint32_t config_below[] = { XCB_STACK_MODE_BELOW };
-        xcb_configure_window(s->con, ci->frame, 
-                             XCB_CONFIG_WINDOW_STACK_MODE, config_below);
+        xconfigurewindow(s, ci->frame, 
+                         XCB_CONFIG_WINDOW_STACK_MODE, config_below);
         break;
       } 
       default: break;
     }
   }
 
-  for(uint32_t i = 0; i < s->popups.size; i++) {
+  for(uint32_t i = 0; i < s->popups.cap; i++) {
+    if(!winmapslotused(&s->popups, i)) continue;
     uint32_t popup_config[] = { !cl->fullscreen ? XCB_STACK_MODE_ABOVE  : XCB_STACK_MODE_BELOW };
-    xcb_configure_window(s->con, s->popups.items[i], 
-                         XCB_CONFIG_WINDOW_STACK_MODE, popup_config);
+    xconfigurewindow(s, s->popups.keys[i], 
+                     XCB_CONFIG_WINDOW_STACK_MODE, popup_config);
   }
 
 
-  xcb_flush(s->con);
+  xflush(s);
 }
 
 
@@ -941,7 +1476,7 @@ clienthasdeleteatom(state_t* s, client_t* cl) {
   bool ret = false;
   xcb_icccm_get_wm_protocols_reply_t reply;
 
-  if(xcb_icccm_get_wm_protocols_reply(s->con, xcb_icccm_get_wm_protocols_unchecked(s->con, cl->win, s->wm_atoms[WMprotocols]), &reply, NULL)) {
+  if(xgetwmprotocols(s, cl->win, s->wm_atoms[WMprotocols], &reply)) {
     for(uint32_t i = 0; !ret && i < reply.atoms_len; i++) {
       if(reply.atoms[i] == s->wm_atoms[WMdelete]) {
 	ret = true;
@@ -970,8 +1505,7 @@ clientshouldtile(state_t* s, client_t* cl) {
   xcb_atom_t wintypenormal_atom = getatom(s, "_NET_WM_WINDOW_TYPE_NORMAL");
 
   // Get window property for type
-  xcb_get_property_cookie_t cookie = xcb_get_property(s->con, 0, cl->win, wintype_atom, XCB_ATOM_ATOM, 0, 1);
-  xcb_get_property_reply_t* propreply = xcb_get_property_reply(s->con, cookie, NULL);
+  xcb_get_property_reply_t* propreply = xgetproperty(s, 0, cl->win, wintype_atom, XCB_ATOM_ATOM, 0, 1);
 
   if (!propreply) {
     return false;
@@ -998,7 +1532,7 @@ clientonscreen(state_t* s, client_t* cl, monitor_t* mon) {
 }
 
 /**
- * @brief Retrieves the name of a given client (allocates memory) 
+ * @brief Retrieves the name of a given client (allocated from the string pool) 
  *
  * @param s The window manager's state
  * @param cl The client to retrieve a name from  
@@ -1007,24 +1541,66 @@ clientonscreen(state_t* s, client_t* cl, monitor_t* mon) {
  */
 char* 
 getclientname(state_t* s, client_t* cl) {
-  xcb_icccm_get_text_property_reply_t prop;
-  // Try to get _NET_WM_NAME
-  xcb_get_property_cookie_t cookie = xcb_icccm_get_text_property(s->con, cl->win, XCB_ATOM_WM_NAME);
-  if (xcb_icccm_get_text_property_reply(s->con, cookie, &prop, NULL)) {
-    char* name = strndup(prop.name, prop.name_len);
-    xcb_icccm_get_text_property_reply_wipe(&prop);
-    return name;
-  }
-
-  // If _NET_WM_NAME is not available, try WM_NAME
-  cookie = xcb_icccm_get_text_property(s->con, cl->win, XCB_ATOM_WM_NAME);
-  if (xcb_icccm_get_text_property_reply(s->con, cookie, &prop, NULL)) {
-    char *name = strndup(prop.name, prop.name_len);
-    xcb_icccm_get_text_property_reply_wipe(&prop);
-    return name;
-  }
+  // _NET_WM_NAME (UTF-8) is preferred over WM_NAME
+  uint32_t len;
+  char* name = fetchwinname(s, cl->win, &len);
+  if(!name) return NULL;
+  char* poolname = pooldupstr(&s->strpool, name, len);
+  free(name);
+  return poolname;
+}
 
-  return NULL;
+/**
+ * @brief Marks the name of a given client as changed. Names are 
+ * fetched at most once per frame, so a client that updates its 
+ * title many times per frame only costs a single fetch.
+ *
+ * @param s The window manager's state
+ * @param cl The client whose name changed
+ */
+void
+marktitledirty(state_t* s, client_t* cl) {
+  if(cl->props->namedirty) return;
+  cl->props->namedirty = true;
+  vector_append(&s->dirtytitles, cl->win);
+  if(!s->titleupdatedue) {
+    s->titleupdatedue = monotonicms() + 1000 / MAX(s->config.motion_notify_debounce_fps, 1);
+  }
+}
+
+/**
+ * @brief Returns the time in milliseconds until the changed 
+ * client names are due to be fetched.
+ *
+ * @param s The window manager's state
+ *
+ * @return The time until the fetch (-1 if no name changed)
+ */
+int32_t
+titleupdatetimeout(state_t* s) {
+  if(!s->titleupdatedue) return -1;
+  uint64_t now = monotonicms();
+  return s->titleupdatedue > now ? (int32_t)(s->titleupdatedue - now) : 0;
+}
+
+/**
+ * @brief Fetches the names of the clients whose name changed 
+ * if the title update of the current frame is due.
+ *
+ * @param s The window manager's state
+ */
+void
+updatetitles(state_t* s) {
+  if(!s->titleupdatedue || monotonicms() < s->titleupdatedue) return;
+  s->titleupdatedue = 0;
+  for(uint32_t i = 0; i < s->dirtytitles.size; i++) {
+    // Clients that were released in the meantime are skipped
+    client_t* cl = clientfromwin(s, s->dirtytitles.items[i]);
+    if(!cl || !cl->props->namedirty) continue;
+    cl->props->namedirty = false;
+    fetchclientprops(s, cl, PropFetchName);
+  }
+  s->dirtytitles.size = 0;
 }
 
 /**
@@ -1045,21 +1621,22 @@ killclient(state_t* s, client_t* cl) {
     ev.data.data32[0] = s->wm_atoms[WMdelete];
     ev.data.data32[1] = XCB_TIME_CURRENT_TIME;
     ev.type = s->wm_atoms[WMprotocols];
-    xcb_send_event(s->con, false, cl->win, XCB_EVENT_MASK_NO_EVENT, (const char*)&ev);
+    xsendevent(s, false, cl->win, XCB_EVENT_MASK_NO_EVENT, (const char*)&ev);
   } else {
     // Force kill the client without sending an event
-    xcb_grab_server(s->con);
-    xcb_set_close_down_mode(s->con, XCB_CLOSE_DOWN_DESTROY_ALL);
-    xcb_kill_client(s->con, cl->win);
-    xcb_ungrab_server(s->con);
+    xgrabserver(s);
+    xsetclosedownmode(s, XCB_CLOSE_DOWN_DESTROY_ALL);
+    xkillclient(s, cl->win);
+    xungrabserver(s);
   }
   makelayout(s, s->monfocus);
-  xcb_flush(s->con);
+  xflush(s);
 }
 
 
 /**
- * @brief Sets the current focus to a given client
+ * @brief Sets the current focus to a given client. Only the previously 
+ * focused client and the newly focused client are touched.
  *
  * @param s The window manager's state
  * @param cl The client to focus
@@ -1070,23 +1647,37 @@ focusclient(state_t* s, client_t* cl, bool upload_ewmh_desktops) {
     return;
   }
 
-  // Unfocus the previously focused window to ensure that there is only
-  // one focused (highlighted) window at a time.
-  if(s->focus) {
-    unfocusclient(s, s->focus);
-  }
+  if(cl != s->focus) {
+    // Show a client that is hidden behind the shown client of a monocle layout
+    if(cl->stacked && cl->desktop == mondesktop(s, cl->mon)->idx) {
+      cl->mon->layouts[cl->desktop].active = cl;
+      makelayout(s, cl->mon);
+    }
 
-  // Set input focus 
-  setxfocus(s, cl);
+    // Remove the highlight of the previously focused client
+    if(s->focus) {
+      setbordercolor(s, s->focus, s->config.winbordercolor);
+      s->focus->ignoreexpose = false;
+    }
 
-  if(!cl->fullscreen) {
-    // Change border color to indicate selection
-    setbordercolor(s, cl, s->config.winbordercolor_selected);
-    setborderwidth(s, cl, s->config.winborderwidth);
-  }
+    // Set input focus 
+    if(cl->neverfocus) {
+      focusroot(s);
+    } else {
+      setxfocus(s, cl);
+    }
+
+    if(!cl->fullscreen) {
+      // Change border color to indicate selection
+      setbordercolor(s, cl, s->config.winbordercolor_selected);
+      if(cl->borderwidth != s->config.winborderwidth) {
+        setborderwidth(s, cl, s->config.winborderwidth);
+      }
+    }
 
-  // Set the focused client
-  s->focus = cl;
+    // Set the focused client
+    s->focus = cl;
+  }
 
   monitor_t* mon = cl->mon; 
   if(mon != s->monfocus && upload_ewmh_desktops) {
@@ -1106,16 +1697,46 @@ void
 setxfocus(state_t* s, client_t* cl) {
   if(cl->neverfocus) return;
   // Set input focus to client
-  xcb_set_input_focus(s->con, XCB_INPUT_FOCUS_POINTER_ROOT, cl->win, XCB_CURRENT_TIME);
+  xsetinputfocus(s, XCB_INPUT_FOCUS_POINTER_ROOT, cl->win, XCB_CURRENT_TIME);
 
   // Set active window hint
-  xcb_change_property(s->con, XCB_PROP_MODE_REPLACE, cl->win, s->ewmh_atoms[EWMHactiveWindow],
-      XCB_ATOM_WINDOW, 32, 1, &cl->win);
+  setactivewindow(s, cl->win);
 
   // Raise take-focus event on the client
   raiseevent(s, cl, s->wm_atoms[WMtakeFocus]);
 }
 
+/**
+ * @brief Sets the X input focus to the root window and 
+ * unsets the active window hint.
+ *
+ * @param s The window manager's state
+ */
+void
+focusroot(state_t* s) {
+  xsetinputfocus(s, XCB_INPUT_FOCUS_POINTER_ROOT, s->root, XCB_CURRENT_TIME);
+  setactivewindow(s, XCB_NONE);
+}
+
+/**
+ * @brief Sets the _NET_ACTIVE_WINDOW hint on the root window if 
+ * it differs from the last value that was set.
+ *
+ * @param s The window manager's state
+ * @param win The active window (XCB_NONE to delete the hint)
+ */
+void
+setactivewindow(state_t* s, xcb_window_t win) {
+  if(win == s->activewin) return;
+  if(win == XCB_NONE) {
+    xdeleteproperty(s, s->root, s->ewmh_atoms[EWMHactiveWindow]);
+  } else {
+    xchangeproperty(s, XCB_PROP_MODE_REPLACE, s->root, s->ewmh_atoms[EWMHactiveWindow],
+                    XCB_ATOM_WINDOW, 32, 1, &win);
+  }
+  s->activewin = win;
+}
+
 /**
  * @brief Creates a frame window for the content of a client window and decoration to live in.
  * The frame window encapsulates the client's window and decoration like titlebar.
@@ -1129,27 +1750,26 @@ frameclient(state_t* s, client_t* cl) {
   // Create the frame window 
   {
     cl->frame = truecolorwindow(s, cl->area, s->config.winborderwidth);
-
-    // Select input events 
-    unsigned long event_mask = StructureNotifyMask | SubstructureNotifyMask | SubstructureRedirectMask |
-      PropertyChangeMask | EnterWindowMask | FocusChangeMask | ButtonPressMask;
-    XSelectInput(s->dsp, cl->frame, event_mask); 
+    trackresource(s, cl, XResourceWindow, 1);
+    // Frames are recognized without asking the server when they are (un)mapped
+    winmapset(&s->winkinds, cl->frame, WindowKindOwn);
+    selectframeinput(s, cl->frame);
   }
 
   // Reparent the client's content to the newly created frame
-  xcb_reparent_window(s->con, cl->win, cl->frame, 0, 0);
+  xreparentwindow(s, cl->win, cl->frame, 0, 0);
 
   // Update the window's geometry
   {
     // Update the window's position by configuring it's X and Y property
     int32_t posval[2] = {(int32_t)cl->area.pos.x, (int32_t)cl->area.pos.y};
-    xcb_configure_window(s->con, cl->frame, XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y, posval);
+    xconfigurewindow(s, cl->frame, XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y, posval);
 
     uint32_t sizeval[2] = { (uint32_t)cl->area.size.x, (uint32_t)cl->area.size.y };
     uint32_t sizeval_content[2] = { (uint32_t)cl->area.size.x, (uint32_t)cl->area.size.y};
     // Resize the window by configuring it's width and height property
-    xcb_configure_window(s->con, cl->win, XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, sizeval_content);
-    xcb_configure_window(s->con, cl->frame, XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, sizeval);
+    xconfigurewindow(s, cl->win, XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, sizeval_content);
+    xconfigurewindow(s, cl->frame, XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, sizeval);
   }
 
   // Send configure notify eventevent  to the client 
@@ -1157,19 +1777,49 @@ frameclient(state_t* s, client_t* cl) {
   updateedgewindows(s, cl);
 }
 
+/**
+ * @brief Selects the events the window manager needs on a frame window.
+ *
+ * @param s The window manager's state
+ * @param frame The frame window 
+ */
+void
+selectframeinput(state_t* s, xcb_window_t frame) {
+  uint32_t event_mask = XCB_EVENT_MASK_STRUCTURE_NOTIFY | XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY | 
+    XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT | XCB_EVENT_MASK_PROPERTY_CHANGE | XCB_EVENT_MASK_ENTER_WINDOW | 
+    XCB_EVENT_MASK_LEAVE_WINDOW | XCB_EVENT_MASK_FOCUS_CHANGE | XCB_EVENT_MASK_BUTTON_PRESS;
+  xchangewindowattributes(s, frame, XCB_CW_EVENT_MASK, &event_mask);
+}
+
 /**
  * @brief Destroys and unmaps the frame window of a given client 
  * which consequently removes the client's window from the display
  *
  * @param s The window manager's state
  * @param cl The client to unframe 
+ * @param windestroyed Whether the client's window was destroyed
  */
 void
-unframeclient(state_t* s, client_t* cl) {
-  xcb_unmap_window(s->con, cl->frame);
-  xcb_reparent_window(s->con, cl->win, s->root, 0, 0);
-  xcb_destroy_window(s->con, cl->frame);
-  xcb_flush(s->con);
+unframeclient(state_t* s, client_t* cl, bool windestroyed) {
+  /* The edge windows and button grabs are on the client's window. 
+   * They are gone with a destroyed window but would stay around 
+   * with a window that is only withdrawn. */
+  uint32_t numedges = cl->props->edges[EdgeLeft].win != XCB_NONE ? 8 : 0;
+  if(!windestroyed) {
+    for(uint32_t i = 1; i <= numedges; i++) {
+      xdestroywindow(s, cl->props->edges[i].win);
+    }
+    xungrabbutton(s, 1, cl->win, XCB_MOD_MASK_ANY);
+    xungrabbutton(s, 3, cl->win, XCB_MOD_MASK_ANY);
+  }
+  trackresource(s, cl, XResourceWindow, -(int32_t)numedges);
+  trackresource(s, cl, XResourceGrab, -(int32_t)cl->props->resources[XResourceGrab]);
+
+  xunmapwindow(s, cl->frame);
+  xreparentwindow(s, cl->win, s->root, 0, 0);
+  xdestroywindow(s, cl->frame);
+  trackresource(s, cl, XResourceWindow, -1);
+  xflush(s);
 }
 
 /**
@@ -1186,16 +1836,164 @@ unfocusclient(state_t* s, client_t* cl) {
     return;
   }
   setbordercolor(s, cl, s->config.winbordercolor);
-  xcb_set_input_focus(s->con, XCB_INPUT_FOCUS_POINTER_ROOT, s->root, XCB_CURRENT_TIME);
-  xcb_delete_property(s->con, s->root, s->ewmh_atoms[EWMHactiveWindow]);
+  focusroot(s);
 
   cl->ignoreexpose = false;
-  s->focus = NULL;
+  if(s->focus == cl) {
+    s->focus = NULL;
+  }
 }
 
 void 
 removescratchpad(state_t* s, uint32_t idx) {
   s->scratchpads[idx].needs_restart = true;
+  s->scratchpads[idx].pending = false;
+  s->scratchpads[idx].win = 0;
+}
+
+/**
+ * @brief Returns the togglescratchpad keybind that defines 
+ * the scratchpad at a given index.
+ *
+ * @param s The window manager's state
+ * @param idx The index of the scratchpad
+ *
+ * @return The keybind of the scratchpad (NULL if there is none)
+ */
+const keybind_t*
+scratchpadkeybind(state_t* s, uint32_t idx) {
+  for(uint32_t i = 0; i < s->config.numkeybinds; i++) {
+    const keybind_t* kb = &s->config.keybinds[i];
+    if(kb->cb == togglescratchpad && kb->data.i == (int32_t)idx) {
+      return kb;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief Launches the command of a scratchpad. The window of the 
+ * command becomes the scratchpad once it maps.
+ *
+ * @param s The window manager's state
+ * @param idx The index of the scratchpad to launch
+ * @param cmd The command that opens the scratchpad's window
+ * @param hidden Whether the scratchpad stays hidden when its window maps
+ */
+void
+launchscratchpad(state_t* s, uint32_t idx, const char* cmd, bool hidden) {
+  if(idx >= s->config.maxscratchpads || !cmd) return;
+  int32_t pid = spawncmd(s, cmd);
+  if(pid == -1) return;
+  s->scratchpads[idx] = (scratchpad_t){
+    .hidden = hidden,
+    .needs_restart = false,
+    .pending = true,
+    .pid = pid,
+  };
+  logmsg(s, LogLevelTrace, "launched scratchpad %i (pid %i).", idx, pid);
+}
+
+/**
+ * @brief Launches every scratchpad with a given launch mode 
+ * hidden that is not running yet.
+ *
+ * @param s The window manager's state
+ * @param launch The launch mode of the scratchpads to launch
+ */
+void
+launchscratchpads(state_t* s, scratchpad_launch_t launch) {
+  for(uint32_t i = 0; i < s->config.numkeybinds; i++) {
+    const keybind_t* kb = &s->config.keybinds[i];
+    if(kb->cb != togglescratchpad || kb->launch != launch) continue;
+    if(kb->data.i < 0 || (uint32_t)kb->data.i >= s->config.maxscratchpads) continue;
+    if(!s->scratchpads[kb->data.i].needs_restart) continue;
+    launchscratchpad(s, kb->data.i, kb->data.cmd, true);
+  }
+}
+
+/**
+ * @brief Returns the time in milliseconds until the lazily 
+ * launched scratchpads are due to be launched.
+ *
+ * @param s The window manager's state
+ *
+ * @return The time until the launch (-1 if nothing is due)
+ */
+int32_t
+scratchpadlaunchtimeout(state_t* s) {
+  if(!s->scratchpadlaunchdue) return -1;
+  uint64_t now = monotonicms();
+  return s->scratchpadlaunchdue > now ? (int32_t)(s->scratchpadlaunchdue - now) : 0;
+}
+
+/**
+ * @brief Finds the launched scratchpad that a newly mapped client 
+ * belongs to by its WM_CLASS or, if the scratchpad does not specify 
+ * a class, by its _NET_WM_PID.
+ *
+ * @param s The window manager's state
+ * @param cl The newly mapped client
+ *
+ * @return The index of the scratchpad (-1 if the client is no scratchpad)
+ */
+int32_t
+matchscratchpad(state_t* s, client_t* cl) {
+  xcb_icccm_get_wm_class_reply_t wmclass;
+  bool classfetched = false, hasclass = false;
+  bool pidfetched = false;
+  int32_t pid = -1;
+  int32_t match = -1;
+
+  // The properties are only fetched if a launched scratchpad needs them
+  for(uint32_t i = 0; i < s->config.maxscratchpads && match == -1; i++) {
+    if(!s->scratchpads[i].pending) continue;
+    const keybind_t* kb = scratchpadkeybind(s, i);
+    if(kb && kb->wmclass) {
+      if(!classfetched) {
+        hasclass = xgetwmclass(s, cl->win, &wmclass);
+        classfetched = true;
+      }
+      if(hasclass && (strcmp(wmclass.instance_name, kb->wmclass) == 0 || 
+        strcmp(wmclass.class_name, kb->wmclass) == 0)) {
+        match = i;
+      }
+    } else {
+      if(!pidfetched) {
+        pid = getwinpid(s, cl->win);
+        pidfetched = true;
+      }
+      if(pid > 0 && pid == s->scratchpads[i].pid) {
+        match = i;
+      }
+    }
+  }
+  if(hasclass) {
+    xcb_icccm_get_wm_class_reply_wipe(&wmclass);
+  }
+  return match;
+}
+
+/**
+ * @brief Returns the process id that a given window 
+ * specifies with _NET_WM_PID.
+ *
+ * @param s The window manager's state
+ * @param win The window to get the process id of
+ *
+ * @return The process id of the window (-1 if not specified)
+ */
+int32_t
+getwinpid(state_t* s, xcb_window_t win) {
+  int32_t pid = -1;
+  xcb_get_property_reply_t* reply = xgetproperty(s, 0, win, s->ewmh_atoms[EWMHwmPid], XCB_ATOM_CARDINAL, 0, 1);
+  if(reply) {
+    if(reply->format == 32 && xcb_get_property_value_length(reply) >= 4) {
+      pid = *(int32_t*)xcb_get_property_value(reply);
+    }
+    free(reply);
+  }
+  return pid;
 }
 
 /**
@@ -1231,7 +2029,7 @@ configclient(state_t* s, client_t* cl) {
   // Override-redirect flag
   event.override_redirect = 0;
   // Send the event
-  xcb_send_event(s->con, 0, cl->win, XCB_EVENT_MASK_STRUCTURE_NOTIFY, (const char *)&event);
+  xsendevent(s, 0, cl->win, XCB_EVENT_MASK_STRUCTURE_NOTIFY, (const char *)&event);
 }
 
 /*
@@ -1242,9 +2040,19 @@ configclient(state_t* s, client_t* cl) {
  */
 void
 hideclient(state_t* s, client_t* cl) {
-  cl->ignoreunmap = true;
   cl->hidden = true;
-  xcb_unmap_window(s->con, cl->frame);
+  if(s->config.hidestrategy == HideStrategyPark) {
+    /* Keep the frame mapped and move it just outside of the left edge 
+     * of the screen so that showing it again is a single configure */
+    int32_t posval[2] = {
+      -(int32_t)(cl->area.size.x + cl->borderwidth * 2), (int32_t)cl->area.pos.y
+    };
+    xconfigurewindow(s, cl->frame, XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y, posval);
+    cl->parked = true;
+    return;
+  }
+  cl->ignoreunmap = true;
+  xunmapwindow(s, cl->frame);
 }
 
 /*
@@ -1256,7 +2064,14 @@ hideclient(state_t* s, client_t* cl) {
 void
 showclient(state_t* s, client_t* cl) {
   cl->hidden = false;
-  xcb_map_window(s->con, cl->frame);
+  if(cl->parked) {
+    // Move the parked frame back to where the client is 
+    int32_t posval[2] = { (int32_t)cl->area.pos.x, (int32_t)cl->area.pos.y };
+    xconfigurewindow(s, cl->frame, XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y, posval);
+    cl->parked = false;
+    return;
+  }
+  xmapwindow(s, cl->frame);
 }
 
 /**
@@ -1272,7 +2087,7 @@ raiseevent(state_t* s, client_t* cl, xcb_atom_t protocol) {
   xcb_icccm_get_wm_protocols_reply_t reply;
 
   // Checking if the event protocol exists
-  if (xcb_icccm_get_wm_protocols_reply(s->con, xcb_icccm_get_wm_protocols(s->con, cl->win, s->wm_atoms[WMprotocols]), &reply, NULL)) {
+  if (xgetwmprotocols(s, cl->win, s->wm_atoms[WMprotocols], &reply)) {
     for (uint32_t i = 0; i < reply.atoms_len && !exists; i++) {
       exists = (reply.atoms[i] == protocol);
     }
@@ -1289,7 +2104,7 @@ raiseevent(state_t* s, client_t* cl, xcb_atom_t protocol) {
     event.format = 32;
     event.data.data32[0] = protocol;
     event.data.data32[1] = XCB_CURRENT_TIME;
-    xcb_send_event(s->con, 0, cl->win, XCB_EVENT_MASK_NO_EVENT, (const char *)&event);
+    xsendevent(s, 0, cl->win, XCB_EVENT_MASK_NO_EVENT, (const char *)&event);
   }
   return exists;
 }
@@ -1328,8 +2143,7 @@ seturgent(state_t* s, client_t* cl, bool urgent) {
   xcb_icccm_wm_hints_t wmh;
   cl->urgent = urgent;
 
-  xcb_get_property_cookie_t cookie = xcb_icccm_get_wm_hints(s->con, cl->win);
-  if (!xcb_icccm_get_wm_hints_reply(s->con, cookie, &wmh, NULL)) {
+  if (!xgetwmhints(s, cl->win, &wmh)) {
     return;
   }
 
@@ -1338,7 +2152,7 @@ seturgent(state_t* s, client_t* cl, bool urgent) {
   } else {
     wmh.flags &= ~XCB_ICCCM_WM_HINT_X_URGENCY;
   }
-  xcb_icccm_set_wm_hints(s->con, cl->win, &wmh);
+  xsetwmhints(s, cl->win, &wmh);
 }
 
 /**
@@ -1351,20 +2165,25 @@ seturgent(state_t* s, client_t* cl, bool urgent) {
 client_t* 
 nextvisible(state_t* s, bool skip_floating) {
   client_t* next = NULL;
+  client_list_t* clients = visibleclients(s, s->monfocus);
   // Find the next client on the current monitor & desktop 
-  for(client_t* cl = s->focus->next; cl != NULL; cl = cl->next) {
-    bool checktiled = (skip_floating) ? !cl->floating : true;
-    if(checktiled && clientonscreen(s, cl, s->monfocus)) {
-      next = cl;
-      break;
+  if(clientonscreen(s, s->focus, s->monfocus)) {
+    for(uint32_t i = s->focus->slot + 1; i < clients->size; i++) {
+      client_t* cl = clients->items[i];
+      bool checktiled = (skip_floating) ? !cl->floating : true;
+      if(checktiled) {
+        next = cl;
+        break;
+      }
     }
   }
 
   // If there is no next client, cycle back to the first client on the 
   // current monitor & desktop
   if(!next) {
-    for(client_t* cl = s->monfocus->clients; cl != NULL; cl = cl->next) {
-    bool checktiled = (skip_floating) ? !cl->floating : true;
+    for(uint32_t i = 0; i < clients->size; i++) {
+      client_t* cl = clients->items[i];
+      bool checktiled = (skip_floating) ? !cl->floating : true;
       if(checktiled) {
         next = cl;
         break;
@@ -1386,15 +2205,10 @@ nextvisible(state_t* s, bool skip_floating) {
  */
 xcb_atom_t
 getclientprop(state_t* s, client_t* cl, xcb_atom_t prop) {
-  xcb_generic_error_t *error;
   xcb_atom_t atom = XCB_NONE;
-  xcb_get_property_cookie_t cookie;
-  xcb_get_property_reply_t *reply;
 
   // Get the property from the window
-  cookie = xcb_get_property(s->con, 0, cl->win, prop, XCB_ATOM_ATOM, 0, sizeof(xcb_atom_t));
-  // Get the reply
-  reply = xcb_get_property_reply(s->con, cookie, &error);
+  xcb_get_property_reply_t *reply = xgetproperty(s, 0, cl->win, prop, XCB_ATOM_ATOM, 0, sizeof(xcb_atom_t));
 
   if(reply) { 
     // Check if the property type matches the expected type and has the right format
@@ -1403,9 +2217,6 @@ getclientprop(state_t* s, client_t* cl, xcb_atom_t prop) {
     }
     free(reply);
   }
-  if(error) {
-    free(error);
-  }
   return atom;
 }
 
@@ -1424,30 +2235,30 @@ setfullscreen(state_t* s, client_t* cl, bool fullscreen) {
 
   cl->fullscreen = fullscreen;
   if(cl->fullscreen) {
-    xcb_change_property(
-      s->con, XCB_PROP_MODE_REPLACE, cl->win, 
+    xchangeproperty(
+      s, XCB_PROP_MODE_REPLACE, cl->win, 
       s->ewmh_atoms[EWMHstate], XCB_ATOM_ATOM, 
       32, 1, &s->ewmh_atoms[EWMHfullscreen]);
     // Store previous position of client
-    cl->area_prev = cl->area;
+    cl->props->area_prev = cl->area;
     // Store previous floating state of client
-    cl->floating_prev = cl->floating;
+    cl->props->floating_prev = cl->floating;
     cl->floating = true;
-    // Set the client's area to the focused monitors area, effictivly
+    // Set the client's area to the client's monitor area, effictivly
     // making the client as large as the monitor screen
-    cl->area = s->monfocus->area;
+    cl->area = cl->mon ? cl->mon->area : s->monfocus->area;
 
     // Unset border of client if it's fullscreen
     cl->borderwidth = 0;
     toggleedgewindows(s, cl, false);
   } else {
-    xcb_change_property(
-      s->con, XCB_PROP_MODE_REPLACE, 
+    xchangeproperty(
+      s, XCB_PROP_MODE_REPLACE, 
       cl->win, s->ewmh_atoms[EWMHstate], 
       XCB_ATOM_ATOM, 32, 0, 0); 
     // Set the client's area to the area before the last fullscreen occured 
-    cl->area = cl->area_prev;
-    cl->floating = cl->floating_prev;
+    cl->area = cl->props->area_prev;
+    cl->floating = cl->props->floating_prev;
     cl->borderwidth = s->config.winborderwidth;
     toggleedgewindows(s, cl, true);
   }
@@ -1491,7 +2302,7 @@ switchclientdesktop(state_t* s, client_t* cl, int32_t desktop) {
   }
   free(names);
 
-  cl->desktop = desktop;
+  relocateclient(s, cl, cl->mon, desktop);
   if(cl == s->focus) {
     unfocusclient(s, cl);
   }
@@ -1511,6 +2322,7 @@ switchmonitordesktop(state_t* s, int32_t desktop) {
  if(!s->monfocus) return;
   if(desktop == (int32_t)mondesktop(s, s->monfocus)->idx) return;
 
+  bool newdesktop = !s->monfocus->activedesktops[desktop].init;
   s->monfocus->activedesktops[desktop].init = true;
 
   uint32_t desktopidx = 0;
@@ -1524,57 +2336,93 @@ switchmonitordesktop(state_t* s, int32_t desktop) {
     init_i++;
   }
   // Notify EWMH for desktop change
-  xcb_change_property(s->con, XCB_PROP_MODE_REPLACE, s->root, s->ewmh_atoms[EWMHcurrentDesktop],
+  xchangeproperty(s, XCB_PROP_MODE_REPLACE, s->root, s->ewmh_atoms[EWMHcurrentDesktop],
       XCB_ATOM_CARDINAL, 32, 1, &desktopidx);
 
-  uint32_t desktopcount = 0;
-  for(uint32_t i = 0; i < s->monfocus->desktopcount; i++) {
-    if(s->monfocus->activedesktops[i].init) {
-      desktopcount++;
+  // The desktop count and names only change when a desktop is shown 
+  // for the first time
+  if(newdesktop) {
+    uint32_t desktopcount = 0;
+    for(uint32_t i = 0; i < s->monfocus->desktopcount; i++) {
+      if(s->monfocus->activedesktops[i].init) {
+        desktopcount++;
+      }
     }
+    xchangeproperty(s, XCB_PROP_MODE_REPLACE, s->root, s->ewmh_atoms[EWMHnumberOfDesktops],
+                    XCB_ATOM_CARDINAL, 32, 1, &desktopcount);
+    uploaddesktopnames(s, s->monfocus);
   }
-  xcb_change_property(s->con, XCB_PROP_MODE_REPLACE, s->root, s->ewmh_atoms[EWMHnumberOfDesktops],
-                      XCB_ATOM_CARDINAL, 32, 1, &desktopcount);
-  uploaddesktopnames(s, s->monfocus);
 
+  client_list_t* outgoing = visibleclients(s, s->monfocus);
+  client_list_t* incoming = &s->monfocus->clients[desktop];
 
-  for (client_t* cl = s->monfocus->clients; cl != NULL; cl = cl->next) {
-    if(cl->scratchpad_index != -1) continue;
-    // Hide the clients on the current desktop
-    if(cl->desktop == mondesktop(s, s->monfocus)->idx) {
-      hideclient(s, cl);
-      // Show the clients on the desktop we want to switch to
-    } else if((int32_t)cl->desktop == desktop) {
-      showclient(s, cl);
-    }
+  // Only the focused client can be selected, so only it needs to be unfocused
+  if(s->focus && s->focus->mon == s->monfocus && 
+    s->focus->desktop == mondesktop(s, s->monfocus)->idx) {
+    unfocusclient(s, s->focus);
   }
 
-  // Unfocus all selected clients
-  for(client_t* cl = s->monfocus->clients; cl != NULL; cl = cl->next) {
-    unfocusclient(s, cl);
+  /* The tab bar belongs to the monitor, so it needs to show the 
+   * tabs of the incoming desktop or be hidden */
+  if(s->monfocus->layouts[desktop].curlayout == LayoutTabbed || 
+    s->monfocus->tabbar.mapped) {
+    s->monfocus->layouts[desktop].dirty = true;
   }
 
   mondesktop(s, s->monfocus)->idx = desktop;
-  makelayout(s, s->monfocus);
+
+  /* Establish the layout before the clients are shown so that they 
+   * appear at their final position. Nothing changed about the desktop 
+   * since it was layed out last if its layout is clean. */
+  if(s->monfocus->layouts[desktop].dirty) {
+    makelayout(s, s->monfocus);
+  }
+
+  /* Show the clients on the desktop we want to switch to before hiding 
+   * the clients of the current desktop so that the root window never 
+   * shows through in between. All requests go out with one flush. */
+  for(uint32_t i = 0; i < incoming->size; i++) {
+    client_t* cl = incoming->items[i];
+    if(cl->scratchpad_index != -1 || cl->stacked) continue;
+    showclient(s, cl);
+  }
+
+  // Stacked clients of a monocle layout are hidden already
+  for(uint32_t i = 0; i < outgoing->size; i++) {
+    client_t* cl = outgoing->items[i];
+    if(cl->scratchpad_index != -1 || cl->stacked) continue;
+    hideclient(s, cl);
+  }
 
   logmsg(s, LogLevelTrace, "Switched virtual desktop on monitor %i to %i",
       s->monfocus->idx, desktop);
 
   s->ignore_enter_layout = false;
 
-  // Retrieving cursor position
-  bool cursor_success;
-  v2_t cursor = cursorpos(s, &cursor_success);
-  if(!cursor_success)  return;
-
   // Focusing the client on the other desktop that is hovered
-  for(client_t* cl = s->monfocus->clients; cl != NULL; cl = cl->next) {
-    if(pointinarea(cursor, cl->area)) {
-      focusclient(s, cl, false);
-      break;
+  bool cursor_success;
+  v2_t cursor = cachedcursorpos(s, &cursor_success);
+  if(cursor_success) {
+    /* The shown client of a monocle layout shares its area with the 
+     * stacked clients, so it is preferred over them */
+    client_t* hovered = NULL;
+    client_t* active = s->monfocus->layouts[desktop].active;
+    if(active && !active->hidden && pointinarea(cursor, active->area)) {
+      hovered = active;
+    }
+    for(uint32_t i = 0; i < incoming->size && !hovered; i++) {
+      client_t* cl = incoming->items[i];
+      if(cl->stacked || cl->hidden) continue;
+      if(pointinarea(cursor, cl->area)) {
+        hovered = cl;
+      }
+    }
+    if(hovered) {
+      focusclient(s, hovered, false);
     }
   }
 
+  xflush(s);
 }
 
 /**
@@ -1587,8 +2435,9 @@ switchmonitordesktop(state_t* s, int32_t desktop) {
 uint32_t
 numinlayout(state_t* s, monitor_t* mon) {
   uint32_t nlayout = 0;
-  for(client_t* cl = s->monfocus->clients; cl != NULL; cl = cl->next) {
-    if(clientonscreen(s, cl, mon) && !cl->floating) {
+  client_list_t* clients = visibleclients(s, mon);
+  for(uint32_t i = 0; i < clients->size; i++) {
+    if(!clients->items[i]->floating) {
       nlayout++;
     }
   }
@@ -1614,11 +2463,18 @@ getcurlayout(state_t* s, monitor_t* mon) {
 void
 makelayout(state_t* s, monitor_t* mon) {
   layout_type_t curlayout = getcurlayout(s, mon); 
+  uint32_t deskidx = mondesktop(s, mon)->idx;
+  mon->layouts[deskidx].dirty = false;
+  if(curlayout != LayoutMonocle && curlayout != LayoutTabbed) {
+    unstackclients(s, mon);
+  }
+  if(curlayout != LayoutTabbed) {
+    hidetabbar(s, mon);
+  }
   if(curlayout == LayoutFloating) return;
 
   /* Make sure that there is always at least one slave window */
-  uint32_t nlayout = numinlayout(s, s->monfocus);
-  uint32_t deskidx = mondesktop(s, mon)->idx;
+  uint32_t nlayout = numinlayout(s, mon);
   while(nlayout - mon->layouts[deskidx].nmaster == 0 && nlayout != 1) {
     mon->layouts[deskidx].nmaster--;
   }
@@ -1637,12 +2493,32 @@ makelayout(state_t* s, monitor_t* mon) {
       horizontalstripes(s, mon);
       break;
     }
+    case LayoutMonocle:
+    case LayoutTabbed: {
+      monocle(s, mon);
+      break;
+    }
     default: {
         break;
       }
   }
 }
 
+/**
+ * @brief Marks the layouts of all desktops on all monitors as 
+ * dirty so that they are re-established when they are shown next.
+ *
+ * @param s The window manager's state
+ */
+void
+invalidatelayouts(state_t* s) {
+  for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
+    for(uint32_t i = 0; i < s->config.maxdesktops; i++) {
+      mon->layouts[i].dirty = true;
+    }
+  }
+}
+
 /**
  * @brief Resets the size modifications of 
  * all client windows within the layout.
@@ -1652,14 +2528,43 @@ makelayout(state_t* s, monitor_t* mon) {
  */
 void 
 resetlayoutsizes(state_t* s, monitor_t* mon) {
-  for(client_t* cl = s->monfocus->clients; cl != NULL; cl = cl->next) {
-    if(cl->floating ||
-      !clientonscreen(s, cl, mon)) continue;
+  client_list_t* clients = visibleclients(s, mon);
+  for(uint32_t i = 0; i < clients->size; i++) {
+    client_t* cl = clients->items[i];
+    if(cl->floating) continue;
 
     cl->layoutsizeadd = 0.0f;
   }
 }
 
+/**
+ * @brief Returns the area of a given monitor that layouts can 
+ * place windows in, which is the monitor's area without the 
+ * struts of the windows on it.
+ *
+ * @param s The window manager's state
+ * @param mon The monitor to get the layout area of 
+ *
+ * @return The area of the monitor without the struts
+ */
+area_t
+layoutarea(state_t* s, monitor_t* mon) {
+  area_t area = mon->area;
+  for(uint32_t i = 0; i < s->nwinstruts; i++) {
+    bool onmonitor = 
+      s->winstruts[i].startx >= mon->area.pos.x  
+      && s->winstruts[i].endx <= mon->area.pos.x + mon->area.size.x;
+
+    if(!onmonitor) continue;
+
+    area.pos.x  += s->winstruts[i].left;
+    area.size.x -= s->winstruts[i].left + s->winstruts[i].right;
+    area.pos.y  += s->winstruts[i].top;
+    area.size.y -= s->winstruts[i].top + s->winstruts[i].bottom;
+  }
+  return area;
+}
+
 /**
  * @brief Establishes a tiled master layout for the windows that are 
  * currently visible.
@@ -1678,49 +2583,26 @@ tiledmaster(state_t* s, monitor_t* mon) {
 
   enumartelayout(s, mon, &nmaster, &nslaves);
 
-  uint32_t w = mon->area.size.x;
-  uint32_t h = mon->area.size.y;
-  int32_t x = mon->area.pos.x;
-  int32_t y = mon->area.pos.y;
-
-  // Apply strut information to the layout
-  for(uint32_t i = 0; i < s->nwinstruts; i++) {
-    bool onmonitor = 
-      s->winstruts[i].startx >= mon->area.pos.x  
-      && s->winstruts[i].endx <= mon->area.pos.x + mon->area.size.x;
-
-    if(!onmonitor) continue;
-
-    if(s->winstruts[i].left != 0) {
-      x += s->winstruts[i].left;
-      w -= s->winstruts[i].left;
-    }
-    if(s->winstruts[i].right != 0) {
-      w -= s->winstruts[i].right;
-    }
-    if(s->winstruts[i].top != 0) {
-      y += s->winstruts[i].top;
-      h -= s->winstruts[i].top;
-    }
-    if(s->winstruts[i].bottom != 0) {
-      h -= s->winstruts[i].bottom;
-    }
-  }
+  area_t area = layoutarea(s, mon);
+  uint32_t w = area.size.x;
+  uint32_t h = area.size.y;
+  int32_t x = area.pos.x;
+  int32_t y = area.pos.y;
 
   int32_t ymaster = y;
   float wmaster = w * masterarea;
 
   mon->layouts[deskidx].mastermaxed = false;
 
+  client_list_t* clients = visibleclients(s, mon);
   uint32_t i = 0;
-  for(client_t* cl = s->monfocus->clients; cl != NULL; cl = cl->next) {
-    if(cl->floating || 
-      cl->desktop != mondesktop(s, cl->mon)->idx || 
-      cl->mon != mon) continue;
+  for(uint32_t j = 0; j < clients->size; j++) {
+    client_t* cl = clients->items[j];
+    if(cl->floating) continue;
     if(i >= nmaster) break;
 
-    if(wmaster <= cl->minsize.x && cl->minsize.x != 0) {
-      wmaster = cl->minsize.x;
+    if(wmaster <= cl->props->minsize.x && cl->props->minsize.x != 0) {
+      wmaster = cl->props->minsize.x;
       mon->layouts[deskidx].mastermaxed = true;
       break;
     }
@@ -1729,10 +2611,9 @@ tiledmaster(state_t* s, monitor_t* mon) {
   i = 0;
 
   float lastadd = 0.0f;
-  for(client_t* cl = s->monfocus->clients; cl != NULL; cl = cl->next) {
-    if(cl->floating ||
-      cl->desktop != mondesktop(s, cl->mon)->idx || 
-      cl->mon != mon) continue;
+  for(uint32_t j = 0; j < clients->size; j++) {
+    client_t* cl = clients->items[j];
+    if(cl->floating) continue;
 
     bool ismaster = (i < nmaster);
 
@@ -1743,21 +2624,21 @@ tiledmaster(state_t* s, monitor_t* mon) {
     lastadd = cl->layoutsizeadd;
     float width = (ismaster ? (uint32_t)wmaster : (uint32_t)w - wmaster);
 
-    /*if(width > cl->maxsize.x && cl->maxsize.x != 0) {
-      width = cl->maxsize.x;
-    } if(width < cl->minsize.x && cl->minsize.x != 0) {
-      width = cl->minsize.x;
-    } if(height >= cl->maxsize.y && cl->maxsize.y != 0) {
-      height = cl->maxsize.y;
-    } if(height < cl->minsize.y && cl->minsize.y != 0) {
-      height = cl->minsize.y;
+    /*if(width > cl->props->maxsize.x && cl->props->maxsize.x != 0) {
+      width = cl->props->maxsize.x;
+    } if(width < cl->props->minsize.x && cl->props->minsize.x != 0) {
+      width = cl->props->minsize.x;
+    } if(height >= cl->props->maxsize.y && cl->props->maxsize.y != 0) {
+      height = cl->props->maxsize.y;
+    } if(height < cl->props->minsize.y && cl->props->minsize.y != 0) {
+      height = cl->props->minsize.y;
     }*/
 
     bool singleclient = !nslaves;
 
     moveclient(s, cl, (v2_t){
       (ismaster ? x : (int32_t)(x + wmaster)) + gapsize,
-      (ismaster ? ymaster : y) + gapsize}, true);
+      (ismaster ? ymaster : y) + gapsize}, false);
     resizeclient(s, cl, (v2_t){
       ((singleclient ? w : width) 
       - cl->borderwidth * 2) - gapsize * 2,
@@ -1787,54 +2668,30 @@ verticalstripes(state_t* s, monitor_t* mon) {
   uint32_t deskidx    = mondesktop(s, mon)->idx;
   int32_t gapsize     = mon->layouts[deskidx].gapsize;
 
-  {
-    for(client_t* cl = s->monfocus->clients; cl != NULL; cl = cl->next) {
-      if(cl->floating || cl->desktop != mondesktop(s, cl->mon)->idx
-        || cl->mon != mon) continue;
-      nwins++;
-    }
+  client_list_t* clients = visibleclients(s, mon);
+  for(uint32_t i = 0; i < clients->size; i++) {
+    if(clients->items[i]->floating) continue;
+    nwins++;
   }
 
-  uint32_t w = mon->area.size.x;
-  uint32_t h = mon->area.size.y;
-  int32_t x = mon->area.pos.x;
-  int32_t y = mon->area.pos.y;
-
-  // Apply strut information to the layout
-  for(uint32_t i = 0; i < s->nwinstruts; i++) {
-    bool onmonitor = 
-      s->winstruts[i].startx >= mon->area.pos.x  
-      && s->winstruts[i].endx <= mon->area.pos.x + mon->area.size.x;
-
-    if(!onmonitor) continue;
-
-    if(s->winstruts[i].left != 0) {
-      x += s->winstruts[i].left;
-      w -= s->winstruts[i].left;
-    }
-    if(s->winstruts[i].right != 0) {
-      w -= s->winstruts[i].right;
-    }
-    if(s->winstruts[i].top != 0) {
-      y += s->winstruts[i].top;
-      h -= s->winstruts[i].top;
-    }
-    if(s->winstruts[i].bottom != 0) {
-      h -= s->winstruts[i].bottom;
-    }
-  }
+  area_t area = layoutarea(s, mon);
+  uint32_t w = area.size.x;
+  uint32_t h = area.size.y;
+  int32_t x = area.pos.x;
+  int32_t y = area.pos.y;
   
 
   float lastadd = 0.0f;
-  for(client_t* cl = s->monfocus->clients; cl != NULL; cl = cl->next) {
-    if(cl->floating || cl->desktop != mondesktop(s, cl->mon)->idx || cl->mon != mon) continue;
+  for(uint32_t i = 0; i < clients->size; i++) {
+    client_t* cl = clients->items[i];
+    if(cl->floating) continue;
 
     float winw = (float)w / nwins + cl->layoutsizeadd - lastadd;
     lastadd = cl->layoutsizeadd;
 
     moveclient(s, cl, (v2_t){
       x + gapsize,
-      y + gapsize}, true);
+      y + gapsize}, false);
     resizeclient(s, cl, (v2_t){
       winw - cl->borderwidth * 2 - gapsize * 2,
       h - cl->borderwidth * 2 - gapsize * 2});
@@ -1844,125 +2701,177 @@ verticalstripes(state_t* s, monitor_t* mon) {
 }
 
 /**
- * @brief Establishes a layout in which windows are 
- * layed out top to bottom as horizontal stripes 
+ * @brief Establishes a layout in which only one tiled window 
+ * is shown and fills the whole layout area. The other tiled 
+ * windows are hidden and not configured until they are shown.
+ * The tabbed layout additionally shows a tab bar for the tiled 
+ * windows above the shown one.
  *
  * @param s The window manager's state
  * @param mon The monitor to use as the frame of the layout 
  */
 void
-horizontalstripes(state_t* s, monitor_t* mon) {
+monocle(state_t* s, monitor_t* mon) {
   if(!mon) return;
 
-  uint32_t nwins = 0;
   uint32_t deskidx    = mondesktop(s, mon)->idx;
   int32_t gapsize     = mon->layouts[deskidx].gapsize;
+  client_list_t* clients = visibleclients(s, mon);
 
-  {
-    for(client_t* cl = s->monfocus->clients; cl != NULL; cl = cl->next) {
-      if(cl->floating || cl->desktop != mondesktop(s, cl->mon)->idx
-        || cl->mon != mon) continue;
-      nwins++;
+  // Keep showing the chosen client, otherwise show the first tiled client
+  client_t* active = mon->layouts[deskidx].active;
+  if(active && active->floating) {
+    active = NULL;
+  }
+  for(uint32_t i = 0; i < clients->size && !active; i++) {
+    if(!clients->items[i]->floating) {
+      active = clients->items[i];
     }
   }
+  mon->layouts[deskidx].active = active;
+  if(!active) {
+    hidetabbar(s, mon);
+    return;
+  }
 
-  uint32_t w = mon->area.size.x;
-  uint32_t h = mon->area.size.y;
-  int32_t x = mon->area.pos.x;
-  int32_t y = mon->area.pos.y;
-
-  // Apply strut information to the layout
-  for(uint32_t i = 0; i < s->nwinstruts; i++) {
-    bool onmonitor = 
-      s->winstruts[i].startx >= mon->area.pos.x  
-      && s->winstruts[i].endx <= mon->area.pos.x + mon->area.size.x;
-
-    if(!onmonitor) continue;
-
-    if(s->winstruts[i].left != 0) {
-      x += s->winstruts[i].left;
-      w -= s->winstruts[i].left;
-    }
-    if(s->winstruts[i].right != 0) {
-      w -= s->winstruts[i].right;
-    }
-    if(s->winstruts[i].top != 0) {
-      y += s->winstruts[i].top;
-      h -= s->winstruts[i].top;
-    }
-    if(s->winstruts[i].bottom != 0) {
-      h -= s->winstruts[i].bottom;
+  area_t area = layoutarea(s, mon);
+  uint32_t w = area.size.x;
+  uint32_t h = area.size.y;
+  int32_t x = area.pos.x;
+  int32_t y = area.pos.y;
+
+  // The tabbed layout shows its tab bar above the shown client
+  if(mon->layouts[deskidx].curlayout == LayoutTabbed) {
+    int32_t barheight = MAX(s->config.tabbarheight, 1);
+    updatetabbar(s, mon, (area_t){
+      .pos = (v2_t){x + gapsize, y + gapsize},
+      .size = (v2_t){(float)w - gapsize * 2, barheight}
+    });
+    y += barheight + gapsize;
+    h -= barheight + gapsize;
+  }
+
+  /* Clients that are already stacked are not touched, so a 
+   * relayout only sends requests for the shown client and the 
+   * clients that were shown before. */
+  for(uint32_t i = 0; i < clients->size; i++) {
+    client_t* cl = clients->items[i];
+    if(cl->floating || cl == active || cl->stacked) continue;
+    cl->stacked = true;
+    if(!cl->hidden) {
+      hideclient(s, cl);
     }
   }
 
-  float lastadd = 0.0f;
-
-  for(client_t* cl = s->monfocus->clients; cl != NULL; cl = cl->next) {
-    if(cl->floating || cl->desktop != mondesktop(s, cl->mon)->idx || cl->mon != mon) continue;
-
-    float winh = (float)h / nwins + cl->layoutsizeadd - lastadd;
-    lastadd = cl->layoutsizeadd;
-
-    moveclient(s, cl, (v2_t){
-      x + gapsize,
-      y + gapsize}, true);
-    resizeclient(s, cl, (v2_t){
-      w - cl->borderwidth * 2 - gapsize * 2,
-      winh - cl->borderwidth * 2 - gapsize * 2});
+  moveclient(s, active, (v2_t){
+    x + gapsize,
+    y + gapsize}, false);
+  resizeclient(s, active, (v2_t){
+    w - active->borderwidth * 2 - gapsize * 2,
+    h - active->borderwidth * 2 - gapsize * 2});
 
-    y += winh;
+  if(active->stacked) {
+    active->stacked = false;
+    showclient(s, active);
+    raiseclient(s, active);
   }
 }
 
-
 /**
- * @brief Swaps two clients within the linked list of clients 
+ * @brief Shows the clients of the visible desktop of a monitor 
+ * that were hidden behind the shown client of a monocle layout.
  *
- * @param s The window manager's state 
- * @param c1 The client to swap with c2 
- * @param c2 The client to swap with c1
+ * @param s The window manager's state
+ * @param mon The monitor of the clients 
  */
-void 
-swapclients(state_t* s, client_t* c1, client_t* c2) {
-  if (c1 == c2) {
-    return;
-  }
+void
+unstackclients(state_t* s, monitor_t* mon) {
+  client_list_t* clients = visibleclients(s, mon);
+  for(uint32_t i = 0; i < clients->size; i++) {
+    client_t* cl = clients->items[i];
+    if(!cl->stacked) continue;
+    cl->stacked = false;
+    showclient(s, cl);
+  }
+  mon->layouts[mondesktop(s, mon)->idx].active = NULL;
+}
 
-  client_t *prev1 = NULL, 
-	   *prev2 = NULL, 
-	   *tmp = s->monfocus->clients;
+/**
+ * @brief Establishes a layout in which windows are 
+ * layed out top to bottom as horizontal stripes 
+ *
+ * @param s The window manager's state
+ * @param mon The monitor to use as the frame of the layout 
+ */
+void
+horizontalstripes(state_t* s, monitor_t* mon) {
+  if(!mon) return;
+
+  uint32_t nwins = 0;
+  uint32_t deskidx    = mondesktop(s, mon)->idx;
+  int32_t gapsize     = mon->layouts[deskidx].gapsize;
 
-  while (tmp && tmp != c1) {
-    prev1 = tmp;
-    tmp = tmp->next;
+  client_list_t* clients = visibleclients(s, mon);
+  for(uint32_t i = 0; i < clients->size; i++) {
+    if(clients->items[i]->floating) continue;
+    nwins++;
   }
 
-  if (tmp == NULL) return;
+  area_t area = layoutarea(s, mon);
+  uint32_t w = area.size.x;
+  uint32_t h = area.size.y;
+  int32_t x = area.pos.x;
+  int32_t y = area.pos.y;
 
-  tmp = s->monfocus->clients;
+  float lastadd = 0.0f;
 
-  while (tmp && tmp != c2) {
-    prev2 = tmp;
-    tmp = tmp->next;
-  }
+  for(uint32_t i = 0; i < clients->size; i++) {
+    client_t* cl = clients->items[i];
+    if(cl->floating) continue;
 
-  if (tmp== NULL) return;
+    float winh = (float)h / nwins + cl->layoutsizeadd - lastadd;
+    lastadd = cl->layoutsizeadd;
 
-  if (prev1) {
-    prev1->next = c2;
-  } else { 
-    s->monfocus->clients = c2;
+    moveclient(s, cl, (v2_t){
+      x + gapsize,
+      y + gapsize}, false);
+    resizeclient(s, cl, (v2_t){
+      w - cl->borderwidth * 2 - gapsize * 2,
+      winh - cl->borderwidth * 2 - gapsize * 2});
+
+    y += winh;
   }
+}
+
 
-  if (prev2) {
-    prev2->next = c1;
-  } else { 
-    s->monfocus->clients = c1;
+/**
+ * @brief Swaps two clients within the client list of their desktop 
+ *
+ * @param s The window manager's state 
+ * @param c1 The client to swap with c2 
+ * @param c2 The client to swap with c1
+ */
+void 
+swapclients(state_t* s, client_t* c1, client_t* c2) {
+  (void)s;
+  if (c1 == c2) {
+    return;
   }
+  // Only clients within the same client list can be swapped
+  if(c1->mon != c2->mon || c1->desktop != c2->desktop) return;
+
+  client_list_t* clients = &c1->mon->clients[c1->desktop];
+  if(clients->items[c1->slot] != c1 || clients->items[c2->slot] != c2) return;
 
-  tmp = c1->next;
-  c1->next = c2->next;
-  c2->next = tmp;
+  clients->items[c1->slot] = c2;
+  clients->items[c2->slot] = c1;
+
+  uint32_t tmp = c1->slot;
+  c1->slot = c2->slot;
+  c2->slot = tmp;
+
+  // The clients trade places in the layout
+  c1->mon->layouts[c1->desktop].dirty = true;
 }
 
 /**
@@ -1989,19 +2898,15 @@ uploaddesktopnames(state_t* s, monitor_t* mon) {
     ptr += strlen(mon->activedesktops[i].name) + 1; 
   }
 
-  // Get the root window
-  xcb_screen_t *screen = xcb_setup_roots_iterator(xcb_get_setup(s->con)).data;
-  xcb_window_t root_window = screen->root;
-
   // Set the _NET_DESKTOP_NAMES property
-  xcb_change_property(s->con,
-                      XCB_PROP_MODE_REPLACE,
-                      root_window,
-                      s->ewmh_atoms[EWMHdesktopNames],
-                      XCB_ATOM_STRING,
-                      8,
-                      total_length,
-                      data);
+  xchangeproperty(s,
+                  XCB_PROP_MODE_REPLACE,
+                  s->root,
+                  s->ewmh_atoms[EWMHdesktopNames],
+                  XCB_ATOM_STRING,
+                  8,
+                  total_length,
+                  data);
   free(data);
 }
 
@@ -2014,13 +2919,13 @@ updateewmhdesktops(state_t* s, monitor_t* mon) {
       desktopcount++;
     }
   }
-  xcb_change_property(s->con, XCB_PROP_MODE_REPLACE, s->root, s->ewmh_atoms[EWMHnumberOfDesktops],
-                      XCB_ATOM_CARDINAL, 32, 1, &desktopcount);
+  xchangeproperty(s, XCB_PROP_MODE_REPLACE, s->root, s->ewmh_atoms[EWMHnumberOfDesktops],
+                  XCB_ATOM_CARDINAL, 32, 1, &desktopcount);
   uploaddesktopnames(s, s->monfocus);
   desktop_t* desk = mondesktop(s, s->monfocus);
   if(desk) {
-    xcb_change_property(s->con, XCB_PROP_MODE_REPLACE, s->root, s->ewmh_atoms[EWMHcurrentDesktop],
-                        XCB_ATOM_CARDINAL, 32, 1, &desk->idx);
+    xchangeproperty(s, XCB_PROP_MODE_REPLACE, s->root, s->ewmh_atoms[EWMHcurrentDesktop],
+                    XCB_ATOM_CARDINAL, 32, 1, &desk->idx);
   }
 }
 
@@ -2056,6 +2961,10 @@ setupatoms(state_t* s) {
   s->wm_atoms[WMdelete]                = getatom(s, "WM_DELETE_WINDOW");
   s->wm_atoms[WMstate]                 = getatom(s, "WM_STATE");
   s->wm_atoms[WMtakeFocus]             = getatom(s, "WM_TAKE_FOCUS");
+  s->wm_atoms[WMwindowRole]            = getatom(s, "WM_WINDOW_ROLE");
+  s->wm_atoms[WMutf8String]            = getatom(s, "UTF8_STRING");
+  s->wm_atoms[WMrestart]               = getatom(s, "_RAGNAR_RESTART");
+  s->wm_atoms[WMrestartState]          = getatom(s, "_RAGNAR_RESTART_STATE");
   s->ewmh_atoms[EWMHactiveWindow]      = getatom(s, "_NET_ACTIVE_WINDOW");
   s->ewmh_atoms[EWMHsupported]         = getatom(s, "_NET_SUPPORTED");
   s->ewmh_atoms[EWMHname]              = getatom(s, "_NET_WM_NAME");
@@ -2072,53 +2981,54 @@ setupatoms(state_t* s) {
   s->ewmh_atoms[EWMHcurrentDesktop]    = getatom(s, "_NET_CURRENT_DESKTOP");
   s->ewmh_atoms[EWMHnumberOfDesktops]  = getatom(s, "_NET_NUMBER_OF_DESKTOPS");
   s->ewmh_atoms[EWMHdesktopNames]      = getatom(s, "_NET_DESKTOP_NAMES");
+  s->ewmh_atoms[EWMHsyncRequest]       = getatom(s, "_NET_WM_SYNC_REQUEST");
+  s->ewmh_atoms[EWMHsyncRequestCounter] = getatom(s, "_NET_WM_SYNC_REQUEST_COUNTER");
+  s->ewmh_atoms[EWMHwmPid]             = getatom(s, "_NET_WM_PID");
 
   xcb_atom_t utf8str = getatom(s, "UTF8_STRING");
 
-  xcb_window_t wmcheckwin = xcb_generate_id(s->con);
-  xcb_create_window(s->con, XCB_COPY_FROM_PARENT, wmcheckwin, s->root, 
+  xcb_window_t wmcheckwin = xgenerateid(s);
+  xcreatewindow(s, XCB_COPY_FROM_PARENT, wmcheckwin, s->root, 
       0, 0, 1, 1, 0, XCB_WINDOW_CLASS_INPUT_OUTPUT, 
       XCB_COPY_FROM_PARENT, 0, NULL);
+  trackresource(s, NULL, XResourceWindow, 1);
 
   // Set _NET_WM_CHECK property on the wmcheckwin
-  xcb_change_property(s->con, XCB_PROP_MODE_REPLACE, wmcheckwin, s->ewmh_atoms[EWMHcheck],
+  xchangeproperty(s, XCB_PROP_MODE_REPLACE, wmcheckwin, s->ewmh_atoms[EWMHcheck],
       XCB_ATOM_WINDOW, 32, 1, &wmcheckwin);
 
   // Set _NET_WM_NAME property on the wmcheckwin
-  xcb_change_property(s->con, XCB_PROP_MODE_REPLACE, wmcheckwin, s->ewmh_atoms[EWMHname],
+  xchangeproperty(s, XCB_PROP_MODE_REPLACE, wmcheckwin, s->ewmh_atoms[EWMHname],
       utf8str, 8, strlen("ragnar"), "ragnar");
 
   // Set _NET_WM_CHECK property on the root window
-  xcb_change_property(s->con, XCB_PROP_MODE_REPLACE, s->root, s->ewmh_atoms[EWMHcheck],
+  xchangeproperty(s, XCB_PROP_MODE_REPLACE, s->root, s->ewmh_atoms[EWMHcheck],
       XCB_ATOM_WINDOW, 32, 1, &wmcheckwin);
 
   // Set _NET_CURRENT_DESKTOP property on the root window
-  xcb_change_property(s->con, XCB_PROP_MODE_REPLACE, s->root, s->ewmh_atoms[EWMHcurrentDesktop],
+  xchangeproperty(s, XCB_PROP_MODE_REPLACE, s->root, s->ewmh_atoms[EWMHcurrentDesktop],
       XCB_ATOM_CARDINAL, 32, 1, &s->config.desktopinit);
 
   // Set _NET_SUPPORTED property on the root window
-  xcb_change_property(s->con, XCB_PROP_MODE_REPLACE, s->root, s->ewmh_atoms[EWMHsupported],
+  xchangeproperty(s, XCB_PROP_MODE_REPLACE, s->root, s->ewmh_atoms[EWMHsupported],
       XCB_ATOM_ATOM, 32, EWMHcount, s->ewmh_atoms);
 
   // Delete _NET_CLIENT_LIST property from the root window
-  xcb_delete_property(s->con, s->root, s->ewmh_atoms[EWMHclientList]);
+  xdeleteproperty(s, s->root, s->ewmh_atoms[EWMHclientList]);
+
+  // Delete _NET_ACTIVE_WINDOW so that it matches the cached active window
+  xdeleteproperty(s, s->root, s->ewmh_atoms[EWMHactiveWindow]);
+  s->activewin = XCB_NONE;
 
   s->monfocus = cursormon(s);
-  // Create initial desktop for all monitors 
-  for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
-    for(uint32_t i = 0; i < s->config.maxdesktops; i++) {
-      createdesktop(s, i, mon);
-    }
-    mon->activedesktops[s->config.desktopinit].init = true;
-  }
 
   int32_t desktopcount = 1;
   // Set number of desktops (_NET_NUMBER_OF_DESKTOPS)
-  xcb_change_property(s->con, XCB_PROP_MODE_REPLACE, s->root, s->ewmh_atoms[EWMHnumberOfDesktops],
-                      XCB_ATOM_CARDINAL, 32, 1, &desktopcount);
+  xchangeproperty(s, XCB_PROP_MODE_REPLACE, s->root, s->ewmh_atoms[EWMHnumberOfDesktops],
+                  XCB_ATOM_CARDINAL, 32, 1, &desktopcount);
   uploaddesktopnames(s, s->monfocus);
 
-  xcb_flush(s->con);
+  xflush(s);
 }
 
 
@@ -2131,7 +3041,7 @@ setupatoms(state_t* s) {
 void
 grabkeybinds(state_t* s) {
   // Ungrab any grabbed keys
-  xcb_ungrab_key(s->con, XCB_GRAB_ANY, s->root, XCB_MOD_MASK_ANY);
+  xungrabkey(s, XCB_GRAB_ANY, s->root, XCB_MOD_MASK_ANY);
 
   // Grab every keybind
   for (size_t i = 0; i < s->config.numkeybinds; ++i) {
@@ -2139,14 +3049,36 @@ grabkeybinds(state_t* s) {
     xcb_keycode_t *keycode = getkeycodes(s, s->config.keybinds[i].key);
     // Grab the key if it is valid 
     if (keycode != NULL) {
-      xcb_grab_key(s->con, 1, s->root, s->config.keybinds[i].modmask, *keycode,
+      xgrabkey(s, 1, s->root, s->config.keybinds[i].modmask, *keycode,
 	  XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
       logmsg(s,  LogLevelTrace, "grabbed key '%s' on X server.",
-             XKeysymToString(s->config.keybinds[i].key));
+             keysymtostr(s->config.keybinds[i].key));
 
     }
   }
-  xcb_flush(s->con);
+  xflush(s);
+}
+
+/**
+ * @brief Frees the root cursor and the cached resize cursors. Windows 
+ * that still use one of them keep it until they are destroyed or their 
+ * cursor changes, the resize cursors are loaded again once needed.
+ *
+ * @param s The window manager's state
+ * */
+void
+freecursors(state_t* s) {
+  for(uint32_t i = 0; i < ARRLEN(s->edgecursors); i++) {
+    if(!s->edgecursors[i]) continue;
+    xfreecursor(s, s->edgecursors[i]);
+    s->edgecursors[i] = XCB_NONE;
+    trackresource(s, NULL, XResourceCursor, -1);
+  }
+  if(s->rootcursor) {
+    xfreecursor(s, s->rootcursor);
+    s->rootcursor = XCB_NONE;
+    trackresource(s, NULL, XResourceCursor, -1);
+  }
 }
 
 /**
@@ -2155,23 +3087,27 @@ grabkeybinds(state_t* s) {
  * */
 void
 loaddefaultcursor(state_t* s) {
-  xcb_cursor_context_t* context;
-  // Create the cursor context
-  if (xcb_cursor_context_new(s->con, s->screen, &context) < 0) {
-    logmsg(s,  LogLevelError, "cannot create cursor context.");
-    terminate(s, EXIT_FAILURE);
+  // Load the cursor image from the cursor theme
+  xcb_cursor_t cursor = xloadcursor(s, s->config.cursorimage); 
+  if(!cursor) {
+    logmsg(s,  LogLevelError, "cannot load cursor image '%s'.", s->config.cursorimage);
   }
-  // Load the context
-  xcb_cursor_t cursor = xcb_cursor_load_cursor(context, s->config.cursorimage); 
 
   // Set the cursor to the root window
-  xcb_change_window_attributes(s->con, s->root, XCB_CW_CURSOR, &cursor);
+  xchangewindowattributes(s, s->root, XCB_CW_CURSOR, &cursor);
 
-  // Flush the requests to the X server
-  xcb_flush(s->con);
+  // The previous cursor is no longer used after reloading the config
+  if(s->rootcursor) {
+    xfreecursor(s, s->rootcursor);
+    trackresource(s, NULL, XResourceCursor, -1);
+  }
+  s->rootcursor = cursor;
+  if(cursor) {
+    trackresource(s, NULL, XResourceCursor, 1);
+  }
 
-  // Free allocated resources
-  xcb_cursor_context_free(context);
+  // Flush the requests to the X server
+  xflush(s);
 
   logmsg(s,  LogLevelTrace, "loaded cursor image '%s'.", s->config.cursorimage);
 }
@@ -2184,9 +3120,7 @@ iswindowpopup(state_t* s, xcb_window_t win) {
   if (typeatom == XCB_ATOM_NONE || popupatom == XCB_ATOM_NONE)
     return false;
 
-  xcb_get_property_cookie_t prop_cookie = xcb_get_property(
-    s->con, 0, win, typeatom, XCB_ATOM_ATOM, 0, 32);
-  xcb_get_property_reply_t* prop_reply = xcb_get_property_reply(s->con, prop_cookie, NULL);
+  xcb_get_property_reply_t* prop_reply = xgetproperty(s, 0, win, typeatom, XCB_ATOM_ATOM, 0, 32);
   if (!prop_reply)
     return false;
 
@@ -2206,9 +3140,57 @@ iswindowpopup(state_t* s, xcb_window_t win) {
   return ispopup;
 }
 
+/**
+ * @brief Returns the kind of a given window. Windows are only 
+ * classified by querying the server the first time they are seen.
+ *
+ * @param s The window manager's state
+ * @param win The window to get the kind of
+ *
+ * @return The kind of the window 
+ */
+window_kind_t
+windowkind(state_t* s, xcb_window_t win) {
+  uint8_t kind;
+  if(winmapget(&s->winkinds, win, &kind)) {
+    return (window_kind_t)kind;
+  }
+  kind = iswindowpopup(s, win) ? WindowKindPopup : WindowKindOther;
+  winmapset(&s->winkinds, win, kind);
+  return (window_kind_t)kind;
+}
+
+/**
+ * @brief Retrieves the size hints (WM_NORMAL_HINTS) of a client 
+ * and caches them within the client.
+ *
+ * @param s The window manager's state
+ * @param cl The client to update the size hints of
+ * */
+void
+updatesizehints(state_t* s, client_t* cl) {
+  cl->props->minsize = (v2_t){0};
+  cl->props->maxsize = (v2_t){0};
+
+  // Retrieve size hints (a size of 0 means that there is no limit)
+  xcb_size_hints_t hints;
+  if (xgetwmnormalhints(s, cl->win, &hints)) {
+    if (hints.flags & XCB_ICCCM_SIZE_HINT_P_MIN_SIZE) {
+      cl->props->minsize = (v2_t){hints.min_width, hints.min_height};
+    }
+    if (hints.flags & XCB_ICCCM_SIZE_HINT_P_MAX_SIZE) {
+      cl->props->maxsize = (v2_t){hints.max_width, hints.max_height};
+    }
+  }
+
+  // Check if client is fixed size
+  v2_t min = cl->props->minsize, max = cl->props->maxsize;
+  cl->fixed = (max.x != 0 && max.y != 0 && max.x == min.x && max.y == min.y);
+}
+
 /**
  * @brief Takes in a size for a client window and adjusts it 
- * if it does not meet the requirements of the client's hints.
+ * if it does not meet the requirements of the client's cached hints.
  * The adjusted value is returned.
  *
  * @param s The window manager's state
@@ -2219,33 +3201,114 @@ iswindowpopup(state_t* s, xcb_window_t win) {
  * */
 v2_t 
 applysizehints(state_t* s, client_t* cl, v2_t size) {
-  // Retrieve size hints
-  xcb_size_hints_t hints;
-  if (xcb_icccm_get_wm_normal_hints_reply(s->con, xcb_icccm_get_wm_normal_hints(s->con, cl->win), &hints, NULL)) {
-    // Enforce minimum size
-    if (hints.flags & XCB_ICCCM_SIZE_HINT_P_MIN_SIZE) {
-      if (size.x < hints.min_width) size.x = hints.min_width;
-      if (size.y < hints.min_height) size.y = hints.min_height;
+  (void)s;
+  v2_t min = cl->props->minsize, max = cl->props->maxsize;
+
+  // Enforce minimum size
+  if (min.x && size.x < min.x) size.x = min.x;
+  if (min.y && size.y < min.y) size.y = min.y;
+
+  // Enforce maximum size
+  if (max.x && size.x > max.x) size.x = max.x;
+  if (max.y && size.y > max.y) size.y = max.y;
+
+  return size;
+}
+
+/**
+ * @brief Shows the resize outline around a given area of a client 
+ * and remembers the area to apply it once the resize is finished.
+ *
+ * @param s The window manager's state
+ * @param cl The client that is resized 
+ * @param a The area the client is resized to 
+ * @param makefloating Whether the client becomes floating 
+ * once the resize is applied
+ * */
+void
+updateoutline(state_t* s, client_t* cl, area_t a, bool makefloating) {
+  uint32_t thickness = MAX(s->config.winborderwidth, 2);
+  bool show = s->outlineclient == NULL;
+
+  // The edge windows of the outline are created once and reused
+  if(!s->outline[0]) {
+    for(uint32_t i = 0; i < 4; i++) {
+      s->outline[i] = xgenerateid(s);
+      uint32_t values[] = { s->config.winbordercolor_selected, true };
+      xcreatewindow(s, XCB_COPY_FROM_PARENT, s->outline[i], s->root, 
+                    0, 0, 1, 1, 0, XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT, 
+                    XCB_CW_BACK_PIXEL | XCB_CW_OVERRIDE_REDIRECT, values);
+      winmapset(&s->winkinds, s->outline[i], WindowKindOwn);
+    }
+    trackresource(s, NULL, XResourceWindow, 4);
+  } else if(show) {
+    // The color might have changed by reloading the config
+    for(uint32_t i = 0; i < 4; i++) {
+      xchangewindowattributes(s, s->outline[i], XCB_CW_BACK_PIXEL, 
+                              &s->config.winbordercolor_selected);
     }
+  }
 
-    // Enforce maximum size
-    if (hints.flags & XCB_ICCCM_SIZE_HINT_P_MAX_SIZE) {
-      if (size.x > hints.max_width) size.x = hints.max_width;
-      if (size.y > hints.max_height) size.y = hints.max_height;
+  s->outlineclient = cl;
+  s->outlinearea = a;
+  s->outlinefloat |= makefloating;
+
+  // The outline covers the frame of the client including its border
+  int32_t x = a.pos.x, y = a.pos.y;
+  uint32_t w = MAX(a.size.x + cl->borderwidth * 2, thickness);
+  uint32_t h = MAX(a.size.y + cl->borderwidth * 2, thickness);
+  int32_t edges[4][4] = {
+    { x, y, w, thickness },
+    { x, y + h - thickness, w, thickness },
+    { x, y, thickness, h },
+    { x + w - thickness, y, thickness, h },
+  };
+  for(uint32_t i = 0; i < 4; i++) {
+    uint32_t values[] = { edges[i][0], edges[i][1], edges[i][2], edges[i][3], XCB_STACK_MODE_ABOVE };
+    xconfigurewindow(s, s->outline[i], 
+                     XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | 
+                     XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT | 
+                     XCB_CONFIG_WINDOW_STACK_MODE, values);
+    if(show) {
+      xmapwindow(s, s->outline[i]);
     }
   }
+}
 
-  cl->minsize.x = hints.min_width;
-  cl->minsize.y = hints.min_height;
+/**
+ * @brief Hides the resize outline and resizes the client to 
+ * the area of the outline with a single configure.
+ *
+ * @param s The window manager's state
+ * */
+void
+applyoutline(state_t* s) {
+  client_t* cl = s->outlineclient;
+  if(!cl) return;
+  bool makefloating = s->outlinefloat;
+  area_t a = s->outlinearea;
+  hideoutline(s);
 
-  cl->maxsize.x = hints.max_width;
-  cl->maxsize.y = hints.max_height;
+  if(makefloating) {
+    cl->floating = true;
+  }
+  moveresizeclient(s, cl, a);
+  cl->ignoreexpose = true;
+}
 
-  // Check if client is fixed size
-  cl->fixed = (hints.max_width != 0 && hints.max_height != 0 &&
-               hints.max_width == hints.min_width && 
-               hints.max_height == hints.min_height);
-  return size;
+/**
+ * @brief Hides the resize outline without applying it.
+ *
+ * @param s The window manager's state
+ * */
+void
+hideoutline(state_t* s) {
+  if(!s->outlineclient) return;
+  for(uint32_t i = 0; i < 4; i++) {
+    xunmapwindow(s, s->outline[i]);
+  }
+  s->outlineclient = NULL;
+  s->outlinefloat = false;
 }
 
 
@@ -2261,8 +3324,8 @@ applysizehints(state_t* s, client_t* cl, v2_t size) {
  */ 
 layering_order_t
 clientlayering(state_t* s, client_t* cl) {
-  xcb_get_property_cookie_t cookie = xcb_get_property(
-    s->con,
+  xcb_get_property_reply_t* reply = xgetproperty(
+    s,
     0,
     cl->win,
     s->ewmh_atoms[EWMHstate],
@@ -2270,9 +3333,6 @@ clientlayering(state_t* s, client_t* cl) {
     0,
     1024
   );
-
-  xcb_get_property_reply_t* reply = xcb_get_property_reply(s->con, 
-                                                           cookie, NULL);
   if (!reply) return false;
 
   uint32_t len = xcb_get_property_value_length(reply) / sizeof(xcb_atom_t);
@@ -2301,8 +3361,12 @@ clientlayering(state_t* s, client_t* cl) {
 void
 addtolayout(state_t* s, client_t* cl)  {
   cl->floating = false;
+  // A client that is added to a monocle layout is the one that is shown
+  cl->mon->layouts[cl->desktop].active = cl;
   // Add all fullscreened clients to the layout
-  for(client_t* it = s->monfocus->clients; it != NULL; it = it->next) {
+  client_list_t* clients = visibleclients(s, cl->mon);
+  for(uint32_t i = 0; i < clients->size; i++) {
+    client_t* it = clients->items[i];
     if(it->fullscreen) {
       setfullscreen(s, it, false);
       it->floating = false; 
@@ -2328,14 +3392,16 @@ enumartelayout(state_t* s, monitor_t* mon, uint32_t* nmaster, uint32_t* nslaves)
 
   layout_type_t curlayout = getcurlayout(s, mon);
   if( curlayout == LayoutVerticalStripes || 
-      curlayout == LayoutHorizontalStripes) {
+      curlayout == LayoutHorizontalStripes ||
+      curlayout == LayoutMonocle ||
+      curlayout == LayoutTabbed) {
     *nmaster = 0; 
   } 
 
   uint32_t i = 0;
-  for(client_t* cl = s->monfocus->clients; cl != NULL; cl = cl->next) {
-    if(cl->floating || cl->desktop != mondesktop(s, cl->mon)->idx
-      || cl->mon != mon) continue;
+  client_list_t* clients = visibleclients(s, mon);
+  for(uint32_t j = 0; j < clients->size; j++) {
+    if(clients->items[j]->floating) continue;
     if(i >= *nmaster) {
       *nslaves = *nslaves + 1;
     }
@@ -2355,7 +3421,9 @@ bool
 isclientmaster(state_t* s, client_t* cl, monitor_t* mon) {
   layout_type_t curlayout = getcurlayout(s, mon);
   if( curlayout == LayoutVerticalStripes || 
-      curlayout == LayoutHorizontalStripes) {
+      curlayout == LayoutHorizontalStripes ||
+      curlayout == LayoutMonocle ||
+      curlayout == LayoutTabbed) {
     return false;
   } 
 
@@ -2363,10 +3431,10 @@ isclientmaster(state_t* s, client_t* cl, monitor_t* mon) {
   uint32_t deskidx = mondesktop(s, mon)->idx;
   uint32_t nmaster = mon->layouts[deskidx].nmaster;
 
-  for(client_t* iter = s->monfocus->clients; iter != NULL; iter = iter->next) {
-    if(iter->floating ||
-      iter->desktop != mondesktop(s, iter->mon)->idx || 
-      iter->mon != mon) continue;
+  client_list_t* clients = visibleclients(s, mon);
+  for(uint32_t j = 0; j < clients->size; j++) {
+    client_t* iter = clients->items[j];
+    if(iter->floating) continue;
 
     if(iter == cl && i < nmaster) {
       return true;
@@ -2409,8 +3477,7 @@ evmaprequest(state_t* s, xcb_generic_event_t* ev) {
 
   logmsg(s, LogLevelTrace, "Got map request: %i", map_ev->window);
   // Retrieve attributes of the mapped window
-  xcb_get_window_attributes_cookie_t wa_cookie = xcb_get_window_attributes(s->con, map_ev->window);
-  xcb_get_window_attributes_reply_t *wa_reply = xcb_get_window_attributes_reply(s->con, wa_cookie, NULL);
+  xcb_get_window_attributes_reply_t *wa_reply = xgetwindowattributes(s, map_ev->window);
 
   // Return if attributes could not be retrieved or if the window uses override_redirect
   if (!wa_reply) {
@@ -2432,71 +3499,52 @@ evmaprequest(state_t* s, xcb_generic_event_t* ev) {
 
   // Handle new client
   client_t* cl = makeclient(s, map_ev->window);
-  
+  if(!cl) return;
 
-  if(!cl->floating) {
+  // Clients on a hidden desktop are layed out once it is shown
+  if(!cl->floating && !cl->hidden) {
     addtolayout(s, cl);
   }
 
-  if(!cl->floating) {
-    for(client_t* it = s->monfocus->clients; it != NULL; it = it->next) {
-      if(clientonscreen(s, it, s->monfocus) && it->fullscreen) {
+  if(!cl->floating && !cl->hidden) {
+    client_list_t* clients = visibleclients(s, s->monfocus);
+    for(uint32_t i = 0; i < clients->size; i++) {
+      client_t* it = clients->items[i];
+      if(it->fullscreen) {
         setfullscreen(s, it, false);
         it->floating = false; 
       }
     }
   }
 
-  cl->scratchpad_index = s->mapping_scratchpad_index;
-  cl->is_scratchpad = s->mapping_scratchpad_index != -1;
-
-  if(s->mapping_scratchpad_index != -1) {
-
-    cl->floating = true;
-
-    s->scratchpads[s->mapping_scratchpad_index] = (scratchpad_t) {
-      .win = cl->win,
-      .hidden = false,
-      .needs_restart = false,
-    };
-    s->mapping_scratchpad_index = -1;
-  }
-
-  xcb_flush(s->con);
+  xflush(s);
 }
 void 
 evmapnotify(state_t* s, xcb_generic_event_t* ev) {
   xcb_map_notify_event_t* notify_ev = (xcb_map_notify_event_t*)ev;
-  xcb_get_window_attributes_cookie_t wa_cookie = xcb_get_window_attributes(s->con, notify_ev->window);
-  xcb_get_window_attributes_reply_t *wa_reply = xcb_get_window_attributes_reply(s->con, wa_cookie, NULL);
-  if (!wa_reply) {
-    return;
-  }
 
-  if(iswindowpopup(s, notify_ev->window)) {
-    vector_append(&s->popups, notify_ev->window);
+  if(windowkind(s, notify_ev->window) == WindowKindPopup) {
+    winmapset(&s->popups, notify_ev->window, true);
     uint32_t popup_config[] = { XCB_STACK_MODE_ABOVE };
-    xcb_configure_window(s->con, notify_ev->window, 
-                         XCB_CONFIG_WINDOW_STACK_MODE, popup_config);
-    xcb_flush(s->con);
+    xconfigurewindow(s, notify_ev->window, 
+                     XCB_CONFIG_WINDOW_STACK_MODE, popup_config);
+    xflush(s);
   }
 
 }
 
-void focus_top_client_under_cursor(state_t* s, xcb_connection_t *conn, xcb_window_t root) {
-    // Get pointer position
-    xcb_query_pointer_cookie_t pointer_cookie = xcb_query_pointer(conn, root);
-    xcb_query_pointer_reply_t *pointer_reply = xcb_query_pointer_reply(conn, pointer_cookie, NULL);
-    if (!pointer_reply)
+void focus_top_client_under_cursor(state_t* s, xcb_window_t root) {
+  // Get pointer position
+  bool cursor_success;
+  v2_t cursor = cachedcursorpos(s, &cursor_success);
+  if (!cursor_success)
     return;
 
-  int pointer_x = pointer_reply->root_x;
-  int pointer_y = pointer_reply->root_y;
-  free(pointer_reply);
+  int pointer_x = cursor.x;
+  int pointer_y = cursor.y;
 
   // Get window stacking order (topmost last)
-  xcb_query_tree_cookie_t tree_cookie = xcb_query_tree(conn, root);
-  xcb_query_tree_reply_t *tree_reply = xcb_query_tree_reply(conn, tree_cookie, NULL);
+  xcb_query_tree_reply_t *tree_reply = xquerytree(s, root);
   if (!tree_reply)
     return;
 
@@ -2508,8 +3556,7 @@ void focus_top_client_under_cursor(state_t* s, xcb_connection_t *conn, xcb_windo
     xcb_window_t win = children[i];
 
     // Get window geometry
-    xcb_get_geometry_cookie_t geo_cookie = xcb_get_geometry(conn, win);
-    xcb_get_geometry_reply_t *geo = xcb_get_geometry_reply(conn, geo_cookie, NULL);
+    xcb_get_geometry_reply_t *geo = xgetgeometry(s, win);
     if (!geo)
       continue;
 
@@ -2525,9 +3572,10 @@ void focus_top_client_under_cursor(state_t* s, xcb_connection_t *conn, xcb_windo
       pointer_y >= y && pointer_y < y + h) {
       logmsg(s, LogLevelTrace, "Win %i\n", win);
       logmsg(s, LogLevelTrace, "===============");
-      for(client_t* cl = s->monfocus->clients; cl != NULL; cl = cl->next) {
-        logmsg(s, LogLevelTrace, "Client %i\n", cl->win);
-        logmsg(s, LogLevelTrace, "Client Frame %i\n", cl->frame);
+      client_list_t* clients = visibleclients(s, s->monfocus);
+      for(uint32_t j = 0; j < clients->size; j++) {
+        logmsg(s, LogLevelTrace, "Client %i\n", clients->items[j]->win);
+        logmsg(s, LogLevelTrace, "Client Frame %i\n", clients->items[j]->frame);
       }
       logmsg(s, LogLevelTrace, "===============");
       client_t* c = clientfromframe(s, win);
@@ -2554,18 +3602,15 @@ void
 evunmapnotify(state_t* s, xcb_generic_event_t* ev) {
   // Retrieve the event
   xcb_unmap_notify_event_t* unmap_ev = (xcb_unmap_notify_event_t*)ev;
-  if(iswindowpopup(s, unmap_ev->window)) {
-    logmsg(s, LogLevelTrace, "remoed popup window. ", unmap_ev->window); 
-    int32_t idx = -1;
-    for(uint32_t i = 0; i < s->popups.size; i++) {
-      if(s->popups.items[i] == unmap_ev->window) {
-        idx = i;
-        break;
-      }
-    }
-    if(idx == -1) return;
-    vector_remove_by_idx(&s->popups, idx);
-    focus_top_client_under_cursor(s, s->con, s->root);
+  // Nothing to do when the window manager's own windows are unmapped
+  uint8_t kind = WindowKindOther;
+  winmapget(&s->winkinds, unmap_ev->window, &kind);
+  if(kind == WindowKindOwn) return;
+
+  if(kind == WindowKindPopup) {
+    if(!winmapremove(&s->popups, unmap_ev->window)) return;
+    logmsg(s, LogLevelTrace, "removed popup window %i.", unmap_ev->window); 
+    focus_top_client_under_cursor(s, s->root);
   }
 
   client_t* cl = clientfromwin(s, unmap_ev->window);
@@ -2578,9 +3623,9 @@ evunmapnotify(state_t* s, xcb_generic_event_t* ev) {
     if(cl->is_scratchpad) {
       removescratchpad(s, cl->scratchpad_index);
     }
-    unframeclient(s, cl);
+    unframeclient(s, cl, false);
   } else {
-    xcb_unmap_window(s->con, unmap_ev->window);
+    xunmapwindow(s, unmap_ev->window);
   }
 
   // Remove the client from the list
@@ -2593,7 +3638,7 @@ evunmapnotify(state_t* s, xcb_generic_event_t* ev) {
   // Re-establish the window layout
   makelayout(s, s->monfocus);
 
-  xcb_flush(s->con);
+  xflush(s);
 }
 
 /**
@@ -2607,6 +3652,10 @@ evunmapnotify(state_t* s, xcb_generic_event_t* ev) {
 void 
 evdestroynotify(state_t* s, xcb_generic_event_t* ev) {
   xcb_destroy_notify_event_t* destroy_ev = (xcb_destroy_notify_event_t*)ev;
+  // The window id might be reused, so forget what is known about it
+  winmapremove(&s->winkinds, destroy_ev->window);
+  winmapremove(&s->popups, destroy_ev->window);
+
   client_t* cl = clientfromwin(s, destroy_ev->window);
   if(!cl) {
     return;
@@ -2614,7 +3663,7 @@ evdestroynotify(state_t* s, xcb_generic_event_t* ev) {
   if(cl->is_scratchpad) {
     removescratchpad(s, cl->scratchpad_index);
   }
-  unframeclient(s, cl);
+  unframeclient(s, cl, true);
   releaseclient(s, destroy_ev->window);
 }
 
@@ -2627,8 +3676,9 @@ evdestroynotify(state_t* s, xcb_generic_event_t* ev) {
  */
 void 
 eventernotify(state_t* s, xcb_generic_event_t* ev) {
-  if(s->ignore_enter_layout) return;
   xcb_enter_notify_event_t *enter_ev = (xcb_enter_notify_event_t*)ev;
+  updatecursor(s, (v2_t){ enter_ev->root_x, enter_ev->root_y });
+  if(s->ignore_enter_layout) return;
 
   if((enter_ev->mode != XCB_NOTIFY_MODE_NORMAL || enter_ev->detail == XCB_NOTIFY_DETAIL_INFERIOR)
       && enter_ev->event != s->root) {
@@ -2643,26 +3693,20 @@ eventernotify(state_t* s, xcb_generic_event_t* ev) {
     focusclient(s, cl, true);
   }
   else if(enter_ev->event == s->root) {
-    // Set Input focus to root
-    xcb_set_input_focus(s->con, XCB_INPUT_FOCUS_POINTER_ROOT, s->root, XCB_CURRENT_TIME);
+    /* Only the focused client is highlighted, so unfocusing it 
+     * resets every highlight and moves the input focus to root */
+    if(s->focus) {
+      unfocusclient(s, s->focus);
+    }
 
     monitor_t* mon = cursormon(s);
-    updateewmhdesktops(s, mon);
-    s->monfocus = mon;
-    /* Reset border color to unactive for every client */
-    client_t* cl;
-    for (monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
-      for (cl = mon->clients; cl != NULL; cl = cl->next) {
-        if(cl->fullscreen) {
-          continue;
-        }
-        setbordercolor(s, cl, s->config.winbordercolor);
-        setborderwidth(s, cl, s->config.winborderwidth);
-      }
+    if(mon != s->monfocus) {
+      updateewmhdesktops(s, mon);
     }
+    s->monfocus = mon;
   }
 
-  xcb_flush(s->con);
+  xflush(s);
  }
 
 /**
@@ -2676,6 +3720,7 @@ eventernotify(state_t* s, xcb_generic_event_t* ev) {
 void
 evkeypress(state_t* s, xcb_generic_event_t* ev) {
   xcb_key_press_event_t *e = ( xcb_key_press_event_t *) ev;
+  updatecursor(s, (v2_t){ e->root_x, e->root_y });
   // Get associated keysym for the keycode of the event
   xcb_keysym_t keysym = getkeysym(s, e->detail);
 
@@ -2688,7 +3733,20 @@ evkeypress(state_t* s, xcb_generic_event_t* ev) {
       }
     }
   }
-  xcb_flush(s->con);
+  xflush(s);
+}
+
+/**
+ * @brief Handles a X leave-window event by storing the pointer 
+ * position that is reported by the event.
+ *
+ * @param s The window manager's state
+ * @param ev The generic event 
+ */
+void 
+evleavenotify(state_t* s, xcb_generic_event_t* ev) {
+  xcb_leave_notify_event_t *leave_ev = (xcb_leave_notify_event_t*)ev;
+  updatecursor(s, (v2_t){ leave_ev->root_x, leave_ev->root_y });
 }
 
 /**
@@ -2701,19 +3759,26 @@ evkeypress(state_t* s, xcb_generic_event_t* ev) {
 void
 evbuttonpress(state_t* s, xcb_generic_event_t* ev) {
   xcb_button_press_event_t* button_ev = (xcb_button_press_event_t*)ev;
-  client_t* cl = clientfromedgewindow(s, button_ev->event);
+  updatecursor(s, (v2_t){ button_ev->root_x, button_ev->root_y });
+  // Clicking a tab of the tabbed layout shows its client
+  client_t* cl = clientfromtab(s, button_ev->event);
+  if(cl) {
+    focusclient(s, cl, true);
+    xflush(s);
+    return;
+  }
+  cl = clientfromedgewindow(s, button_ev->event);
   if (cl && cl->showedgewindows) {
     s->grabedge = getedgefromwindow(cl, button_ev->event);
     s->grabwin = cl->area;
     s->grabcursor = (v2_t){ button_ev->root_x, button_ev->root_y };
     focusclient(s, cl, true);
     raiseclient(s, cl);
-    xcb_allow_events(s->con, XCB_ALLOW_ASYNC_POINTER, button_ev->time);
+    xallowevents(s, XCB_ALLOW_ASYNC_POINTER, button_ev->time);
     return;
   }
   // Get the window attributes
-  xcb_get_window_attributes_cookie_t attr_cookie = xcb_get_window_attributes(s->con, button_ev->event);
-  xcb_get_window_attributes_reply_t* attr_reply = xcb_get_window_attributes_reply(s->con, attr_cookie, NULL);
+  xcb_get_window_attributes_reply_t* attr_reply = xgetwindowattributes(s, button_ev->event);
 
   if (attr_reply) {
     if (attr_reply->override_redirect) {
@@ -2730,11 +3795,6 @@ evbuttonpress(state_t* s, xcb_generic_event_t* ev) {
   if (!cl) return;
   // Focusing client 
   if (cl != s->focus) {
-    // Unfocus the previously focused window to ensure that there is only
-    // one focused (highlighted) window at a time.
-    if (s->focus) {
-      unfocusclient(s, s->focus);
-    }
     focusclient(s, cl, true);
   }
 
@@ -2751,7 +3811,7 @@ evbuttonpress(state_t* s, xcb_generic_event_t* ev) {
 
   // Raising the client to the top of the stack
   raiseclient(s, cl);
-  xcb_flush(s->con);
+  xflush(s);
 }
 
 void
@@ -2763,8 +3823,11 @@ evbuttonrelease(state_t* s, xcb_generic_event_t* ev) {
   s->grabwin = (area_t){0};
   s->grabcursor = (v2_t){0};
 
-  xcb_allow_events(s->con, XCB_ALLOW_REPLAY_POINTER, button_ev->time);
-  xcb_flush(s->con);
+  // Resize the client to the outline with a single configure
+  applyoutline(s);
+
+  xallowevents(s, XCB_ALLOW_REPLAY_POINTER, button_ev->time);
+  xflush(s);
   makelayout(s, s->monfocus);
 }
 
@@ -2794,6 +3857,7 @@ void print_to_file(const char *filename, const char *format, ...) {
 void
 evmotionnotify(state_t* s, xcb_generic_event_t* ev) {
   xcb_motion_notify_event_t* motion_ev = (xcb_motion_notify_event_t*)ev;
+  updatecursor(s, (v2_t){ motion_ev->root_x, motion_ev->root_y });
 
   // Throttle high-rate motion events (e.g., 60Hz)
   uint32_t curtime = motion_ev->time;
@@ -2816,12 +3880,7 @@ evmotionnotify(state_t* s, xcb_generic_event_t* ev) {
   v2_t movedest   = (v2_t){.x = s->grabwin.pos.x + dragdelta.x, .y = s->grabwin.pos.y + dragdelta.y};
 
   
-  client_t* cl = clientfromedgewindow(s, motion_ev->event);
-  if(cl && !cl->fullscreen && cl->showedgewindows) {
-    window_edge_t edge = getedgefromwindow(cl, motion_ev->event);
-    setcursorforresize(s, motion_ev->event, edge);
-  }
-  cl = clientfromwin(s, motion_ev->event);
+  client_t* cl = clientfromwin(s, motion_ev->event);
   if (!cl && s->grabedge != EdgeNone) {
     // Edge window might have triggered this
     cl = clientfromedgewindow(s, motion_ev->event);
@@ -2891,9 +3950,13 @@ evmotionnotify(state_t* s, xcb_generic_event_t* ev) {
     newsize.y = MAX(newsize.y, 1);
     newsize = applysizehints(s, cl, newsize);
 
-    moveclient(s, cl, newpos, true);
-    resizeclient(s, cl, newsize);
-    cl->ignoreexpose = true;
+    if(s->config.resizemode == ResizeModeOutline) {
+      updateoutline(s, cl, (area_t){.pos = newpos, .size = newsize}, false);
+    } else {
+      moveclient(s, cl, newpos, true);
+      resizeclient(s, cl, newsize);
+      cl->ignoreexpose = true;
+    }
   }
 
   // === Handle Move ===
@@ -2915,12 +3978,16 @@ evmotionnotify(state_t* s, xcb_generic_event_t* ev) {
       .y = s->grabwin.size.y + resizedelta.y
     };
     sizedest = applysizehints(s, cl, sizedest);
-    resizeclient(s, cl, sizedest);
-    cl->ignoreexpose = true;
-    cl->floating = true;
+    if(s->config.resizemode == ResizeModeOutline) {
+      updateoutline(s, cl, (area_t){.pos = cl->area.pos, .size = sizedest}, true);
+    } else {
+      resizeclient(s, cl, sizedest);
+      cl->ignoreexpose = true;
+      cl->floating = true;
+    }
   }
 
-  xcb_flush(s->con);
+  xflush(s);
 }
 
 /**
@@ -2970,7 +4037,7 @@ evconfigrequest(state_t* s, xcb_generic_event_t* ev) {
     }
 
     // Configure the window with the specified values
-    xcb_configure_window(s->con, config_ev->window, mask, values);
+    xconfigurewindow(s, config_ev->window, mask, values);
   } else {
     if(getcurlayout(s, cl->mon) != LayoutFloating && !cl->floating) return;
     {
@@ -2997,7 +4064,7 @@ evconfigrequest(state_t* s, xcb_generic_event_t* ev) {
         mask |= XCB_CONFIG_WINDOW_STACK_MODE;
         values[i++] = config_ev->stack_mode;
       }
-      xcb_configure_window(s->con, cl->frame, mask, values);
+      xconfigurewindow(s, cl->frame, mask, values);
     }
     {
       uint16_t mask = 0;
@@ -3027,7 +4094,7 @@ evconfigrequest(state_t* s, xcb_generic_event_t* ev) {
         mask |= XCB_CONFIG_WINDOW_STACK_MODE;
         values[i++] = config_ev->stack_mode;
       }
-      xcb_configure_window(s->con, cl->win, mask, values);
+      xconfigurewindow(s, cl->win, mask, values);
     }
     bool success;
     cl->area = winarea(s, cl->frame, &success);
@@ -3036,7 +4103,7 @@ evconfigrequest(state_t* s, xcb_generic_event_t* ev) {
     configclient(s, cl);
   }
 
-  xcb_flush(s->con);
+  xflush(s);
 }
 
 
@@ -3052,15 +4119,16 @@ evconfignotify(state_t* s, xcb_generic_event_t* ev) {
   xcb_configure_notify_event_t* config_ev = (xcb_configure_notify_event_t*)ev;
 
   // If the root window configures itself, update the monitor arrangment
+  // once the queued events are handled
   if(config_ev->window == s->root) {
-    updatemons(s);
+    s->monsdirty = true;
   }
 
   // Update the client's titlebar geometry
   client_t* cl = clientfromwin(s, config_ev->window);
   if(!cl) return;
 
-  xcb_flush(s->con);
+  xflush(s);
 }
 
 /**
@@ -3077,17 +4145,24 @@ evpropertynotify(state_t* s, xcb_generic_event_t* ev) {
   if(cl) {
     // Updating the window type if we receive a window type change event.
     if(prop_ev->atom == s->ewmh_atoms[EWMHwindowType]) {
+      // Classify the window again the next time it is mapped
+      winmapremove(&s->winkinds, cl->win);
       setwintype(s, cl);
     }
+    // Keep the cached size hints up to date
+    if(prop_ev->atom == XCB_ATOM_WM_NORMAL_HINTS) {
+      updatesizehints(s, cl);
+    }
+    if(prop_ev->atom == XCB_ATOM_WM_HINTS) {
+      fetchclientprops(s, cl, PropFetchHints);
+    }
     if(s->config.usedecoration) {
-      if(prop_ev->atom == s->ewmh_atoms[EWMHname]) {
-        if(cl->name)
-          free(cl->name);
-        cl->name = getclientname(s, cl);
+      if(prop_ev->atom == s->ewmh_atoms[EWMHname] || prop_ev->atom == XCB_ATOM_WM_NAME) {
+        marktitledirty(s, cl);
       }
     }
   }
-  xcb_flush(s->con);
+  xflush(s);
 }
 
 /**
@@ -3100,6 +4175,11 @@ evpropertynotify(state_t* s, xcb_generic_event_t* ev) {
 void
 evclientmessage(state_t* s, xcb_generic_event_t* ev) {
   xcb_client_message_event_t* msg_ev = (xcb_client_message_event_t*)ev;
+  // Restarts requested by other threads are handled by the event loop
+  if(msg_ev->window == s->root && msg_ev->type == s->wm_atoms[WMrestart]) {
+    execrestart(s);
+    return;
+  }
   client_t* cl = clientfromwin(s, msg_ev->window);
 
   if(!cl) {
@@ -3119,7 +4199,7 @@ evclientmessage(state_t* s, xcb_generic_event_t* ev) {
       seturgent(s, cl, true);
     }
   }
-  xcb_flush(s->con);
+  xflush(s);
 }
 
 void 
@@ -3131,56 +4211,292 @@ evfocusin(state_t* s, xcb_generic_event_t* ev) {
 }
 
 /**
- * @brief Adds a client window to the linked list of clients->
+ * @brief Handles a X sync alarm notify event by finishing the 
+ * _NET_WM_SYNC_REQUEST of the client whose counter triggered the alarm.
+ *
+ * @param s The window manager's state
+ * @param ev The generic event 
+ */
+void
+evsyncalarmnotify(state_t* s, xcb_generic_event_t* ev) {
+  xcb_sync_alarm_notify_event_t* alarm_ev = (xcb_sync_alarm_notify_event_t*)ev;
+
+  for (monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
+    for (uint32_t i = 0; i < s->config.maxdesktops; i++) {
+      for (uint32_t j = 0; j < mon->clients[i].size; j++) {
+        client_t* cl = mon->clients[i].items[j];
+        if(cl->props->syncalarm != alarm_ev->alarm) continue;
+
+        int64_t value = ((int64_t)alarm_ev->counter_value.hi << 32) | alarm_ev->counter_value.lo;
+        if(cl->props->syncpending && value >= cl->props->syncvalue) {
+          endsyncresize(s, cl);
+        }
+        return;
+      }
+    }
+  }
+}
+
+/**
+ * @brief Sets up _NET_WM_SYNC_REQUEST resize synchronization for a 
+ * client if the client supports it by creating an alarm on the 
+ * client's sync counter.
+ *
+ * @param s The window manager's state
+ * @param cl The client to set up synchronization for 
+ */
+void
+setupclientsync(state_t* s, client_t* cl) {
+  if(!s->hassync) return;
+
+  // Clients opt in by listing _NET_WM_SYNC_REQUEST in WM_PROTOCOLS
+  bool supported = false;
+  xcb_icccm_get_wm_protocols_reply_t protocols;
+  if (xgetwmprotocols(s, cl->win, s->wm_atoms[WMprotocols], &protocols)) {
+    for (uint32_t i = 0; i < protocols.atoms_len && !supported; i++) {
+      supported = (protocols.atoms[i] == s->ewmh_atoms[EWMHsyncRequest]);
+    }
+    xcb_icccm_get_wm_protocols_reply_wipe(&protocols);
+  }
+  if(!supported) return;
+
+  xcb_get_property_reply_t* reply = xgetproperty(s, 0, cl->win, s->ewmh_atoms[EWMHsyncRequestCounter], 
+                                                 XCB_ATOM_CARDINAL, 0, 1);
+  if(!reply) return;
+  xcb_sync_counter_t counter = 0;
+  if(xcb_get_property_value_length(reply) >= (int32_t)sizeof(uint32_t)) {
+    counter = *(uint32_t*)xcb_get_property_value(reply);
+  }
+  free(reply);
+  if(!counter) return;
+
+  // Continue from the current value of the counter
+  xcb_sync_query_counter_reply_t* value = xquerycounter(s, counter);
+  if(!value) return;
+  cl->props->syncvalue = ((int64_t)value->counter_value.hi << 32) | value->counter_value.lo;
+  free(value);
+
+  /* The alarm fires once the counter reaches the value of the 
+   * last sync request. It deactivates itself after firing and is 
+   * activated again by changing its value with the next request. */
+  int64_t alarmvalue = cl->props->syncvalue + 1;
+  uint32_t values[] = {
+    counter,
+    XCB_SYNC_VALUETYPE_ABSOLUTE,
+    (uint32_t)(alarmvalue >> 32), (uint32_t)alarmvalue,
+    XCB_SYNC_TESTTYPE_POSITIVE_COMPARISON,
+    0, 0,
+    true
+  };
+  cl->props->synccounter = counter;
+  cl->props->syncalarm = xgenerateid(s);
+  xcreatealarm(s, cl->props->syncalarm, 
+               XCB_SYNC_CA_COUNTER | XCB_SYNC_CA_VALUE_TYPE | XCB_SYNC_CA_VALUE | 
+               XCB_SYNC_CA_TEST_TYPE | XCB_SYNC_CA_DELTA | XCB_SYNC_CA_EVENTS, values);
+  trackresource(s, cl, XResourceAlarm, 1);
+
+  logmsg(s, LogLevelTrace, "client %i supports _NET_WM_SYNC_REQUEST.", cl->win);
+}
+
+/**
+ * @brief Prepares resizing a client that uses _NET_WM_SYNC_REQUEST. 
+ * If the client has not yet acknowledged the previous resize, the 
+ * resize is held back. Otherwise a new sync request is sent.
+ *
+ * @param s The window manager's state
+ * @param cl The client that is resized 
+ *
+ * @return Whether or not the client can be resized now
+ */
+bool
+beginsyncresize(state_t* s, client_t* cl) {
+  client_props_t* props = cl->props;
+  if(!props->synccounter) return true;
+
+  uint64_t now = monotonicms();
+  if(props->syncpending) {
+    if(now - props->syncsent < SYNC_REQUEST_TIMEOUT_MS) {
+      props->syncdeferred = true;
+      return false;
+    }
+    // The client took too long, resize it anyway
+    props->syncpending = false;
+    s->numsyncpending--;
+  }
+
+  props->syncvalue++;
+  uint32_t alarmvalue[] = { (uint32_t)(props->syncvalue >> 32), (uint32_t)props->syncvalue };
+  xchangealarm(s, props->syncalarm, XCB_SYNC_CA_VALUE, alarmvalue);
+
+  // The sync request needs to be sent before the configure request
+  xcb_client_message_event_t event = {0};
+  event.response_type = XCB_CLIENT_MESSAGE;
+  event.window = cl->win;
+  event.type = s->wm_atoms[WMprotocols];
+  event.format = 32;
+  event.data.data32[0] = s->ewmh_atoms[EWMHsyncRequest];
+  event.data.data32[1] = XCB_CURRENT_TIME;
+  event.data.data32[2] = (uint32_t)props->syncvalue;
+  event.data.data32[3] = (uint32_t)(props->syncvalue >> 32);
+  xsendevent(s, 0, cl->win, XCB_EVENT_MASK_NO_EVENT, (const char *)&event);
+
+  props->syncpending = true;
+  props->syncdeferred = false;
+  props->syncsent = now;
+  s->numsyncpending++;
+  return true;
+}
+
+/**
+ * @brief Finishes the pending sync request of a client and applies 
+ * a resize that was held back in the meantime.
+ *
+ * @param s The window manager's state
+ * @param cl The client whose sync request is finished 
+ */
+void
+endsyncresize(state_t* s, client_t* cl) {
+  if(!cl->props->syncpending) return;
+
+  cl->props->syncpending = false;
+  s->numsyncpending--;
+
+  if(cl->props->syncdeferred) {
+    cl->props->syncdeferred = false;
+    resizeclient(s, cl, cl->area.size);
+    xflush(s);
+  }
+}
+
+/**
+ * @brief Returns the time until the next pending sync request 
+ * times out.
  *
  * @param s The window manager's state
+ *
+ * @return The timeout in ms (-1 if no sync request is pending)
+ */
+int32_t
+synctimeout(state_t* s) {
+  if(!s->numsyncpending) return -1;
+
+  uint64_t now = monotonicms();
+  int32_t timeout = -1;
+  for (monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
+    for (uint32_t i = 0; i < s->config.maxdesktops; i++) {
+      for (uint32_t j = 0; j < mon->clients[i].size; j++) {
+        client_props_t* props = mon->clients[i].items[j]->props;
+        if(!props->syncpending) continue;
+        uint64_t due = props->syncsent + SYNC_REQUEST_TIMEOUT_MS;
+        int32_t remaining = due > now ? (int32_t)(due - now) : 0;
+        if(timeout == -1 || remaining < timeout) {
+          timeout = remaining;
+        }
+      }
+    }
+  }
+  return timeout;
+}
+
+/**
+ * @brief Finishes every sync request that was not acknowledged 
+ * within SYNC_REQUEST_TIMEOUT_MS.
+ *
+ * @param s The window manager's state
+ */
+void
+handlesynctimeouts(state_t* s) {
+  if(!s->numsyncpending) return;
+
+  uint64_t now = monotonicms();
+  for (monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
+    for (uint32_t i = 0; i < s->config.maxdesktops; i++) {
+      for (uint32_t j = 0; j < mon->clients[i].size; j++) {
+        client_t* cl = mon->clients[i].items[j];
+        if(cl->props->syncpending && now - cl->props->syncsent >= SYNC_REQUEST_TIMEOUT_MS) {
+          endsyncresize(s, cl);
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief Creates a client from a given window and adds it to the 
+ * client list of the current desktop on a given monitor.
+ *
+ * @param s The window manager's state
+ * @param mon The monitor to add the client to
  * @param win The window to create a client from and add it 
  * to the clients
  *
- * @return The newly created client
+ * @return The newly created client (NULL if the window is invalid)
  */
 client_t*
-addclient(state_t* s, client_t** clients, xcb_window_t win) {
-  // Allocate client structure
-  client_t* cl = (client_t*)malloc(sizeof(*cl));
-  cl->win = win;
-  cl->edges = NULL;
-
-
+addclient(state_t* s, monitor_t* mon, xcb_window_t win) {
   /* Get the window area */
   bool success;
   area_t area = winarea(s, win, &success);
-  if(!success) return cl;
+  if(!success) return NULL;
 
+  // Allocate the client and its rarely accessed properties from the pool
+  client_t* cl = poolallocclient(&s->clientpool);
+  if(!cl) {
+    logmsg(s, LogLevelError, "failed to allocate client for window %i.", win);
+    return NULL;
+  }
+  cl->win = win;
   cl->area = area;
   cl->borderwidth = s->config.winborderwidth;
   cl->fullscreen = false;
   cl->hidden = false;
   cl->decorated = true;
-  cl->floating = getcurlayout(s, s->monfocus) == LayoutFloating;
-  cl->name = getclientname(s, cl);
+  cl->floating = getcurlayout(s, mon) == LayoutFloating;
+  cl->fixed = false;
+  cl->ignoreunmap = false;
+  cl->ignoreexpose = false;
+  cl->showedgewindows = true;
+  cl->parked = false;
+  cl->stacked = false;
+  cl->props->name = NULL;
+  cl->props->namedirty = false;
   cl->layoutsizeadd = 0;
   cl->urgent = false;
   cl->neverfocus = false;
+  cl->scratchpad_index = -1;
+  cl->is_scratchpad = false;
 
   // Create frame window for the client
   frameclient(s, cl);
 
-  // Insert the new client at the beginning of the list
-  cl->next = *clients;
-  // Update the head of the list to the new client
-  *clients = cl;
+  setupclientsync(s, cl);
+  updatesizehints(s, cl);
 
-  edgegrab_t* edges = calloc(9, sizeof(edgegrab_t));
-  cl->edges = edges;  // Add this pointer to your client_t struct
+  // Insert the new client at the beginning of the client list 
+  // of the monitor's current desktop
+  cl->mon = mon;
+  cl->desktop = mondesktop(s, mon)->idx;
+  monaddclient(mon, cl);
 
-  logmsg(s,  LogLevelTrace, "Added client ('%s') to the linked list of clients.", 
-         cl->name ? cl->name : "No name");
+  logmsg(s,  LogLevelTrace, "Added client ('%s') to the client list of desktop %i.", 
+         cl->props->name ? cl->props->name : "No name", cl->desktop);
 
   return cl;
 }
 
-void setcursorforresize(state_t* s, xcb_window_t win, window_edge_t edge) {
+/**
+ * @brief Returns the cursor shown over the edge windows of a given 
+ * edge. Every cursor is loaded once and shared by all clients.
+ *
+ * @param s The window manager's state
+ * @param edge The edge to get the cursor of
+ *
+ * @return The cursor of the edge (XCB_NONE if it could not be loaded)
+ */
+xcb_cursor_t
+edgecursor(state_t* s, window_edge_t edge) {
+  if(s->edgecursors[edge]) return s->edgecursors[edge];
+
   const char* cursor_name = "left_ptr"; // default
 
   switch (edge) {
@@ -3195,20 +4511,17 @@ void setcursorforresize(state_t* s, xcb_window_t win, window_edge_t edge) {
     default:               cursor_name = "left_ptr"; break;
   }
 
-  xcb_cursor_context_t* ctx;
-  if (xcb_cursor_context_new(s->con, s->screen, &ctx) < 0) return;
-
-  xcb_cursor_t cursor = xcb_cursor_load_cursor(ctx, cursor_name);
-  xcb_change_window_attributes(s->con, win, XCB_CW_CURSOR, &cursor);
-
-  xcb_cursor_context_free(ctx);
-  xcb_flush(s->con);
+  s->edgecursors[edge] = xloadcursor(s, cursor_name);
+  if(s->edgecursors[edge]) {
+    trackresource(s, NULL, XResourceCursor, 1);
+  }
+  return s->edgecursors[edge];
 }
 
 window_edge_t getedgefromwindow(client_t* cl, xcb_window_t win) {
   for (int i = 1; i <= 8; i++) {
-    if (cl->edges[i].win == win)
-      return cl->edges[i].edge;
+    if (cl->props->edges[i].win == win)
+      return cl->props->edges[i].edge;
   }
   return EdgeNone;
 }
@@ -3222,26 +4535,35 @@ window_edge_t getedgefromwindow(client_t* cl, xcb_window_t win) {
  */
 void 
 releaseclient(state_t* s, xcb_window_t win) {
-  for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
-    client_t** prev = &mon->clients;
-    client_t* cl = mon->clients;
-    /* Iterate throguh the clients to find the client thats 
-   * associated with the window */
-    while(cl) {
-      if(cl->win == win) {
-        /* Setting the pointer to previous client to the next client 
-       * after the client we want to release, effectivly removing it
-       * from our list of clients*/ 
-        *prev = cl->next;
-        // Freeing memory allocated for client
-        free(cl);
-        return;
-      }
-      // Advancing the client
-      prev = &cl->next;
-      cl = cl->next;
+  client_t* cl = clientfromwin(s, win);
+  if(!cl) return;
+
+  // Remove the client from the client list of its desktop
+  monremoveclient(cl->mon, cl);
+
+  if(s->focus == cl) {
+    s->focus = NULL;
+  }
+  if(s->activewin == cl->win) {
+    setactivewindow(s, XCB_NONE);
+  }
+
+  if(s->outlineclient == cl) {
+    hideoutline(s);
+  }
+
+  if(cl->props->syncalarm) {
+    xdestroyalarm(s, cl->props->syncalarm);
+    trackresource(s, cl, XResourceAlarm, -1);
+    if(cl->props->syncpending) {
+      s->numsyncpending--;
     }
-  } 
+  }
+  checkclientresources(s, cl);
+
+  // Freeing memory allocated for client
+  poolfreestr(&s->strpool, cl->props->name);
+  poolfreeclient(&s->clientpool, cl);
 }
 
 /**
@@ -3255,13 +4577,13 @@ releaseclient(state_t* s, xcb_window_t win) {
  */
 client_t*
 clientfromwin(state_t* s, xcb_window_t win) {
-  client_t* cl;
-
   for (monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
-    for (cl = mon->clients; cl != NULL; cl = cl->next) {
-      // If the window is found in the clients, return the client
-      if(cl->win == win) {
-        return cl;
+    for (uint32_t i = 0; i < s->config.maxdesktops; i++) {
+      for (uint32_t j = 0; j < mon->clients[i].size; j++) {
+        // If the window is found in the clients, return the client
+        if(mon->clients[i].items[j]->win == win) {
+          return mon->clients[i].items[j];
+        }
       }
     }
   }
@@ -3270,13 +4592,13 @@ clientfromwin(state_t* s, xcb_window_t win) {
 
 client_t*
 clientfromframe(state_t* s, xcb_window_t frame) {
-  client_t* cl;
-
   for (monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
-    for (cl = mon->clients; cl != NULL; cl = cl->next) {
-      // If the window frame is found in the clients, return the client
-      if(cl->frame == frame) {
-        return cl;
+    for (uint32_t i = 0; i < s->config.maxdesktops; i++) {
+      for (uint32_t j = 0; j < mon->clients[i].size; j++) {
+        // If the window frame is found in the clients, return the client
+        if(mon->clients[i].items[j]->frame == frame) {
+          return mon->clients[i].items[j];
+        }
       }
     }
   }
@@ -3284,51 +4606,34 @@ clientfromframe(state_t* s, xcb_window_t frame) {
 }
 
 client_t* clientfromedgewindow(state_t* s, xcb_window_t win) {
-  client_t* cl;
   for (monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
-    for (cl = mon->clients; cl != NULL; cl = cl->next) {
-      for (int i = 1; i <= 8; i++) {
-        if (cl->edges && cl->edges[i].win == win) {
-          return cl;
+    for (uint32_t i = 0; i < s->config.maxdesktops; i++) {
+      for (uint32_t j = 0; j < mon->clients[i].size; j++) {
+        client_t* cl = mon->clients[i].items[j];
+        for (int k = 1; k <= 8; k++) {
+          if (cl->props->edges[k].win == win) {
+            return cl;
+          }
         }
+      }
     }
   }
-  }
   return NULL;
 }
 
 
 /**
- * @brief Returns a filtered linked list of all clients 
- * that are currently visible on the given monitor
+ * @brief Returns the list of clients that are on the currently 
+ * selected desktop of a given monitor
  *
  * @param s The window manager's state
  * @param mon The monitor to get visible clients off
- * @param tiled Whether or not to ignore floating clients
  *
- * @return A filtered linked list with all visible clients on 
- * the given monitor
+ * @return The client list of the current desktop on the given monitor
  */
-client_t* 
-visibleclients(state_t* s, monitor_t* mon, bool tiled) {
-  client_t dummy;
-  client_t* tail = &dummy;
-  dummy.next = NULL;
-
-  client_t* current = s->monfocus->clients;
-
-  while (current != NULL) {
-    bool tiled_check = tiled ? current->floating : !tiled;
-    if (tiled_check && clientonscreen(s, current, mon)) {
-      tail->next = current;
-      tail = current;
-    }
-    current = current->next;
-  }
-
-  tail->next = NULL;
-
-  return dummy.next;
+client_list_t* 
+visibleclients(state_t* s, monitor_t* mon) {
+  return &mon->clients[mondesktop(s, mon)->idx];
 }
 
 /**
@@ -3336,28 +4641,45 @@ visibleclients(state_t* s, monitor_t* mon, bool tiled) {
  *
  * @param s The window manager's state 
  * @param a The area of the monitor to create 
+ * @param idx The index of the monitor 
+ * @param name The RandR name of the monitor (XCB_NONE if unnamed)
  *
  * @return The newly created monitor 
  */
-monitor_t* addmon(state_t* s, area_t a, uint32_t idx) {
+monitor_t* addmon(state_t* s, area_t a, uint32_t idx, xcb_atom_t name) {
   // Allocate a new item for the monitor in the linked list 
   // of monitors.
   monitor_t* mon  = (monitor_t*)malloc(sizeof(*mon));
   mon->area     = a;
   mon->next     = s->monitors;
   mon->idx      = idx;
+  mon->name     = name;
+  mon->active   = true;
   mon->desktopcount = 0;
   mon->activedesktops = malloc(sizeof(*mon->activedesktops) * s->config.maxdesktops);
-  mon->clients = NULL;
+  mon->clients = calloc(s->config.maxdesktops, sizeof(*mon->clients));
+  // Set when the monitor topology is built
+  memset(mon->neighbours, 0, sizeof(mon->neighbours));
+  // The tab bar is created once the tabbed layout is shown on the monitor
+  mon->tabbar = (tab_bar_t){0};
 
+  // Create all virtual desktops of the monitor 
+  for(uint32_t i = 0; i < s->config.maxdesktops; i++) {
+    createdesktop(s, i, mon);
+  }
+  mon->activedesktops[s->config.desktopinit].init = true;
+  mon->curdesktop.idx = s->config.desktopinit;
 
   // Initialize the layout properties of all virtual desktops on the monitor
   mon->layouts = malloc(sizeof(*mon->layouts) * s->config.maxdesktops);
   for(uint32_t i = 0; i < s->config.maxdesktops; i++) {
-    mon->layouts[i].nmaster = 1;
-    mon->layouts[i].gapsize = s->config.winlayoutgap;
-    mon->layouts[i].masterarea = MIN(MAX(s->config.layoutmasterarea, 0.0), 1.0);
-    mon->layouts[i].curlayout = s->config.initlayout;
+    mon->layouts[i] = (layout_props_t){
+      .nmaster = 1,
+      .gapsize = s->config.winlayoutgap,
+      .masterarea = MIN(MAX(s->config.layoutmasterarea, 0.0), 1.0),
+      .curlayout = s->config.initlayout,
+      .dirty = true,
+    };
   }
   // Update linked list pointer
   s->monitors    = mon;
@@ -3370,6 +4692,68 @@ monitor_t* addmon(state_t* s, area_t a, uint32_t idx) {
   return mon;
 }
 
+/**
+ * @brief Frees all resources of a given monitor. The monitor 
+ * needs to be unlinked from the list of monitors and must not 
+ * contain any clients.
+ *
+ * @param s The window manager's state 
+ * @param mon The monitor to destroy 
+ */
+void
+destroymon(state_t* s, monitor_t* mon) {
+  destroytabbar(s, mon);
+  for(uint32_t i = 0; i < mon->desktopcount; i++) {
+    free(mon->activedesktops[i].name);
+  }
+  for(uint32_t i = 0; i < s->config.maxdesktops; i++) {
+    vector_free(&mon->clients[i]);
+  }
+  free(mon->activedesktops);
+  free(mon->layouts);
+  free(mon->clients);
+  free(mon);
+}
+
+/**
+ * @brief Moves all clients of a given monitor onto another monitor. 
+ * Clients keep their virtual desktop and their position relative 
+ * to the monitor.
+ *
+ * @param s The window manager's state 
+ * @param from The monitor to move the clients from 
+ * @param to The monitor to move the clients to 
+ */
+void
+migrateclients(state_t* s, monitor_t* from, monitor_t* to) {
+  uint32_t visibledesktop = mondesktop(s, to)->idx;
+  for(uint32_t i = 0; i < s->config.maxdesktops; i++) {
+    client_list_t* clients = &from->clients[i];
+    // Relocating removes the client from the list, so always take the last one
+    while(clients->size) {
+      client_t* cl = clients->items[clients->size - 1];
+      v2_t rel = (v2_t){
+        cl->area.pos.x - from->area.pos.x,
+        cl->area.pos.y - from->area.pos.y
+      };
+      relocateclient(s, cl, to, i);
+
+      // Keep the client within the bounds of the new monitor
+      v2_t pos = (v2_t){
+        to->area.pos.x + MAX(MIN(rel.x, to->area.size.x - cl->area.size.x), 0),
+        to->area.pos.y + MAX(MIN(rel.y, to->area.size.y - cl->area.size.y), 0)
+      };
+      moveclient(s, cl, pos, false);
+
+      if(i != visibledesktop && !cl->hidden) {
+        hideclient(s, cl);
+      } else if(i == visibledesktop && cl->hidden && !cl->is_scratchpad) {
+        showclient(s, cl);
+      }
+    }
+  }
+  logmsg(s, LogLevelTrace, "moved clients of monitor %i to monitor %i.", from->idx, to->idx);
+}
 
 /**
  * @brief Returns the monitor within the list of monitors 
@@ -3406,48 +4790,142 @@ monbyarea(state_t* s, area_t a) {
  */
 monitor_t*
 clientmon(state_t* s, client_t* cl) {
-  monitor_t* ret = s->monitors;
   if (!cl) {
-    return ret;
+    return s->monitors;
   }
+  // Clients mostly stay within the monitor they are on
+  return monforarea(s, cl->area, cl->mon);
+}
 
-  monitor_t* mon;
-  float biggest_overlap_area = -1.0f;
+/**
+ * @brief Moves a given client to a given monitor, keeping its 
+ * position and size relative to the monitor and placing it on 
+ * the monitor's selected desktop.
+ *
+ * @param s The window manager's state
+ * @param cl The client to move
+ * @param mon The monitor to move the client to
+ */
+void
+sendclienttomon(state_t* s, client_t* cl, monitor_t* mon) {
+  if(!cl || !mon || mon == cl->mon) return;
+  s->ignore_enter_layout = true;
 
-  for (mon = s->monitors; mon != NULL; mon = mon->next) {
-    float overlap = getoverlaparea(cl->area, mon->area);
+  area_t aclientmon = cl->mon->area;
+
+  bool fs = cl->fullscreen;
+  bool floating = cl->floating;
+  if(fs) {
+    setfullscreen(s, cl, false);
+  }
 
-    // Assign the monitor on which the client has the biggest overlap area
-    if (overlap > biggest_overlap_area) {
-      biggest_overlap_area = overlap;
-      ret = mon;
+  // Unset fullscreen for all clients on the 
+  // destination monitor
+  client_list_t* clients = visibleclients(s, mon);
+  for(uint32_t i = 0; i < clients->size; i++) {
+    client_t* other = clients->items[i];
+    if(other->fullscreen) {
+      setfullscreen(s, other, false);
+      other->floating = floating;
     }
   }
-  return ret;
+
+  // Moving
+  {
+    v2_t relpos;
+    relpos.x = cl->area.pos.x - aclientmon.pos.x;
+    relpos.y = cl->area.pos.y - aclientmon.pos.y;
+
+    float normx = relpos.x / aclientmon.size.x; 
+    float normy = relpos.y / aclientmon.size.y; 
+
+    v2_t dest;
+    dest.x = mon->area.pos.x + (normx * mon->area.size.x); 
+    dest.y = mon->area.pos.y + (normy * mon->area.size.y); 
+
+    removefromlayout(s, cl);
+    makelayout(s, cl->mon);
+    cl->floating = floating;
+
+    moveclient(s, cl, dest, false);
+
+    relocateclient(s, cl, mon, mondesktop(s, mon)->idx);
+    updateewmhdesktops(s, cl->mon);
+    s->monfocus = cl->mon;
+  }
+
+  // Resizing
+  {
+    float scalex = mon->area.size.x / aclientmon.size.x;
+    float scaley = mon->area.size.y / aclientmon.size.y;
+
+    v2_t dest;
+    dest.x = cl->area.size.x * scalex;
+    dest.y = cl->area.size.y * scaley;
+
+    resizeclient(s, cl, dest);
+  }
+
+  makelayout(s, mon);
+
+  if(fs) {
+    setfullscreen(s, cl, true);
+  }
 }
 
-void 
-updateclienthints(state_t* s, client_t* cl) {
-  xcb_icccm_wm_hints_t hints;
-  xcb_get_property_cookie_t cookie;
+/**
+ * @brief Focuses a given monitor by warping the pointer to its 
+ * center and focusing the topmost client under it.
+ *
+ * @param s The window manager's state
+ * @param mon The monitor to focus
+ */
+void
+focusmon(state_t* s, monitor_t* mon) {
+  if(!mon || mon == s->monfocus) return;
+  v2_t center = (v2_t){
+    mon->area.pos.x + mon->area.size.x / 2.0f,
+    mon->area.pos.y + mon->area.size.y / 2.0f
+  };
+  xwarppointer(s, XCB_NONE, s->root, 0, 0, 0, 0, 
+               (int16_t)center.x, (int16_t)center.y);
+  updatecursor(s, center);
 
-  cookie = xcb_icccm_get_wm_hints(s->con, cl->win);
-  if (!xcb_icccm_get_wm_hints_reply(s->con, cookie, &hints, NULL))
-    return;
+  s->monfocus = mon;
+  updateewmhdesktops(s, mon);
+  focus_top_client_under_cursor(s, s->root);
+  // There might be no client under the pointer on the monitor
+  if(s->focus && s->focus->mon != mon) {
+    focusroot(s);
+  }
+  xflush(s);
+}
 
-  if (cl == s->focus && (hints.flags & XCB_ICCCM_WM_HINT_X_URGENCY)) {
+/**
+ * @brief Applies the WM_HINTS of a given client, updating its 
+ * urgency and whether it accepts input focus.
+ *
+ * @param s The window manager's state
+ * @param cl The client the hints belong to
+ * @param hints The WM_HINTS of the client's window
+ */
+void
+applyclienthints(state_t* s, client_t* cl, const xcb_icccm_wm_hints_t* hints) {
+  if (cl == s->focus && (hints->flags & XCB_ICCCM_WM_HINT_X_URGENCY)) {
     // Clear the urgency flag
-    hints.flags &= ~XCB_ICCCM_WM_HINT_X_URGENCY;
-    xcb_icccm_set_wm_hints(s->con, cl->win, &hints);
-    xcb_flush(s->con);
+    xcb_icccm_wm_hints_t cleared = *hints;
+    cleared.flags &= ~XCB_ICCCM_WM_HINT_X_URGENCY;
+    xsetwmhints(s, cl->win, &cleared);
   } else {
-    cl->urgent = (hints.flags & XCB_ICCCM_WM_HINT_X_URGENCY) ? 1 : 0;
+    cl->urgent = (hints->flags & XCB_ICCCM_WM_HINT_X_URGENCY) ? 1 : 0;
   }
 
-  if (hints.flags & XCB_ICCCM_WM_HINT_INPUT)
-    cl->neverfocus = !hints.input;
-  else
-    cl->neverfocus = false;
+  bool neverfocus = (hints->flags & XCB_ICCCM_WM_HINT_INPUT) ? !hints->input : false;
+  // The client may have been focused before its hints arrived
+  if(neverfocus && !cl->neverfocus && cl == s->focus) {
+    focusroot(s);
+  }
+  cl->neverfocus = neverfocus;
 }
 
 
@@ -3462,7 +4940,8 @@ updateclienthints(state_t* s, client_t* cl) {
  */
 desktop_t* 
 mondesktop(state_t* s, monitor_t* mon) {
-  return &s->curdesktop[mon->idx];
+  (void)s;
+  return &mon->curdesktop;
 }
 
 /**
@@ -3476,22 +4955,35 @@ mondesktop(state_t* s, monitor_t* mon) {
 monitor_t*
 cursormon(state_t* s) {
   bool success;
-  v2_t cursor = cursorpos(s, &success);
-  if(!success) {
+  cachedcursorpos(s, &success);
+  if(!success || !s->lastcursormon) {
     return s->monitors;
   }
-  monitor_t* mon;
-  for (mon = s->monitors; mon != NULL; mon = mon->next) {
-    if(pointinarea(cursor, mon->area)) {
-      return mon;
-    }
+  return s->lastcursormon;
+}
+
+/**
+ * @brief Returns the monitor with a given index 
+ *
+ * @param s The window manager's state
+ * @param idx The index of the monitor 
+ *
+ * @return The monitor with the given index (NULL if there is none)
+ */
+monitor_t*
+monbyidx(state_t* s, int32_t idx) {
+  for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
+    if((int32_t)mon->idx == idx) return mon;
   }
-  return s->monitors;
+  return NULL;
 }
 
 /**
- * @brief Gets all screens registed by xrandr and adds newly registered 
- * monitors to the linked list of monitors in the window manager.
+ * @brief Queries the monitors registered by xrandr and reconciles 
+ * them with the linked list of monitors in the window manager. 
+ * Known monitors are matched by name and updated in place, new 
+ * monitors are added and the clients of removed monitors are 
+ * moved to the focused monitor.
  *
  * @param s The window manager's state 
  *
@@ -3499,57 +4991,119 @@ cursormon(state_t* s) {
  */
 uint32_t
 updatemons(state_t* s) {
+  // Get every active monitor with a single request
+  xcb_randr_get_monitors_reply_t* reply = xgetmonitors(s, s->root, 1);
 
-  // Get xrandr screen resources
-  xcb_randr_get_screen_resources_current_cookie_t res_cookie = 
-    xcb_randr_get_screen_resources_current(s->con, s->screen->root);
-  xcb_randr_get_screen_resources_current_reply_t *res_reply =
-    xcb_randr_get_screen_resources_current_reply(s->con, res_cookie, NULL);
-
-  if (!res_reply) {
-    logmsg(s,  LogLevelError, "cannot get Xrandr screen resources.");
+  if(!reply && !s->monitors) {
+    logmsg(s,  LogLevelError, "cannot get Xrandr monitors.");
     terminate(s, EXIT_FAILURE);
   }
+  // Keep the current monitors if the server does not report any
+  if(!reply || !xcb_randr_get_monitors_monitors_length(reply)) {
+    if(!s->monitors) {
+      addmon(s, (area_t){
+        .pos = (v2_t){0, 0}, 
+        .size = (v2_t){s->screen->width_in_pixels, s->screen->height_in_pixels}
+      }, 0, XCB_NONE);
+    }
+    free(reply);
+    buildtopology(s);
+    return 0;
+  }
 
-  // Get number of connected monitors
-  int32_t num_outputs = xcb_randr_get_screen_resources_current_outputs_length(res_reply);
-  // Get list of monitors
-  xcb_randr_output_t *outputs = xcb_randr_get_screen_resources_current_outputs(res_reply);
+  for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
+    mon->active = false;
+  }
 
   uint32_t registered_count = 0; 
-  // Iterate through the outputs
-  for (int32_t i = 0; i < num_outputs; i++) {
-    // Get the monitor info
-    xcb_randr_get_output_info_cookie_t info_cookie = xcb_randr_get_output_info(s->con, outputs[i], XCB_TIME_CURRENT_TIME);
-    xcb_randr_get_output_info_reply_t *info_reply = xcb_randr_get_output_info_reply(s->con, info_cookie, NULL);
-
-    // Check if montior has CRTC
-    if (info_reply && info_reply->crtc != XCB_NONE) {
-      // Get CRTC info
-      xcb_randr_get_crtc_info_cookie_t crtc_cookie = xcb_randr_get_crtc_info(s->con, info_reply->crtc, XCB_TIME_CURRENT_TIME);
-      xcb_randr_get_crtc_info_reply_t *crtc_reply = xcb_randr_get_crtc_info_reply(s->con, crtc_cookie, NULL);
-
-      // If that worked, register the monitor if it isn't registered yet 
-      if (crtc_reply) {
-        area_t monarea = (area_t){
-          .pos = (v2_t){
-            crtc_reply->x, crtc_reply->y
-          },
-          .size = (v2_t){
-            crtc_reply->width, crtc_reply->height
-          }
-        };
-        if(!monbyarea(s, monarea)) {
-          addmon(s, monarea, registered_count++);
-        }
-        free(crtc_reply);
+  xcb_randr_monitor_info_iterator_t it = xcb_randr_get_monitors_monitors_iterator(reply);
+  for(; it.rem; xcb_randr_monitor_info_next(&it)) {
+    area_t monarea = (area_t){
+      .pos = (v2_t){
+        it.data->x, it.data->y
+      },
+      .size = (v2_t){
+        it.data->width, it.data->height
+      }
+    };
+
+    // Find the monitor by name and fall back to its area
+    monitor_t* mon;
+    for(mon = s->monitors; mon != NULL; mon = mon->next) {
+      if(!mon->active && mon->name != XCB_NONE && mon->name == it.data->name) break;
+    }
+    if(!mon) {
+      mon = monbyarea(s, monarea);
+      if(mon && mon->active) mon = NULL;
+    }
+
+    if(!mon) {
+      addmon(s, monarea, 0, it.data->name);
+      registered_count++;
+      continue;
+    }
+    mon->active = true;
+    mon->name = it.data->name;
+    if(mon->area.pos.x != monarea.pos.x || mon->area.pos.y != monarea.pos.y ||
+      mon->area.size.x != monarea.size.x || mon->area.size.y != monarea.size.y) {
+      mon->area = monarea;
+      for(uint32_t i = 0; i < s->config.maxdesktops; i++) {
+        mon->layouts[i].dirty = true;
       }
     }
-    if (info_reply) {
-      free(info_reply);
+  }
+  free(reply);
+
+  // The clients of removed monitors go to the focused monitor if it is still there
+  monitor_t* dest = (s->monfocus && s->monfocus->active) ? s->monfocus : NULL;
+  for(monitor_t* mon = s->monitors; mon != NULL && !dest; mon = mon->next) {
+    if(mon->active) dest = mon;
+  }
+
+  bool focusremoved = s->monfocus && !s->monfocus->active;
+  // The cached pointer monitor might be removed and the pointer might be moved
+  invalidatecursor(s);
+
+  // Remove every monitor that was not reported anymore
+  monitor_t** link = &s->monitors;
+  while(*link) {
+    monitor_t* mon = *link;
+    if(mon->active) {
+      link = &mon->next;
+      continue;
+    }
+    migrateclients(s, mon, dest);
+    *link = mon->next;
+    logmsg(s,  LogLevelTrace, "removed monitor %i.", mon->idx);
+    destroymon(s, mon);
+  }
+
+  // Index the monitors in the order they were registered
+  uint32_t nmons = 0;
+  for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
+    nmons++;
+  }
+  uint32_t i = 0;
+  for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
+    mon->idx = nmons - 1 - i++;
+  }
+  buildtopology(s);
+
+  /* Lay out the new monitor arrangement (monfocus is not set during setup). 
+   * Only the monitors that are new, changed their area or received the 
+   * clients of a removed monitor have a dirty layout, the others keep theirs. */
+  if(s->monfocus) {
+    if(focusremoved) {
+      s->monfocus = dest;
+    }
+    for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
+      if(mon->layouts[mondesktop(s, mon)->idx].dirty) {
+        makelayout(s, mon);
+      }
     }
+    updateewmhdesktops(s, s->monfocus);
+    xflush(s);
   }
-  free(res_reply);
 
   return registered_count;
 }
@@ -3565,13 +5119,7 @@ updatemons(state_t* s) {
  */
 xcb_keysym_t
 getkeysym(state_t* s, xcb_keycode_t keycode) {
-  // Allocate key symbols 
-  xcb_key_symbols_t *keysyms = xcb_key_symbols_alloc(s->con);
-  // Get the keysym
-  xcb_keysym_t keysym = (!(keysyms) ? 0 : xcb_key_symbols_get_keysym(keysyms, keycode, 0));
-  // Free allocated resources
-  xcb_key_symbols_free(keysyms);
-  return keysym;
+  return xgetkeysym(s, keycode);
 }
 
 /**
@@ -3585,11 +5133,7 @@ getkeysym(state_t* s, xcb_keycode_t keycode) {
  */
 xcb_keycode_t*
 getkeycodes(state_t* s, xcb_keysym_t keysym) {
-  xcb_key_symbols_t *keysyms = xcb_key_symbols_alloc(s->con);
-  xcb_keycode_t *keycode = (!(keysyms) ? NULL : xcb_key_symbols_get_keycode(keysyms, keysym));
-  xcb_key_symbols_free(keysyms);
-  return keycode;
-
+  return xgetkeycodes(s, keysym);
 }
 
 /**
@@ -3604,16 +5148,14 @@ getkeycodes(state_t* s, xcb_keysym_t keysym) {
 strut_t
 readstrut(state_t* s, xcb_window_t win) {
   strut_t strut = {0};
-  xcb_intern_atom_cookie_t cookie = xcb_intern_atom(s->con, 0, strlen("_NET_WM_STRUT_PARTIAL"), "_NET_WM_STRUT_PARTIAL");
-  xcb_intern_atom_reply_t* reply = xcb_intern_atom_reply(s->con, cookie, NULL);
+  xcb_intern_atom_reply_t* reply = xinternatom(s, 0, strlen("_NET_WM_STRUT_PARTIAL"), "_NET_WM_STRUT_PARTIAL");
 
   if (!reply) {
     logmsg(s,  LogLevelError, "failed to get _NET_WM_STRUT_PARTIAL atom.");
     return strut;
   }
 
-  xcb_get_property_cookie_t propcookie = xcb_get_property(s->con, 0, win, reply->atom, XCB_GET_PROPERTY_TYPE_ANY, 0, 16);
-  xcb_get_property_reply_t* propreply = xcb_get_property_reply(s->con, propcookie, NULL);
+  xcb_get_property_reply_t* propreply = xgetproperty(s, 0, win, reply->atom, XCB_GET_PROPERTY_TYPE_ANY, 0, 16);
 
   if (reply && xcb_get_property_value_length(propreply) >= 16) {
     uint32_t* data = (uint32_t*)xcb_get_property_value(propreply);
@@ -3644,8 +5186,7 @@ readstrut(state_t* s, xcb_window_t win) {
  */
 void 
 getwinstruts(state_t* s, xcb_window_t win) {
-  xcb_query_tree_cookie_t cookie = xcb_query_tree(s->con, win);
-  xcb_query_tree_reply_t* reply = xcb_query_tree_reply(s->con, cookie, NULL);
+  xcb_query_tree_reply_t* reply = xquerytree(s, win);
 
   if (!reply) {
     logmsg(s,  LogLevelError, "failed to get the query tree for window %i.", win);
@@ -3681,8 +5222,7 @@ getwinstruts(state_t* s, xcb_window_t win) {
  * */
 xcb_atom_t
 getatom(state_t* s, const char* atomstr) {
-  xcb_intern_atom_cookie_t cookie = xcb_intern_atom(s->con, 0, strlen(atomstr), atomstr);
-  xcb_intern_atom_reply_t* reply = xcb_intern_atom_reply(s->con, cookie, NULL);
+  xcb_intern_atom_reply_t* reply = xinternatom(s, 0, strlen(atomstr), atomstr);
   xcb_atom_t atom = reply ? reply->atom : XCB_ATOM_NONE;
   free(reply);
   return atom;
@@ -3696,13 +5236,26 @@ getatom(state_t* s, const char* atomstr) {
  * */
 void
 ewmh_updateclients(state_t* s) {
-  xcb_delete_property(s->con, s->root, s->ewmh_atoms[EWMHclientList]);
+  uint32_t nclients = 0;
+  for (monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
+    for (uint32_t i = 0; i < s->config.maxdesktops; i++) {
+      nclients += mon->clients[i].size;
+    }
+  }
 
-  client_t* cl;
-  for (cl = s->monfocus->clients; cl != NULL; cl = cl->next) {
-    xcb_change_property(s->con, XCB_PROP_MODE_APPEND, s->root, s->ewmh_atoms[EWMHclientList],
-	XCB_ATOM_WINDOW, 32, 1, &cl->win);
+  // Gather the windows of all clients and upload them with a single request
+  xcb_window_t* wins = malloc(sizeof(*wins) * (nclients ? nclients : 1));
+  uint32_t n = 0;
+  for (monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
+    for (uint32_t i = 0; i < s->config.maxdesktops; i++) {
+      for (uint32_t j = 0; j < mon->clients[i].size; j++) {
+        wins[n++] = mon->clients[i].items[j]->win;
+      }
+    }
   }
+  xchangeproperty(s, XCB_PROP_MODE_REPLACE, s->root, s->ewmh_atoms[EWMHclientList],
+                  XCB_ATOM_WINDOW, 32, n, wins);
+  free(wins);
 }
 
 /**
@@ -3714,6 +5267,40 @@ sigchld_handler(int32_t signum) {
   while (waitpid(-1, NULL, WNOHANG) > 0);
 }
 
+/**
+ * @brief Launches a given shell command without waiting for it. 
+ * The shell replaces itself with the command so that the returned 
+ * process id is the one the command's windows report.
+ *
+ * @param s The window manager's state
+ * @param cmd The command to launch (a trailing '&' is ignored)
+ *
+ * @return The process id of the launched command (-1 on failure)
+ */
+int32_t
+spawncmd(state_t* s, const char* cmd) {
+  size_t len = strlen(cmd);
+  while(len && (cmd[len - 1] == '&' || cmd[len - 1] == ' ' || cmd[len - 1] == '\t')) {
+    len--;
+  }
+  char* execcmd = malloc(len + sizeof("exec "));
+  if(!execcmd) return -1;
+  snprintf(execcmd, len + sizeof("exec "), "exec %.*s", (int32_t)len, cmd);
+
+  pid_t pid = fork();
+  if(pid == 0) {
+    setsid();
+    execl("/bin/sh", "sh", "-c", execcmd, (char *)NULL);
+    _exit(EXIT_FAILURE);
+  }
+  free(execcmd);
+  if(pid < 0) {
+    logmsg(s, LogLevelError, "failed to execute command '%s'.", cmd);
+    return -1;
+  }
+  return pid;
+}
+
 /**
  * @brief Checks if a given string is within a given 
  * array of strings
@@ -3878,14 +5465,52 @@ cmdoutput(const char* cmd) {
 }
 
 
+uint64_t
+monotonicms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+/* The tests bring their own main() (see 'make test') */
+#ifndef RAGNAR_TEST
 int
-main(void) {
+main(int argc, char** argv) {
+  const char* recordpath = NULL;
+  const char* replaypath = NULL;
+  bool realtime = false;
+  for(int32_t i = 1; i < argc; i++) {
+    if(strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+      recordpath = argv[++i];
+    } else if(strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+      replaypath = argv[++i];
+    } else if(strcmp(argv[i], "--realtime") == 0) {
+      realtime = true;
+    } else {
+      fprintf(stderr, "usage: ragnar [--record <file>] [--replay <file> [--realtime]]\n");
+      return EXIT_FAILURE;
+    }
+  }
+
   state_t* wm_state = calloc(1, sizeof(state_t));
+  // Not watching the config file until it has been read
+  wm_state->cfgwatchfd = -1;
+  // Kept to execute the window manager again when it restarts in place
+  wm_state->argv = argv;
+  wm_state->replaying = replaypath != NULL;
+  /* A recording is replayed on a display of its own instead of 
+   * handling the events of the X server (it sets up the window manager) */
+  if(replaypath) {
+    terminate(wm_state, replay(wm_state, replaypath, realtime));
+  }
   // Setup the window manager
   setup(wm_state);
-  // Manage all windows on the display
+  if(recordpath && !startrecording(wm_state, recordpath)) {
+    terminate(wm_state, EXIT_FAILURE);
+  }
   // Enter the event loop
   loop(wm_state);
   // Terminate after the loop
   terminate(wm_state, EXIT_SUCCESS);
 }
+#endif
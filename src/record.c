@@ -0,0 +1,888 @@
+#include "record.h"
+#include "funcs.h"
+#include "winmap.h"
+#include "propfetch.h"
+#include "xbackend.h"
+#include "fakex.h"
+#include "ipc/sockets.h"
+#include <ragnar/api.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <xcb/xcb_event.h>
+
+/* Identifies a recording and the byte order it was written in
+ * (recordings are replayed on the machine type they were made on) */
+#define RECORD_MAGIC 0x52475243
+/* Version of the recording format. Recordings of another version
+ * are not replayed. */
+#define RECORD_VERSION 2
+/* Size of an X event on the wire */
+#define RECORD_EVENT_SIZE 32
+/* Largest record that is replayed (larger ones are corrupt) */
+#define RECORD_MAX_SIZE (1 << 20)
+/* Interval in µs at which a recording is written to its file */
+#define RECORD_FLUSH_INTERVAL_US 1000000
+
+/* A recording is a header followed by records. Every record is the
+ * kind of the record (1 byte), the time in µs since the previous
+ * record and the length of its data (both LEB128 encoded), then
+ * the data itself. */
+typedef enum {
+  /* An X event as it was received */
+  RecordXEvent = 0,
+  /* An IPC command: its ID followed by its data */
+  RecordIpc,
+  /* The event loop handled all queued events and waited for more */
+  RecordBatch,
+  /* A window that requested to be mapped (record_window_t and its WM_CLASS) */
+  RecordWindow,
+  /* The windows created for a client (record_frame_t) */
+  RecordFrame,
+  /* The name of an atom that a recorded event refers to */
+  RecordAtom,
+  RecordKindCount
+} record_kind_t;
+
+typedef struct {
+  uint32_t magic, version;
+  /* Root window of the recorded display and its size */
+  uint32_t root;
+  uint16_t width, height;
+  /* Number of monitors (record_monitor_t) that follow the header */
+  uint32_t nummons;
+} record_header_t;
+
+typedef struct {
+  int16_t x, y;
+  uint16_t width, height;
+} record_monitor_t;
+
+typedef struct {
+  uint32_t win;
+  /* _NET_WM_WINDOW_TYPE of the window (XCB_NONE if not set) */
+  uint32_t type;
+  int16_t x, y;
+  uint16_t width, height, borderwidth;
+  uint8_t overrideredirect;
+  uint8_t pad;
+  /* Length of the WM_CLASS that follows */
+  uint32_t classlen;
+} record_window_t;
+
+typedef struct {
+  uint32_t win, frame;
+  /* Edge windows (indexed by window_edge_t - 1) */
+  uint32_t edges[8];
+} record_frame_t;
+
+/* A recorded window or atom and what it is replayed as */
+typedef struct {
+  uint32_t key, val;
+  /* Recorded client of frame and edge windows (0 if none), which
+   * are resolved through the client as they are created by the
+   * replaying window manager. The role is 0 for the frame and
+   * the window_edge_t of edge windows. */
+  uint32_t owner;
+  uint8_t role;
+  /* Whether the replay created a window standing in for the key */
+  bool standin;
+} xid_entry_t;
+
+/* Open addressing hash map of recorded XIDs (never 0) */
+typedef struct {
+  xid_entry_t* entries;
+  uint32_t cap, size;
+} xid_map_t;
+
+typedef struct {
+  FILE* file;
+  /* Display the recording is replayed on, which also holds the 
+   * windows standing in for recorded clients */
+  fake_x_t* fx;
+  xid_map_t wins, atoms;
+  /* Receives the replies of replayed IPC commands */
+  int32_t nullfd;
+  uint8_t* buf;
+  uint32_t bufcap;
+  /* Number of records of every kind and events of every type,
+   * and the time in µs and the X requests and round trips
+   * spent handling them */
+  uint64_t counts[RecordKindCount];
+  uint64_t evcounts[128], evtimes[128];
+  uint64_t evrequests[128], evroundtrips[128];
+  uint64_t ipctime, batchtime;
+} replay_t;
+
+static uint64_t monotonicus(void);
+static void writevarint(FILE* f, uint64_t val);
+static bool readvarint(FILE* f, uint64_t* val);
+static void beginrecord(recorder_t* r, record_kind_t kind, uint32_t len);
+static void recordatom(state_t* s, xcb_atom_t atom);
+static void recordwindow(state_t* s, xcb_window_t win);
+
+static xid_entry_t* xidfind(const xid_map_t* map, uint32_t key);
+static xid_entry_t* xidinsert(xid_map_t* map, uint32_t key);
+static bool readrecord(replay_t* rp, uint8_t* kind, uint64_t* delta, uint32_t* len);
+static fake_x_t* createdisplay(replay_t* rp, const record_header_t* header);
+static xcb_window_t livewin(replay_t* rp, state_t* s, xcb_window_t win);
+static xcb_atom_t liveatom(replay_t* rp, xcb_atom_t atom);
+static void translateevent(replay_t* rp, state_t* s, xcb_generic_event_t* ev);
+static void translatewin(replay_t* rp, state_t* s, uint8_t* data);
+static void replayevent(replay_t* rp, state_t* s, uint32_t len);
+static void replayipc(replay_t* rp, state_t* s, uint32_t len);
+static void replaybatch(replay_t* rp, state_t* s);
+static void addstandin(replay_t* rp, state_t* s, uint32_t len);
+static void addframe(replay_t* rp, uint32_t len);
+static void addatom(replay_t* rp, state_t* s, uint32_t len);
+static void sleepuntil(uint64_t us);
+static void printreport(const replay_t* rp, uint64_t elapsed, uint64_t recorded);
+
+uint64_t
+monotonicus(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+void
+writevarint(FILE* f, uint64_t val) {
+  uint8_t bytes[10];
+  uint32_t n = 0;
+  do {
+    bytes[n] = val & 0x7f;
+    val >>= 7;
+    if(val) bytes[n] |= 0x80;
+    n++;
+  } while(val);
+  fwrite(bytes, 1, n, f);
+}
+
+bool
+readvarint(FILE* f, uint64_t* val) {
+  *val = 0;
+  for(uint32_t shift = 0; shift < 64; shift += 7) {
+    int32_t c = fgetc(f);
+    if(c == EOF) return false;
+    *val |= (uint64_t)(c & 0x7f) << shift;
+    if(!(c & 0x80)) return true;
+  }
+  return false;
+}
+
+/* Writes the head of a record (the lock of the recorder is held) */
+void
+beginrecord(recorder_t* r, record_kind_t kind, uint32_t len) {
+  uint64_t now = monotonicus();
+  fputc(kind, r->file);
+  writevarint(r->file, now - r->last);
+  writevarint(r->file, len);
+  r->last = now;
+  r->pending = true;
+}
+
+/**
+ * @brief Starts recording the X events and IPC commands that the
+ * window manager receives to a file. A recording that the file
+ * already holds (e.g. before a restart in place) is continued.
+ *
+ * @param s The window manager's state
+ * @param path The path of the file to record to
+ *
+ * @return Whether the file could be opened
+ */
+bool
+startrecording(state_t* s, const char* path) {
+  recorder_t* r = &s->recorder;
+  FILE* f = fopen(path, "abe");
+  if(!f) {
+    logmsg(s, LogLevelError, "failed to open recording '%s': %s.", path, strerror(errno));
+    return false;
+  }
+  fseek(f, 0, SEEK_END);
+  if(ftell(f) == 0) {
+    record_header_t header = {
+      .magic = RECORD_MAGIC,
+      .version = RECORD_VERSION,
+      .root = s->root,
+      .width = s->screen->width_in_pixels,
+      .height = s->screen->height_in_pixels
+    };
+    for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
+      header.nummons++;
+    }
+    fwrite(&header, sizeof(header), 1, f);
+    // The replay lays out the clients on the same monitors
+    for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
+      record_monitor_t m = {
+        .x = mon->area.pos.x, .y = mon->area.pos.y,
+        .width = mon->area.size.x, .height = mon->area.size.y
+      };
+      fwrite(&m, sizeof(m), 1, f);
+    }
+  }
+  pthread_mutex_init(&r->lock, NULL);
+  r->last = r->lastflush = monotonicus();
+  r->pending = false;
+  // Set last, the IPC thread starts recording commands once it is set
+  r->file = f;
+  logmsg(s, LogLevelTrace, "recording to '%s'.", path);
+  return true;
+}
+
+/**
+ * @brief Stops recording and closes the file of the recording.
+ *
+ * @param s The window manager's state
+ */
+void
+stoprecording(state_t* s) {
+  recorder_t* r = &s->recorder;
+  if(!r->file) return;
+  pthread_mutex_lock(&r->lock);
+  fclose(r->file);
+  r->file = NULL;
+  pthread_mutex_unlock(&r->lock);
+  destroywinmap(&r->atoms);
+}
+
+/**
+ * @brief Writes everything that was recorded to the file.
+ *
+ * @param s The window manager's state
+ */
+void
+flushrecording(state_t* s) {
+  recorder_t* r = &s->recorder;
+  if(!r->file) return;
+  pthread_mutex_lock(&r->lock);
+  fflush(r->file);
+  pthread_mutex_unlock(&r->lock);
+}
+
+/* Records the name of an atom once, before the first event
+ * that refers to it (the lock of the recorder is held) */
+void
+recordatom(state_t* s, xcb_atom_t atom) {
+  recorder_t* r = &s->recorder;
+  // Predefined atoms are the same on every display
+  if(atom <= XCB_ATOM_WM_TRANSIENT_FOR || winmapget(&r->atoms, atom, NULL)) return;
+
+  xcb_get_atom_name_reply_t* reply = xcb_get_atom_name_reply(
+    s->con, xcb_get_atom_name(s->con, atom), NULL);
+  if(!reply) return;
+  winmapset(&r->atoms, atom, true);
+
+  uint32_t len = xcb_get_atom_name_name_length(reply);
+  beginrecord(r, RecordAtom, sizeof(atom) + len);
+  fwrite(&atom, sizeof(atom), 1, r->file);
+  fwrite(xcb_get_atom_name_name(reply), 1, len, r->file);
+  free(reply);
+}
+
+/* Records what a replay needs to create a window standing in for
+ * a window that requested to be mapped (the lock of the recorder is held) */
+void
+recordwindow(state_t* s, xcb_window_t win) {
+  xcb_get_geometry_cookie_t geomcookie = xcb_get_geometry(s->con, win);
+  xcb_get_window_attributes_cookie_t attrcookie = xcb_get_window_attributes(s->con, win);
+  xcb_get_property_cookie_t classcookie = xcb_get_property(
+    s->con, 0, win, XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 0, 256);
+  xcb_get_property_cookie_t typecookie = xcb_get_property(
+    s->con, 0, win, s->ewmh_atoms[EWMHwindowType], XCB_ATOM_ATOM, 0, 1);
+
+  xcb_get_geometry_reply_t* geom = xcb_get_geometry_reply(s->con, geomcookie, NULL);
+  xcb_get_window_attributes_reply_t* attr = xcb_get_window_attributes_reply(s->con, attrcookie, NULL);
+  xcb_get_property_reply_t* class = xcb_get_property_reply(s->con, classcookie, NULL);
+  xcb_get_property_reply_t* type = xcb_get_property_reply(s->con, typecookie, NULL);
+
+  // Windows that are already gone are replayed as no window at all
+  if(geom && attr) {
+    record_window_t rec = {
+      .win = win,
+      .x = geom->x, .y = geom->y,
+      .width = geom->width, .height = geom->height,
+      .borderwidth = geom->border_width,
+      .overrideredirect = attr->override_redirect,
+      .classlen = class ? xcb_get_property_value_length(class) : 0
+    };
+    if(type && xcb_get_property_value_length(type) >= (int32_t)sizeof(xcb_atom_t)) {
+      rec.type = *(xcb_atom_t*)xcb_get_property_value(type);
+      recordatom(s, rec.type);
+    }
+    beginrecord(&s->recorder, RecordWindow, sizeof(rec) + rec.classlen);
+    fwrite(&rec, sizeof(rec), 1, s->recorder.file);
+    if(rec.classlen) {
+      fwrite(xcb_get_property_value(class), 1, rec.classlen, s->recorder.file);
+    }
+  }
+  free(geom);
+  free(attr);
+  free(class);
+  free(type);
+}
+
+/**
+ * @brief Records an X event that was received before it is handled.
+ * Names of the atoms it refers to and windows it requests to map
+ * are recorded along with it.
+ *
+ * @param s The window manager's state
+ * @param ev The received event
+ */
+void
+recordevent(state_t* s, const xcb_generic_event_t* ev) {
+  recorder_t* r = &s->recorder;
+  pthread_mutex_lock(&r->lock);
+  switch(ev->response_type & ~0x80) {
+    case XCB_PROPERTY_NOTIFY:
+      recordatom(s, ((const xcb_property_notify_event_t*)ev)->atom);
+      break;
+    case XCB_CLIENT_MESSAGE: {
+      const xcb_client_message_event_t* msg = (const xcb_client_message_event_t*)ev;
+      recordatom(s, msg->type);
+      if(msg->type == s->ewmh_atoms[EWMHstate]) {
+        recordatom(s, msg->data.data32[1]);
+        recordatom(s, msg->data.data32[2]);
+      }
+      break;
+    }
+    case XCB_MAP_REQUEST:
+      recordwindow(s, ((const xcb_map_request_event_t*)ev)->window);
+      break;
+    default:
+      break;
+  }
+  beginrecord(r, RecordXEvent, RECORD_EVENT_SIZE);
+  fwrite(ev, RECORD_EVENT_SIZE, 1, r->file);
+  pthread_mutex_unlock(&r->lock);
+}
+
+/**
+ * @brief Records an IPC command that was received before it is handled.
+ *
+ * @param s The window manager's state
+ * @param cmdid The ID of the command
+ * @param data The data of the command
+ * @param len The length of the data
+ */
+void
+recordipc(state_t* s, uint8_t cmdid, const uint8_t* data, uint32_t len) {
+  recorder_t* r = &s->recorder;
+  pthread_mutex_lock(&r->lock);
+  if(r->file) {
+    beginrecord(r, RecordIpc, sizeof(cmdid) + len);
+    fputc(cmdid, r->file);
+    fwrite(data, 1, len, r->file);
+  }
+  pthread_mutex_unlock(&r->lock);
+}
+
+/**
+ * @brief Records that the event loop handled all queued events.
+ * The recording is written to its file at most once per interval.
+ *
+ * @param s The window manager's state
+ */
+void
+recordbatch(state_t* s) {
+  recorder_t* r = &s->recorder;
+  pthread_mutex_lock(&r->lock);
+  if(r->pending) {
+    beginrecord(r, RecordBatch, 0);
+    r->pending = false;
+    if(r->last - r->lastflush >= RECORD_FLUSH_INTERVAL_US) {
+      fflush(r->file);
+      r->lastflush = r->last;
+    }
+  }
+  pthread_mutex_unlock(&r->lock);
+}
+
+/**
+ * @brief Records the windows the window manager created for a new
+ * client so that events on them can be replayed.
+ *
+ * @param s The window manager's state
+ * @param cl The new client
+ */
+void
+recordclient(state_t* s, client_t* cl) {
+  recorder_t* r = &s->recorder;
+  record_frame_t rec = { .win = cl->win, .frame = cl->frame };
+  for(uint32_t i = 1; i <= 8; i++) {
+    rec.edges[i - 1] = cl->props->edges[i].win;
+  }
+  pthread_mutex_lock(&r->lock);
+  beginrecord(r, RecordFrame, sizeof(rec));
+  fwrite(&rec, sizeof(rec), 1, r->file);
+  pthread_mutex_unlock(&r->lock);
+}
+
+xid_entry_t*
+xidfind(const xid_map_t* map, uint32_t key) {
+  if(!map->cap) return NULL;
+  uint32_t mask = map->cap - 1;
+  for(uint32_t i = (key * 2654435761u) & mask;; i = (i + 1) & mask) {
+    if(map->entries[i].key == key) return &map->entries[i];
+    if(map->entries[i].key == 0) return NULL;
+  }
+}
+
+/* Returns the entry of a key, adding an empty one if there is none */
+xid_entry_t*
+xidinsert(xid_map_t* map, uint32_t key) {
+  xid_entry_t* found = xidfind(map, key);
+  if(found) return found;
+
+  // Grow at half load so that probes stay short
+  if((map->size + 1) * 2 > map->cap) {
+    xid_map_t grown = { .cap = map->cap ? map->cap * 2 : 64 };
+    grown.entries = calloc(grown.cap, sizeof(*grown.entries));
+    for(uint32_t i = 0; i < map->cap; i++) {
+      if(map->entries[i].key) {
+        *xidinsert(&grown, map->entries[i].key) = map->entries[i];
+      }
+    }
+    free(map->entries);
+    map->entries = grown.entries;
+    map->cap = grown.cap;
+  }
+
+  uint32_t mask = map->cap - 1;
+  uint32_t i = (key * 2654435761u) & mask;
+  while(map->entries[i].key) {
+    i = (i + 1) & mask;
+  }
+  map->entries[i] = (xid_entry_t){ .key = key };
+  map->size++;
+  return &map->entries[i];
+}
+
+/* Reads the next record into the buffer of the replay */
+bool
+readrecord(replay_t* rp, uint8_t* kind, uint64_t* delta, uint32_t* len) {
+  int32_t c = fgetc(rp->file);
+  if(c == EOF) return false;
+  uint64_t size;
+  if(!readvarint(rp->file, delta) || !readvarint(rp->file, &size) ||
+    size > RECORD_MAX_SIZE) {
+    return false;
+  }
+  if(size > rp->bufcap) {
+    uint8_t* buf = realloc(rp->buf, size);
+    if(!buf) return false;
+    rp->buf = buf;
+    rp->bufcap = size;
+  }
+  if(size && fread(rp->buf, 1, size, rp->file) != size) {
+    return false;
+  }
+  *kind = c;
+  *len = size;
+  return true;
+}
+
+/* Creates the display a recording is replayed on from the size 
+ * of the recorded root window and its monitors */
+fake_x_t*
+createdisplay(replay_t* rp, const record_header_t* header) {
+  fake_x_t* fx = fakexcreate((area_t){
+    .size = (v2_t){ MAX(header->width, 1), MAX(header->height, 1) }
+  });
+  if(!fx) return NULL;
+  for(uint32_t i = 0; i < header->nummons; i++) {
+    record_monitor_t m;
+    if(fread(&m, sizeof(m), 1, rp->file) != 1) {
+      fakexdestroy(fx);
+      return NULL;
+    }
+    fakexaddmonitor(fx, (area_t){
+      .pos = (v2_t){ m.x, m.y }, .size = (v2_t){ m.width, m.height }
+    });
+  }
+  return fx;
+}
+
+/* Returns the window a recorded window is replayed as (XCB_NONE if unknown) */
+xcb_window_t
+livewin(replay_t* rp, state_t* s, xcb_window_t win) {
+  if(win == XCB_NONE) return XCB_NONE;
+  xid_entry_t* entry = xidfind(&rp->wins, win);
+  if(!entry) return XCB_NONE;
+  if(!entry->owner) return entry->val;
+
+  client_t* cl = clientfromwin(s, livewin(rp, s, entry->owner));
+  if(!cl) return XCB_NONE;
+  return entry->role == 0 ? cl->frame : cl->props->edges[entry->role].win;
+}
+
+/* Returns the atom a recorded atom is replayed as (XCB_NONE if unknown) */
+xcb_atom_t
+liveatom(replay_t* rp, xcb_atom_t atom) {
+  if(atom <= XCB_ATOM_WM_TRANSIENT_FOR) return atom;
+  xid_entry_t* entry = xidfind(&rp->atoms, atom);
+  return entry ? entry->val : XCB_NONE;
+}
+
+/* Replaces the windows and atoms of a recorded event with
+ * the ones they are replayed as */
+void
+translateevent(replay_t* rp, state_t* s, xcb_generic_event_t* ev) {
+  switch(ev->response_type & ~0x80) {
+    case XCB_MAP_REQUEST: {
+      xcb_map_request_event_t* e = (xcb_map_request_event_t*)ev;
+      e->parent = livewin(rp, s, e->parent);
+      e->window = livewin(rp, s, e->window);
+      break;
+    }
+    // Map and destroy notifies share the layout of unmap notifies
+    case XCB_UNMAP_NOTIFY:
+    case XCB_MAP_NOTIFY:
+    case XCB_DESTROY_NOTIFY: {
+      xcb_unmap_notify_event_t* e = (xcb_unmap_notify_event_t*)ev;
+      e->event = livewin(rp, s, e->event);
+      e->window = livewin(rp, s, e->window);
+      break;
+    }
+    // Input and crossing events share the layout of key presses
+    case XCB_KEY_PRESS:
+    case XCB_KEY_RELEASE:
+    case XCB_BUTTON_PRESS:
+    case XCB_BUTTON_RELEASE:
+    case XCB_MOTION_NOTIFY:
+    case XCB_ENTER_NOTIFY:
+    case XCB_LEAVE_NOTIFY: {
+      xcb_key_press_event_t* e = (xcb_key_press_event_t*)ev;
+      e->root = livewin(rp, s, e->root);
+      e->event = livewin(rp, s, e->event);
+      e->child = livewin(rp, s, e->child);
+      break;
+    }
+    case XCB_CONFIGURE_REQUEST: {
+      xcb_configure_request_event_t* e = (xcb_configure_request_event_t*)ev;
+      e->parent = livewin(rp, s, e->parent);
+      e->window = livewin(rp, s, e->window);
+      e->sibling = livewin(rp, s, e->sibling);
+      break;
+    }
+    case XCB_CONFIGURE_NOTIFY: {
+      xcb_configure_notify_event_t* e = (xcb_configure_notify_event_t*)ev;
+      e->event = livewin(rp, s, e->event);
+      e->window = livewin(rp, s, e->window);
+      e->above_sibling = livewin(rp, s, e->above_sibling);
+      break;
+    }
+    case XCB_PROPERTY_NOTIFY: {
+      xcb_property_notify_event_t* e = (xcb_property_notify_event_t*)ev;
+      e->window = livewin(rp, s, e->window);
+      e->atom = liveatom(rp, e->atom);
+      break;
+    }
+    case XCB_CLIENT_MESSAGE: {
+      xcb_client_message_event_t* e = (xcb_client_message_event_t*)ev;
+      e->window = livewin(rp, s, e->window);
+      e->type = liveatom(rp, e->type);
+      if(e->type == s->ewmh_atoms[EWMHstate]) {
+        e->data.data32[1] = liveatom(rp, e->data.data32[1]);
+        e->data.data32[2] = liveatom(rp, e->data.data32[2]);
+      }
+      break;
+    }
+    case XCB_FOCUS_IN: {
+      xcb_focus_in_event_t* e = (xcb_focus_in_event_t*)ev;
+      e->event = livewin(rp, s, e->event);
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+/* Replaces the recorded window at the start of IPC data */
+void
+translatewin(replay_t* rp, state_t* s, uint8_t* data) {
+  RgWindow win;
+  memcpy(&win, data, sizeof(win));
+  win = (RgWindow)livewin(rp, s, (xcb_window_t)win);
+  memcpy(data, &win, sizeof(win));
+}
+
+void
+replayevent(replay_t* rp, state_t* s, uint32_t len) {
+  if(len != RECORD_EVENT_SIZE) return;
+  xcb_generic_event_t ev = {0};
+  memcpy(&ev, rp->buf, RECORD_EVENT_SIZE);
+  uint8_t evcode = ev.response_type & ~0x80;
+
+  /* A window that was destroyed is gone before its destroy notify is 
+   * handled. The stand-ins are the clients' windows, so their requests 
+   * go to the display directly instead of being counted as the window 
+   * manager's. */
+  if(evcode == XCB_DESTROY_NOTIFY) {
+    xid_entry_t* entry = xidfind(&rp->wins, ((xcb_destroy_notify_event_t*)&ev)->window);
+    if(entry && entry->standin) {
+      fakexbackend.destroywindow(rp->fx, entry->val);
+      entry->standin = false;
+    }
+  }
+  // The pointer is where it was when the input event was recorded
+  if(evcode >= XCB_KEY_PRESS && evcode <= XCB_LEAVE_NOTIFY) {
+    xcb_key_press_event_t* e = (xcb_key_press_event_t*)&ev;
+    fakexsetpointer(rp->fx, (v2_t){ e->root_x, e->root_y });
+  }
+  translateevent(rp, s, &ev);
+
+  x_stats_t stats = s->xstats;
+  uint64_t start = monotonicus();
+  dispatchevent(s, &ev);
+  rp->evtimes[evcode] += monotonicus() - start;
+  rp->evrequests[evcode] += s->xstats.requests - stats.requests;
+  rp->evroundtrips[evcode] += s->xstats.roundtrips - stats.roundtrips;
+  rp->evcounts[evcode]++;
+}
+
+void
+replayipc(replay_t* rp, state_t* s, uint32_t len) {
+  if(!len) return;
+  uint8_t cmdid = rp->buf[0];
+  uint8_t* data = rp->buf + 1;
+  len--;
+
+  // Windows given to commands are replayed as the windows standing in for them
+  switch(cmdid) {
+    // The replay ends with the recording, not with the session
+    case RgCommandTerminate:
+    case RgCommandRestart:
+      return;
+    case RgCommandKillWindow:
+    case RgCommandFocusWindow:
+    case RgCommandNextWindow:
+    case RgCommandGetWindowArea:
+      if(len >= sizeof(RgWindow)) {
+        translatewin(rp, s, data);
+      }
+      break;
+    case RgCommandUpdateWindows:
+      for(uint32_t i = 0; i + sizeof(RgWindowUpdate) <= len; i += sizeof(RgWindowUpdate)) {
+        translatewin(rp, s, data + i + offsetof(RgWindowUpdate, win));
+      }
+      break;
+    default:
+      break;
+  }
+
+  uint64_t start = monotonicus();
+  handlecmd(s, cmdid, data, len, rp->nullfd);
+  rp->ipctime += monotonicus() - start;
+}
+
+/* Does the work the event loop does once it handled all queued events */
+void
+replaybatch(replay_t* rp, state_t* s) {
+  uint64_t start = monotonicus();
+
+  if(s->monsdirty) {
+    s->monsdirty = false;
+    updatemons(s);
+  }
+  struct pollfd fd = {
+    .fd = s->propfetcher.con ? s->propfetcher.eventfd : -1,
+    .events = POLLIN
+  };
+  if(poll(&fd, 1, 0) > 0 && (fd.revents & POLLIN)) {
+    handlepropresults(s);
+  }
+  handletimers(s);
+  xflush(s);
+
+  rp->batchtime += monotonicus() - start;
+}
+
+/* Creates a window that stands in for a recorded window */
+void
+addstandin(replay_t* rp, state_t* s, uint32_t len) {
+  record_window_t rec;
+  if(len < sizeof(rec)) return;
+  memcpy(&rec, rp->buf, sizeof(rec));
+  if(len < sizeof(rec) + rec.classlen) return;
+
+  // A window that is mapped again keeps its stand-in
+  xid_entry_t* entry = xidinsert(&rp->wins, rec.win);
+  if(entry->standin) return;
+
+  xcb_window_t win = fakexcreatewindow(rp->fx, s->root, (area_t){
+    .pos = (v2_t){ rec.x, rec.y },
+    .size = (v2_t){ MAX(rec.width, 1), MAX(rec.height, 1) }
+  }, rec.overrideredirect);
+  if(win == XCB_NONE) return;
+  uint32_t borderwidth = rec.borderwidth;
+  fakexbackend.configurewindow(rp->fx, win, XCB_CONFIG_WINDOW_BORDER_WIDTH, &borderwidth);
+  if(rec.classlen) {
+    fakexbackend.changeproperty(rp->fx, XCB_PROP_MODE_REPLACE, win, XCB_ATOM_WM_CLASS,
+                                XCB_ATOM_STRING, 8, rec.classlen, rp->buf + sizeof(rec));
+  }
+  xcb_atom_t type = liveatom(rp, rec.type);
+  if(type != XCB_NONE) {
+    fakexbackend.changeproperty(rp->fx, XCB_PROP_MODE_REPLACE, win, s->ewmh_atoms[EWMHwindowType],
+                                XCB_ATOM_ATOM, 32, 1, &type);
+  }
+
+  *entry = (xid_entry_t){ .key = rec.win, .val = win, .standin = true };
+}
+
+void
+addframe(replay_t* rp, uint32_t len) {
+  record_frame_t rec;
+  if(len != sizeof(rec)) return;
+  memcpy(&rec, rp->buf, sizeof(rec));
+
+  *xidinsert(&rp->wins, rec.frame) = (xid_entry_t){ .key = rec.frame, .owner = rec.win };
+  for(uint32_t i = 0; i < 8; i++) {
+    if(!rec.edges[i]) continue;
+    *xidinsert(&rp->wins, rec.edges[i]) = (xid_entry_t){
+      .key = rec.edges[i], .owner = rec.win, .role = i + 1 };
+  }
+}
+
+void
+addatom(replay_t* rp, state_t* s, uint32_t len) {
+  xcb_atom_t atom;
+  if(len <= sizeof(atom)) return;
+  memcpy(&atom, rp->buf, sizeof(atom));
+
+  xcb_intern_atom_reply_t* reply = xinternatom(s, 0, len - sizeof(atom), 
+                                               (const char*)rp->buf + sizeof(atom));
+  if(!reply) return;
+  xidinsert(&rp->atoms, atom)->val = reply->atom;
+  free(reply);
+}
+
+void
+sleepuntil(uint64_t us) {
+  struct timespec ts = {
+    .tv_sec = us / 1000000,
+    .tv_nsec = (us % 1000000) * 1000
+  };
+  while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+}
+
+/* Prints how long handling the records of the replay took */
+void
+printreport(const replay_t* rp, uint64_t elapsed, uint64_t recorded) {
+  printf("ragnar: replayed %llu events, %llu IPC commands and %llu batches "
+         "in %.1f ms (recorded over %.1f ms)\n",
+         (unsigned long long)rp->counts[RecordXEvent],
+         (unsigned long long)rp->counts[RecordIpc],
+         (unsigned long long)rp->counts[RecordBatch],
+         elapsed / 1000.0, recorded / 1000.0);
+  for(uint32_t i = 0; i < ARRLEN(rp->evcounts); i++) {
+    if(!rp->evcounts[i]) continue;
+    const char* label = xcb_event_get_label(i);
+    char name[32];
+    if(!label) {
+      snprintf(name, sizeof(name), "event %u", i);
+      label = name;
+    }
+    printf("  %-24s %8llu %12.1f ms %10.1f us each %8.1f requests %6.1f round trips\n", label,
+           (unsigned long long)rp->evcounts[i], rp->evtimes[i] / 1000.0,
+           (double)rp->evtimes[i] / rp->evcounts[i],
+           (double)rp->evrequests[i] / rp->evcounts[i],
+           (double)rp->evroundtrips[i] / rp->evcounts[i]);
+  }
+  if(rp->counts[RecordIpc]) {
+    printf("  %-24s %8llu %12.1f ms\n", "IPC commands",
+           (unsigned long long)rp->counts[RecordIpc], rp->ipctime / 1000.0);
+  }
+  printf("  %-24s %8llu %12.1f ms\n", "end of batch",
+         (unsigned long long)rp->counts[RecordBatch], rp->batchtime / 1000.0);
+}
+
+/**
+ * @brief Sets up the window manager on an in-process display (see 
+ * fakex.h) with the size and monitors of the recorded one and replays 
+ * a recording by handling its events and IPC commands like the event 
+ * loop would. Recorded clients are replayed by windows that stand in 
+ * for them on that display, so no X server is needed. Prints the time, 
+ * X requests and round trips spent on every kind of event once done. 
+ * The display lives until the window manager terminates.
+ *
+ * @param s The window manager's state
+ * @param path The path of the recording
+ * @param realtime Whether the records are replayed at the pace
+ * they were recorded at instead of as fast as possible
+ *
+ * @return The exit code of the replay
+ */
+int32_t
+replay(state_t* s, const char* path, bool realtime) {
+  replay_t rp = { .nullfd = -1 };
+  rp.file = fopen(path, "rbe");
+  if(!rp.file) {
+    logmsg(s, LogLevelError, "failed to open recording '%s': %s.", path, strerror(errno));
+    return EXIT_FAILURE;
+  }
+  record_header_t header;
+  if(fread(&header, sizeof(header), 1, rp.file) != 1 ||
+    header.magic != RECORD_MAGIC || header.version != RECORD_VERSION) {
+    logmsg(s, LogLevelError, "'%s' is not a recording of this version of ragnar.", path);
+    fclose(rp.file);
+    return EXIT_FAILURE;
+  }
+  rp.fx = createdisplay(&rp, &header);
+  if(!rp.fx) {
+    logmsg(s, LogLevelError, "replay: cannot create the display of '%s'.", path);
+    fclose(rp.file);
+    return EXIT_FAILURE;
+  }
+  fakexuse(s, rp.fx);
+  setup(s);
+
+  rp.nullfd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+  *xidinsert(&rp.wins, header.root) = (xid_entry_t){ .key = header.root, .val = s->root };
+
+  logmsg(s, LogLevelTrace, "replaying '%s'%s.", path, realtime ? " in real time" : "");
+  uint64_t start = monotonicus();
+  uint64_t recorded = 0;
+  uint8_t kind;
+  uint64_t delta;
+  uint32_t len;
+  while(readrecord(&rp, &kind, &delta, &len)) {
+    recorded += delta;
+    if(realtime) {
+      sleepuntil(start + recorded);
+    }
+    if(kind >= RecordKindCount) {
+      logmsg(s, LogLevelWarn, "replay: skipping record of unknown kind %i.", kind);
+      continue;
+    }
+    rp.counts[kind]++;
+    switch((record_kind_t)kind) {
+      case RecordXEvent:  replayevent(&rp, s, len); break;
+      case RecordIpc:     replayipc(&rp, s, len); break;
+      case RecordBatch:   replaybatch(&rp, s); break;
+      case RecordWindow:  addstandin(&rp, s, len); break;
+      case RecordFrame:   addframe(&rp, len); break;
+      case RecordAtom:    addatom(&rp, s, len); break;
+      default: break;
+    }
+  }
+  // A recording that was cut off does not end with a batch
+  replaybatch(&rp, s);
+  printreport(&rp, monotonicus() - start, recorded);
+
+  if(rp.nullfd != -1) {
+    close(rp.nullfd);
+  }
+  free(rp.wins.entries);
+  free(rp.atoms.entries);
+  free(rp.buf);
+  fclose(rp.file);
+  return EXIT_SUCCESS;
+}
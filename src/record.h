@@ -0,0 +1,12 @@
+#pragma once
+
+#include "structs.h"
+
+bool startrecording(state_t* s, const char* path);
+void stoprecording(state_t* s);
+void flushrecording(state_t* s);
+void recordevent(state_t* s, const xcb_generic_event_t* ev);
+void recordipc(state_t* s, uint8_t cmdid, const uint8_t* data, uint32_t len);
+void recordbatch(state_t* s);
+void recordclient(state_t* s, client_t* cl);
+int32_t replay(state_t* s, const char* path, bool realtime);
@@ -0,0 +1,103 @@
+#include "resources.h"
+#include "funcs.h"
+
+static const char* resourcenames[XResourceCount] = {
+  [XResourceWindow]   = "windows",
+  [XResourceCursor]   = "cursors",
+  [XResourceColormap] = "colormaps",
+  [XResourceAlarm]    = "alarms",
+  [XResourceGrab]     = "grabs",
+};
+
+static uint64_t winmapbytes(const window_map_t* map);
+
+/**
+ * @brief Counts server-side resources the window manager created 
+ * (n > 0) or freed (n < 0), either for a client or globally.
+ *
+ * @param s The window manager's state
+ * @param cl The client the resources are held for (NULL if global)
+ * @param kind The kind of the resources
+ * @param n The number of resources created or freed
+ */
+void
+trackresource(state_t* s, client_t* cl, x_resource_kind_t kind, int32_t n) {
+  if(n > 0) {
+    s->resources.created[kind] += n;
+  } else {
+    s->resources.freed[kind] += -n;
+  }
+  if(!cl) return;
+  uint32_t* held = &cl->props->resources[kind];
+  if(n < 0 && (uint32_t)-n > *held) {
+    logmsg(s, LogLevelWarn, "client %i freed %i %s but only held %u.", 
+           cl->win, -n, resourcenames[kind], *held);
+    *held = 0;
+    return;
+  }
+  *held += n;
+}
+
+/**
+ * @brief Checks that every resource created for a client was freed 
+ * by the time it is released and counts the ones that were not as 
+ * leaked (they stay allocated until the window manager exits).
+ *
+ * @param s The window manager's state
+ * @param cl The client that is released
+ */
+void
+checkclientresources(state_t* s, client_t* cl) {
+  for(uint32_t i = 0; i < XResourceCount; i++) {
+    uint32_t held = cl->props->resources[i];
+    if(!held) continue;
+    logmsg(s, LogLevelWarn, "client %i leaked %u %s.", cl->win, held, resourcenames[i]);
+    s->resources.leaked[i] += held;
+    cl->props->resources[i] = 0;
+  }
+}
+
+uint64_t
+winmapbytes(const window_map_t* map) {
+  return (uint64_t)map->cap * (sizeof(*map->keys) + sizeof(*map->vals));
+}
+
+/**
+ * @brief Sums up the heap memory held by the window manager's own 
+ * data structures. Allocations of libraries (xcb, libconfig) are 
+ * not included.
+ *
+ * @param s The window manager's state
+ *
+ * @return The heap usage by what the memory holds 
+ */
+heap_usage_t
+heapusage(const state_t* s) {
+  heap_usage_t usage = {0};
+  usage.clients = (uint64_t)s->clientpool.numslabs * sizeof(client_slab_t);
+  usage.strings = s->strpool.bytes;
+
+  uint32_t maxdesktops = s->config.maxdesktops;
+  for(const monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
+    usage.monitors += sizeof(*mon) + (uint64_t)maxdesktops * 
+      (sizeof(*mon->activedesktops) + sizeof(*mon->layouts) + sizeof(*mon->clients));
+    for(uint32_t i = 0; i < maxdesktops; i++) {
+      usage.monitors += (uint64_t)mon->clients[i].cap * sizeof(*mon->clients[i].items);
+    }
+  }
+
+  usage.winmaps = winmapbytes(&s->popups) + winmapbytes(&s->winkinds) + 
+    winmapbytes(&s->recorder.atoms);
+
+  uint32_t numrules = s->config.numrules;
+  usage.rules = (uint64_t)numrules * sizeof(*s->config.rules);
+  if(s->rules.buckets) {
+    usage.rules += (uint64_t)s->rules.numbuckets * sizeof(*s->rules.buckets) + 
+      (uint64_t)numrules * (sizeof(*s->rules.next) + sizeof(*s->rules.types));
+  }
+
+  usage.other = (uint64_t)s->config.maxstruts * sizeof(*s->winstruts) + 
+    (uint64_t)s->config.maxscratchpads * sizeof(*s->scratchpads) + 
+    (uint64_t)s->dirtytitles.cap * sizeof(*s->dirtytitles.items);
+  return usage;
+}
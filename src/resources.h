@@ -0,0 +1,7 @@
+#pragma once
+
+#include "structs.h"
+
+void trackresource(state_t* s, client_t* cl, x_resource_kind_t kind, int32_t n);
+void checkclientresources(state_t* s, client_t* cl);
+heap_usage_t heapusage(const state_t* s);
@@ -0,0 +1,552 @@
+#include "restart.h"
+#include "funcs.h"
+#include "pool.h"
+#include "winmap.h"
+#include "propfetch.h"
+#include "record.h"
+#include "resources.h"
+#include "tabbar.h"
+#include "xbackend.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <xcb/xcb_util.h>
+#include <xcb/sync.h>
+
+/* Version of the state that an in-place restart leaves on the root
+ * window. A state of another version is ignored. */
+#define RESTART_STATE_VERSION 1
+
+typedef enum {
+  RestartFullscreen     = 1 << 0,
+  RestartFloating       = 1 << 1,
+  RestartFixed          = 1 << 2,
+  RestartHidden         = 1 << 3,
+  RestartScratchpad     = 1 << 4,
+  RestartUrgent         = 1 << 5,
+  RestartDecorated      = 1 << 6,
+  RestartNeverFocus     = 1 << 7,
+  RestartEdgeWindows    = 1 << 8,
+  RestartParked         = 1 << 9,
+  RestartStacked        = 1 << 10,
+  RestartFloatingPrev   = 1 << 11,
+} restart_client_flag_t;
+
+typedef enum {
+  RestartScratchpadHidden       = 1 << 0,
+  RestartScratchpadNeedsRestart = 1 << 1,
+  RestartScratchpadPending      = 1 << 2,
+} restart_scratchpad_flag_t;
+
+/* The state is stored as a format 32 property, so every
+ * record only consists of 32-bit fields. It is laid out as
+ * the header, every monitor followed by its desktops, every
+ * client and every scratchpad. */
+typedef struct {
+  uint32_t version;
+  uint32_t nummons, numdesktops, numclients, numscratchpads;
+  xcb_window_t focus;
+  uint32_t monfocus;
+  /* Colormap of the frames if the old process created it (XCB_NONE otherwise) */
+  xcb_colormap_t framecolormap;
+  xcb_visualid_t framevisual;
+  /* Windows of the old process that are not adopted */
+  xcb_window_t wmcheck, outline[4];
+} restart_header_t;
+
+typedef struct {
+  uint32_t idx, curdesktop;
+} restart_mon_t;
+
+typedef struct {
+  uint32_t init;
+  uint32_t nmaster;
+  float masterarea;
+  int32_t gapsize;
+  uint32_t curlayout;
+  uint32_t mastermaxed;
+  xcb_window_t active;
+} restart_desktop_t;
+
+typedef struct {
+  xcb_window_t win, frame;
+  uint32_t mon, desktop;
+  /* restart_client_flag_t */
+  uint32_t flags;
+  area_t area, areaprev;
+  uint32_t borderwidth;
+  float layoutsizeadd;
+  int32_t scratchpad;
+  xcb_sync_alarm_t syncalarm;
+  xcb_window_t edges[8];
+} restart_client_t;
+
+typedef struct {
+  xcb_window_t win;
+  int32_t pid;
+  /* restart_scratchpad_flag_t */
+  uint32_t flags;
+} restart_scratchpad_t;
+
+static xcb_window_t wmcheckwin(state_t* s);
+static bool saverestartstate(state_t* s);
+static client_t* adoptclient(state_t* s, const restart_client_t* rec);
+
+xcb_window_t
+wmcheckwin(state_t* s) {
+  xcb_window_t win = XCB_NONE;
+  xcb_get_property_reply_t* reply = xgetproperty(s, 0, s->root, s->ewmh_atoms[EWMHcheck], 
+                                                 XCB_ATOM_WINDOW, 0, 1);
+  if(reply) {
+    if(reply->format == 32 && xcb_get_property_value_length(reply) >= 4) {
+      win = *(xcb_window_t*)xcb_get_property_value(reply);
+    }
+    free(reply);
+  }
+  return win;
+}
+
+bool
+saverestartstate(state_t* s) {
+  uint32_t nummons = 0, numclients = 0;
+  for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
+    nummons++;
+    for(uint32_t i = 0; i < s->config.maxdesktops; i++) {
+      numclients += mon->clients[i].size;
+    }
+  }
+
+  size_t size = sizeof(restart_header_t) +
+    nummons * (sizeof(restart_mon_t) + s->config.maxdesktops * sizeof(restart_desktop_t)) +
+    numclients * sizeof(restart_client_t) +
+    s->config.maxscratchpads * sizeof(restart_scratchpad_t);
+  uint8_t* buf = calloc(1, size);
+  if(!buf) {
+    logmsg(s, LogLevelError, "failed to allocate the restart state.");
+    return false;
+  }
+  uint8_t* ptr = buf;
+
+  restart_header_t hdr = {
+    .version        = RESTART_STATE_VERSION,
+    .nummons        = nummons,
+    .numdesktops    = s->config.maxdesktops,
+    .numclients     = numclients,
+    .numscratchpads = s->config.maxscratchpads,
+    .focus          = s->focus ? s->focus->win : XCB_NONE,
+    .monfocus       = s->monfocus ? s->monfocus->idx : 0,
+    .framecolormap  = s->ownsframecolormap ? s->framecolormap : XCB_NONE,
+    .framevisual    = s->framevisual,
+    .wmcheck        = wmcheckwin(s),
+  };
+  memcpy(hdr.outline, s->outline, sizeof(hdr.outline));
+  memcpy(ptr, &hdr, sizeof(hdr));
+  ptr += sizeof(hdr);
+
+  for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
+    restart_mon_t m = {
+      .idx = mon->idx,
+      .curdesktop = mondesktop(s, mon)->idx
+    };
+    memcpy(ptr, &m, sizeof(m));
+    ptr += sizeof(m);
+    for(uint32_t i = 0; i < s->config.maxdesktops; i++) {
+      layout_props_t* layout = &mon->layouts[i];
+      restart_desktop_t d = {
+        .init         = mon->activedesktops[i].init,
+        .nmaster      = layout->nmaster,
+        .masterarea   = layout->masterarea,
+        .gapsize      = layout->gapsize,
+        .curlayout    = layout->curlayout,
+        .mastermaxed  = layout->mastermaxed,
+        .active       = layout->active ? layout->active->win : XCB_NONE,
+      };
+      memcpy(ptr, &d, sizeof(d));
+      ptr += sizeof(d);
+    }
+  }
+
+  for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
+    for(uint32_t i = 0; i < s->config.maxdesktops; i++) {
+      for(uint32_t j = 0; j < mon->clients[i].size; j++) {
+        client_t* cl = mon->clients[i].items[j];
+        restart_client_t c = {
+          .win          = cl->win,
+          .frame        = cl->frame,
+          .mon          = mon->idx,
+          .desktop      = cl->desktop,
+          .flags        =
+            (cl->fullscreen           ? RestartFullscreen   : 0) |
+            (cl->floating             ? RestartFloating     : 0) |
+            (cl->fixed                ? RestartFixed        : 0) |
+            (cl->hidden               ? RestartHidden       : 0) |
+            (cl->is_scratchpad        ? RestartScratchpad   : 0) |
+            (cl->urgent               ? RestartUrgent       : 0) |
+            (cl->decorated            ? RestartDecorated    : 0) |
+            (cl->neverfocus           ? RestartNeverFocus   : 0) |
+            (cl->showedgewindows      ? RestartEdgeWindows  : 0) |
+            (cl->parked               ? RestartParked       : 0) |
+            (cl->stacked              ? RestartStacked      : 0) |
+            (cl->props->floating_prev ? RestartFloatingPrev : 0),
+          .area         = cl->area,
+          .areaprev     = cl->props->area_prev,
+          .borderwidth  = cl->borderwidth,
+          .layoutsizeadd = cl->layoutsizeadd,
+          .scratchpad   = cl->scratchpad_index,
+          .syncalarm    = cl->props->syncalarm,
+        };
+        for(uint32_t e = 0; e < 8; e++) {
+          c.edges[e] = cl->props->edges[e + 1].win;
+        }
+        memcpy(ptr, &c, sizeof(c));
+        ptr += sizeof(c);
+      }
+    }
+  }
+
+  for(uint32_t i = 0; i < s->config.maxscratchpads; i++) {
+    scratchpad_t* sp = &s->scratchpads[i];
+    restart_scratchpad_t r = {
+      .win = sp->win,
+      .pid = sp->pid,
+      .flags =
+        (sp->hidden        ? RestartScratchpadHidden       : 0) |
+        (sp->needs_restart ? RestartScratchpadNeedsRestart : 0) |
+        (sp->pending       ? RestartScratchpadPending      : 0),
+    };
+    memcpy(ptr, &r, sizeof(r));
+    ptr += sizeof(r);
+  }
+
+  xcb_atom_t atom = s->wm_atoms[WMrestartState];
+  xchangeproperty(s, XCB_PROP_MODE_REPLACE, s->root, atom, atom, 32, size / 4, buf);
+  free(buf);
+
+  logmsg(s, LogLevelTrace, "saved the state of %i clients for the restart (%i bytes).",
+         numclients, (int32_t)size);
+  return true;
+}
+
+client_t*
+adoptclient(state_t* s, const restart_client_t* rec) {
+  monitor_t* mon = monbyidx(s, rec->mon);
+  // Clients of monitors that are gone end up on the focused monitor
+  if(!mon) mon = s->monfocus ? s->monfocus : s->monitors;
+  if(!mon) return NULL;
+
+  client_t* cl = poolallocclient(&s->clientpool);
+  if(!cl) {
+    logmsg(s, LogLevelError, "failed to allocate client for window %i.", rec->win);
+    return NULL;
+  }
+  cl->win = rec->win;
+  cl->frame = rec->frame;
+  // The adopted frame is destroyed by this process when the client is unframed
+  trackresource(s, cl, XResourceWindow, 1);
+  cl->area = rec->area;
+  cl->borderwidth = rec->borderwidth;
+  cl->layoutsizeadd = rec->layoutsizeadd;
+  cl->fullscreen = rec->flags & RestartFullscreen;
+  cl->floating = rec->flags & RestartFloating;
+  cl->hidden = rec->flags & RestartHidden;
+  cl->urgent = rec->flags & RestartUrgent;
+  cl->decorated = rec->flags & RestartDecorated;
+  cl->neverfocus = rec->flags & RestartNeverFocus;
+  cl->showedgewindows = rec->flags & RestartEdgeWindows;
+  cl->parked = rec->flags & RestartParked;
+  cl->stacked = rec->flags & RestartStacked;
+  cl->props->area_prev = rec->areaprev;
+  cl->props->floating_prev = rec->flags & RestartFloatingPrev;
+  // The scratchpads of the new config may be fewer
+  if(rec->scratchpad >= 0 && (uint32_t)rec->scratchpad < s->config.maxscratchpads) {
+    cl->scratchpad_index = rec->scratchpad;
+    cl->is_scratchpad = rec->flags & RestartScratchpad;
+  } else {
+    cl->scratchpad_index = -1;
+  }
+  cl->desktop = rec->desktop < s->config.maxdesktops ?
+    rec->desktop : mondesktop(s, mon)->idx;
+
+  // Event selections and grabs belonged to the old connection
+  selectclientinput(s, cl);
+  selectframeinput(s, cl->frame);
+  winmapset(&s->winkinds, cl->frame, WindowKindOwn);
+
+  if(rec->syncalarm && s->hassync) {
+    xdestroyalarm(s, rec->syncalarm);
+  }
+  setupclientsync(s, cl);
+  updatesizehints(s, cl);
+  cl->fixed = cl->fixed || (rec->flags & RestartFixed);
+
+  monaddclient(mon, cl);
+  fetchclientprops(s, cl, PropFetchName | PropFetchHints);
+
+  // The edge windows are input only, so replacing them is not visible
+  for(uint32_t e = 0; e < 8; e++) {
+    if(rec->edges[e]) xdestroywindow(s, rec->edges[e]);
+  }
+  createwindowedges(s, cl);
+  updateedgewindows(s, cl);
+  if(!cl->showedgewindows) {
+    toggleedgewindows(s, cl, false);
+  }
+  return cl;
+}
+
+/**
+ * @brief Returns whether a previous process of the window manager
+ * restarted in place and left its state on the root window.
+ *
+ * @param s The window manager's state
+ */
+bool
+hasrestartstate(state_t* s) {
+  xcb_atom_t atom = getatom(s, "_RAGNAR_RESTART_STATE");
+  xcb_get_property_reply_t* reply = xgetproperty(s, 0, s->root, atom, atom, 0, 0);
+  bool has = reply && reply->type == atom && reply->bytes_after;
+  free(reply);
+  return has;
+}
+
+/**
+ * @brief Asks the event loop to restart the window manager in place.
+ * Used by threads other than the event loop's.
+ *
+ * @param s The window manager's state
+ */
+void
+requestrestart(state_t* s) {
+  // Without a connection to the X server there is nothing to restart
+  if(!s->con) return;
+  xcb_client_message_event_t ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.response_type = XCB_CLIENT_MESSAGE;
+  ev.window = s->root;
+  ev.format = 32;
+  ev.type = s->wm_atoms[WMrestart];
+  xcb_send_event(s->con, false, s->root, XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT, (const char*)&ev);
+  xcb_flush(s->con);
+}
+
+/**
+ * @brief Restarts the window manager in place by executing it again.
+ * The state of all clients, desktops and scratchpads is left on the
+ * root window and the frames outlive the X connection, so the new
+ * process adopts every client without unframing or remapping it.
+ * Returns only if the window manager could not be executed.
+ *
+ * @param s The window manager's state
+ */
+void
+execrestart(state_t* s) {
+  if(!s->argv || !s->argv[0]) {
+    logmsg(s, LogLevelError, "cannot restart, the command ragnar was started with is unknown.");
+    return;
+  }
+  if(!s->con) {
+    logmsg(s, LogLevelError, "cannot restart without a connection to the X server.");
+    return;
+  }
+  // The new process destroys the outline windows
+  hideoutline(s);
+  // The new process creates its own tab bars once it lays out the monitors
+  for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
+    destroytabbar(s, mon);
+  }
+  if(!saverestartstate(s)) return;
+  /* Resources outlive the connection with the close down mode below and 
+   * the new process loads its own cursors, so they are freed here */
+  freecursors(s);
+
+  xsetclosedownmode(s, XCB_CLOSE_DOWN_RETAIN_PERMANENT);
+  xcb_aux_sync(s->con);
+  stoppropfetcher(s);
+  // The new process appends to the recording
+  flushrecording(s);
+
+  // The new process can only redirect the root window once the connection is closed
+  int32_t xfd = xcb_get_file_descriptor(s->con);
+  fcntl(xfd, F_SETFD, fcntl(xfd, F_GETFD) | FD_CLOEXEC);
+
+  logmsg(s, LogLevelTrace, "restarting in place as '%s'.", s->argv[0]);
+  execvp(s->argv[0], s->argv);
+
+  logmsg(s, LogLevelError, "failed to restart as '%s': %s.", s->argv[0], strerror(errno));
+  xsetclosedownmode(s, XCB_CLOSE_DOWN_DESTROY_ALL);
+  xdeleteproperty(s, s->root, s->wm_atoms[WMrestartState]);
+  startpropfetcher(s);
+  loaddefaultcursor(s);
+  for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
+    makelayout(s, mon);
+  }
+  xflush(s);
+}
+
+/**
+ * @brief Adopts the clients that a previous process of the window
+ * manager left behind when it restarted in place, together with the
+ * layouts and desktops of the monitors, the scratchpads and the focus.
+ * Clients whose window is gone are dropped. The state is removed from
+ * the root window.
+ *
+ * @param s The window manager's state
+ *
+ * @return Whether a state was found and restored
+ */
+bool
+restorestate(state_t* s) {
+  xcb_atom_t atom = s->wm_atoms[WMrestartState];
+  xcb_get_property_reply_t* reply = xgetproperty(s, 1, s->root, atom, atom, 0, UINT32_MAX / 4);
+  if(!reply) return false;
+
+  const uint8_t* ptr = xcb_get_property_value(reply);
+  size_t len = reply->format == 32 ? (size_t)xcb_get_property_value_length(reply) : 0;
+
+  restart_header_t hdr;
+  if(len < sizeof(hdr)) {
+    free(reply);
+    return false;
+  }
+  memcpy(&hdr, ptr, sizeof(hdr));
+  ptr += sizeof(hdr);
+  if(hdr.version != RESTART_STATE_VERSION ||
+    len != sizeof(hdr) +
+    hdr.nummons * (sizeof(restart_mon_t) + hdr.numdesktops * sizeof(restart_desktop_t)) +
+    hdr.numclients * sizeof(restart_client_t) +
+    hdr.numscratchpads * sizeof(restart_scratchpad_t)) {
+    logmsg(s, LogLevelWarn, "ignoring restart state of an incompatible version.");
+    free(reply);
+    return false;
+  }
+
+  if(hdr.wmcheck) {
+    xdestroywindow(s, hdr.wmcheck);
+  }
+  for(uint32_t i = 0; i < 4; i++) {
+    if(hdr.outline[i]) xdestroywindow(s, hdr.outline[i]);
+  }
+  /* The adopted frames keep using the old colormap. Frames created
+   * from now on share it if it has the visual they use. */
+  if(hdr.framecolormap && s->ownsframecolormap && hdr.framevisual == s->framevisual) {
+    xfreecolormap(s, s->framecolormap);
+    s->framecolormap = hdr.framecolormap;
+  }
+
+  const uint8_t* mons = ptr;
+  for(uint32_t i = 0; i < hdr.nummons; i++) {
+    restart_mon_t m;
+    memcpy(&m, ptr, sizeof(m));
+    ptr += sizeof(m);
+    monitor_t* mon = monbyidx(s, m.idx);
+    for(uint32_t j = 0; j < hdr.numdesktops; j++, ptr += sizeof(restart_desktop_t)) {
+      if(!mon || j >= s->config.maxdesktops) continue;
+      restart_desktop_t d;
+      memcpy(&d, ptr, sizeof(d));
+      mon->activedesktops[j].init = d.init;
+      mon->layouts[j] = (layout_props_t){
+        .nmaster      = d.nmaster,
+        .masterarea   = d.masterarea,
+        .gapsize      = d.gapsize,
+        .curlayout    = d.curlayout,
+        .mastermaxed  = d.mastermaxed,
+        .dirty        = true,
+      };
+    }
+    if(mon && m.curdesktop < s->config.maxdesktops) {
+      mon->curdesktop.idx = m.curdesktop;
+      mon->activedesktops[m.curdesktop].init = true;
+    }
+  }
+
+  restart_client_t* recs = malloc(sizeof(*recs) * (hdr.numclients ? hdr.numclients : 1));
+  xcb_query_tree_cookie_t* cookies = malloc(sizeof(*cookies) * (hdr.numclients ? hdr.numclients : 1));
+  if(!recs || !cookies) {
+    logmsg(s, LogLevelError, "failed to allocate the restart state.");
+    free(recs);
+    free(cookies);
+    free(reply);
+    return false;
+  }
+  memcpy(recs, ptr, sizeof(*recs) * hdr.numclients);
+  ptr += sizeof(*recs) * hdr.numclients;
+
+  // A client is only adopted if its window is still in its frame
+  for(uint32_t i = 0; i < hdr.numclients; i++) {
+    cookies[i] = xquerytreerequest(s, recs[i].win);
+  }
+  uint32_t adopted = 0;
+  // Clients are inserted at the front of their desktop, so the last one is adopted first
+  for(uint32_t i = hdr.numclients; i-- > 0;) {
+    xcb_query_tree_reply_t* tree = xquerytreereply(s, cookies[i]);
+    bool framed = tree && tree->parent == recs[i].frame;
+    free(tree);
+    if(!framed) {
+      xdestroywindow(s, recs[i].frame);
+      continue;
+    }
+    if(adoptclient(s, &recs[i])) {
+      adopted++;
+    }
+  }
+  free(cookies);
+  free(recs);
+
+  // The monocle layouts show the same clients as before
+  ptr = mons;
+  for(uint32_t i = 0; i < hdr.nummons; i++) {
+    restart_mon_t m;
+    memcpy(&m, ptr, sizeof(m));
+    ptr += sizeof(m);
+    monitor_t* mon = monbyidx(s, m.idx);
+    for(uint32_t j = 0; j < hdr.numdesktops; j++, ptr += sizeof(restart_desktop_t)) {
+      if(!mon || j >= s->config.maxdesktops) continue;
+      restart_desktop_t d;
+      memcpy(&d, ptr, sizeof(d));
+      client_t* active = d.active ? clientfromwin(s, d.active) : NULL;
+      if(active && active->mon == mon && active->desktop == j) {
+        mon->layouts[j].active = active;
+      }
+    }
+  }
+  ptr += hdr.numclients * sizeof(restart_client_t);
+
+  for(uint32_t i = 0; i < hdr.numscratchpads; i++, ptr += sizeof(restart_scratchpad_t)) {
+    if(i >= s->config.maxscratchpads) continue;
+    restart_scratchpad_t r;
+    memcpy(&r, ptr, sizeof(r));
+    s->scratchpads[i] = (scratchpad_t){
+      .win            = r.win,
+      .pid            = r.pid,
+      .hidden         = r.flags & RestartScratchpadHidden,
+      .needs_restart  = r.flags & RestartScratchpadNeedsRestart,
+      .pending        = r.flags & RestartScratchpadPending,
+    };
+    // The scratchpad is launched again if its window was not adopted
+    if(r.win && !clientfromwin(s, r.win)) {
+      removescratchpad(s, i);
+    }
+  }
+
+  monitor_t* monfocus = monbyidx(s, hdr.monfocus);
+  if(monfocus) {
+    s->monfocus = monfocus;
+  }
+  if(s->monfocus) {
+    updateewmhdesktops(s, s->monfocus);
+  }
+  ewmh_updateclients(s);
+
+  client_t* focus = hdr.focus ? clientfromwin(s, hdr.focus) : NULL;
+  if(focus) {
+    focusclient(s, focus, true);
+  }
+
+  logmsg(s, LogLevelTrace, "restored %i of %i clients after restarting in place.",
+         adopted, hdr.numclients);
+  free(reply);
+  return true;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "structs.h"
+
+bool hasrestartstate(state_t* s);
+void requestrestart(state_t* s);
+void execrestart(state_t* s);
+bool restorestate(state_t* s);
@@ -0,0 +1,218 @@
+#include "rules.h"
+#include "funcs.h"
+#include "xbackend.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <xcb/xcb_icccm.h>
+
+#define RULES_MIN_BUCKETS 8
+
+static uint32_t strhash(const char* str, uint32_t numbuckets);
+static xcb_atom_t typeatom(state_t* s, const char* type);
+static bool strmatches(const char* pattern, const char* str);
+static bool rulematches(const window_rule_t* rule, xcb_atom_t ruletype, 
+                        const char* wmclass, const char* instance, const char* title, 
+                        const char* role, xcb_atom_t type);
+static void mergerule(window_rule_t* dst, const window_rule_t* src);
+
+uint32_t
+strhash(const char* str, uint32_t numbuckets) {
+  // FNV-1a
+  uint32_t hash = 2166136261u;
+  for(; *str; str++) {
+    hash ^= (uint8_t)*str;
+    hash *= 16777619u;
+  }
+  return hash & (numbuckets - 1);
+}
+
+/* Returns the atom of a window type name like "dialog" (_NET_WM_WINDOW_TYPE_DIALOG) */
+xcb_atom_t
+typeatom(state_t* s, const char* type) {
+  char name[64];
+  int32_t len = snprintf(name, sizeof(name), "_NET_WM_WINDOW_TYPE_%s", type);
+  if(len < 0 || (size_t)len >= sizeof(name)) return XCB_NONE;
+  for(char* c = name; *c; c++) {
+    *c = toupper((uint8_t)*c);
+  }
+  return getatom(s, name);
+}
+
+/* Whether an exact match criterion is unset or equals the given string */
+bool
+strmatches(const char* pattern, const char* str) {
+  return !pattern || (str && strcmp(pattern, str) == 0);
+}
+
+bool
+rulematches(const window_rule_t* rule, xcb_atom_t ruletype, 
+            const char* wmclass, const char* instance, const char* title, 
+            const char* role, xcb_atom_t type) {
+  if(!strmatches(rule->wmclass, wmclass) || !strmatches(rule->instance, instance) ||
+    !strmatches(rule->role, role)) {
+    return false;
+  }
+  if(rule->title && (!title || !strstr(title, rule->title))) {
+    return false;
+  }
+  if(rule->type && (ruletype == XCB_NONE || ruletype != type)) {
+    return false;
+  }
+  return true;
+}
+
+/* Applies the properties that a rule sets over the ones of earlier rules */
+void
+mergerule(window_rule_t* dst, const window_rule_t* src) {
+  if(src->desktop != -1)    dst->desktop = src->desktop;
+  if(src->monitor != -1)    dst->monitor = src->monitor;
+  if(src->floating != -1)   dst->floating = src->floating;
+  if(src->fullscreen != -1) dst->fullscreen = src->fullscreen;
+  if(src->hasgeometry) {
+    dst->hasgeometry = true;
+    dst->geometry = src->geometry;
+  }
+}
+
+void
+compilerules(state_t* s) {
+  rule_matcher_t* m = &s->rules;
+  destroyrules(m);
+
+  uint32_t n = s->config.numrules;
+  if(!n) return;
+
+  // Keep the buckets at most half full
+  m->numbuckets = RULES_MIN_BUCKETS;
+  while(m->numbuckets < n * 2) {
+    m->numbuckets *= 2;
+  }
+  m->buckets = malloc(sizeof(*m->buckets) * m->numbuckets);
+  m->next = malloc(sizeof(*m->next) * n);
+  m->types = calloc(n, sizeof(*m->types));
+  for(uint32_t i = 0; i < m->numbuckets; i++) {
+    m->buckets[i] = RULE_NONE;
+  }
+
+  // Rules are prepended in reverse so that every chain is in config order
+  for(uint32_t i = n; i-- > 0;) {
+    const window_rule_t* rule = &s->config.rules[i];
+    const char* key = rule->wmclass ? rule->wmclass : rule->instance;
+    uint32_t* head = key ? &m->buckets[strhash(key, m->numbuckets)] : &m->generic;
+    m->next[i] = *head;
+    *head = i;
+
+    if(rule->type) {
+      m->types[i] = typeatom(s, rule->type);
+      if(m->types[i] == XCB_NONE) {
+        logmsg(s, LogLevelWarn, "config: invalid window type '%s' in rule %i.", rule->type, i);
+      }
+    }
+    m->needtitle |= rule->title != NULL;
+    m->needrole |= rule->role != NULL;
+    m->needtype |= rule->type != NULL;
+  }
+  logmsg(s, LogLevelTrace, "compiled %i window rules into %i buckets.", n, m->numbuckets);
+}
+
+window_rule_t
+matchrules(state_t* s, client_t* cl) {
+  window_rule_t res = {
+    .desktop = -1,
+    .monitor = -1,
+    .floating = -1,
+    .fullscreen = -1,
+  };
+  const rule_matcher_t* m = &s->rules;
+  if(!s->config.numrules) return res;
+
+  // Request every property the rules need before waiting for any reply
+  xcb_get_property_cookie_t classcookie = xgetwmclassrequest(s, cl->win);
+  xcb_get_property_cookie_t rolecookie = {0}, typecookie = {0};
+  if(m->needrole) {
+    rolecookie = xgetpropertyrequest(s, 0, cl->win, s->wm_atoms[WMwindowRole], 
+                                     XCB_ATOM_STRING, 0, 64);
+  }
+  if(m->needtype) {
+    typecookie = xgetpropertyrequest(s, 0, cl->win, s->ewmh_atoms[EWMHwindowType], 
+                                     XCB_ATOM_ATOM, 0, 1);
+  }
+
+  // Names are fetched in the background, so rules that match by title read it now
+  if(m->needtitle && !cl->props->name) {
+    cl->props->name = getclientname(s, cl);
+  }
+
+  xcb_icccm_get_wm_class_reply_t wmclass;
+  bool hasclass = xgetwmclassreply(s, classcookie, &wmclass);
+  const char* classname = hasclass ? wmclass.class_name : NULL;
+  const char* instance = hasclass ? wmclass.instance_name : NULL;
+
+  char* role = NULL;
+  if(m->needrole) {
+    xcb_get_property_reply_t* reply = xgetpropertyreply(s, rolecookie);
+    if(reply && xcb_get_property_value_length(reply) > 0) {
+      role = strndup(xcb_get_property_value(reply), xcb_get_property_value_length(reply));
+    }
+    free(reply);
+  }
+  xcb_atom_t type = XCB_NONE;
+  if(m->needtype) {
+    xcb_get_property_reply_t* reply = xgetpropertyreply(s, typecookie);
+    if(reply && xcb_get_property_value_length(reply) >= (int32_t)sizeof(xcb_atom_t)) {
+      type = *(xcb_atom_t*)xcb_get_property_value(reply);
+    }
+    free(reply);
+  }
+
+  /* Only the rules of the window's class and instance buckets and the 
+   * generic rules are checked. The chains are walked together so that 
+   * the rules apply in config order. */
+  uint32_t heads[3] = { RULE_NONE, RULE_NONE, m->generic };
+  uint32_t classbucket = RULE_NONE;
+  if(classname) {
+    classbucket = strhash(classname, m->numbuckets);
+    heads[0] = m->buckets[classbucket];
+  }
+  if(instance) {
+    uint32_t bucket = strhash(instance, m->numbuckets);
+    if(bucket != classbucket) {
+      heads[1] = m->buckets[bucket];
+    }
+  }
+  while(true) {
+    uint32_t* head = NULL;
+    for(uint32_t i = 0; i < ARRLEN(heads); i++) {
+      if(heads[i] != RULE_NONE && (!head || heads[i] < *head)) {
+        head = &heads[i];
+      }
+    }
+    if(!head) break;
+
+    uint32_t i = *head;
+    *head = m->next[i];
+    if(rulematches(&s->config.rules[i], m->types[i], classname, instance, 
+                   cl->props->name, role, type)) {
+      logmsg(s, LogLevelTrace, "window %i matched rule %i.", cl->win, i);
+      mergerule(&res, &s->config.rules[i]);
+    }
+  }
+
+  free(role);
+  if(hasclass) {
+    xcb_icccm_get_wm_class_reply_wipe(&wmclass);
+  }
+  return res;
+}
+
+void
+destroyrules(rule_matcher_t* rules) {
+  free(rules->buckets);
+  free(rules->next);
+  free(rules->types);
+  memset(rules, 0, sizeof(*rules));
+  rules->generic = RULE_NONE;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "structs.h"
+
+/* Terminates the rule chains of the matcher */
+#define RULE_NONE UINT32_MAX
+
+void compilerules(state_t* s);
+window_rule_t matchrules(state_t* s, client_t* cl);
+void destroyrules(rule_matcher_t* rules);
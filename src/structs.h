@@ -1,18 +1,35 @@
 #pragma once
 
+#include <stdio.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <pthread.h>
 
 #include <xcb/xcb.h>
 #include <xcb/xcb_keysyms.h>
 #include <X11/keysym.h>
 #include <xcb/xcb_ewmh.h>
-
-#include <GL/gl.h>
-#include <GL/glx.h>
+#include <xcb/xcb_icccm.h>
+#include <xcb/sync.h>
+#include <xcb/randr.h>
 #include <xcb/xproto.h>
 
 #define EDGE_WIDTH 5
+/* Number of clients that are allocated at once by the client pool */
+#define CLIENT_SLAB_SIZE 64
+/* Number of string size classes (16 to 256 bytes) of the string pool */
+#define STRPOOL_NUMCLASSES 5
+/* Size of the chunks that the string pool carves its blocks from */
+#define STRPOOL_CHUNK_SIZE 4096
+/* Time to wait for a client to acknowledge a _NET_WM_SYNC_REQUEST 
+ * before resizing it anyway */
+#define SYNC_REQUEST_TIMEOUT_MS 100
+/* Time after startup at which lazily launched scratchpads are started */
+#define SCRATCHPAD_LAZY_DELAY_MS 3000
+/* Times and interval at which the process started by an in-place 
+ * restart tries to redirect the root window until the old one let go */
+#define RESTART_REDIRECT_RETRIES 50
+#define RESTART_REDIRECT_INTERVAL_MS 10
 
 typedef struct state_t state_t;
 typedef struct passthrough_data_t passthrough_data_t;
@@ -35,6 +52,8 @@ void settiledmaster(state_t* s, passthrough_data_t data);
 void setverticalstripes(state_t* s, passthrough_data_t data);
 void sethorizontalstripes(state_t* s, passthrough_data_t data); 
 void setfloatingmode(state_t* s, passthrough_data_t data);
+void setmonocle(state_t* s, passthrough_data_t data);
+void settabbed(state_t* s, passthrough_data_t data);
 void updatebarslayout(state_t* s, passthrough_data_t data);
 void cycledownlayout(state_t* s, passthrough_data_t data);
 void cycleuplayout(state_t* s, passthrough_data_t data);
@@ -54,6 +73,15 @@ void cyclefocusmonitordown(state_t* s, passthrough_data_t data);
 void cyclefocusmonitorup(state_t* s, passthrough_data_t data);
 void togglescratchpad(state_t* s, passthrough_data_t data);
 void reloadconfigfile(state_t* s, passthrough_data_t data);
+void restartwm(state_t* s, passthrough_data_t data);
+void movefocusmonitorleft(state_t* s, passthrough_data_t data);
+void movefocusmonitorright(state_t* s, passthrough_data_t data);
+void movefocusmonitorup(state_t* s, passthrough_data_t data);
+void movefocusmonitordown(state_t* s, passthrough_data_t data);
+void focusmonitorleft(state_t* s, passthrough_data_t data);
+void focusmonitorright(state_t* s, passthrough_data_t data);
+void focusmonitorup(state_t* s, passthrough_data_t data);
+void focusmonitordown(state_t* s, passthrough_data_t data);
 
 #define _XCB_EV_LAST 36 
 
@@ -94,6 +122,19 @@ do {
   (vec)->size--;                                                                  \
 } while (0)                                                                       
 
+#define vector_insert(vec, idx, item)                                             \
+do {                                                                              \
+  if ((vec)->size >= (vec)->cap) {                                                \
+    (vec)->cap = (vec)->cap == 0 ? VEC_INIT_CAP : (vec)->cap*2;                   \
+    (vec)->items = realloc((vec)->items, (vec)->cap*sizeof(*(vec)->items));       \
+  }                                                                               \
+  for (uint32_t _i = (vec)->size; _i > (idx); _i--) {                             \
+  (vec)->items[_i] = (vec)->items[_i - 1];                                        \
+  }                                                                               \
+  (vec)->items[(idx)] = (item);                                                   \
+  (vec)->size++;                                                                  \
+} while (0)
+
 #define vector_append(vec, item)                                                  \
 do {                                                                              \
   if ((vec)->size >= (vec)->cap) {                                                \
@@ -122,9 +163,45 @@ typedef enum {
   LayoutFloating = 0,
   LayoutTiledMaster,
   LayoutVerticalStripes,
-  LayoutHorizontalStripes
+  LayoutHorizontalStripes,
+  /* Only one tiled window is shown and fills the layout area */
+  LayoutMonocle,
+  /* Like the monocle layout with a bar of tabs for the tiled windows above the shown one */
+  LayoutTabbed
 } layout_type_t;
 
+typedef enum {
+  /* Hidden windows are unmapped */
+  HideStrategyUnmap = 0,
+  /* Hidden windows stay mapped and are moved off-screen */
+  HideStrategyPark,
+} hide_strategy_t;
+
+typedef enum {
+  /* ARGB frames if a compositing manager is running, opaque frames otherwise */
+  FrameVisualAuto = 0,
+  /* Frames always use a 32-bit ARGB visual */
+  FrameVisualARGB,
+  /* Frames always use the visual of the root window */
+  FrameVisualOpaque,
+} frame_visual_t;
+
+typedef enum {
+  /* Clients are resized while they are dragged */
+  ResizeModeLive = 0,
+  /* Only an outline is resized while dragging, the client once the button is released */
+  ResizeModeOutline,
+} resize_mode_t;
+
+typedef enum {
+  /* The scratchpad is launched when it is toggled for the first time */
+  ScratchpadLaunchOnDemand = 0,
+  /* The scratchpad is launched hidden when the window manager starts */
+  ScratchpadLaunchStartup,
+  /* The scratchpad is launched hidden shortly after the window manager started */
+  ScratchpadLaunchLazy,
+} scratchpad_launch_t;
+
 typedef enum {
   LayeringOrderNormal = 0,
   LayeringOrderBelow,
@@ -148,6 +225,9 @@ typedef enum {
   EWMHcurrentDesktop,
   EWMHnumberOfDesktops,
   EWMHdesktopNames,
+  EWMHsyncRequest,
+  EWMHsyncRequestCounter,
+  EWMHwmPid,
   EWMHcount
 } ewmh_atom_t;
 
@@ -156,6 +236,12 @@ typedef enum {
   WMdelete,
   WMstate,
   WMtakeFocus,
+  WMwindowRole,
+  WMutf8String,
+  /* Client message that restarts the window manager in place and 
+   * the root window property that holds the state across the restart */
+  WMrestart,
+  WMrestartState,
   WMcount
 } wm_atom_t;
 
@@ -180,6 +266,12 @@ typedef struct {
   xcb_keysym_t key;
   keycallback_t cb;
   passthrough_data_t data;
+
+  /* Options of togglescratchpad keybinds: the WM_CLASS instance or class 
+   * that identifies the scratchpad's window (NULL to match by _NET_WM_PID) 
+   * and when the scratchpad is launched */
+  const char* wmclass;
+  scratchpad_launch_t launch;
 } keybind_t;
 
 typedef struct {
@@ -364,6 +456,7 @@ typedef struct {
 } strut_t;
 
 typedef struct monitor_t monitor_t;
+typedef struct client_t client_t;
 
 typedef struct {
   uint32_t nmaster;
@@ -371,11 +464,12 @@ typedef struct {
   int32_t gapsize;
   layout_type_t curlayout;
   bool mastermaxed;
+  /* Whether the clients of the desktop need to be layed out again */
+  bool dirty;
+  /* The tiled client that is shown in the monocle layout (NULL if not chosen yet) */
+  client_t* active;
 } layout_props_t; 
 
-
-typedef struct client_t client_t;
-
 typedef enum {
   EdgeNone = 0,
   EdgeLeft,
@@ -393,38 +487,151 @@ typedef struct {
   window_edge_t edge;
 } edgegrab_t;
 
-struct client_t {
-  area_t area, area_prev;
-  bool fullscreen, floating, floating_prev,
-       fixed, hidden;
-  
-  bool is_scratchpad;
+/* Kinds of server-side resources the window manager creates */
+typedef enum {
+  XResourceWindow = 0,
+  XResourceCursor,
+  XResourceColormap,
+  XResourceAlarm,
+  XResourceGrab,
+  XResourceCount
+} x_resource_kind_t;
+
+/* Data of a client that is only needed when the client is created, 
+ * its hints change or it is decorated. Kept out of client_t so 
+ * that layout and desktop iteration only touch hot data. */
+typedef struct {
+  /* Owned by the string pool */
+  char* name;
+  /* Whether the name changed and is waiting to be fetched again */
+  bool namedirty;
 
-  int32_t scratchpad_index;
+  /* Edge windows of the client (indexed by window_edge_t) */
+  edgegrab_t edges[9];
 
-  xcb_window_t win, frame;
+  v2_t minsize;
+  v2_t maxsize;
 
-  v2_t closebutton, layoutbutton;
+  area_t area_prev;
+  bool floating_prev;
+
+  /* _NET_WM_SYNC_REQUEST counter of the client (0 if not supported) 
+   * and the alarm that fires once the client has updated it */
+  xcb_sync_counter_t synccounter;
+  xcb_sync_alarm_t syncalarm;
+  /* Counter value the client has to reach for the last sync request */
+  int64_t syncvalue;
+  /* Monotonic time in ms the last sync request was sent at */
+  uint64_t syncsent;
+  /* Whether a sync request is waiting for acknowledgement and 
+   * whether a resize was held back until then */
+  bool syncpending, syncdeferred;
+
+  /* Server-side resources held for the client (indexed by x_resource_kind_t) */
+  uint32_t resources[XResourceCount];
+} client_props_t;
 
-  client_t* next;
+struct client_t {
+  area_t area;
 
-  size_t borderwidth;
+  xcb_window_t win, frame;
 
   monitor_t* mon;
   uint32_t desktop;
+  /* Index of the client within the client list of its desktop */
+  uint32_t slot;
 
-  edgegrab_t* edges;
+  uint32_t borderwidth;
 
-  bool urgent, ignoreunmap, ignoreexpose, decorated, neverfocus, showedgewindows; 
+  float layoutsizeadd;
 
-  v2_t minsize;
-  v2_t maxsize;
+  int32_t scratchpad_index;
 
-  float layoutsizeadd;
+  bool fullscreen, floating, fixed, hidden;
+  bool is_scratchpad;
+  bool urgent, ignoreunmap, ignoreexpose, decorated, neverfocus, showedgewindows;
+  /* Whether the client is hidden by being moved off-screen */
+  bool parked; 
+  /* Whether the client is hidden behind the shown client of a monocle layout */
+  bool stacked;
 
-  char* name;
+  client_props_t* props;
 };
 
+typedef struct {
+  client_t** items;
+  uint32_t size, cap;
+} client_list_t;
+
+/* Fields of a client update that are applied */
+typedef enum {
+  ClientUpdateArea      = 1 << 0,
+  ClientUpdateDesktop   = 1 << 1,
+  ClientUpdateMonitor   = 1 << 2,
+  ClientUpdateFloating  = 1 << 3,
+} client_update_field_t;
+
+/* A change to a client as part of a transaction (see updateclients()) */
+typedef struct {
+  xcb_window_t win;
+  /* The fields of the update that are applied (client_update_field_t) */
+  uint32_t fields;
+  /* Area in root window coordinates (makes the client float 
+   * unless the floating state is given as well) */
+  area_t area;
+  uint32_t desktop;
+  int32_t monitor;
+  bool floating;
+} client_update_t;
+
+typedef enum {
+  ClientUpdateOk = 0,
+  /* The update is valid but another update of the transaction is not */
+  ClientUpdateNotApplied,
+  ClientUpdateInvalidWindow,
+  ClientUpdateInvalidDesktop,
+  ClientUpdateInvalidMonitor,
+  ClientUpdateInvalidArea,
+} client_update_status_t;
+
+typedef struct client_slab_t client_slab_t;
+
+/* A client together with its properties as allocated by the client pool */
+typedef struct client_slot_t {
+  client_t cl;
+  client_props_t props;
+  client_slab_t* slab;
+  struct client_slot_t* nextfree;
+} client_slot_t;
+
+struct client_slab_t {
+  client_slab_t *next, *prev;
+  client_slot_t* freelist;
+  uint32_t used;
+  client_slot_t slots[CLIENT_SLAB_SIZE];
+};
+
+typedef struct {
+  client_slab_t* slabs;
+  uint32_t numslabs;
+  uint32_t live, peak;
+} client_pool_t;
+
+typedef struct strpool_chunk_t {
+  struct strpool_chunk_t* next;
+} strpool_chunk_t;
+
+typedef struct {
+  /* Free blocks of every size class */
+  void* freelists[STRPOOL_NUMCLASSES];
+  strpool_chunk_t* chunks;
+  /* Bump allocation range within the current chunk */
+  uint8_t *chunkpos, *chunkend;
+  uint32_t live, peak;
+  /* Bytes held by chunks and strings too large for a size class */
+  uint64_t bytes;
+} string_pool_t;
+
 typedef struct {
   uint32_t idx;
 } desktop_t;
@@ -433,18 +640,81 @@ typedef struct {
   bool init;
 } named_desktop_t;
 
+/* Directions of the physical monitor arrangement */
+typedef enum {
+  DirectionLeft = 0,
+  DirectionRight,
+  DirectionUp,
+  DirectionDown,
+  DirectionCount
+} direction_t;
+
+/* Bar of the tabbed layout with a tab for every tiled client of the 
+ * shown desktop (in layout order), the tab of the shown client highlighted */
+typedef struct {
+  /* XCB_NONE if the bar was not created yet */
+  xcb_window_t win;
+  xcb_window_t* tabs;
+  uint32_t numtabs, tabscap;
+  /* What the bar shows, so that only changes are sent to the X server */
+  area_t area;
+  int32_t activetab;
+  bool mapped;
+  /* Whether every tab needs to be configured and colored again */
+  bool dirty;
+} tab_bar_t;
+
 struct monitor_t {
   area_t area;
   monitor_t* next;
   uint32_t idx;
+  /* Name of the monitor as reported by RandR (XCB_NONE if unnamed) */
+  xcb_atom_t name;
+  /* Whether the monitor was reported by the last monitor query */
+  bool active;
+
+  /* The currently selected virtual desktop of the monitor */
+  desktop_t curdesktop;
 
   named_desktop_t* activedesktops;
   uint32_t desktopcount;
   layout_props_t* layouts;
 
-  client_t* clients;
+  /* Clients of every virtual desktop on the monitor (indexed by desktop) */
+  client_list_t* clients;
+
+  /* Closest monitor in every direction (indexed by direction_t, NULL 
+   * if there is none), built with the monitor topology */
+  monitor_t* neighbours[DirectionCount];
+
+  tab_bar_t tabbar;
 };
 
+/* Grid formed by the edges of all monitors, mapping every cell to the 
+ * monitor that covers it so that the monitor of a point is found with 
+ * two binary searches (see topology.c). Rebuilt whenever the monitors change. */
+typedef struct {
+  /* Sorted distinct x and y coordinates of the monitor edges */
+  float *xs, *ys;
+  uint32_t numxs, numys;
+  /* Monitor of every cell, row by row (NULL if no monitor covers it) */
+  monitor_t** cells;
+} monitor_topology_t;
+
+/* A window rule as read from the config. Unset match criteria (NULL) 
+ * match every window and unset properties (-1) are left as they are. */
+typedef struct {
+  /* WM_CLASS class and instance, WM_WINDOW_ROLE and window type are 
+   * matched exactly, the title matches if it contains the given string */
+  char *wmclass, *instance, *title, *role, *type;
+
+  int32_t desktop, monitor;
+  int8_t floating, fullscreen;
+  /* Area of the window relative to its monitor (makes the window float) */
+  bool hasgeometry;
+  area_t geometry;
+} window_rule_t;
+
 typedef struct {
   uint32_t maxstruts;
   uint32_t maxdesktops;
@@ -463,6 +733,7 @@ typedef struct {
   uint32_t desktopinit;
 
   char** desktopnames;
+  uint32_t numdesktopnames;
 
   bool usedecoration;
 
@@ -480,8 +751,15 @@ typedef struct {
   int32_t winlayoutgap_max; 
   int32_t winlayoutgap_step;
 
+  /* Height of the tab bar of the tabbed layout */
+  int32_t tabbarheight;
+
   layout_type_t initlayout;
 
+  hide_strategy_t hidestrategy;
+  frame_visual_t framevisual;
+  resize_mode_t resizemode;
+
   keybind_t* keybinds;
   uint32_t numkeybinds;
 
@@ -494,53 +772,342 @@ typedef struct {
   bool shouldlogtofile;
 
   char* cursorimage;
+
+  bool watchconfig;
+
+  window_rule_t* rules;
+  uint32_t numrules;
 } config_data_t;
 
 typedef struct {
   xcb_window_t win;
   bool hidden, needs_restart;
+  /* Whether the command was launched and its window did not map yet */
+  bool pending;
+  /* Process id of the launched command */
+  int32_t pid;
 } scratchpad_t;
 
+/* The window rules of the config hashed by their class 
+ * (or their instance if they match every class) */
+typedef struct {
+  /* First rule of every bucket and the next rule of every rule 
+   * within its bucket, in config order */
+  uint32_t* buckets;
+  uint32_t* next;
+  uint32_t numbuckets;
+  /* First rule that matches every class and instance */
+  uint32_t generic;
+  /* Window type atom of every rule (XCB_NONE if it matches every type) */
+  xcb_atom_t* types;
+  /* Whether any rule matches by title, role or window type */
+  bool needtitle, needrole, needtype;
+} rule_matcher_t;
+
 typedef struct {
   xcb_window_t* items;
   uint32_t size, cap;
-} popup_list_t;
+} window_list_t;
 
+/* Client properties that are fetched by the property fetcher */
+typedef enum {
+  PropFetchName   = 1 << 0,
+  PropFetchHints  = 1 << 1,
+} prop_fetch_t;
+
+typedef struct prop_request_t {
+  xcb_window_t win;
+  /* Properties to fetch (prop_fetch_t) */
+  uint32_t what;
+  struct prop_request_t* next;
+} prop_request_t;
+
+typedef struct prop_result_t {
+  xcb_window_t win;
+  /* Properties that were fetched (prop_fetch_t) */
+  uint32_t what;
+  /* The window's name (NULL if it has none) */
+  char* name;
+  uint32_t namelen;
+  /* The window's WM_HINTS (only valid if hashints is set) */
+  bool hashints;
+  xcb_icccm_wm_hints_t hints;
+  struct prop_result_t* next;
+} prop_result_t;
+
+/* Worker thread that reads client properties on its own 
+ * X connection so that the event loop never waits for them */
+typedef struct {
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  /* Connection of the worker (NULL if properties are fetched synchronously) */
+  xcb_connection_t* con;
+  /* Signals the main loop that results are queued */
+  int32_t eventfd;
+  /* Atoms needed to read _NET_WM_NAME */
+  xcb_atom_t netwmname, utf8string;
+  prop_request_t *requests, *lastrequest;
+  prop_result_t *results, *lastresult;
+  bool running;
+} prop_fetcher_t;
+
+/* Command of an IPC client that waits to be handled by the event loop */
+typedef struct {
+  uint8_t id;
+  const uint8_t* data;
+  size_t len;
+  int32_t clientfd;
+} ipc_command_t;
+
+/* Hands the commands the IPC thread reads to the event loop, so that 
+ * handlers never run on the IPC thread, which would share the state 
+ * and the X connection with the event loop. The IPC thread waits until 
+ * its command was handled before reading the next one. */
+typedef struct {
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  /* Signals the main loop that a command is pending */
+  int32_t eventfd;
+  /* Command that waits to be handled (NULL if there is none) */
+  ipc_command_t* pending;
+} ipc_queue_t;
+
+/* Open addressing hash map from windows to a small value */
+typedef struct {
+  xcb_window_t* keys;
+  uint8_t* vals;
+  /* Number of entries and number of slots that are not empty (including removed ones) */
+  uint32_t cap, size, used;
+} window_map_t;
+
+typedef enum {
+  WindowKindOther = 0,
+  /* Frames and other windows created by the window manager */
+  WindowKindOwn,
+  WindowKindPopup,
+} window_kind_t;
+
+/* The X requests of the window manager's handlers (see xbackend.h). 
+ * Every function gets the context of the backend, and replies are 
+ * allocated with malloc() in the layout of xcb's replies (NULL on 
+ * errors like xcb). */
+typedef struct {
+  /* Requests without a reply */
+  void (*configurewindow)(void* ctx, xcb_window_t win, uint16_t mask, const void* values);
+  void (*changewindowattributes)(void* ctx, xcb_window_t win, uint32_t mask, const void* values);
+  void (*mapwindow)(void* ctx, xcb_window_t win);
+  void (*unmapwindow)(void* ctx, xcb_window_t win);
+  void (*destroywindow)(void* ctx, xcb_window_t win);
+  void (*changeproperty)(void* ctx, uint8_t mode, xcb_window_t win, xcb_atom_t prop, 
+                         xcb_atom_t type, uint8_t format, uint32_t len, const void* data);
+  void (*deleteproperty)(void* ctx, xcb_window_t win, xcb_atom_t prop);
+  void (*setinputfocus)(void* ctx, uint8_t revertto, xcb_window_t win, xcb_timestamp_t time);
+  void (*sendevent)(void* ctx, uint8_t propagate, xcb_window_t dest, uint32_t mask, const char* ev);
+  void (*flush)(void* ctx);
+  void (*createwindow)(void* ctx, uint8_t depth, xcb_window_t win, xcb_window_t parent,
+                       int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t borderwidth,
+                       uint16_t class, xcb_visualid_t visual, uint32_t mask, const void* values);
+  void (*reparentwindow)(void* ctx, xcb_window_t win, xcb_window_t parent, int16_t x, int16_t y);
+  void (*cleararea)(void* ctx, uint8_t exposures, xcb_window_t win, 
+                    int16_t x, int16_t y, uint16_t w, uint16_t h);
+  void (*createcolormap)(void* ctx, uint8_t alloc, xcb_colormap_t cmap, 
+                         xcb_window_t win, xcb_visualid_t visual);
+  void (*freecolormap)(void* ctx, xcb_colormap_t cmap);
+  void (*freecursor)(void* ctx, xcb_cursor_t cursor);
+  void (*grabbutton)(void* ctx, uint8_t ownerevents, xcb_window_t win, uint16_t evmask, 
+                     uint8_t pointermode, uint8_t keyboardmode, xcb_window_t confineto, 
+                     xcb_cursor_t cursor, uint8_t button, uint16_t modifiers);
+  void (*ungrabbutton)(void* ctx, uint8_t button, xcb_window_t win, uint16_t modifiers);
+  void (*grabkey)(void* ctx, uint8_t ownerevents, xcb_window_t win, uint16_t modifiers, 
+                  xcb_keycode_t key, uint8_t pointermode, uint8_t keyboardmode);
+  void (*ungrabkey)(void* ctx, xcb_keycode_t key, xcb_window_t win, uint16_t modifiers);
+  void (*allowevents)(void* ctx, uint8_t mode, xcb_timestamp_t time);
+  void (*warppointer)(void* ctx, xcb_window_t srcwin, xcb_window_t dstwin, 
+                      int16_t srcx, int16_t srcy, uint16_t srcw, uint16_t srch, 
+                      int16_t dstx, int16_t dsty);
+  void (*grabserver)(void* ctx);
+  void (*ungrabserver)(void* ctx);
+  void (*setclosedownmode)(void* ctx, uint8_t mode);
+  void (*killclient)(void* ctx, uint32_t resource);
+  void (*createalarm)(void* ctx, xcb_sync_alarm_t alarm, uint32_t mask, const void* values);
+  void (*changealarm)(void* ctx, xcb_sync_alarm_t alarm, uint32_t mask, const void* values);
+  void (*destroyalarm)(void* ctx, xcb_sync_alarm_t alarm);
+  /* Returns a new ID for a resource, which is no request */
+  uint32_t (*generateid)(void* ctx);
+  /* Loads a cursor of the cursor theme by name (XCB_NONE if it has none) */
+  xcb_cursor_t (*loadcursor)(void* ctx, xcb_screen_t* screen, const char* name);
+  /* Requests that wait for their reply */
+  bool (*changewindowattributeschecked)(void* ctx, xcb_window_t win, uint32_t mask, const void* values);
+  xcb_get_property_reply_t* (*getproperty)(void* ctx, uint8_t del, xcb_window_t win, xcb_atom_t prop, 
+                                           xcb_atom_t type, uint32_t offset, uint32_t len);
+  xcb_get_geometry_reply_t* (*getgeometry)(void* ctx, xcb_drawable_t drawable);
+  xcb_get_window_attributes_reply_t* (*getwindowattributes)(void* ctx, xcb_window_t win);
+  xcb_query_pointer_reply_t* (*querypointer)(void* ctx, xcb_window_t win);
+  xcb_query_tree_reply_t* (*querytree)(void* ctx, xcb_window_t win);
+  xcb_intern_atom_reply_t* (*internatom)(void* ctx, uint8_t onlyifexists, uint16_t len, const char* name);
+  xcb_get_selection_owner_reply_t* (*getselectionowner)(void* ctx, xcb_atom_t selection);
+  xcb_sync_query_counter_reply_t* (*querycounter)(void* ctx, xcb_sync_counter_t counter);
+  xcb_randr_get_monitors_reply_t* (*getmonitors)(void* ctx, xcb_window_t win, uint8_t active);
+  /* Keysym of a keycode (0 if none) and keycodes of a keysym (malloc'd, 
+   * terminated by XCB_NO_SYMBOL, NULL if none) of the keyboard mapping */
+  xcb_keysym_t (*getkeysym)(void* ctx, xcb_keycode_t keycode);
+  xcb_keycode_t* (*getkeycodes)(void* ctx, xcb_keysym_t keysym);
+  /* Requests whose replies are read later, so that several of them 
+   * are sent before waiting for the first reply */
+  xcb_get_property_cookie_t (*getpropertyrequest)(void* ctx, uint8_t del, xcb_window_t win, xcb_atom_t prop, 
+                                                  xcb_atom_t type, uint32_t offset, uint32_t len);
+  xcb_get_property_reply_t* (*getpropertyreply)(void* ctx, xcb_get_property_cookie_t cookie);
+  xcb_query_tree_cookie_t (*querytreerequest)(void* ctx, xcb_window_t win);
+  xcb_query_tree_reply_t* (*querytreereply)(void* ctx, xcb_query_tree_cookie_t cookie);
+} x_backend_t;
+
+/* Number of X requests, requests that waited for their reply 
+ * and flushes that went through the backend */
+typedef struct {
+  uint64_t requests, roundtrips, flushes;
+} x_stats_t;
+
+/* Server-side resources created and freed over the lifetime of the 
+ * window manager (indexed by x_resource_kind_t, see resources.c) */
+typedef struct {
+  uint64_t created[XResourceCount], freed[XResourceCount];
+  /* Resources that were still held for clients when they were released */
+  uint64_t leaked[XResourceCount];
+} x_resource_stats_t;
+
+/* Bytes of the window manager's own heap allocations by what they hold */
+typedef struct {
+  uint64_t clients, strings, monitors, winmaps, rules, other;
+} heap_usage_t;
+
+/* Writes every X event and IPC command the window manager receives 
+ * to a file so that a session can be replayed (see record.c) */
+typedef struct {
+  /* File the recording is written to (NULL if not recording) */
+  FILE* file;
+  /* IPC commands are recorded by the IPC thread */
+  pthread_mutex_t lock;
+  /* Monotonic time in µs of the last record and of the last write to the file */
+  uint64_t last, lastflush;
+  /* Whether anything was recorded since the end of the last batch of events */
+  bool pending;
+  /* Atoms whose names are part of the recording */
+  window_map_t atoms;
+} recorder_t;
 
 struct state_t {
   window_edge_t grabedge;
   xcb_connection_t* con;
+  /* Backend the requests of the handlers go through, its context (the 
+   * connection for the xcb backend) and the requests sent through it */
+  const x_backend_t* x;
+  void* xctx;
+  x_stats_t xstats;
   xcb_ewmh_connection_t ewmh;
   xcb_window_t root;
   xcb_screen_t* screen; 
 
   float lastexposetime, lastmotiontime; 
 
-  Display* dsp; 
+  /* Number of the screen the window manager runs on */
+  int32_t screennum;
+
+  /* Whether the X sync extension is available and its first event code */
+  bool hassync;
+  uint8_t syncevbase;
+  /* Number of clients with an unacknowledged sync request */
+  uint32_t numsyncpending;
+
+  /* Whether the RandR extension is available and its first event code */
+  bool hasrandr;
+  uint8_t randrevbase;
+  /* Whether the monitor layout changed and needs to be queried again */
+  bool monsdirty;
+
+  /* Edge windows of the outline shown for outline resizes */
+  xcb_window_t outline[4];
+  /* The client that is resized with an outline (NULL if none), 
+   * the area it is resized to and whether it becomes floating */
+  client_t* outlineclient;
+  area_t outlinearea;
+  bool outlinefloat;
+
+  /* Visual, depth and colormap shared by all frame windows */
+  xcb_visualid_t framevisual;
+  uint8_t framedepth;
+  xcb_colormap_t framecolormap;
+  /* Whether the frame colormap was created by the window manager */
+  bool ownsframecolormap;
+
+  /* Cursors of the edge windows (indexed by window_edge_t, loaded 
+   * on first use) and of the root window */
+  xcb_cursor_t edgecursors[9];
+  xcb_cursor_t rootcursor;
+  x_resource_stats_t resources;
 
   bool ignore_enter_layout;
 
+  /* The focused client, which is also the only highlighted client */
   client_t* focus;
-  popup_list_t popups;
+  /* Window last set as _NET_ACTIVE_WINDOW on the root (XCB_NONE if unset) */
+  xcb_window_t activewin;
+  /* Mapped popup windows (menus, tooltips) */
+  window_map_t popups;
+  /* Kind of every window that was classified (window_kind_t) */
+  window_map_t winkinds;
 
   v2_t grabcursor;
   area_t grabwin;
 
+  /* Pointer position reported by the last X input event */
+  v2_t lastcursor;
+  bool haslastcursor;
+  /* Monitor that contains the last reported pointer position (NULL if unknown) */
+  monitor_t* lastcursormon;
+
   monitor_t* monitors;
   monitor_t* monfocus;
+  monitor_topology_t montopo;
 
   xcb_atom_t wm_atoms[WMcount]; 
   xcb_atom_t ewmh_atoms[EWMHcount];
 
-  desktop_t* curdesktop;
-
   strut_t* winstruts;
   uint32_t nwinstruts;
 
   config_data_t config;
+  /* Compiled window rules of the config */
+  rule_matcher_t rules;
+
+  /* Reads client names and hints off the main thread */
+  prop_fetcher_t propfetcher;
+  /* Commands of IPC clients that wait for the event loop */
+  ipc_queue_t ipc;
+  /* Windows whose name changed since the last title update and the 
+   * monotonic time in ms at which their names are fetched (0 if none) */
+  window_list_t dirtytitles;
+  uint64_t titleupdatedue;
+
+  /* Storage of all clients and client names */
+  client_pool_t clientpool;
+  string_pool_t strpool;
 
   scratchpad_t* scratchpads;
-  int32_t mapping_scratchpad_index;
+  /* Monotonic time in ms the lazily launched scratchpads are started at (0 if none) */
+  uint64_t scratchpadlaunchdue;
+
+  /* Arguments the window manager was started with (to restart in place) */
+  char** argv;
+
+  recorder_t recorder;
+  /* Whether a recording is replayed instead of handling the events of the display */
+  bool replaying;
+
+  /* inotify descriptor watching the config file (-1 if not watching) */
+  int32_t cfgwatchfd;
+  /* Monotonic time in ms at which a changed config file is reloaded (0 if none) */
+  uint64_t cfgreloaddue;
 };
 
 
@@ -0,0 +1,207 @@
+#include "tabbar.h"
+#include "funcs.h"
+#include "xbackend.h"
+#include "resources.h"
+#include "winmap.h"
+
+#include <stdlib.h>
+
+/* Width of the gap between two tabs that shows the bar's background */
+#define TAB_SEPARATOR 1
+#define TAB_BAR_BACKGROUND 0x000000
+
+static bool resizetabs(state_t* s, tab_bar_t* bar, uint32_t numtabs);
+static void colortab(state_t* s, tab_bar_t* bar, uint32_t tab, bool active);
+
+/* Creates or destroys tab windows so that the bar has a given number of tabs */
+bool
+resizetabs(state_t* s, tab_bar_t* bar, uint32_t numtabs) {
+  if(numtabs > bar->tabscap) {
+    xcb_window_t* tabs = realloc(bar->tabs, numtabs * sizeof(*tabs));
+    if(!tabs) {
+      logmsg(s, LogLevelError, "failed to allocate the tabs of the tab bar.");
+      return false;
+    }
+    bar->tabs = tabs;
+    bar->tabscap = numtabs;
+  }
+  for(uint32_t i = bar->numtabs; i < numtabs; i++) {
+    bar->tabs[i] = xgenerateid(s);
+    uint32_t values[] = { s->config.winbordercolor, XCB_EVENT_MASK_BUTTON_PRESS };
+    xcreatewindow(s, XCB_COPY_FROM_PARENT, bar->tabs[i], bar->win,
+                  0, 0, 1, 1, 0, XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT,
+                  XCB_CW_BACK_PIXEL | XCB_CW_EVENT_MASK, values);
+    winmapset(&s->winkinds, bar->tabs[i], WindowKindOwn);
+    xmapwindow(s, bar->tabs[i]);
+  }
+  for(uint32_t i = numtabs; i < bar->numtabs; i++) {
+    xdestroywindow(s, bar->tabs[i]);
+    winmapremove(&s->winkinds, bar->tabs[i]);
+  }
+  trackresource(s, NULL, XResourceWindow, (int32_t)numtabs - (int32_t)bar->numtabs);
+  bar->numtabs = numtabs;
+  return true;
+}
+
+void
+colortab(state_t* s, tab_bar_t* bar, uint32_t tab, bool active) {
+  uint32_t color = active ? s->config.winbordercolor_selected : s->config.winbordercolor;
+  xchangewindowattributes(s, bar->tabs[tab], XCB_CW_BACK_PIXEL, &color);
+  // The new background only shows once the window is cleared
+  xcleararea(s, 0, bar->tabs[tab], 0, 0, 0, 0);
+}
+
+/**
+ * @brief Shows the tab bar of the tabbed layout on a given monitor
+ * at a given area with a tab for every tiled client on the shown
+ * desktop. Only the tabs that changed since the last update are
+ * configured, so switching the shown client recolors two tabs.
+ *
+ * @param s The window manager's state
+ * @param mon The monitor of the layout
+ * @param area The area of the bar in root window coordinates
+ */
+void
+updatetabbar(state_t* s, monitor_t* mon, area_t area) {
+  tab_bar_t* bar = &mon->tabbar;
+  client_t* active = mon->layouts[mondesktop(s, mon)->idx].active;
+
+  uint32_t numtabs = 0;
+  int32_t activetab = -1;
+  client_list_t* clients = visibleclients(s, mon);
+  for(uint32_t i = 0; i < clients->size; i++) {
+    client_t* cl = clients->items[i];
+    if(cl->floating) continue;
+    if(cl == active) activetab = numtabs;
+    numtabs++;
+  }
+  if(!numtabs || area.size.x < numtabs || area.size.y < 1) {
+    hidetabbar(s, mon);
+    return;
+  }
+
+  if(bar->win == XCB_NONE) {
+    bar->win = xgenerateid(s);
+    uint32_t values[] = { TAB_BAR_BACKGROUND, true };
+    xcreatewindow(s, XCB_COPY_FROM_PARENT, bar->win, s->root,
+                  0, 0, 1, 1, 0, XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT,
+                  XCB_CW_BACK_PIXEL | XCB_CW_OVERRIDE_REDIRECT, values);
+    winmapset(&s->winkinds, bar->win, WindowKindOwn);
+    trackresource(s, NULL, XResourceWindow, 1);
+    bar->dirty = true;
+  }
+
+  bool reconfigure = bar->dirty || numtabs != bar->numtabs ||
+    area.pos.x != bar->area.pos.x || area.pos.y != bar->area.pos.y ||
+    area.size.x != bar->area.size.x || area.size.y != bar->area.size.y;
+  if(numtabs != bar->numtabs && !resizetabs(s, bar, numtabs)) {
+    hidetabbar(s, mon);
+    return;
+  }
+
+  if(reconfigure) {
+    uint32_t barvalues[] = {
+      (int32_t)area.pos.x, (int32_t)area.pos.y, (uint32_t)area.size.x, (uint32_t)area.size.y
+    };
+    xconfigurewindow(s, bar->win,
+                     XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y |
+                     XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, barvalues);
+    // The tabs split the bar evenly, the last one takes the remainder
+    uint32_t w = area.size.x;
+    for(uint32_t i = 0; i < numtabs; i++) {
+      uint32_t x = i * w / numtabs;
+      uint32_t next = (i + 1) * w / numtabs;
+      uint32_t tabw = next - x;
+      if(i + 1 < numtabs && tabw > TAB_SEPARATOR) {
+        tabw -= TAB_SEPARATOR;
+      }
+      uint32_t values[] = { x, 0, tabw, (uint32_t)area.size.y };
+      xconfigurewindow(s, bar->tabs[i],
+                       XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y |
+                       XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, values);
+      colortab(s, bar, i, (int32_t)i == activetab);
+    }
+  } else if(activetab != bar->activetab) {
+    if(bar->activetab >= 0 && (uint32_t)bar->activetab < numtabs) {
+      colortab(s, bar, bar->activetab, false);
+    }
+    if(activetab >= 0) {
+      colortab(s, bar, activetab, true);
+    }
+  }
+
+  bar->area = area;
+  bar->activetab = activetab;
+  bar->dirty = false;
+  if(!bar->mapped) {
+    uint32_t stack[] = { XCB_STACK_MODE_ABOVE };
+    xconfigurewindow(s, bar->win, XCB_CONFIG_WINDOW_STACK_MODE, stack);
+    xmapwindow(s, bar->win);
+    bar->mapped = true;
+  }
+}
+
+/**
+ * @brief Hides the tab bar of a given monitor if it is shown.
+ *
+ * @param s The window manager's state
+ * @param mon The monitor of the tab bar
+ */
+void
+hidetabbar(state_t* s, monitor_t* mon) {
+  tab_bar_t* bar = &mon->tabbar;
+  if(!bar->mapped) return;
+  xunmapwindow(s, bar->win);
+  bar->mapped = false;
+}
+
+/**
+ * @brief Destroys the tab bar of a given monitor along with its tabs.
+ *
+ * @param s The window manager's state
+ * @param mon The monitor of the tab bar
+ */
+void
+destroytabbar(state_t* s, monitor_t* mon) {
+  tab_bar_t* bar = &mon->tabbar;
+  if(bar->win != XCB_NONE) {
+    // The tabs are destroyed along with the bar
+    xdestroywindow(s, bar->win);
+    winmapremove(&s->winkinds, bar->win);
+    for(uint32_t i = 0; i < bar->numtabs; i++) {
+      winmapremove(&s->winkinds, bar->tabs[i]);
+    }
+    trackresource(s, NULL, XResourceWindow, -(int32_t)(bar->numtabs + 1));
+  }
+  free(bar->tabs);
+  *bar = (tab_bar_t){0};
+}
+
+/**
+ * @brief Returns the client of a given tab of a shown tab bar.
+ *
+ * @param s The window manager's state
+ * @param win The tab window
+ *
+ * @return The client the tab stands for (NULL if the window is no tab)
+ */
+client_t*
+clientfromtab(state_t* s, xcb_window_t win) {
+  for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
+    tab_bar_t* bar = &mon->tabbar;
+    if(!bar->mapped) continue;
+    for(uint32_t i = 0; i < bar->numtabs; i++) {
+      if(bar->tabs[i] != win) continue;
+      // Tabs are in the order of the tiled clients
+      uint32_t tab = 0;
+      client_list_t* clients = visibleclients(s, mon);
+      for(uint32_t j = 0; j < clients->size; j++) {
+        client_t* cl = clients->items[j];
+        if(cl->floating) continue;
+        if(tab++ == i) return cl;
+      }
+      return NULL;
+    }
+  }
+  return NULL;
+}
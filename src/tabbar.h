@@ -0,0 +1,8 @@
+#pragma once
+
+#include "structs.h"
+
+void updatetabbar(state_t* s, monitor_t* mon, area_t area);
+void hidetabbar(state_t* s, monitor_t* mon);
+void destroytabbar(state_t* s, monitor_t* mon);
+client_t* clientfromtab(state_t* s, xcb_window_t win);
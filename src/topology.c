@@ -0,0 +1,290 @@
+#include "topology.h"
+#include "funcs.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+static int cmpfloat(const void* a, const void* b);
+static uint32_t uniquesorted(float* vals, uint32_t n);
+static int32_t findinterval(const float* vals, uint32_t n, float v);
+static bool areacontains(area_t outer, area_t inner);
+static void span(area_t a, bool horizontal, float* lo, float* hi);
+static monitor_t* closestneighbour(const state_t* s, const monitor_t* mon, direction_t dir);
+static bool monbefore(const monitor_t* a, const monitor_t* b);
+
+int
+cmpfloat(const void* a, const void* b) {
+  float fa = *(const float*)a, fb = *(const float*)b;
+  return (fa > fb) - (fa < fb);
+}
+
+/* Sorts the values, drops duplicates and returns how many are left */
+uint32_t
+uniquesorted(float* vals, uint32_t n) {
+  if(!n) return 0;
+  qsort(vals, n, sizeof(*vals), cmpfloat);
+  uint32_t len = 1;
+  for(uint32_t i = 1; i < n; i++) {
+    if(vals[i] != vals[len - 1]) vals[len++] = vals[i];
+  }
+  return len;
+}
+
+/* Returns the index i of sorted values with vals[i] <= v < vals[i + 1]
+ * or -1 if the value is outside of them */
+int32_t
+findinterval(const float* vals, uint32_t n, float v) {
+  if(n < 2 || v < vals[0] || v >= vals[n - 1]) return -1;
+  uint32_t lo = 0, hi = n - 1;
+  while(hi - lo > 1) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if(vals[mid] <= v) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  return (int32_t)lo;
+}
+
+bool
+areacontains(area_t outer, area_t inner) {
+  return inner.pos.x >= outer.pos.x && inner.pos.y >= outer.pos.y &&
+    inner.pos.x + inner.size.x <= outer.pos.x + outer.size.x &&
+    inner.pos.y + inner.size.y <= outer.pos.y + outer.size.y;
+}
+
+/* Gets the range an area covers along the x (horizontal) or y axis */
+void
+span(area_t a, bool horizontal, float* lo, float* hi) {
+  *lo = horizontal ? a.pos.x : a.pos.y;
+  *hi = *lo + (horizontal ? a.size.x : a.size.y);
+}
+
+/* Returns the monitor next to a given one in a given direction, which is 
+ * one whose center lies past the edge facing that direction. Monitors that 
+ * share part of that edge are preferred, then the ones closest to the edge 
+ * and the ones most in line with the monitor. */
+monitor_t*
+closestneighbour(const state_t* s, const monitor_t* mon, direction_t dir) {
+  bool horizontal = dir == DirectionLeft || dir == DirectionRight;
+  float sign = (dir == DirectionRight || dir == DirectionDown) ? 1.0f : -1.0f;
+  // Range of the monitor along the direction (p) and across it (q)
+  float plo, phi, qlo, qhi;
+  span(mon->area, horizontal, &plo, &phi);
+  span(mon->area, !horizontal, &qlo, &qhi);
+
+  monitor_t* best = NULL;
+  bool bestshares = false;
+  float bestgap = 0.0f, bestoffset = 0.0f;
+  for(monitor_t* other = s->monitors; other != NULL; other = other->next) {
+    if(other == mon) continue;
+    float oplo, ophi, oqlo, oqhi;
+    span(other->area, horizontal, &oplo, &ophi);
+    span(other->area, !horizontal, &oqlo, &oqhi);
+
+    // The other monitor needs to lie past the edge facing the direction
+    float ocenter = (oplo + ophi) / 2.0f;
+    if(sign > 0.0f ? ocenter < phi : ocenter > plo) continue;
+
+    bool shares = MIN(qhi, oqhi) > MAX(qlo, oqlo);
+    float gap = MAX(0.0f, sign > 0.0f ? oplo - phi : plo - ophi);
+    float offset = fabsf((oqlo + oqhi) - (qlo + qhi)) / 2.0f;
+    if(best && (bestshares && !shares)) continue;
+    if(best && bestshares == shares &&
+      (gap > bestgap || (gap == bestgap && offset >= bestoffset))) continue;
+
+    best = other;
+    bestshares = shares;
+    bestgap = gap;
+    bestoffset = offset;
+  }
+  return best;
+}
+
+/**
+ * @brief Builds the monitor topology from the areas of the monitors:
+ * the grid that maps points to monitors and the neighbours of every
+ * monitor. Needs to be called whenever monitors are added, removed
+ * or change their area.
+ *
+ * @param s The window manager's state
+ */
+void
+buildtopology(state_t* s) {
+  monitor_topology_t* topo = &s->montopo;
+  destroytopology(topo);
+
+  uint32_t nmons = 0;
+  for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
+    nmons++;
+  }
+  if(!nmons) return;
+
+  topo->xs = malloc(2 * nmons * sizeof(*topo->xs));
+  topo->ys = malloc(2 * nmons * sizeof(*topo->ys));
+  if(!topo->xs || !topo->ys) {
+    logmsg(s, LogLevelError, "failed to allocate the monitor topology.");
+    destroytopology(topo);
+    return;
+  }
+  uint32_t n = 0;
+  for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next, n += 2) {
+    span(mon->area, true, &topo->xs[n], &topo->xs[n + 1]);
+    span(mon->area, false, &topo->ys[n], &topo->ys[n + 1]);
+  }
+  topo->numxs = uniquesorted(topo->xs, n);
+  topo->numys = uniquesorted(topo->ys, n);
+
+  uint32_t cols = topo->numxs > 1 ? topo->numxs - 1 : 0;
+  uint32_t rows = topo->numys > 1 ? topo->numys - 1 : 0;
+  topo->cells = malloc((cols * rows + 1) * sizeof(*topo->cells));
+  if(!topo->cells) {
+    logmsg(s, LogLevelError, "failed to allocate the monitor topology.");
+    destroytopology(topo);
+    return;
+  }
+  // A cell lies within or outside of every monitor, so its center decides
+  for(uint32_t y = 0; y < rows; y++) {
+    for(uint32_t x = 0; x < cols; x++) {
+      v2_t center = (v2_t){
+        (topo->xs[x] + topo->xs[x + 1]) / 2.0f,
+        (topo->ys[y] + topo->ys[y + 1]) / 2.0f
+      };
+      monitor_t* cellmon = NULL;
+      for(monitor_t* mon = s->monitors; mon != NULL && !cellmon; mon = mon->next) {
+        if(pointinarea(center, mon->area)) cellmon = mon;
+      }
+      topo->cells[y * cols + x] = cellmon;
+    }
+  }
+
+  for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
+    for(uint32_t dir = 0; dir < DirectionCount; dir++) {
+      mon->neighbours[dir] = closestneighbour(s, mon, (direction_t)dir);
+    }
+    logmsg(s, LogLevelTrace, "neighbours of monitor %i: left %i, right %i, up %i, down %i.", mon->idx,
+           mon->neighbours[DirectionLeft]  ? (int32_t)mon->neighbours[DirectionLeft]->idx  : -1,
+           mon->neighbours[DirectionRight] ? (int32_t)mon->neighbours[DirectionRight]->idx : -1,
+           mon->neighbours[DirectionUp]    ? (int32_t)mon->neighbours[DirectionUp]->idx    : -1,
+           mon->neighbours[DirectionDown]  ? (int32_t)mon->neighbours[DirectionDown]->idx  : -1);
+  }
+}
+
+/**
+ * @brief Frees the memory of a monitor topology and resets it.
+ *
+ * @param topo The monitor topology to destroy
+ */
+void
+destroytopology(monitor_topology_t* topo) {
+  free(topo->xs);
+  free(topo->ys);
+  free(topo->cells);
+  *topo = (monitor_topology_t){0};
+}
+
+/**
+ * @brief Returns the monitor that contains a given point.
+ *
+ * @param s The window manager's state
+ * @param p The point in root window coordinates
+ *
+ * @return The monitor that contains the point (NULL if none does)
+ */
+monitor_t*
+monatpoint(const state_t* s, v2_t p) {
+  const monitor_topology_t* topo = &s->montopo;
+  int32_t x = findinterval(topo->xs, topo->numxs, p.x);
+  int32_t y = findinterval(topo->ys, topo->numys, p.y);
+  if(x < 0 || y < 0) return NULL;
+  return topo->cells[(uint32_t)y * (topo->numxs - 1) + (uint32_t)x];
+}
+
+/**
+ * @brief Returns the monitor that has the biggest overlap with a given
+ * area. Areas that lie within a single monitor (the common case) are
+ * resolved without comparing them to every monitor.
+ *
+ * @param s The window manager's state
+ * @param a The area in root window coordinates
+ * @param hint The monitor the area is expected on (NULL if unknown)
+ *
+ * @return The monitor of the area (the first monitor if it overlaps none)
+ */
+monitor_t*
+monforarea(const state_t* s, area_t a, monitor_t* hint) {
+  if(hint && areacontains(hint->area, a)) return hint;
+
+  v2_t center = (v2_t){a.pos.x + a.size.x / 2.0f, a.pos.y + a.size.y / 2.0f};
+  monitor_t* centermon = monatpoint(s, center);
+  if(centermon && areacontains(centermon->area, a)) return centermon;
+
+  // The area spans several monitors
+  monitor_t* ret = s->monitors;
+  float biggest = -1.0f;
+  for(monitor_t* mon = s->monitors; mon != NULL; mon = mon->next) {
+    float overlap = getoverlaparea(a, mon->area);
+    if(overlap > biggest) {
+      biggest = overlap;
+      ret = mon;
+    }
+  }
+  return ret;
+}
+
+/**
+ * @brief Returns the monitor next to a given one in a given direction.
+ *
+ * @param s The window manager's state
+ * @param mon The monitor to start from
+ * @param dir The direction to go in
+ *
+ * @return The monitor in the given direction (NULL if there is none)
+ */
+monitor_t*
+monindirection(const state_t* s, monitor_t* mon, direction_t dir) {
+  (void)s;
+  if(!mon) return NULL;
+  return mon->neighbours[dir];
+}
+
+/* Returns whether a monitor comes before another one when the 
+ * monitors are ordered top to bottom and then left to right */
+bool
+monbefore(const monitor_t* a, const monitor_t* b) {
+  if(a->area.pos.y != b->area.pos.y) return a->area.pos.y < b->area.pos.y;
+  if(a->area.pos.x != b->area.pos.x) return a->area.pos.x < b->area.pos.x;
+  // Monitors at the same position (e.g. mirrored ones) are ordered by index
+  return a->idx < b->idx;
+}
+
+/**
+ * @brief Returns the monitor after or before a given one when all 
+ * monitors are ordered top to bottom and then left to right, wrapping 
+ * around at either end. Unlike monindirection(), cycling reaches every 
+ * monitor however the monitors are arranged.
+ *
+ * @param s The window manager's state
+ * @param mon The monitor to start from
+ * @param forward Whether to go to the monitor after the given one 
+ * instead of the one before it
+ *
+ * @return The next monitor in the order (NULL if there is no other monitor)
+ */
+monitor_t*
+moncycle(const state_t* s, monitor_t* mon, bool forward) {
+  if(!mon) return NULL;
+  // The closest monitor in the order and the farthest one to wrap around to
+  monitor_t* next = NULL;
+  monitor_t* wrapped = NULL;
+  for(monitor_t* m = s->monitors; m != NULL; m = m->next) {
+    if(m == mon) continue;
+    bool ahead = forward ? monbefore(mon, m) : monbefore(m, mon);
+    monitor_t** best = ahead ? &next : &wrapped;
+    if(!*best || (forward ? monbefore(m, *best) : monbefore(*best, m))) {
+      *best = m;
+    }
+  }
+  return next ? next : wrapped;
+}
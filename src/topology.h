@@ -0,0 +1,10 @@
+#pragma once
+
+#include "structs.h"
+
+void buildtopology(state_t* s);
+void destroytopology(monitor_topology_t* topo);
+monitor_t* monatpoint(const state_t* s, v2_t p);
+monitor_t* monforarea(const state_t* s, area_t a, monitor_t* hint);
+monitor_t* monindirection(const state_t* s, monitor_t* mon, direction_t dir);
+monitor_t* moncycle(const state_t* s, monitor_t* mon, bool forward);
@@ -0,0 +1,107 @@
+#include "winmap.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define WINMAP_INIT_CAP 32
+
+static uint32_t winhash(xcb_window_t win, uint32_t cap);
+static int32_t findslot(const window_map_t* map, xcb_window_t win);
+static void rehash(window_map_t* map, uint32_t cap);
+
+uint32_t
+winhash(xcb_window_t win, uint32_t cap) {
+  // Fibonacci hashing spreads the sequential XIDs of a client over the table
+  return (uint32_t)(win * 2654435761u) & (cap - 1);
+}
+
+/* Returns the slot that holds the given window or -1 if it is not in the map */
+int32_t
+findslot(const window_map_t* map, xcb_window_t win) {
+  if(!map->cap) return -1;
+  for(uint32_t i = winhash(win, map->cap), n = 0; n < map->cap; i = (i + 1) & (map->cap - 1), n++) {
+    if(map->keys[i] == WINMAP_EMPTY) return -1;
+    if(map->keys[i] == win) return (int32_t)i;
+  }
+  return -1;
+}
+
+/* Moves all entries into a table of the given capacity, dropping the tombstones */
+void
+rehash(window_map_t* map, uint32_t cap) {
+  xcb_window_t* keys = map->keys;
+  uint8_t* vals = map->vals;
+  uint32_t oldcap = map->cap;
+
+  map->keys = calloc(cap, sizeof(*map->keys));
+  map->vals = malloc(cap * sizeof(*map->vals));
+  map->cap = cap;
+  map->used = map->size;
+
+  for(uint32_t i = 0; i < oldcap; i++) {
+    if(keys[i] == WINMAP_EMPTY || keys[i] == WINMAP_TOMBSTONE) continue;
+    uint32_t j = winhash(keys[i], cap);
+    while(map->keys[j] != WINMAP_EMPTY) {
+      j = (j + 1) & (cap - 1);
+    }
+    map->keys[j] = keys[i];
+    map->vals[j] = vals[i];
+  }
+  free(keys);
+  free(vals);
+}
+
+bool
+winmapget(const window_map_t* map, xcb_window_t win, uint8_t* val) {
+  int32_t i = findslot(map, win);
+  if(i == -1) return false;
+  if(val) {
+    *val = map->vals[i];
+  }
+  return true;
+}
+
+void
+winmapset(window_map_t* map, xcb_window_t win, uint8_t val) {
+  int32_t found = findslot(map, win);
+  if(found != -1) {
+    map->vals[found] = val;
+    return;
+  }
+
+  // Keep the table at most three quarters full (counting tombstones)
+  if((map->used + 1) * 4 > map->cap * 3) {
+    uint32_t cap = map->cap ? map->cap : WINMAP_INIT_CAP;
+    while((map->size + 1) * 2 > cap) {
+      cap *= 2;
+    }
+    rehash(map, cap);
+  }
+
+  uint32_t i = winhash(win, map->cap);
+  while(map->keys[i] != WINMAP_EMPTY && map->keys[i] != WINMAP_TOMBSTONE) {
+    i = (i + 1) & (map->cap - 1);
+  }
+  if(map->keys[i] == WINMAP_EMPTY) {
+    map->used++;
+  }
+  map->keys[i] = win;
+  map->vals[i] = val;
+  map->size++;
+}
+
+bool
+winmapremove(window_map_t* map, xcb_window_t win) {
+  int32_t i = findslot(map, win);
+  if(i == -1) return false;
+  map->keys[i] = WINMAP_TOMBSTONE;
+  map->size--;
+  return true;
+}
+
+void
+destroywinmap(window_map_t* map) {
+  free(map->keys);
+  free(map->vals);
+  memset(map, 0, sizeof(*map));
+}
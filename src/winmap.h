@@ -0,0 +1,19 @@
+#pragma once
+
+#include "structs.h"
+
+/* Key of a slot that was never used and of a slot whose 
+ * entry was removed (XIDs never have the top bits set) */
+#define WINMAP_EMPTY XCB_NONE
+#define WINMAP_TOMBSTONE UINT32_MAX
+
+bool winmapget(const window_map_t* map, xcb_window_t win, uint8_t* val);
+void winmapset(window_map_t* map, xcb_window_t win, uint8_t val);
+bool winmapremove(window_map_t* map, xcb_window_t win);
+void destroywinmap(window_map_t* map);
+
+/* Whether a slot of the map holds an entry (for iterating the map) */
+static inline bool 
+winmapslotused(const window_map_t* map, uint32_t i) {
+  return map->keys[i] != WINMAP_EMPTY && map->keys[i] != WINMAP_TOMBSTONE;
+}
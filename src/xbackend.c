@@ -0,0 +1,319 @@
+#include "xbackend.h"
+
+#include <stdlib.h>
+#include <xcb/xcb_cursor.h>
+#include <xcb/xcb_keysyms.h>
+
+/* Backend that sends the requests over the X connection given as context */
+
+static void
+xcbconfigurewindow(void* ctx, xcb_window_t win, uint16_t mask, const void* values) {
+  xcb_configure_window(ctx, win, mask, values);
+}
+
+static void
+xcbchangewindowattributes(void* ctx, xcb_window_t win, uint32_t mask, const void* values) {
+  xcb_change_window_attributes(ctx, win, mask, values);
+}
+
+static void
+xcbmapwindow(void* ctx, xcb_window_t win) {
+  xcb_map_window(ctx, win);
+}
+
+static void
+xcbunmapwindow(void* ctx, xcb_window_t win) {
+  xcb_unmap_window(ctx, win);
+}
+
+static void
+xcbdestroywindow(void* ctx, xcb_window_t win) {
+  xcb_destroy_window(ctx, win);
+}
+
+static void
+xcbchangeproperty(void* ctx, uint8_t mode, xcb_window_t win, xcb_atom_t prop,
+                  xcb_atom_t type, uint8_t format, uint32_t len, const void* data) {
+  xcb_change_property(ctx, mode, win, prop, type, format, len, data);
+}
+
+static void
+xcbdeleteproperty(void* ctx, xcb_window_t win, xcb_atom_t prop) {
+  xcb_delete_property(ctx, win, prop);
+}
+
+static void
+xcbsetinputfocus(void* ctx, uint8_t revertto, xcb_window_t win, xcb_timestamp_t time) {
+  xcb_set_input_focus(ctx, revertto, win, time);
+}
+
+static void
+xcbsendevent(void* ctx, uint8_t propagate, xcb_window_t dest, uint32_t mask, const char* ev) {
+  xcb_send_event(ctx, propagate, dest, mask, ev);
+}
+
+static void
+xcbflush(void* ctx) {
+  xcb_flush(ctx);
+}
+
+static void
+xcbcreatewindow(void* ctx, uint8_t depth, xcb_window_t win, xcb_window_t parent,
+                int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t borderwidth,
+                uint16_t class, xcb_visualid_t visual, uint32_t mask, const void* values) {
+  xcb_create_window(ctx, depth, win, parent, x, y, w, h, borderwidth, class, visual, mask, values);
+}
+
+static void
+xcbreparentwindow(void* ctx, xcb_window_t win, xcb_window_t parent, int16_t x, int16_t y) {
+  xcb_reparent_window(ctx, win, parent, x, y);
+}
+
+static void
+xcbcleararea(void* ctx, uint8_t exposures, xcb_window_t win, 
+             int16_t x, int16_t y, uint16_t w, uint16_t h) {
+  xcb_clear_area(ctx, exposures, win, x, y, w, h);
+}
+
+static void
+xcbcreatecolormap(void* ctx, uint8_t alloc, xcb_colormap_t cmap, 
+                  xcb_window_t win, xcb_visualid_t visual) {
+  xcb_create_colormap(ctx, alloc, cmap, win, visual);
+}
+
+static void
+xcbfreecolormap(void* ctx, xcb_colormap_t cmap) {
+  xcb_free_colormap(ctx, cmap);
+}
+
+static void
+xcbfreecursor(void* ctx, xcb_cursor_t cursor) {
+  xcb_free_cursor(ctx, cursor);
+}
+
+static void
+xcbgrabbutton(void* ctx, uint8_t ownerevents, xcb_window_t win, uint16_t evmask, 
+              uint8_t pointermode, uint8_t keyboardmode, xcb_window_t confineto, 
+              xcb_cursor_t cursor, uint8_t button, uint16_t modifiers) {
+  xcb_grab_button(ctx, ownerevents, win, evmask, pointermode, keyboardmode, 
+                  confineto, cursor, button, modifiers);
+}
+
+static void
+xcbungrabbutton(void* ctx, uint8_t button, xcb_window_t win, uint16_t modifiers) {
+  xcb_ungrab_button(ctx, button, win, modifiers);
+}
+
+static void
+xcbgrabkey(void* ctx, uint8_t ownerevents, xcb_window_t win, uint16_t modifiers, 
+           xcb_keycode_t key, uint8_t pointermode, uint8_t keyboardmode) {
+  xcb_grab_key(ctx, ownerevents, win, modifiers, key, pointermode, keyboardmode);
+}
+
+static void
+xcbungrabkey(void* ctx, xcb_keycode_t key, xcb_window_t win, uint16_t modifiers) {
+  xcb_ungrab_key(ctx, key, win, modifiers);
+}
+
+static void
+xcballowevents(void* ctx, uint8_t mode, xcb_timestamp_t time) {
+  xcb_allow_events(ctx, mode, time);
+}
+
+static void
+xcbwarppointer(void* ctx, xcb_window_t srcwin, xcb_window_t dstwin, 
+               int16_t srcx, int16_t srcy, uint16_t srcw, uint16_t srch, 
+               int16_t dstx, int16_t dsty) {
+  xcb_warp_pointer(ctx, srcwin, dstwin, srcx, srcy, srcw, srch, dstx, dsty);
+}
+
+static void
+xcbgrabserver(void* ctx) {
+  xcb_grab_server(ctx);
+}
+
+static void
+xcbungrabserver(void* ctx) {
+  xcb_ungrab_server(ctx);
+}
+
+static void
+xcbsetclosedownmode(void* ctx, uint8_t mode) {
+  xcb_set_close_down_mode(ctx, mode);
+}
+
+static void
+xcbkillclient(void* ctx, uint32_t resource) {
+  xcb_kill_client(ctx, resource);
+}
+
+static void
+xcbcreatealarm(void* ctx, xcb_sync_alarm_t alarm, uint32_t mask, const void* values) {
+  xcb_sync_create_alarm(ctx, alarm, mask, values);
+}
+
+static void
+xcbchangealarm(void* ctx, xcb_sync_alarm_t alarm, uint32_t mask, const void* values) {
+  xcb_sync_change_alarm(ctx, alarm, mask, values);
+}
+
+static void
+xcbdestroyalarm(void* ctx, xcb_sync_alarm_t alarm) {
+  xcb_sync_destroy_alarm(ctx, alarm);
+}
+
+static uint32_t
+xcbgenerateid(void* ctx) {
+  return xcb_generate_id(ctx);
+}
+
+static xcb_cursor_t
+xcbloadcursor(void* ctx, xcb_screen_t* screen, const char* name) {
+  xcb_cursor_context_t* cursorctx;
+  if(xcb_cursor_context_new(ctx, screen, &cursorctx) < 0) return XCB_NONE;
+  xcb_cursor_t cursor = xcb_cursor_load_cursor(cursorctx, name);
+  xcb_cursor_context_free(cursorctx);
+  return cursor;
+}
+
+static bool
+xcbchangewindowattributeschecked(void* ctx, xcb_window_t win, uint32_t mask, const void* values) {
+  xcb_generic_error_t* err = xcb_request_check(ctx, 
+    xcb_change_window_attributes_checked(ctx, win, mask, values));
+  free(err);
+  return !err;
+}
+
+static xcb_get_property_reply_t*
+xcbgetproperty(void* ctx, uint8_t del, xcb_window_t win, xcb_atom_t prop,
+               xcb_atom_t type, uint32_t offset, uint32_t len) {
+  return xcb_get_property_reply(ctx,
+    xcb_get_property(ctx, del, win, prop, type, offset, len), NULL);
+}
+
+static xcb_get_geometry_reply_t*
+xcbgetgeometry(void* ctx, xcb_drawable_t drawable) {
+  return xcb_get_geometry_reply(ctx, xcb_get_geometry(ctx, drawable), NULL);
+}
+
+static xcb_get_window_attributes_reply_t*
+xcbgetwindowattributes(void* ctx, xcb_window_t win) {
+  return xcb_get_window_attributes_reply(ctx, xcb_get_window_attributes(ctx, win), NULL);
+}
+
+static xcb_query_pointer_reply_t*
+xcbquerypointer(void* ctx, xcb_window_t win) {
+  return xcb_query_pointer_reply(ctx, xcb_query_pointer(ctx, win), NULL);
+}
+
+static xcb_query_tree_reply_t*
+xcbquerytree(void* ctx, xcb_window_t win) {
+  return xcb_query_tree_reply(ctx, xcb_query_tree(ctx, win), NULL);
+}
+
+static xcb_intern_atom_reply_t*
+xcbinternatom(void* ctx, uint8_t onlyifexists, uint16_t len, const char* name) {
+  return xcb_intern_atom_reply(ctx, xcb_intern_atom(ctx, onlyifexists, len, name), NULL);
+}
+
+static xcb_get_selection_owner_reply_t*
+xcbgetselectionowner(void* ctx, xcb_atom_t selection) {
+  return xcb_get_selection_owner_reply(ctx, xcb_get_selection_owner(ctx, selection), NULL);
+}
+
+static xcb_sync_query_counter_reply_t*
+xcbquerycounter(void* ctx, xcb_sync_counter_t counter) {
+  return xcb_sync_query_counter_reply(ctx, xcb_sync_query_counter(ctx, counter), NULL);
+}
+
+static xcb_randr_get_monitors_reply_t*
+xcbgetmonitors(void* ctx, xcb_window_t win, uint8_t active) {
+  return xcb_randr_get_monitors_reply(ctx, xcb_randr_get_monitors(ctx, win, active), NULL);
+}
+
+static xcb_keysym_t
+xcbgetkeysym(void* ctx, xcb_keycode_t keycode) {
+  xcb_key_symbols_t* keysyms = xcb_key_symbols_alloc(ctx);
+  xcb_keysym_t keysym = keysyms ? xcb_key_symbols_get_keysym(keysyms, keycode, 0) : 0;
+  xcb_key_symbols_free(keysyms);
+  return keysym;
+}
+
+static xcb_keycode_t*
+xcbgetkeycodes(void* ctx, xcb_keysym_t keysym) {
+  xcb_key_symbols_t* keysyms = xcb_key_symbols_alloc(ctx);
+  xcb_keycode_t* keycodes = keysyms ? xcb_key_symbols_get_keycode(keysyms, keysym) : NULL;
+  xcb_key_symbols_free(keysyms);
+  return keycodes;
+}
+
+static xcb_get_property_cookie_t
+xcbgetpropertyrequest(void* ctx, uint8_t del, xcb_window_t win, xcb_atom_t prop,
+                      xcb_atom_t type, uint32_t offset, uint32_t len) {
+  return xcb_get_property(ctx, del, win, prop, type, offset, len);
+}
+
+static xcb_get_property_reply_t*
+xcbgetpropertyreply(void* ctx, xcb_get_property_cookie_t cookie) {
+  return xcb_get_property_reply(ctx, cookie, NULL);
+}
+
+static xcb_query_tree_cookie_t
+xcbquerytreerequest(void* ctx, xcb_window_t win) {
+  return xcb_query_tree(ctx, win);
+}
+
+static xcb_query_tree_reply_t*
+xcbquerytreereply(void* ctx, xcb_query_tree_cookie_t cookie) {
+  return xcb_query_tree_reply(ctx, cookie, NULL);
+}
+
+const x_backend_t xcbbackend = {
+  .configurewindow        = xcbconfigurewindow,
+  .changewindowattributes = xcbchangewindowattributes,
+  .mapwindow              = xcbmapwindow,
+  .unmapwindow            = xcbunmapwindow,
+  .destroywindow          = xcbdestroywindow,
+  .changeproperty         = xcbchangeproperty,
+  .deleteproperty         = xcbdeleteproperty,
+  .setinputfocus          = xcbsetinputfocus,
+  .sendevent              = xcbsendevent,
+  .flush                  = xcbflush,
+  .createwindow           = xcbcreatewindow,
+  .reparentwindow         = xcbreparentwindow,
+  .cleararea              = xcbcleararea,
+  .createcolormap         = xcbcreatecolormap,
+  .freecolormap           = xcbfreecolormap,
+  .freecursor             = xcbfreecursor,
+  .grabbutton             = xcbgrabbutton,
+  .ungrabbutton           = xcbungrabbutton,
+  .grabkey                = xcbgrabkey,
+  .ungrabkey              = xcbungrabkey,
+  .allowevents            = xcballowevents,
+  .warppointer            = xcbwarppointer,
+  .grabserver             = xcbgrabserver,
+  .ungrabserver           = xcbungrabserver,
+  .setclosedownmode       = xcbsetclosedownmode,
+  .killclient             = xcbkillclient,
+  .createalarm            = xcbcreatealarm,
+  .changealarm            = xcbchangealarm,
+  .destroyalarm           = xcbdestroyalarm,
+  .generateid             = xcbgenerateid,
+  .loadcursor             = xcbloadcursor,
+  .changewindowattributeschecked = xcbchangewindowattributeschecked,
+  .getproperty            = xcbgetproperty,
+  .getgeometry            = xcbgetgeometry,
+  .getwindowattributes    = xcbgetwindowattributes,
+  .querypointer           = xcbquerypointer,
+  .querytree              = xcbquerytree,
+  .internatom             = xcbinternatom,
+  .getselectionowner      = xcbgetselectionowner,
+  .querycounter           = xcbquerycounter,
+  .getmonitors            = xcbgetmonitors,
+  .getkeysym              = xcbgetkeysym,
+  .getkeycodes            = xcbgetkeycodes,
+  .getpropertyrequest     = xcbgetpropertyrequest,
+  .getpropertyreply       = xcbgetpropertyreply,
+  .querytreerequest       = xcbquerytreerequest,
+  .querytreereply         = xcbquerytreereply,
+};
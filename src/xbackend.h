@@ -0,0 +1,389 @@
+#pragma once
+
+#include "structs.h"
+
+#include <stdlib.h>
+#include <xcb/xcb_icccm.h>
+
+/* Requests of the handlers go through the backend of the state so
+ * that they can run against an X server (xcbbackend) or windows
+ * modeled in memory (see fakex.h), which also makes it possible to
+ * count the requests and round trips of an operation. Only opening 
+ * the connection and the requests of the property fetcher's own 
+ * connection use xcb directly. */
+
+extern const x_backend_t xcbbackend;
+
+static inline void
+xconfigurewindow(state_t* s, xcb_window_t win, uint16_t mask, const void* values) {
+  s->xstats.requests++;
+  s->x->configurewindow(s->xctx, win, mask, values);
+}
+
+static inline void
+xchangewindowattributes(state_t* s, xcb_window_t win, uint32_t mask, const void* values) {
+  s->xstats.requests++;
+  s->x->changewindowattributes(s->xctx, win, mask, values);
+}
+
+static inline void
+xmapwindow(state_t* s, xcb_window_t win) {
+  s->xstats.requests++;
+  s->x->mapwindow(s->xctx, win);
+}
+
+static inline void
+xunmapwindow(state_t* s, xcb_window_t win) {
+  s->xstats.requests++;
+  s->x->unmapwindow(s->xctx, win);
+}
+
+static inline void
+xdestroywindow(state_t* s, xcb_window_t win) {
+  s->xstats.requests++;
+  s->x->destroywindow(s->xctx, win);
+}
+
+static inline void
+xchangeproperty(state_t* s, uint8_t mode, xcb_window_t win, xcb_atom_t prop,
+                xcb_atom_t type, uint8_t format, uint32_t len, const void* data) {
+  s->xstats.requests++;
+  s->x->changeproperty(s->xctx, mode, win, prop, type, format, len, data);
+}
+
+static inline void
+xdeleteproperty(state_t* s, xcb_window_t win, xcb_atom_t prop) {
+  s->xstats.requests++;
+  s->x->deleteproperty(s->xctx, win, prop);
+}
+
+static inline void
+xsetinputfocus(state_t* s, uint8_t revertto, xcb_window_t win, xcb_timestamp_t time) {
+  s->xstats.requests++;
+  s->x->setinputfocus(s->xctx, revertto, win, time);
+}
+
+static inline void
+xsendevent(state_t* s, uint8_t propagate, xcb_window_t dest, uint32_t mask, const char* ev) {
+  s->xstats.requests++;
+  s->x->sendevent(s->xctx, propagate, dest, mask, ev);
+}
+
+static inline void
+xflush(state_t* s) {
+  s->xstats.flushes++;
+  s->x->flush(s->xctx);
+}
+
+static inline void
+xcreatewindow(state_t* s, uint8_t depth, xcb_window_t win, xcb_window_t parent,
+              int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t borderwidth,
+              uint16_t class, xcb_visualid_t visual, uint32_t mask, const void* values) {
+  s->xstats.requests++;
+  s->x->createwindow(s->xctx, depth, win, parent, x, y, w, h, borderwidth, class, visual, mask, values);
+}
+
+static inline void
+xreparentwindow(state_t* s, xcb_window_t win, xcb_window_t parent, int16_t x, int16_t y) {
+  s->xstats.requests++;
+  s->x->reparentwindow(s->xctx, win, parent, x, y);
+}
+
+static inline void
+xcleararea(state_t* s, uint8_t exposures, xcb_window_t win, 
+           int16_t x, int16_t y, uint16_t w, uint16_t h) {
+  s->xstats.requests++;
+  s->x->cleararea(s->xctx, exposures, win, x, y, w, h);
+}
+
+static inline void
+xcreatecolormap(state_t* s, uint8_t alloc, xcb_colormap_t cmap, 
+                xcb_window_t win, xcb_visualid_t visual) {
+  s->xstats.requests++;
+  s->x->createcolormap(s->xctx, alloc, cmap, win, visual);
+}
+
+static inline void
+xfreecolormap(state_t* s, xcb_colormap_t cmap) {
+  s->xstats.requests++;
+  s->x->freecolormap(s->xctx, cmap);
+}
+
+static inline void
+xfreecursor(state_t* s, xcb_cursor_t cursor) {
+  s->xstats.requests++;
+  s->x->freecursor(s->xctx, cursor);
+}
+
+static inline void
+xgrabbutton(state_t* s, uint8_t ownerevents, xcb_window_t win, uint16_t evmask, 
+            uint8_t pointermode, uint8_t keyboardmode, xcb_window_t confineto, 
+            xcb_cursor_t cursor, uint8_t button, uint16_t modifiers) {
+  s->xstats.requests++;
+  s->x->grabbutton(s->xctx, ownerevents, win, evmask, pointermode, keyboardmode, 
+                   confineto, cursor, button, modifiers);
+}
+
+static inline void
+xungrabbutton(state_t* s, uint8_t button, xcb_window_t win, uint16_t modifiers) {
+  s->xstats.requests++;
+  s->x->ungrabbutton(s->xctx, button, win, modifiers);
+}
+
+static inline void
+xgrabkey(state_t* s, uint8_t ownerevents, xcb_window_t win, uint16_t modifiers, 
+         xcb_keycode_t key, uint8_t pointermode, uint8_t keyboardmode) {
+  s->xstats.requests++;
+  s->x->grabkey(s->xctx, ownerevents, win, modifiers, key, pointermode, keyboardmode);
+}
+
+static inline void
+xungrabkey(state_t* s, xcb_keycode_t key, xcb_window_t win, uint16_t modifiers) {
+  s->xstats.requests++;
+  s->x->ungrabkey(s->xctx, key, win, modifiers);
+}
+
+static inline void
+xallowevents(state_t* s, uint8_t mode, xcb_timestamp_t time) {
+  s->xstats.requests++;
+  s->x->allowevents(s->xctx, mode, time);
+}
+
+static inline void
+xwarppointer(state_t* s, xcb_window_t srcwin, xcb_window_t dstwin, 
+             int16_t srcx, int16_t srcy, uint16_t srcw, uint16_t srch, 
+             int16_t dstx, int16_t dsty) {
+  s->xstats.requests++;
+  s->x->warppointer(s->xctx, srcwin, dstwin, srcx, srcy, srcw, srch, dstx, dsty);
+}
+
+static inline void
+xgrabserver(state_t* s) {
+  s->xstats.requests++;
+  s->x->grabserver(s->xctx);
+}
+
+static inline void
+xungrabserver(state_t* s) {
+  s->xstats.requests++;
+  s->x->ungrabserver(s->xctx);
+}
+
+static inline void
+xsetclosedownmode(state_t* s, uint8_t mode) {
+  s->xstats.requests++;
+  s->x->setclosedownmode(s->xctx, mode);
+}
+
+static inline void
+xkillclient(state_t* s, uint32_t resource) {
+  s->xstats.requests++;
+  s->x->killclient(s->xctx, resource);
+}
+
+static inline void
+xcreatealarm(state_t* s, xcb_sync_alarm_t alarm, uint32_t mask, const void* values) {
+  s->xstats.requests++;
+  s->x->createalarm(s->xctx, alarm, mask, values);
+}
+
+static inline void
+xchangealarm(state_t* s, xcb_sync_alarm_t alarm, uint32_t mask, const void* values) {
+  s->xstats.requests++;
+  s->x->changealarm(s->xctx, alarm, mask, values);
+}
+
+static inline void
+xdestroyalarm(state_t* s, xcb_sync_alarm_t alarm) {
+  s->xstats.requests++;
+  s->x->destroyalarm(s->xctx, alarm);
+}
+
+static inline uint32_t
+xgenerateid(state_t* s) {
+  return s->x->generateid(s->xctx);
+}
+
+static inline xcb_cursor_t
+xloadcursor(state_t* s, const char* name) {
+  s->xstats.requests++;
+  return s->x->loadcursor(s->xctx, s->screen, name);
+}
+
+static inline bool
+xchangewindowattributeschecked(state_t* s, xcb_window_t win, uint32_t mask, const void* values) {
+  s->xstats.requests++;
+  s->xstats.roundtrips++;
+  return s->x->changewindowattributeschecked(s->xctx, win, mask, values);
+}
+
+static inline xcb_get_property_reply_t*
+xgetproperty(state_t* s, uint8_t del, xcb_window_t win, xcb_atom_t prop,
+             xcb_atom_t type, uint32_t offset, uint32_t len) {
+  s->xstats.requests++;
+  s->xstats.roundtrips++;
+  return s->x->getproperty(s->xctx, del, win, prop, type, offset, len);
+}
+
+static inline xcb_get_geometry_reply_t*
+xgetgeometry(state_t* s, xcb_drawable_t drawable) {
+  s->xstats.requests++;
+  s->xstats.roundtrips++;
+  return s->x->getgeometry(s->xctx, drawable);
+}
+
+static inline xcb_get_window_attributes_reply_t*
+xgetwindowattributes(state_t* s, xcb_window_t win) {
+  s->xstats.requests++;
+  s->xstats.roundtrips++;
+  return s->x->getwindowattributes(s->xctx, win);
+}
+
+static inline xcb_query_pointer_reply_t*
+xquerypointer(state_t* s, xcb_window_t win) {
+  s->xstats.requests++;
+  s->xstats.roundtrips++;
+  return s->x->querypointer(s->xctx, win);
+}
+
+static inline xcb_query_tree_reply_t*
+xquerytree(state_t* s, xcb_window_t win) {
+  s->xstats.requests++;
+  s->xstats.roundtrips++;
+  return s->x->querytree(s->xctx, win);
+}
+
+static inline xcb_intern_atom_reply_t*
+xinternatom(state_t* s, uint8_t onlyifexists, uint16_t len, const char* name) {
+  s->xstats.requests++;
+  s->xstats.roundtrips++;
+  return s->x->internatom(s->xctx, onlyifexists, len, name);
+}
+
+static inline xcb_get_selection_owner_reply_t*
+xgetselectionowner(state_t* s, xcb_atom_t selection) {
+  s->xstats.requests++;
+  s->xstats.roundtrips++;
+  return s->x->getselectionowner(s->xctx, selection);
+}
+
+static inline xcb_sync_query_counter_reply_t*
+xquerycounter(state_t* s, xcb_sync_counter_t counter) {
+  s->xstats.requests++;
+  s->xstats.roundtrips++;
+  return s->x->querycounter(s->xctx, counter);
+}
+
+static inline xcb_randr_get_monitors_reply_t*
+xgetmonitors(state_t* s, xcb_window_t win, uint8_t active) {
+  s->xstats.requests++;
+  s->xstats.roundtrips++;
+  return s->x->getmonitors(s->xctx, win, active);
+}
+
+static inline xcb_keysym_t
+xgetkeysym(state_t* s, xcb_keycode_t keycode) {
+  s->xstats.requests++;
+  s->xstats.roundtrips++;
+  return s->x->getkeysym(s->xctx, keycode);
+}
+
+static inline xcb_keycode_t*
+xgetkeycodes(state_t* s, xcb_keysym_t keysym) {
+  s->xstats.requests++;
+  s->xstats.roundtrips++;
+  return s->x->getkeycodes(s->xctx, keysym);
+}
+
+/* A pipelined request counts as a round trip when its reply is read */
+static inline xcb_get_property_cookie_t
+xgetpropertyrequest(state_t* s, uint8_t del, xcb_window_t win, xcb_atom_t prop,
+                    xcb_atom_t type, uint32_t offset, uint32_t len) {
+  s->xstats.requests++;
+  return s->x->getpropertyrequest(s->xctx, del, win, prop, type, offset, len);
+}
+
+static inline xcb_get_property_reply_t*
+xgetpropertyreply(state_t* s, xcb_get_property_cookie_t cookie) {
+  s->xstats.roundtrips++;
+  return s->x->getpropertyreply(s->xctx, cookie);
+}
+
+static inline xcb_query_tree_cookie_t
+xquerytreerequest(state_t* s, xcb_window_t win) {
+  s->xstats.requests++;
+  return s->x->querytreerequest(s->xctx, win);
+}
+
+static inline xcb_query_tree_reply_t*
+xquerytreereply(state_t* s, xcb_query_tree_cookie_t cookie) {
+  s->xstats.roundtrips++;
+  return s->x->querytreereply(s->xctx, cookie);
+}
+
+/* The ICCCM properties are requested like xcb-icccm does and 
+ * parsed with its *_from_reply() functions */
+
+static inline xcb_get_property_cookie_t
+xgetwmclassrequest(state_t* s, xcb_window_t win) {
+  return xgetpropertyrequest(s, 0, win, XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 0, 2048);
+}
+
+/* The reply is owned by wmclass on success (see xcb_icccm_get_wm_class_reply_wipe()) */
+static inline bool
+xgetwmclassreply(state_t* s, xcb_get_property_cookie_t cookie, xcb_icccm_get_wm_class_reply_t* wmclass) {
+  xcb_get_property_reply_t* reply = xgetpropertyreply(s, cookie);
+  if(reply && xcb_icccm_get_wm_class_from_reply(wmclass, reply)) return true;
+  free(reply);
+  return false;
+}
+
+static inline bool
+xgetwmclass(state_t* s, xcb_window_t win, xcb_icccm_get_wm_class_reply_t* wmclass) {
+  return xgetwmclassreply(s, xgetwmclassrequest(s, win), wmclass);
+}
+
+static inline xcb_get_property_cookie_t
+xgetwmhintsrequest(state_t* s, xcb_window_t win) {
+  return xgetpropertyrequest(s, 0, win, XCB_ATOM_WM_HINTS, XCB_ATOM_WM_HINTS, 
+                             0, XCB_ICCCM_NUM_WM_HINTS_ELEMENTS);
+}
+
+static inline bool
+xgetwmhintsreply(state_t* s, xcb_get_property_cookie_t cookie, xcb_icccm_wm_hints_t* hints) {
+  xcb_get_property_reply_t* reply = xgetpropertyreply(s, cookie);
+  bool ok = reply && xcb_icccm_get_wm_hints_from_reply(hints, reply);
+  free(reply);
+  return ok;
+}
+
+static inline bool
+xgetwmhints(state_t* s, xcb_window_t win, xcb_icccm_wm_hints_t* hints) {
+  return xgetwmhintsreply(s, xgetwmhintsrequest(s, win), hints);
+}
+
+static inline void
+xsetwmhints(state_t* s, xcb_window_t win, const xcb_icccm_wm_hints_t* hints) {
+  xchangeproperty(s, XCB_PROP_MODE_REPLACE, win, XCB_ATOM_WM_HINTS, XCB_ATOM_WM_HINTS,
+                  32, sizeof(*hints) >> 2, hints);
+}
+
+static inline bool
+xgetwmnormalhints(state_t* s, xcb_window_t win, xcb_size_hints_t* hints) {
+  xcb_get_property_reply_t* reply = xgetproperty(s, 0, win, XCB_ATOM_WM_NORMAL_HINTS, 
+                                                 XCB_ATOM_WM_SIZE_HINTS, 0, 
+                                                 XCB_ICCCM_NUM_WM_SIZE_HINTS_ELEMENTS);
+  bool ok = reply && xcb_icccm_get_wm_size_hints_from_reply(hints, reply);
+  free(reply);
+  return ok;
+}
+
+/* The reply is owned by protocols on success (see xcb_icccm_get_wm_protocols_reply_wipe()) */
+static inline bool
+xgetwmprotocols(state_t* s, xcb_window_t win, xcb_atom_t atom, 
+                xcb_icccm_get_wm_protocols_reply_t* protocols) {
+  xcb_get_property_reply_t* reply = xgetproperty(s, 0, win, atom, XCB_ATOM_ATOM, 0, UINT32_MAX);
+  if(reply && xcb_icccm_get_wm_protocols_from_reply(reply, protocols)) return true;
+  free(reply);
+  return false;
+}
@@ -0,0 +1,311 @@
+/* In-process tests of the window manager's handlers. The handlers run
+ * against the fake X backend (see src/fakex.h), which checks the state
+ * of the windows they leave behind and the number of requests and
+ * roundtrips they take. Built and run with 'make test'. */
+
+#include "../src/structs.h"
+#include "../src/funcs.h"
+#include "../src/fakex.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EXPECT(cond) do {                                                   \
+  if(!(cond)) {                                                             \
+    fprintf(stderr, "%s:%i: %s: expected %s\n", __FILE__, __LINE__,         \
+            __func__, #cond);                                               \
+    failures++;                                                             \
+  }                                                                         \
+} while(0)
+
+#define MON_W 1920
+#define MON_H 1080
+#define GAP 10
+#define BORDER 2
+#define NUM_DESKTOPS 3
+
+/* Budgets of requests and roundtrips that the handlers take as of now.
+ * A change that makes a handler take more has to raise them on purpose. */
+#define MAP_REQUEST_REQUESTS 104
+#define MAP_REQUEST_ROUNDTRIPS 13
+#define SWITCH_DESKTOP_REQUESTS 8
+/* A tiled client is moved and resized, which configures its frame and 
+ * window, notifies it and places its eight edge windows twice */
+#define TILED_CLIENT_REQUESTS 36
+
+static uint32_t failures = 0;
+
+static state_t* createwm(fake_x_t** fx, const area_t* mons, uint32_t nummons);
+static xcb_window_t mapwindow(state_t* s, fake_x_t* fx);
+static const fake_window_t* framewindow(state_t* s, fake_x_t* fx, xcb_window_t win);
+
+static void testmaprequest(void);
+static void testswitchdesktop(void);
+static void testtiledmaster(void);
+static void testcyclemonitors(void);
+static void testhotplug(void);
+
+static const area_t onemonitor[] = {
+  { .pos = {0, 0}, .size = {MON_W, MON_H} },
+};
+
+/* Sets up a window manager on fake monitors. The config is filled in 
+ * here instead of being read from a file. */
+state_t*
+createwm(fake_x_t** fx, const area_t* mons, uint32_t nummons) {
+  state_t* s = calloc(1, sizeof(*s));
+  s->cfgwatchfd = -1;
+  s->ipc.eventfd = -1;
+
+  char** names = calloc(NUM_DESKTOPS, sizeof(*names));
+  for(uint32_t i = 0; i < NUM_DESKTOPS; i++) {
+    names[i] = malloc(2);
+    snprintf(names[i], 2, "%i", i + 1);
+  }
+  s->config = (config_data_t){
+    .maxstruts              = 4,
+    .maxdesktops            = NUM_DESKTOPS,
+    .maxscratchpads         = 1,
+    .winborderwidth         = BORDER,
+    .winbordercolor         = 0x222222,
+    .winbordercolor_selected = 0xffffff,
+    .modkey                 = Super,
+    .winmod                 = Super,
+    .movebtn                = LeftMouse,
+    .resizebtn              = RightMouse,
+    .desktopinit            = 0,
+    .desktopnames           = names,
+    .numdesktopnames        = NUM_DESKTOPS,
+    .layoutmasterarea       = 0.5,
+    .layoutmasterarea_min   = 0.1,
+    .layoutmasterarea_max   = 0.9,
+    .layoutmasterarea_step  = 0.1,
+    .layoutsize_step        = 10,
+    .layoutsize_min         = 50,
+    .keywinmove_step        = 10,
+    .winlayoutgap           = GAP,
+    .winlayoutgap_max       = 100,
+    .winlayoutgap_step      = 5,
+    .tabbarheight           = 8,
+    .initlayout             = LayoutTiledMaster,
+    .hidestrategy           = HideStrategyUnmap,
+    .framevisual            = FrameVisualOpaque,
+    .resizemode             = ResizeModeLive,
+    .motion_notify_debounce_fps = 60,
+  };
+
+  area_t root = {0};
+  for(uint32_t i = 0; i < nummons; i++) {
+    root.size.x = MAX(root.size.x, mons[i].pos.x + mons[i].size.x);
+    root.size.y = MAX(root.size.y, mons[i].pos.y + mons[i].size.y);
+  }
+  *fx = fakexcreate(root);
+  for(uint32_t i = 0; i < nummons; i++) {
+    fakexaddmonitor(*fx, mons[i]);
+  }
+  fakexsetpointer(*fx, (v2_t){MON_W / 2, MON_H / 2});
+  fakexuse(s, *fx);
+  if(!setupwm(s, false)) {
+    fprintf(stderr, "failed to set up the window manager on the fake backend.\n");
+    exit(EXIT_FAILURE);
+  }
+  return s;
+}
+
+/* Creates a client window and lets the window manager handle its map request */
+xcb_window_t
+mapwindow(state_t* s, fake_x_t* fx) {
+  xcb_window_t win = fakexcreatewindow(fx, s->root,
+                                       (area_t){.pos = {0, 0}, .size = {640, 480}}, false);
+  xcb_map_request_event_t ev = {
+    .response_type = XCB_MAP_REQUEST,
+    .parent = s->root,
+    .window = win,
+  };
+  evmaprequest(s, (xcb_generic_event_t*)&ev);
+  return win;
+}
+
+const fake_window_t*
+framewindow(state_t* s, fake_x_t* fx, xcb_window_t win) {
+  client_t* cl = clientfromwin(s, win);
+  return cl ? fakexwindow(fx, cl->frame) : NULL;
+}
+
+void
+testmaprequest(void) {
+  fake_x_t* fx;
+  state_t* s = createwm(&fx, onemonitor, ARRLEN(onemonitor));
+
+  s->xstats = (x_stats_t){0};
+  xcb_window_t win = mapwindow(s, fx);
+  client_t* cl = clientfromwin(s, win);
+  EXPECT(cl != NULL);
+  if(!cl) return;
+
+  // The window is framed, mapped and fills the monitor within the gaps
+  const fake_window_t* frame = fakexwindow(fx, cl->frame);
+  EXPECT(frame && frame->mapped && frame->parent == s->root);
+  EXPECT(fakexwindow(fx, win)->parent == cl->frame);
+  EXPECT(fakexwindow(fx, win)->mapped);
+  EXPECT(frame && frame->x == GAP && frame->y == GAP);
+  EXPECT(frame && frame->width == MON_W - 2 * GAP - 2 * BORDER);
+  EXPECT(frame && frame->height == MON_H - 2 * GAP - 2 * BORDER);
+  EXPECT(s->xstats.roundtrips <= MAP_REQUEST_ROUNDTRIPS);
+  EXPECT(s->xstats.requests <= MAP_REQUEST_REQUESTS);
+  EXPECT(s->xstats.flushes >= 1);
+
+  // A window that is mapped again is not managed twice
+  s->xstats = (x_stats_t){0};
+  xcb_map_request_event_t ev = {
+    .response_type = XCB_MAP_REQUEST,
+    .parent = s->root,
+    .window = win,
+  };
+  evmaprequest(s, (xcb_generic_event_t*)&ev);
+  EXPECT(s->xstats.roundtrips == 1);
+  EXPECT(s->monfocus->clients[0].size == 1);
+
+  // Override redirect windows are left alone
+  xcb_window_t popup = fakexcreatewindow(fx, s->root,
+                                         (area_t){.pos = {0, 0}, .size = {10, 10}}, true);
+  ev.window = popup;
+  evmaprequest(s, (xcb_generic_event_t*)&ev);
+  EXPECT(clientfromwin(s, popup) == NULL);
+  EXPECT(fakexwindow(fx, popup)->parent == s->root);
+}
+
+void
+testswitchdesktop(void) {
+  fake_x_t* fx;
+  state_t* s = createwm(&fx, onemonitor, ARRLEN(onemonitor));
+
+  xcb_window_t a = mapwindow(s, fx);
+  xcb_window_t b = mapwindow(s, fx);
+
+  s->xstats = (x_stats_t){0};
+  switchmonitordesktop(s, 1);
+  EXPECT(mondesktop(s, s->monfocus)->idx == 1);
+  // The clients of the desktop that was switched away from are hidden
+  EXPECT(!framewindow(s, fx, a)->mapped);
+  EXPECT(!framewindow(s, fx, b)->mapped);
+  // Switching desktops never waits for a reply of the X server
+  EXPECT(s->xstats.roundtrips == 0);
+  EXPECT(s->xstats.requests <= SWITCH_DESKTOP_REQUESTS);
+
+  // Switching back shows the clients again at the areas they had
+  s->xstats = (x_stats_t){0};
+  switchmonitordesktop(s, 0);
+  EXPECT(framewindow(s, fx, a)->mapped);
+  EXPECT(framewindow(s, fx, b)->mapped);
+  EXPECT(s->xstats.roundtrips == 0);
+  // The layout of the desktop did not change, so the clients are not configured again
+  EXPECT(s->xstats.requests < SWITCH_DESKTOP_REQUESTS);
+
+  // Switching to the shown desktop does nothing
+  s->xstats = (x_stats_t){0};
+  switchmonitordesktop(s, 0);
+  EXPECT(s->xstats.requests == 0);
+}
+
+void
+testtiledmaster(void) {
+  fake_x_t* fx;
+  state_t* s = createwm(&fx, onemonitor, ARRLEN(onemonitor));
+
+  xcb_window_t wins[3];
+  for(uint32_t i = 0; i < 3; i++) {
+    wins[i] = mapwindow(s, fx);
+  }
+
+  s->xstats = (x_stats_t){0};
+  tiledmaster(s, s->monfocus);
+  // The newest client is the master, the others are stacked beside it
+  const fake_window_t* master = framewindow(s, fx, wins[2]);
+  const fake_window_t* top = framewindow(s, fx, wins[1]);
+  const fake_window_t* bottom = framewindow(s, fx, wins[0]);
+  EXPECT(master->x == GAP && master->y == GAP);
+  EXPECT(master->height == MON_H - 2 * GAP - 2 * BORDER);
+  EXPECT(top->x > master->x + master->width);
+  EXPECT(top->y == GAP);
+  EXPECT(bottom->x == top->x && bottom->y > top->y + top->height);
+  EXPECT(top->x + top->width + 2 * BORDER == MON_W - GAP);
+  EXPECT(s->xstats.roundtrips == 0);
+  EXPECT(s->xstats.requests <= 3 * TILED_CLIENT_REQUESTS);
+
+  // A larger master area widens the master and narrows the others
+  s->xstats = (x_stats_t){0};
+  s->monfocus->layouts[0].masterarea = 0.6f;
+  tiledmaster(s, s->monfocus);
+  EXPECT(s->xstats.roundtrips == 0);
+  EXPECT(s->xstats.requests <= 3 * TILED_CLIENT_REQUESTS);
+  EXPECT(framewindow(s, fx, wins[2])->width > MON_W / 2);
+  EXPECT(framewindow(s, fx, wins[1])->x > MON_W / 2 + GAP);
+}
+
+void
+testcyclemonitors(void) {
+  // Two monitors on top of each other and one to the right of them
+  const area_t mons[] = {
+    { .pos = {0, MON_H},  .size = {MON_W, MON_H} },
+    { .pos = {MON_W, 0},  .size = {MON_W, MON_H} },
+    { .pos = {0, 0},      .size = {MON_W, MON_H} },
+  };
+  fake_x_t* fx;
+  state_t* s = createwm(&fx, mons, ARRLEN(mons));
+
+  xcb_window_t win = mapwindow(s, fx);
+  client_t* cl = clientfromwin(s, win);
+  EXPECT(cl != NULL);
+  if(!cl) return;
+  focusclient(s, cl, true);
+
+  // Cycling goes top to bottom, then left to right and reaches every monitor
+  const v2_t order[] = { {MON_W, 0}, {0, MON_H}, {0, 0} };
+  for(uint32_t i = 0; i < ARRLEN(order); i++) {
+    cyclefocusmonitorup(s, (passthrough_data_t){0});
+    EXPECT(cl->mon->area.pos.x == order[i].x && cl->mon->area.pos.y == order[i].y);
+  }
+  for(uint32_t i = ARRLEN(order) - 1; i-- > 0;) {
+    cyclefocusmonitordown(s, (passthrough_data_t){0});
+    EXPECT(cl->mon->area.pos.x == order[i].x && cl->mon->area.pos.y == order[i].y);
+  }
+}
+
+void
+testhotplug(void) {
+  fake_x_t* fx;
+  state_t* s = createwm(&fx, onemonitor, ARRLEN(onemonitor));
+
+  xcb_window_t win = mapwindow(s, fx);
+  const fake_window_t* frame = framewindow(s, fx, win);
+  int32_t x = frame->x, y = frame->y;
+  uint32_t w = frame->width, h = frame->height;
+
+  // Plugging in a monitor lays out the new monitor only
+  fakexaddmonitor(fx, (area_t){ .pos = {MON_W, 0}, .size = {MON_W, MON_H} });
+  s->xstats = (x_stats_t){0};
+  updatemons(s);
+  EXPECT(s->monitors && s->monitors->next);
+  frame = framewindow(s, fx, win);
+  EXPECT(frame->x == x && frame->y == y && frame->width == w && frame->height == h);
+  // The client on the unchanged monitor is not configured again
+  EXPECT(s->xstats.requests < TILED_CLIENT_REQUESTS);
+}
+
+int
+main(void) {
+  testmaprequest();
+  testswitchdesktop();
+  testtiledmaster();
+  testcyclemonitors();
+  testhotplug();
+
+  if(failures) {
+    fprintf(stderr, "%i checks failed.\n", failures);
+    return EXIT_FAILURE;
+  }
+  printf("all handler tests passed.\n");
+  return EXIT_SUCCESS;
+}